@@ -0,0 +1,430 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       bench_host.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Host runner of the control-path benchmarks (see bench.h), with the
+ *   command line and the console / JSON outputs of Google Benchmark, so
+ *   that its tools (compare.py) take them:
+ *
+ *     build/bench [--benchmark_filter=<regex>] [--benchmark_min_time=<s>]
+ *                 [--benchmark_format=console|json]
+ *                 [--benchmark_out=<file>] [--benchmark_out_format=console|json]
+ *                 [--benchmark_list_tests]
+ *                 [--target_dump=<file>]
+ *
+ *   Each kernel is checked against its reference checksum first, then run
+ *   until it lasts the minimum CPU time. A wrong checksum is reported as
+ *   a benchmark error and the exit status is 1.
+ *
+ *   With --target_dump, the output of the shell 'bench' command of a
+ *   BENCH_TARGET firmware ("-" for stdin) is reported in the same formats
+ *   instead: average time per call, cycles and cycles_min counters.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <regex.h>
+
+#include "bench.h"
+
+#define BENCH_NAME_LEN          48
+#define BENCH_RESULTS_MAX       64
+#define BENCH_MAX_ITERATIONS    1000000000ULL
+
+typedef enum {
+    BENCH_FORMAT_CONSOLE = 0,
+    BENCH_FORMAT_JSON
+} bench_format_t;
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    unsigned long long iterations;
+    double real_ns;                         /* per iteration */
+    double cpu_ns;
+    double cycles;                          /* per iteration, target only */
+    double cycles_min;
+    uint32_t checksum;
+    uint32_t reference;
+} bench_result_t;
+
+/* Context of the results */
+static struct {
+    char executable[256];
+    char host_name[64];
+    int num_cpus;
+    double mhz_per_cpu;
+    int target;                             /* results of a target dump */
+} context;
+
+static bench_result_t results[BENCH_RESULTS_MAX];
+static int nb_results;
+
+static double min_time = 0.5;               /* seconds */
+static regex_t filter;
+static int filter_set;
+
+static double now(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int selected(const char* name)
+{
+    return !filter_set || regexec(&filter, name, 0, NULL, 0) == 0;
+}
+
+static bench_result_t* new_result(const char* name)
+{
+    bench_result_t* result;
+
+    if(nb_results == BENCH_RESULTS_MAX)
+        return NULL;
+
+    result = &results[nb_results++];
+    memset(result, 0, sizeof(*result));
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    return result;
+}
+
+/* -----------------------------------------------------------------------------
+ * Host runs
+ * -----------------------------------------------------------------------------
+ */
+
+/* Same iterations growth as Google Benchmark */
+static void run_kernel(const bench_kernel_t* kernel, bench_result_t* result)
+{
+    unsigned long long iterations = 1, next;
+    double real, cpu, multiplier;
+
+    result->checksum = bench_check(kernel);
+    result->reference = kernel->reference;
+    if(result->checksum != result->reference)
+        return;
+
+    kernel->setup();
+    for(;;)
+    {
+        real = now(CLOCK_MONOTONIC);
+        cpu = now(CLOCK_PROCESS_CPUTIME_ID);
+        kernel->run((uint32_t)iterations);
+        cpu = now(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+        real = now(CLOCK_MONOTONIC) - real;
+
+        if(cpu >= min_time || iterations >= BENCH_MAX_ITERATIONS)
+            break;
+
+        multiplier = min_time * 1.4 / (cpu > 1e-9 ? cpu : 1e-9);
+        if(cpu / min_time <= 0.1 && multiplier > 10.0)
+            multiplier = 10.0;
+        next = (unsigned long long)(iterations * multiplier);
+        iterations = (next > iterations) ? next : iterations + 1;
+        if(iterations > BENCH_MAX_ITERATIONS)
+            iterations = BENCH_MAX_ITERATIONS;
+    }
+
+    result->iterations = iterations;
+    result->real_ns = real * 1e9 / iterations;
+    result->cpu_ns = cpu * 1e9 / iterations;
+}
+
+static void run_host(void)
+{
+    bench_result_t* result;
+    FILE* cpuinfo;
+    char line[256];
+    uint32_t n;
+
+    context.num_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    gethostname(context.host_name, sizeof(context.host_name) - 1);
+    cpuinfo = fopen("/proc/cpuinfo", "r");
+    if(cpuinfo)
+    {
+        while(fgets(line, sizeof(line), cpuinfo))
+            if(sscanf(line, "cpu MHz : %lf", &context.mhz_per_cpu) == 1)
+                break;
+        fclose(cpuinfo);
+    }
+
+    for(n = 0; n < bench_nb_kernels; n++)
+    {
+        if(!selected(bench_kernels[n].name))
+            continue;
+        result = new_result(bench_kernels[n].name);
+        if(result)
+            run_kernel(&bench_kernels[n], result);
+    }
+}
+
+/* -----------------------------------------------------------------------------
+ * Target dumps
+ *   # bench <cpu_hz> <kernels>
+ *   B <name> <iterations per batch> <batches> <min cycles> <avg cycles> <checksum> <reference>
+ *   # end
+ * Cycles of a batch, checksums in hexadecimal, other lines are ignored.
+ * -----------------------------------------------------------------------------
+ */
+
+static int read_target(const char* path)
+{
+    bench_result_t* result;
+    FILE* dump;
+    char line[256], name[BENCH_NAME_LEN];
+    unsigned long cpu_hz = 0, kernels, iterations, batches, cycles_min, cycles_avg;
+    unsigned int checksum, reference;
+
+    dump = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if(!dump)
+    {
+        perror(path);
+        return -1;
+    }
+
+    context.target = 1;
+    context.num_cpus = 1;
+    snprintf(context.host_name, sizeof(context.host_name), "HoloBoard");
+    snprintf(context.executable, sizeof(context.executable), "%s", path);
+
+    while(fgets(line, sizeof(line), dump))
+    {
+        if(sscanf(line, "# bench %lu %lu", &cpu_hz, &kernels) == 2)
+        {
+            context.mhz_per_cpu = cpu_hz / 1e6;
+            continue;
+        }
+        if(sscanf(line, "B %47s %lu %lu %lu %lu %x %x", name, &iterations, &batches,
+                  &cycles_min, &cycles_avg, &checksum, &reference) != 7)
+            continue;
+        if(!cpu_hz || !iterations || !selected(name))
+            continue;
+
+        result = new_result(name);
+        if(!result)
+            break;
+        result->iterations = (unsigned long long)iterations * batches;
+        result->cycles = (double)cycles_avg / iterations;
+        result->cycles_min = (double)cycles_min / iterations;
+        result->real_ns = result->cycles * 1e9 / cpu_hz;
+        result->cpu_ns = result->real_ns;
+        result->checksum = checksum;
+        result->reference = reference;
+    }
+
+    if(dump != stdin)
+        fclose(dump);
+
+    if(!cpu_hz)
+    {
+        fprintf(stderr, "%s: no '# bench' header\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Reports
+ * -----------------------------------------------------------------------------
+ */
+
+static void report_console(FILE* out, const char* date)
+{
+    int width = 10, n, i;
+    bench_result_t* result;
+
+    for(n = 0; n < nb_results; n++)
+        if((int)strlen(results[n].name) > width)
+            width = (int)strlen(results[n].name);
+
+    fprintf(out, "%s\n", date);
+    fprintf(out, "Running %s\n", context.executable);
+    fprintf(out, "Run on (%d X %.0f MHz CPU%s)\n", context.num_cpus, context.mhz_per_cpu,
+            context.num_cpus > 1 ? " s" : "");
+
+    for(i = 0; i < width + 43; i++)
+        fputc('-', out);
+    fprintf(out, "\n%-*s %13s %15s %12s\n", width, "Benchmark", "Time", "CPU", "Iterations");
+    for(i = 0; i < width + 43; i++)
+        fputc('-', out);
+    fputc('\n', out);
+
+    for(n = 0; n < nb_results; n++)
+    {
+        result = &results[n];
+        if(result->checksum != result->reference)
+        {
+            fprintf(out, "%-*s ERROR OCCURRED: 'checksum 0x%08x, reference 0x%08x'\n",
+                    width, result->name, result->checksum, result->reference);
+            continue;
+        }
+        fprintf(out, "%-*s %10.2f ns %12.2f ns %12llu", width, result->name,
+                result->real_ns, result->cpu_ns, result->iterations);
+        if(context.target)
+            fprintf(out, " cycles=%.1f cycles_min=%.1f", result->cycles, result->cycles_min);
+        fputc('\n', out);
+    }
+}
+
+static void report_json(FILE* out, const char* date)
+{
+    bench_result_t* result;
+    int n;
+
+    fprintf(out, "{\n"
+                 "  \"context\": {\n"
+                 "    \"date\": \"%s\",\n"
+                 "    \"host_name\": \"%s\",\n"
+                 "    \"executable\": \"%s\",\n"
+                 "    \"num_cpus\": %d,\n"
+                 "    \"mhz_per_cpu\": %.0f,\n"
+                 "    \"library_build_type\": \"release\"\n"
+                 "  },\n"
+                 "  \"benchmarks\": [",
+            date, context.host_name, context.executable, context.num_cpus, context.mhz_per_cpu);
+
+    for(n = 0; n < nb_results; n++)
+    {
+        result = &results[n];
+        fprintf(out, "%s\n    {\n"
+                     "      \"name\": \"%s\",\n"
+                     "      \"run_name\": \"%s\",\n"
+                     "      \"run_type\": \"iteration\",\n"
+                     "      \"repetitions\": 1,\n"
+                     "      \"repetition_index\": 0,\n"
+                     "      \"threads\": 1,\n",
+                n ? "," : "", result->name, result->name);
+        if(result->checksum != result->reference)
+            fprintf(out, "      \"error_occurred\": true,\n"
+                         "      \"error_message\": \"checksum 0x%08x, reference 0x%08x\",\n",
+                    result->checksum, result->reference);
+        fprintf(out, "      \"iterations\": %llu,\n"
+                     "      \"real_time\": %.4f,\n"
+                     "      \"cpu_time\": %.4f,\n"
+                     "      \"time_unit\": \"ns\"",
+                result->iterations, result->real_ns, result->cpu_ns);
+        if(context.target)
+            fprintf(out, ",\n      \"cycles\": %.2f,\n"
+                         "      \"cycles_min\": %.2f",
+                    result->cycles, result->cycles_min);
+        fprintf(out, "\n    }");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void report(FILE* out, bench_format_t format)
+{
+    char date[32];
+    time_t t = time(NULL);
+
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&t));
+
+    if(format == BENCH_FORMAT_JSON)
+        report_json(out, date);
+    else
+        report_console(out, date);
+}
+
+static int parse_format(const char* value, bench_format_t* format)
+{
+    if(strcmp(value, "console") == 0)
+        *format = BENCH_FORMAT_CONSOLE;
+    else if(strcmp(value, "json") == 0)
+        *format = BENCH_FORMAT_JSON;
+    else
+        return -1;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    bench_format_t format = BENCH_FORMAT_CONSOLE, out_format = BENCH_FORMAT_JSON;
+    const char* out_path = NULL;
+    const char* target_path = NULL;
+    FILE* out;
+    int list = 0, failed = 0, n;
+    uint32_t k;
+
+    snprintf(context.executable, sizeof(context.executable), "%s", argv[0]);
+
+    for(n = 1; n < argc; n++)
+    {
+        if(strncmp(argv[n], "--benchmark_filter=", 19) == 0)
+        {
+            if(regcomp(&filter, argv[n] + 19, REG_EXTENDED | REG_NOSUB))
+            {
+                fprintf(stderr, "invalid filter '%s'\n", argv[n] + 19);
+                return 2;
+            }
+            filter_set = 1;
+        }
+        else if(strncmp(argv[n], "--benchmark_format=", 19) == 0 && parse_format(argv[n] + 19, &format) == 0)
+            continue;
+        else if(strncmp(argv[n], "--benchmark_out_format=", 23) == 0 && parse_format(argv[n] + 23, &out_format) == 0)
+            continue;
+        else if(strncmp(argv[n], "--benchmark_out=", 16) == 0)
+            out_path = argv[n] + 16;
+        else if(strncmp(argv[n], "--benchmark_min_time=", 21) == 0)
+            min_time = atof(argv[n] + 21);          /* "0.5" or "0.5s" */
+        else if(strcmp(argv[n], "--benchmark_list_tests") == 0 || strcmp(argv[n], "--benchmark_list_tests=true") == 0)
+            list = 1;
+        else if(strncmp(argv[n], "--target_dump=", 14) == 0)
+            target_path = argv[n] + 14;
+        else
+        {
+            fprintf(stderr, "unknown option '%s', see the header of bench_host.c\n", argv[n]);
+            return 2;
+        }
+    }
+
+    if(list)
+    {
+        for(k = 0; k < bench_nb_kernels; k++)
+            if(selected(bench_kernels[k].name))
+                printf("%s\n", bench_kernels[k].name);
+        return 0;
+    }
+
+    if(target_path)
+    {
+        if(read_target(target_path))
+            return 2;
+    }
+    else
+    {
+        run_host();
+    }
+
+    report(stdout, format);
+    if(out_path)
+    {
+        out = fopen(out_path, "w");
+        if(!out)
+        {
+            perror(out_path);
+            return 2;
+        }
+        report(out, out_format);
+        fclose(out);
+    }
+
+    for(n = 0; n < nb_results; n++)
+        if(results[n].checksum != results[n].reference)
+            failed = 1;
+
+    return failed;
+}
@@ -0,0 +1,27 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       control_host.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   FreeRTOS hooks the control code calls, for its host build into
+ *   build/libcontrol.a: configASSERT() stops the host tool where the
+ *   firmware would stop in vAssertCalled() (freertos_hooks.c).
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+void vAssertCalled(uint32_t ulLine, const char *pcFile)
+{
+    fprintf(stderr, "%s:%lu: assertion failed\n", pcFile, (unsigned long)ulLine);
+    abort();
+}
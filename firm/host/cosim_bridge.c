@@ -0,0 +1,223 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       cosim_bridge.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Mailbox between the firmware thread and the GHDL simulation, and the
+ *   LCMXO2 SPI transport of the co-simulation build of hb_lcmxo2.c
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include "cosim_bridge.h"
+
+/* Largest SPI transaction tracked by the statistics, in words */
+#define COSIM_SPI_MAX_WORDS     16
+
+static pthread_mutex_t cosim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cosim_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t cosim_firmware;
+static int cosim_started;
+
+/* Mailbox, one operation in flight */
+static struct {
+    int pending;
+    cosim_op_t op;
+    int32_t argument;
+    int32_t reply;
+    int32_t now_ns;
+} cosim_mbox;
+
+/* SPI transaction cost in simulated time, indexed by words per transaction */
+static struct {
+    int32_t start_ns;
+    uint8_t words;
+    uint32_t count[COSIM_SPI_MAX_WORDS+1];
+    uint32_t min_ns[COSIM_SPI_MAX_WORDS+1];
+    uint32_t max_ns[COSIM_SPI_MAX_WORDS+1];
+    uint64_t total_ns[COSIM_SPI_MAX_WORDS+1];
+} cosim_spi;
+
+/* -----------------------------------------------------------------------------
+ * Firmware side
+ * -----------------------------------------------------------------------------
+ */
+
+static void* cosim_firmware_thread(void* arg)
+{
+    (void) arg;
+
+    cosim_call(COSIM_OP_END, cosim_firmware_main());
+    return NULL;
+}
+
+/* Hand an operation to the simulation and wait until it is played */
+int32_t cosim_call(cosim_op_t op, int32_t argument)
+{
+    int32_t reply;
+
+    pthread_mutex_lock(&cosim_lock);
+    cosim_mbox.op = op;
+    cosim_mbox.argument = argument;
+    cosim_mbox.pending = 1;
+    pthread_cond_broadcast(&cosim_cond);
+    while(cosim_mbox.pending)
+        pthread_cond_wait(&cosim_cond, &cosim_lock);
+    reply = cosim_mbox.reply;
+    pthread_mutex_unlock(&cosim_lock);
+
+    return reply;
+}
+
+/* Simulated time, the simulation is stopped while the firmware runs */
+int32_t cosim_now_ns(void)
+{
+    int32_t now;
+
+    pthread_mutex_lock(&cosim_lock);
+    now = cosim_mbox.now_ns;
+    pthread_mutex_unlock(&cosim_lock);
+
+    return now;
+}
+
+void cosim_delay_us(uint32_t us)
+{
+    cosim_call(COSIM_OP_DELAY, (int32_t)(us * 1000));
+}
+
+/* Same as LCMXO2_RESET_WRITE() on the target */
+void cosim_lcmxo2_reset(int active)
+{
+    cosim_call(COSIM_OP_RESET, active);
+}
+
+/* LCMXO2 IRQ_O pulses since the start, the target counts EXTI interrupts */
+int32_t cosim_irq_count(void)
+{
+    return cosim_call(COSIM_OP_IRQ, 0);
+}
+
+void cosim_spi_report(void)
+{
+    uint8_t words;
+
+    printf("LCMXO2 SPI transactions (simulated time):\n");
+    printf("  words   count     min ns     avg ns     max ns\n");
+    for(words = 0; words <= COSIM_SPI_MAX_WORDS; words++)
+    {
+        if(cosim_spi.count[words] == 0)
+            continue;
+        printf("  %5u %7u %10u %10u %10u\n",
+               words, cosim_spi.count[words], cosim_spi.min_ns[words],
+               (uint32_t)(cosim_spi.total_ns[words] / cosim_spi.count[words]),
+               cosim_spi.max_ns[words]);
+    }
+}
+
+/* -----------------------------------------------------------------------------
+ * LCMXO2 transport (see hb_lcmxo2.c, HB_LCMXO2_COSIM)
+ * -----------------------------------------------------------------------------
+ */
+
+void hb_lcmxo2_setup(void)
+{
+    cosim_lcmxo2_reset(1);
+}
+
+void hb_lcmxo2_reset(uint8_t active)
+{
+    cosim_lcmxo2_reset(active);
+}
+
+void hb_lcmxo2_delay_us(uint32_t us)
+{
+    cosim_delay_us(us);
+}
+
+void hb_lcmxo2_select(void)
+{
+    cosim_spi.start_ns = cosim_now_ns();
+    cosim_spi.words = 0;
+    cosim_call(COSIM_OP_SELECT, 0);
+}
+
+uint16_t hb_lcmxo2_tx_rx(uint16_t value)
+{
+    if(cosim_spi.words < COSIM_SPI_MAX_WORDS)
+        cosim_spi.words++;
+    return (uint16_t)cosim_call(COSIM_OP_WORD, value);
+}
+
+void hb_lcmxo2_deselect(void)
+{
+    uint32_t duration;
+    uint8_t words = cosim_spi.words;
+
+    cosim_call(COSIM_OP_DESELECT, 0);
+
+    duration = (uint32_t)(cosim_now_ns() - cosim_spi.start_ns);
+    if(cosim_spi.count[words] == 0 || duration < cosim_spi.min_ns[words])
+        cosim_spi.min_ns[words] = duration;
+    if(duration > cosim_spi.max_ns[words])
+        cosim_spi.max_ns[words] = duration;
+    cosim_spi.total_ns[words] += duration;
+    cosim_spi.count[words]++;
+}
+
+/* -----------------------------------------------------------------------------
+ * Simulation side, called by cosim_top.vhd through VHPIDIRECT
+ * -----------------------------------------------------------------------------
+ */
+
+/* Blocks until the firmware hands the next operation */
+int32_t cosim_request(int32_t now_ns)
+{
+    cosim_op_t op;
+
+    pthread_mutex_lock(&cosim_lock);
+    cosim_mbox.now_ns = now_ns;
+    if(!cosim_started)
+    {
+        cosim_started = 1;
+        if(pthread_create(&cosim_firmware, NULL, cosim_firmware_thread, NULL) != 0)
+        {
+            cosim_mbox.argument = 1;
+            pthread_mutex_unlock(&cosim_lock);
+            fprintf(stderr, "cosim: cannot start the firmware thread\n");
+            return COSIM_OP_END;
+        }
+    }
+    while(!cosim_mbox.pending)
+        pthread_cond_wait(&cosim_cond, &cosim_lock);
+    op = cosim_mbox.op;
+    pthread_mutex_unlock(&cosim_lock);
+
+    return op;
+}
+
+int32_t cosim_argument(void)
+{
+    return cosim_mbox.argument;
+}
+
+/* Completes the pending operation and resumes the firmware */
+int32_t cosim_reply(int32_t value, int32_t now_ns)
+{
+    pthread_mutex_lock(&cosim_lock);
+    cosim_mbox.reply = value;
+    cosim_mbox.now_ns = now_ns;
+    cosim_mbox.pending = 0;
+    pthread_cond_broadcast(&cosim_cond);
+    pthread_mutex_unlock(&cosim_lock);
+
+    return 0;
+}
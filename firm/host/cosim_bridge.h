@@ -0,0 +1,57 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       cosim_bridge.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Co-simulation of the firmware against the GHDL model of the LCMXO2.
+ *   The firmware runs in its own thread; each SPI operation is handed to
+ *   the simulation (cosim_top.vhd), which plays it on the HOLOBOARD pins
+ *   and hands the result back. Only one side runs at a time, so the
+ *   firmware sees the simulated time advance by the cost of its accesses.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __COSIM_BRIDGE_H
+#define __COSIM_BRIDGE_H
+
+#include <stdint.h>
+
+/* Operations handed to the simulation, keep in sync with cosim_pkg.vhd */
+typedef enum {
+    COSIM_OP_SELECT     = 1,
+    COSIM_OP_WORD       = 2,
+    COSIM_OP_DESELECT   = 3,
+    COSIM_OP_DELAY      = 4,
+    COSIM_OP_RESET      = 5,
+    COSIM_OP_END        = 6,
+    COSIM_OP_IRQ        = 7
+} cosim_op_t;
+
+/* Firmware side */
+int32_t cosim_call(cosim_op_t op, int32_t argument);
+int32_t cosim_now_ns(void);
+void cosim_delay_us(uint32_t us);
+void cosim_lcmxo2_reset(int active);
+void cosim_spi_report(void);
+int32_t cosim_irq_count(void);
+
+/* Motor model, encoder position in counts of the LCMXO2 decoder */
+int32_t cosim_plant_counts(uint16_t channel);
+
+/* Firmware scenario, returns the number of errors */
+int cosim_firmware_main(void);
+
+/* Simulation side (VHPIDIRECT) */
+int32_t cosim_request(int32_t now_ns);
+int32_t cosim_argument(void);
+int32_t cosim_reply(int32_t value, int32_t now_ns);
+int32_t cosim_plant(int32_t channel, int32_t drive, int32_t samples);
+
+#endif /* __COSIM_BRIDGE_H */
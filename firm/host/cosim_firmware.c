@@ -0,0 +1,209 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       cosim_firmware.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Firmware side of the co-simulation: LCMXO2 start-up as done by
+ *   motion_cs.c, register file checks, an open-loop drive of the motors
+ *   and a run of the FPGA velocity loop, through the unmodified hb_lcmxo2.c
+ *   driver
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include "holoboard.h"
+#include "cosim_bridge.h"
+
+/* Open-loop drive: control period and duration */
+#define COSIM_CONTROL_PERIOD_US     500
+#define COSIM_CONTROL_STEPS         20
+
+/* Smallest displacement expected from the driven motors, in counts */
+#define COSIM_MIN_COUNTS            10
+
+/* FPGA encoder sampling: period and samples checked */
+#define COSIM_SAMPLE_PERIOD_US      100
+#define COSIM_SAMPLES               3
+
+/* FPGA velocity loop: reference of 1 count per loop period (1/256 count
+ * units), half the plant no-load speed, settling and measure times */
+#define COSIM_VEL_PERIOD_US         100
+#define COSIM_VEL_REF               256
+#define COSIM_VEL_SETTLE_US         10000
+#define COSIM_VEL_MEASURE_US        5000
+#define COSIM_VEL_COUNTS            (COSIM_VEL_MEASURE_US / COSIM_VEL_PERIOD_US)
+
+static int errors;
+
+static void cosim_check(int condition, const char* what, int32_t got, int32_t expected)
+{
+    if(!condition)
+    {
+        printf("cosim: %s: got %d, expected %d (t = %d ns)\n", what, got, expected, cosim_now_ns());
+        errors++;
+    }
+}
+
+/* The snapshot may miss the last encoder edge, one count of slack */
+static void cosim_check_qei(uint16_t channel, int16_t qei)
+{
+    int32_t expected = cosim_plant_counts(channel) & 0x0FFF;
+    uint16_t diff = (uint16_t)(qei - expected) & 0x0FFF;
+
+    cosim_check(diff == 0 || diff == 1 || diff == 0x0FFF, "QEI counter", qei, expected);
+}
+
+/* Register read, every burst of the co-simulation has to pass its CRC */
+static uint16_t cosim_read(uint8_t address, uint16_t* data, uint8_t length)
+{
+    uint16_t status = 0;
+
+    cosim_check(hb_lcmxo2_read(address, data, length, &status) == SUCCESS, "read burst CRC", address, 0);
+    return status;
+}
+
+int cosim_firmware_main(void)
+{
+    uint16_t pwm_config[HB_LCMXO2_NB_CHANNELS];
+    uint16_t data[HB_LCMXO2_NB_CHANNELS];
+    uint16_t status;
+    int16_t start[HB_LCMXO2_NB_CHANNELS];
+    int16_t qei, counters[HB_LCMXO2_NB_CHANNELS], refs[HB_LCMXO2_NB_CHANNELS];
+    int32_t irqs;
+    uint8_t i, step;
+
+    /* Start-up sequence of hb_init() and motion_cs_task() */
+    cosim_check(hb_lcmxo2_init() == HB_LCMXO2_READY, "LCMXO2 start-up", hb_lcmxo2_get_state(), HB_LCMXO2_READY);
+    cosim_check(hb_lcmxo2_get_id() == HB_LCMXO2_ID(HB_LCMXO2_ID_MAGIC, HB_LCMXO2_ID_VERSION), "ID",
+                hb_lcmxo2_get_id(), HB_LCMXO2_ID(HB_LCMXO2_ID_MAGIC, HB_LCMXO2_ID_VERSION));
+    cosim_check(HB_LCMXO2_CAPS_CHANNELS(hb_lcmxo2_get_caps()) == HB_LCMXO2_NB_CHANNELS, "CAPS channels",
+                HB_LCMXO2_CAPS_CHANNELS(hb_lcmxo2_get_caps()), HB_LCMXO2_NB_CHANNELS);
+    printf("cosim: LCMXO2 ready at %d us\n", cosim_now_ns() / 1000);
+
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        pwm_config[i] = HB_LCMXO2_PWM_PERIOD;
+    hb_lcmxo2_write(HB_LCMXO2_REG_PWM_PERIOD(0), pwm_config, HB_LCMXO2_NB_CHANNELS);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        pwm_config[i] = HB_LCMXO2_PWM_DEADBAND;
+    hb_lcmxo2_write(HB_LCMXO2_REG_PWM_DEADBAND(0), pwm_config, HB_LCMXO2_NB_CHANNELS);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        pwm_config[i] = HB_LCMXO2_PWM_SLEW;
+    hb_lcmxo2_write(HB_LCMXO2_REG_PWM_SLEW(0), pwm_config, HB_LCMXO2_NB_CHANNELS);
+    hb_lcmxo2_set_qei_filter(HB_LCMXO2_QEI_FILTER);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        hb_lcmxo2_set_pwm(i, 0);
+    hb_lcmxo2_set_pwm_enable(ENABLE);
+
+    /* Register file */
+    status = cosim_read(HB_LCMXO2_REG_PWM_PERIOD(0), data, HB_LCMXO2_NB_CHANNELS);
+    cosim_check(status & HB_LCMXO2_STATUS_PWM_EN, "STATUS.PWM_EN", status, HB_LCMXO2_STATUS_PWM_EN);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        cosim_check(data[i] == HB_LCMXO2_PWM_PERIOD, "PWM period", data[i], HB_LCMXO2_PWM_PERIOD);
+    cosim_read(HB_LCMXO2_REG_PWM_DEADBAND(0), data, HB_LCMXO2_NB_CHANNELS);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        cosim_check(data[i] == HB_LCMXO2_PWM_DEADBAND, "PWM dead-band", data[i], HB_LCMXO2_PWM_DEADBAND);
+    cosim_read(HB_LCMXO2_REG_PWM_SLEW(0), data, HB_LCMXO2_NB_CHANNELS);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        cosim_check(data[i] == HB_LCMXO2_PWM_SLEW, "PWM slew", data[i], HB_LCMXO2_PWM_SLEW);
+
+    /* The open loop steps are shorter than a full slew ramp */
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        hb_lcmxo2_set_pwm_slew(i, 0);
+    cosim_read(HB_LCMXO2_REG_QEI_FILTER, data, 1);
+    cosim_check(data[0] == HB_LCMXO2_QEI_FILTER, "QEI filter", data[0], HB_LCMXO2_QEI_FILTER);
+
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+    {
+        start[i] = hb_lcmxo2_get_qei(i);
+        cosim_check_qei(i, start[i]);
+    }
+
+    /* Open loop: forward, reverse and still */
+    hb_lcmxo2_set_pwm(0, HB_LCMXO2_PWM_MAX / 2);
+    hb_lcmxo2_set_pwm(1, -HB_LCMXO2_PWM_MAX / 2);
+    hb_lcmxo2_set_pwm(2, 0);
+    for(step=0;step<COSIM_CONTROL_STEPS;step++)
+    {
+        cosim_delay_us(COSIM_CONTROL_PERIOD_US);
+        for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+            cosim_check_qei(i, hb_lcmxo2_get_qei(i));
+    }
+
+    /* Same snapshot through one burst */
+    cosim_read(HB_LCMXO2_REG_QEI(0), data, HB_LCMXO2_NB_CHANNELS);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        cosim_check_qei(i, data[i] & 0x0FFF);
+
+    /* Encoder follows the drive sign */
+    qei = (int16_t)((hb_lcmxo2_get_qei(0) - start[0]) << 4) / 16;
+    cosim_check(qei >= COSIM_MIN_COUNTS, "forward displacement", qei, COSIM_MIN_COUNTS);
+    qei = (int16_t)((hb_lcmxo2_get_qei(1) - start[1]) << 4) / 16;
+    cosim_check(qei <= -COSIM_MIN_COUNTS, "reverse displacement", qei, -COSIM_MIN_COUNTS);
+    qei = (int16_t)((hb_lcmxo2_get_qei(2) - start[2]) << 4) / 16;
+    cosim_check(qei == 0, "still displacement", qei, 0);
+
+    /* The plant only makes legal transitions */
+    cosim_read(HB_LCMXO2_REG_QEI_ERR(0), data, HB_LCMXO2_NB_CHANNELS);
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+        cosim_check(data[i] == 0, "QEI errors", data[i], 0);
+
+    /* Emergency stop: pre-built burst, latched until cleared */
+    hb_lcmxo2_emergency_stop();
+    status = cosim_read(HB_LCMXO2_REG_STATUS, data, 1);
+    cosim_check(!(status & HB_LCMXO2_STATUS_PWM_EN), "emergency stop", status, 0);
+    hb_lcmxo2_set_pwm_enable(ENABLE);
+    status = cosim_read(HB_LCMXO2_REG_STATUS, data, 1);
+    cosim_check(!(status & HB_LCMXO2_STATUS_PWM_EN), "enable after stop", status, 0);
+    hb_lcmxo2_clear_stop();
+    hb_lcmxo2_set_pwm_enable(ENABLE);
+    status = cosim_read(HB_LCMXO2_REG_STATUS, data, 1);
+    cosim_check(status & HB_LCMXO2_STATUS_PWM_EN, "enable after clear", status, HB_LCMXO2_STATUS_PWM_EN);
+
+    /* Encoder sampling: one IRQ pulse per sample, STATUS.SAMPLE until read */
+    irqs = cosim_irq_count();
+    hb_lcmxo2_set_sample(COSIM_SAMPLE_PERIOD_US, HB_LCMXO2_IRQ_SAMPLE);
+    cosim_delay_us(COSIM_SAMPLE_PERIOD_US * COSIM_SAMPLES + COSIM_SAMPLE_PERIOD_US / 2);
+    irqs = cosim_irq_count() - irqs;
+    cosim_check(irqs == COSIM_SAMPLES, "sample interrupts", irqs, COSIM_SAMPLES);
+    cosim_check(hb_lcmxo2_get_qei_all(counters, &status) == SUCCESS, "QEI burst CRC", 0, 0);
+    cosim_check(status & HB_LCMXO2_STATUS_SAMPLE, "STATUS.SAMPLE", status, HB_LCMXO2_STATUS_SAMPLE);
+    status = cosim_read(HB_LCMXO2_REG_STATUS, data, 1);
+    cosim_check(!(status & HB_LCMXO2_STATUS_SAMPLE), "STATUS.SAMPLE after read", status, 0);
+    hb_lcmxo2_set_sample(0, 0);
+
+    /* Velocity loop on channel 0, the other references are zero */
+    for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+    {
+        hb_lcmxo2_set_vel_gains(i, 400, 20);
+        refs[i] = 0;
+    }
+    refs[0] = COSIM_VEL_REF;
+    hb_lcmxo2_set_vel_ref_all(refs);
+    hb_lcmxo2_set_vel_loop(COSIM_VEL_PERIOD_US, ENABLE);
+    status = cosim_read(HB_LCMXO2_REG_STATUS, data, 1);
+    cosim_check(status & HB_LCMXO2_STATUS_VEL_EN, "STATUS.VEL_EN", status, HB_LCMXO2_STATUS_VEL_EN);
+    cosim_delay_us(COSIM_VEL_SETTLE_US);
+    start[0] = hb_lcmxo2_get_qei(0);
+    cosim_delay_us(COSIM_VEL_MEASURE_US);
+    qei = (int16_t)((hb_lcmxo2_get_qei(0) - start[0]) << 4) / 16;
+    cosim_check(qei >= COSIM_VEL_COUNTS * 3 / 4 && qei <= COSIM_VEL_COUNTS * 5 / 4,
+                "velocity loop", qei, COSIM_VEL_COUNTS);
+    hb_lcmxo2_set_vel_loop(COSIM_VEL_PERIOD_US, DISABLE);
+
+    /* Bridges braked */
+    hb_lcmxo2_set_pwm_enable(DISABLE);
+    status = cosim_read(HB_LCMXO2_REG_STATUS, data, 1);
+    cosim_check(!(status & HB_LCMXO2_STATUS_PWM_EN), "STATUS.PWM_EN", status, 0);
+
+    cosim_spi_report();
+    printf("cosim: %d error(s), %d us simulated\n", errors, cosim_now_ns() / 1000);
+
+    return errors;
+}
@@ -0,0 +1,66 @@
+LIBRARY ieee;
+USE ieee.std_logic_1164.ALL;
+
+-- Foreign functions of the co-simulation bridge, implemented in
+-- cosim_bridge.c and cosim_plant.c (GHDL VHPIDIRECT).
+-- Times are exchanged in ns as INTEGER, which limits a run to 2.1 s of
+-- simulated time.
+
+PACKAGE COSIM_PKG IS
+
+	-- Operations requested by the firmware (see cosim_bridge.h)
+	CONSTANT C_OP_SELECT	: INTEGER := 1;											-- SS low
+	CONSTANT C_OP_WORD		: INTEGER := 2;											-- exchange one word, argument = MOSI word
+	CONSTANT C_OP_DESELECT	: INTEGER := 3;											-- SS high
+	CONSTANT C_OP_DELAY		: INTEGER := 4;											-- argument = ns
+	CONSTANT C_OP_RESET		: INTEGER := 5;											-- argument = LCMXO2 reset level
+	CONSTANT C_OP_END		: INTEGER := 6;											-- argument = firmware error count
+	CONSTANT C_OP_IRQ		: INTEGER := 7;											-- reply = IRQ_O pulses so far
+
+	-- Wait for the next firmware operation, returns C_OP_xxx
+	IMPURE FUNCTION cosim_request(now_ns : INTEGER) RETURN INTEGER;
+	ATTRIBUTE foreign OF cosim_request : FUNCTION IS "VHPIDIRECT cosim_request";
+
+	-- Argument of the pending operation
+	IMPURE FUNCTION cosim_argument RETURN INTEGER;
+	ATTRIBUTE foreign OF cosim_argument : FUNCTION IS "VHPIDIRECT cosim_argument";
+
+	-- Complete the pending operation, value = MISO word of C_OP_WORD
+	IMPURE FUNCTION cosim_reply(value : INTEGER; now_ns : INTEGER) RETURN INTEGER;
+	ATTRIBUTE foreign OF cosim_reply : FUNCTION IS "VHPIDIRECT cosim_reply";
+
+	-- Advance the motor model of a channel, drive = sum over the samples
+	-- of the bridge state (+1 forward, -1 reverse, 0 brake). Returns the
+	-- encoder position in quadrature edges.
+	IMPURE FUNCTION cosim_plant(channel : INTEGER; drive : INTEGER; samples : INTEGER) RETURN INTEGER;
+	ATTRIBUTE foreign OF cosim_plant : FUNCTION IS "VHPIDIRECT cosim_plant";
+
+END COSIM_PKG;
+
+PACKAGE BODY COSIM_PKG IS
+
+	IMPURE FUNCTION cosim_request(now_ns : INTEGER) RETURN INTEGER IS
+	BEGIN
+		REPORT "VHPIDIRECT cosim_request" SEVERITY FAILURE;
+		RETURN 0;
+	END FUNCTION;
+
+	IMPURE FUNCTION cosim_argument RETURN INTEGER IS
+	BEGIN
+		REPORT "VHPIDIRECT cosim_argument" SEVERITY FAILURE;
+		RETURN 0;
+	END FUNCTION;
+
+	IMPURE FUNCTION cosim_reply(value : INTEGER; now_ns : INTEGER) RETURN INTEGER IS
+	BEGIN
+		REPORT "VHPIDIRECT cosim_reply" SEVERITY FAILURE;
+		RETURN 0;
+	END FUNCTION;
+
+	IMPURE FUNCTION cosim_plant(channel : INTEGER; drive : INTEGER; samples : INTEGER) RETURN INTEGER IS
+	BEGIN
+		REPORT "VHPIDIRECT cosim_plant" SEVERITY FAILURE;
+		RETURN 0;
+	END FUNCTION;
+
+END COSIM_PKG;
@@ -0,0 +1,70 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       cosim_plant.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Motor and encoder model of the co-simulation: first order DC motor
+ *   driven by the DRV8872 bridge outputs, position in quadrature edges
+ *   (4 per encoder cycle). Rough figures of the wheel motors, enough to
+ *   check signs and the protocol, not to tune the control loop.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include "cosim_bridge.h"
+
+#define COSIM_PLANT_CHANNELS        3
+#define COSIM_PLANT_SAMPLE_HZ       133.0e6     /* cosim_top.vhd C_PLANT_CLK */
+#define COSIM_PLANT_SPEED_MAX       20000.0     /* no-load speed, edges/s at full drive */
+#define COSIM_PLANT_TAU             5.0e-3      /* mechanical time constant, s */
+
+static struct {
+    double speed;       /* edges/s */
+    double position;    /* edges */
+} cosim_plant_state[COSIM_PLANT_CHANNELS];
+
+/**
+  * @brief  Advance the model of one motor, called by cosim_top.vhd
+  * @param  channel: motor channel
+  * @param  drive: sum of the bridge state over the samples, +1 forward,
+  *         -1 reverse, 0 brake
+  * @param  samples: number of samples of the step
+  * @retval Encoder position, in edges
+  */
+int32_t cosim_plant(int32_t channel, int32_t drive, int32_t samples)
+{
+    double dt, target;
+
+    if(channel < 0 || channel >= COSIM_PLANT_CHANNELS || samples <= 0)
+        return 0;
+
+    dt = samples / COSIM_PLANT_SAMPLE_HZ;
+    target = COSIM_PLANT_SPEED_MAX * drive / samples;
+
+    /* Exact step of the first order response, the drive is constant over dt */
+    cosim_plant_state[channel].speed = target + (cosim_plant_state[channel].speed - target) * exp(-dt / COSIM_PLANT_TAU);
+    cosim_plant_state[channel].position += cosim_plant_state[channel].speed * dt;
+
+    return (int32_t)floor(cosim_plant_state[channel].position);
+}
+
+/**
+  * @brief  Counter expected from the LCMXO2 decoder, which counts every
+  *         edge (QEI.vhd), starting from the reset position
+  * @param  channel: encoder channel
+  * @retval Encoder position, in counts
+  */
+int32_t cosim_plant_counts(uint16_t channel)
+{
+    if(channel >= COSIM_PLANT_CHANNELS)
+        return 0;
+
+    return (int32_t)floor(cosim_plant_state[channel].position);
+}
@@ -0,0 +1,143 @@
+LIBRARY ieee;
+USE ieee.std_logic_1164.ALL;
+USE ieee.numeric_std.ALL;
+LIBRARY work;
+USE work.holoboard_pkg.ALL;
+USE work.spi_master_bfm_pkg.ALL;
+USE work.cosim_pkg.ALL;
+
+-- Co-simulation top: HOLOBOARD driven by the host build of the firmware.
+-- Every SPI operation of hb_lcmxo2.c is played on the pins by the SPI
+-- master BFM, the encoder inputs come from the motor model of
+-- cosim_plant.c fed with the bridge outputs. IRQ_O pulses are counted
+-- for the firmware.
+-- Built and run by "make" from firm/host.
+
+ENTITY COSIM_TOP IS
+	GENERIC (
+		G_SPI_KHZ	: POSITIVE := 12000												-- SCLK, see HB_LCMXO2_SPI_PRESCALER
+		);
+END COSIM_TOP;
+
+ARCHITECTURE BEHAVIOR OF COSIM_TOP IS
+	COMPONENT HOLOBOARD IS
+		GENERIC (
+			G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+			);
+		PORT (
+			RESET_I		: IN  	STD_LOGIC;
+			SPI_CLK_I   : IN	STD_LOGIC;
+			SPI_SS_I    : IN 	STD_LOGIC;
+			SPI_MOSI_I  : IN	STD_LOGIC;
+			SPI_MISO_O	: OUT	STD_LOGIC;
+			QE_CHA_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			QE_CHB_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			PWM_IN1_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			PWM_IN2_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			IRQ_O		: OUT	STD_LOGIC
+			);
+	END COMPONENT;
+
+	CONSTANT SPI_PERIOD : TIME := 1 ms / G_SPI_KHZ;
+	CONSTANT C_PLANT_CLK : TIME := 1 us / 133.0;											-- bridge outputs sampling
+	CONSTANT C_PLANT_SAMPLES : INTEGER := 133;											-- motor model step, 1 us
+
+	SIGNAL reset, spi_ss : std_logic := '1';
+	SIGNAL spi_clk, spi_mosi, spi_miso : std_logic := '0';
+	SIGNAL plant_clk : std_logic := '0';
+	SIGNAL sim_done : boolean := false;
+	SIGNAL qe_a, qe_b : std_logic_vector(0 TO C_NB_CHANNELS-1) := (OTHERS => '0');
+	SIGNAL in1, in2 : std_logic_vector(0 TO C_NB_CHANNELS-1);
+	SIGNAL irq : std_logic;
+	SIGNAL irq_count : INTEGER := 0;
+
+BEGIN
+	UUT : HOLOBOARD
+	PORT MAP ( 	RESET_I => reset,
+				SPI_CLK_I => spi_clk,
+				SPI_SS_I => spi_ss,
+				SPI_MOSI_I => spi_mosi,
+				SPI_MISO_O => spi_miso,
+				QE_CHA_I => qe_a,
+				QE_CHB_I => qe_b,
+				PWM_IN1_O => in1,
+				PWM_IN2_O => in2,
+				IRQ_O => irq);
+
+	PROCESS(irq)
+	BEGIN
+		IF (rising_edge(irq)) THEN
+			irq_count <= irq_count + 1;
+		END IF;
+	END PROCESS;
+
+	plant_clk <= not plant_clk AFTER C_PLANT_CLK/2 WHEN not sim_done ELSE '0';
+
+	-- Motor model: average the bridge state over each step, encoder
+	-- position back as a Gray sequence (A,B): 00 -> 10 -> 11 -> 01
+	PROCESS(plant_clk)
+		VARIABLE drive : INTEGER_VECTOR(0 TO C_NB_CHANNELS-1) := (OTHERS => 0);
+		VARIABLE samples : INTEGER := 0;
+		VARIABLE state : INTEGER;
+	BEGIN
+		IF (rising_edge(plant_clk)) THEN
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				-- DRV8872: IN1 low = forward, IN2 low = reverse, both high = brake
+				IF (in1(i) = '0' and in2(i) = '1') THEN
+					drive(i) := drive(i) + 1;
+				ELSIF (in1(i) = '1' and in2(i) = '0') THEN
+					drive(i) := drive(i) - 1;
+				END IF;
+			END LOOP;
+			samples := samples + 1;
+			IF (samples = C_PLANT_SAMPLES) THEN
+				FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+					state := cosim_plant(i, drive(i), samples) MOD 4;
+					IF (state = 1 or state = 2) THEN qe_a(i) <= '1'; ELSE qe_a(i) <= '0'; END IF;
+					IF (state = 2 or state = 3) THEN qe_b(i) <= '1'; ELSE qe_b(i) <= '0'; END IF;
+				END LOOP;
+				drive := (OTHERS => 0);
+				samples := 0;
+			END IF;
+		END IF;
+	END PROCESS;
+
+	-- MCU side: play the firmware SPI operations until it ends
+	PROCESS
+		VARIABLE op, reply, dummy : INTEGER;
+		VARIABLE rx : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	BEGIN
+		LOOP
+			op := cosim_request(now / 1 ns);
+			reply := 0;
+			IF (op = C_OP_SELECT) THEN
+				spi_select(SPI_PERIOD, spi_ss);
+			ELSIF (op = C_OP_WORD) THEN
+				spi_word(std_logic_vector(to_unsigned(cosim_argument, 16)), rx, SPI_PERIOD, spi_clk, spi_mosi, spi_miso);
+				reply := to_integer(unsigned(rx));
+			ELSIF (op = C_OP_DESELECT) THEN
+				spi_deselect(SPI_PERIOD, spi_ss);
+			ELSIF (op = C_OP_DELAY) THEN
+				WAIT FOR cosim_argument * 1 ns;
+			ELSIF (op = C_OP_RESET) THEN
+				IF (cosim_argument /= 0) THEN reset <= '1'; ELSE reset <= '0'; END IF;
+				WAIT FOR 0 ns;
+			ELSIF (op = C_OP_IRQ) THEN
+				reply := irq_count;
+			ELSIF (op = C_OP_END) THEN
+				reply := cosim_argument;
+				EXIT;
+			ELSE
+				REPORT "unknown co-simulation operation " & integer'image(op) SEVERITY FAILURE;
+			END IF;
+			dummy := cosim_reply(reply, now / 1 ns);
+		END LOOP;
+
+		dummy := cosim_reply(0, now / 1 ns);
+		sim_done <= true;
+		tb_end("COSIM_TOP", reply);
+		std.env.finish;
+		WAIT;
+	END PROCESS;
+
+END BEHAVIOR;
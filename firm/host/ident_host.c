@@ -0,0 +1,180 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       ident_host.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Host check of the wheels feed-forward identification, motion_ident_cycle()
+ *   of build/libcontrol.a, against simulated wheels:
+ *
+ *     build/ident [-v]
+ *
+ *   Each wheel is a first order motor behind a dead zone: it does not turn
+ *   under ks, and above it goes to gain*(pwm - ks) ticks per period with a
+ *   time constant of tau periods. The feed-forward of such a wheel is
+ *   KV = 100/gain, KA = 100*tau/gain and KS = ks, the ramp looking for KS
+ *   overshooting it by a few steps.
+ *
+ *   The cases give the three wheels different plants, so that a value
+ *   landing on the wrong wheel fails, and a wheel whose dead zone is out of
+ *   reach has to end the identification as MOTION_IDENT_FAILED. Exits
+ *   non-zero when a case fails.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "motion_control.h"
+
+#if !HB_LCMXO2_VEL_LOOP
+
+#define IDENT_SUBSTEPS          100         /* plant steps per control period */
+#define IDENT_PERIODS_MAX       2000        /* the identification has to end before */
+#define IDENT_TOLERANCE         0.10        /* KV and KA, relative */
+#define IDENT_KS_MARGIN         24          /* KS, PWM above ks, the ramp overshoots */
+
+typedef struct {
+    double ks;                              /* dead zone, PWM */
+    double gain;                            /* ticks per period per PWM */
+    double tau;                             /* time constant, periods */
+} ident_plant_t;
+
+typedef struct {
+    const char* name;
+    ident_plant_t plant[PID_WHEELS];
+    motion_ident_phase_t expected;
+} ident_case_t;
+
+static const ident_case_t ident_cases[] = {
+    { "nominal",        { { 100, 0.20, 2.0 }, { 100, 0.20, 2.0 }, { 100, 0.20, 2.0 } }, MOTION_IDENT_DONE },
+    { "mixed wheels",   { {  40, 0.30, 1.0 }, { 150, 0.15, 3.0 }, {  80, 0.25, 5.0 } }, MOTION_IDENT_DONE },
+    { "no friction",    { {   0, 0.20, 2.0 }, {   0, 0.10, 0.5 }, {   0, 0.40, 4.0 } }, MOTION_IDENT_DONE },
+    { "stuck wheel",    { { 100, 0.20, 2.0 }, { 600, 0.20, 2.0 }, { 100, 0.20, 2.0 } }, MOTION_IDENT_FAILED }
+};
+#define IDENT_CASES             (sizeof(ident_cases) / sizeof(ident_cases[0]))
+
+static int ident_verbose;
+
+/* One control period of a wheel, the PWM held */
+static void ident_plant_step(const ident_plant_t* plant, int32_t pwm, double* speed, double* position)
+{
+    double drive;
+    int step;
+
+    for(step = 0; step < IDENT_SUBSTEPS; step++)
+    {
+        if(abs(pwm) <= plant->ks)
+            drive = 0;
+        else
+            drive = plant->gain * (pwm > 0 ? pwm - plant->ks : pwm + plant->ks);
+
+        *speed += (drive - *speed) / (plant->tau * IDENT_SUBSTEPS);
+        *position += *speed / IDENT_SUBSTEPS;
+    }
+}
+
+/* Identified value within [low, high] */
+static int ident_check(const char* name, int wheel, const char* value, int32_t got, double low, double high)
+{
+    int ok = (got >= floor(low)) && (got <= ceil(high));
+
+    if(!ok || ident_verbose)
+        printf("  %-14s wheel %d %s %5ld, expected %7.1f to %7.1f%s\n",
+               name, wheel, value, (long)got, low, high, ok ? "" : "  FAILED");
+    return ok;
+}
+
+static int ident_run(const ident_case_t* test)
+{
+    motion_ident_t ident;
+    int32_t position[PID_WHEELS] = { 0 }, pwm[PID_WHEELS] = { 0 };
+    double speed[PID_WHEELS] = { 0 }, travel[PID_WHEELS] = { 0 };
+    const ident_plant_t* plant;
+    double kv, ka;
+    uint32_t periods = 0;
+    int wheel, ok = 1;
+
+    motion_ident_start(&ident, position);
+    while(motion_ident_cycle(&ident, position, pwm))
+    {
+        if(++periods > IDENT_PERIODS_MAX)
+        {
+            printf("  %-14s still running after %d periods, phase %d  FAILED\n", test->name, IDENT_PERIODS_MAX, ident.phase);
+            return 0;
+        }
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        {
+            ident_plant_step(&test->plant[wheel], pwm[wheel], &speed[wheel], &travel[wheel]);
+            position[wheel] = (int32_t)travel[wheel];
+        }
+    }
+
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+    {
+        if(pwm[wheel] != 0)
+        {
+            printf("  %-14s wheel %d left at PWM %ld  FAILED\n", test->name, wheel, (long)pwm[wheel]);
+            ok = 0;
+        }
+    }
+
+    if(ident.phase != test->expected)
+    {
+        printf("  %-14s ended in phase %d after %lu periods, expected %d  FAILED\n",
+               test->name, ident.phase, (unsigned long)periods, test->expected);
+        return 0;
+    }
+    if(test->expected == MOTION_IDENT_FAILED)
+        return ok && !ident.valid;
+
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+    {
+        plant = &test->plant[wheel];
+        kv = 100.0 / plant->gain;
+        ka = kv * plant->tau;
+        ok &= ident_check(test->name, wheel, "KV", ident.KV[wheel], kv * (1 - IDENT_TOLERANCE), kv * (1 + IDENT_TOLERANCE));
+        ok &= ident_check(test->name, wheel, "KA", ident.KA[wheel], ka * (1 - IDENT_TOLERANCE), ka * (1 + IDENT_TOLERANCE));
+        ok &= ident_check(test->name, wheel, "KS", ident.KS[wheel], plant->ks, plant->ks + IDENT_KS_MARGIN);
+    }
+    return ok && ident.valid;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int n, failed = 0;
+
+    ident_verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+
+    for(n = 0; n < IDENT_CASES; n++)
+    {
+        if(ident_run(&ident_cases[n]))
+            printf("%-16s ok\n", ident_cases[n].name);
+        else
+        {
+            printf("%-16s FAILED\n", ident_cases[n].name);
+            failed++;
+        }
+    }
+    printf("%u case(s), %u failed\n", (unsigned int)IDENT_CASES, failed);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#else
+
+int main(void)
+{
+    printf("HB_LCMXO2_VEL_LOOP: no feed-forward identification, nothing to check\n");
+    return EXIT_SUCCESS;
+}
+
+#endif /* !HB_LCMXO2_VEL_LOOP */
@@ -0,0 +1,327 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       replay_host.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Replays the output of the shell 'replay dump' command (see replay.c)
+ *   through motion_control.c and pid.c built for the host, cycle by cycle:
+ *
+ *     build/replay [--csv=<file>] [dump.txt]
+ *
+ *   Each cycle gets the recorded counters and references, the wheel
+ *   commands are compared with the recorded ones. Reports the cycles that
+ *   diverge, the first one in detail, and the host cost of the cycles.
+ *   The CSV has one line per cycle, inputs, both commands and cost, to
+ *   compare two versions of the control code on the same field data.
+ *   Exit status 1 when a cycle diverges, 2 on a bad dump.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "replay.h"
+
+/* Fields of a record, absolute */
+typedef struct {
+    uint32_t time;
+    uint32_t period;
+    uint16_t status;
+    int16_t counters[PID_WHEELS];
+    int32_t ref[MOTION_AXES];
+    int32_t command[PID_WHEELS];
+} cycle_t;
+
+static uint8_t* log_data;
+static size_t log_length;
+static size_t log_size;
+
+static motion_control_t control;
+
+/* Unsigned LEB128, NULL past the end of the log */
+static const uint8_t* get(const uint8_t* p, const uint8_t* end, uint32_t* value)
+{
+    uint8_t shift = 0;
+
+    *value = 0;
+    while(p < end && shift < 35)
+    {
+        *value |= (uint32_t)(*p & 0x7F) << shift;
+        if(!(*p++ & 0x80))
+            return p;
+        shift += 7;
+    }
+    return NULL;
+}
+
+static const uint8_t* get_delta(const uint8_t* p, const uint8_t* end, int32_t* delta)
+{
+    uint32_t value;
+
+    p = get(p, end, &value);
+    *delta = replay_unzigzag(value);
+    return p;
+}
+
+/* Next record, relative to the current fields */
+static const uint8_t* decode(const uint8_t* p, const uint8_t* end, cycle_t* cycle)
+{
+    uint32_t value;
+    int32_t delta;
+    uint8_t header;
+    int n;
+
+    header = *p++;
+    if(header & REPLAY_HDR_PERIOD)
+    {
+        if(!(p = get(p, end, &cycle->period)))
+            return NULL;
+    }
+    cycle->time += cycle->period;
+
+    if(header & REPLAY_HDR_STATUS)
+    {
+        if(!(p = get(p, end, &value)))
+            return NULL;
+        cycle->status = (uint16_t)value;
+    }
+
+    if(header & REPLAY_HDR_REF)
+    {
+        for(n = 0; n < MOTION_AXES; n++)
+        {
+            if(!(p = get_delta(p, end, &delta)))
+                return NULL;
+            cycle->ref[n] += delta;
+        }
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        if(!(p = get_delta(p, end, &delta)))
+            return NULL;
+        cycle->counters[n] = (int16_t)((cycle->counters[n] + delta) & REPLAY_COUNTER_MASK);
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        if(!(p = get_delta(p, end, &delta)))
+            return NULL;
+        cycle->command[n] += delta;
+    }
+
+    return p;
+}
+
+static int compare_ns(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Reads the dump, returns the number of cycles or -1 */
+static long read_dump(FILE* in)
+{
+    char line[512];
+    unsigned long cycles, bytes, dropped;
+    unsigned wheels, vel_loop;
+    long header_cycles = -1;
+    char *text, *hex;
+    unsigned byte;
+
+    while(fgets(line, sizeof(line), in))
+    {
+        /* The shell ends its lines with "\n\r" */
+        for(text = line; *text == '\r'; text++);
+
+        if(sscanf(text, "# replay %lu %lu %lu %u %u", &cycles, &bytes, &dropped, &wheels, &vel_loop) == 5)
+        {
+            if(wheels != PID_WHEELS || vel_loop != HB_LCMXO2_VEL_LOOP)
+            {
+                fprintf(stderr, "capture of %u wheels, velocity loop %u: the replay is built for %u, %u\n",
+                        wheels, vel_loop, PID_WHEELS, HB_LCMXO2_VEL_LOOP);
+                return -1;
+            }
+            if(dropped)
+                fprintf(stderr, "log full, the last %lu cycles were not captured\n", dropped);
+            header_cycles = (long)cycles;
+            log_length = 0;
+            continue;
+        }
+        if(text[0] != 'D' || text[1] != ' ' || header_cycles < 0)
+            continue;
+
+        for(hex = text + 2; sscanf(hex, "%2x", &byte) == 1; hex += 2)
+        {
+            if(log_length == log_size)
+            {
+                log_size = log_size ? 2 * log_size : 65536;
+                log_data = realloc(log_data, log_size);
+                if(!log_data)
+                    return -1;
+            }
+            log_data[log_length++] = (uint8_t)byte;
+        }
+    }
+
+    if(header_cycles < 0)
+        fprintf(stderr, "no '# replay' header\n");
+    return header_cycles;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* csv_path = NULL;
+    const char* dump_path = NULL;
+    FILE *in = stdin, *csv = NULL;
+    const uint8_t *p, *end;
+    struct timespec start, stop;
+    cycle_t cycle, first_diverged;
+    int32_t replayed[PID_WHEELS], first_replayed[PID_WHEELS];
+    int32_t diff, max_diff = 0;
+    long cycles, n = 0, diverged = 0, first = -1;
+    double *cost, total = 0;
+    int i, wheel, differs;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strncmp(argv[i], "--csv=", 6) == 0)
+            csv_path = argv[i] + 6;
+        else
+            dump_path = argv[i];
+    }
+
+    if(dump_path && !(in = fopen(dump_path, "r")))
+    {
+        perror(dump_path);
+        return 2;
+    }
+    cycles = read_dump(in);
+    if(in != stdin)
+        fclose(in);
+    if(cycles < 0)
+        return 2;
+
+    if(csv_path)
+    {
+        csv = fopen(csv_path, "w");
+        if(!csv)
+        {
+            perror(csv_path);
+            return 2;
+        }
+        fprintf(csv, "cycle,time_ms,status");
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+            fprintf(csv, ",counter%d", wheel);
+        for(i = 0; i < MOTION_AXES; i++)
+            fprintf(csv, ",ref%d", i);
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+            fprintf(csv, ",recorded%d,replayed%d", wheel, wheel);
+        fprintf(csv, ",cost_ns\n");
+    }
+
+    cost = calloc(cycles ? cycles : 1, sizeof(*cost));
+    memset(&cycle, 0, sizeof(cycle));
+    motion_control_init(&control);
+
+    p = log_data;
+    end = log_data + log_length;
+    while(p && p < end && n < cycles)
+    {
+        p = decode(p, end, &cycle);
+        if(!p)
+            break;
+
+        /* References of the cycle, as the control task set them */
+        for(i = 0; i < MOTION_AXES; i++)
+            PID_Set_Ref_Position(control.axis[i], cycle.ref[i]);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        motion_control_cycle(&control, cycle.counters);
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        cost[n] = (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+        total += cost[n];
+
+        differs = 0;
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        {
+            replayed[wheel] = control.wheel_command[wheel];
+            diff = abs(replayed[wheel] - cycle.command[wheel]);
+            if(diff)
+                differs = 1;
+            if(diff > max_diff)
+                max_diff = diff;
+        }
+        if(differs)
+        {
+            if(first < 0)
+            {
+                first = n;
+                first_diverged = cycle;
+                memcpy(first_replayed, replayed, sizeof(replayed));
+            }
+            diverged++;
+        }
+
+        if(csv)
+        {
+            fprintf(csv, "%ld,%lu,0x%04x", n, (unsigned long)cycle.time, cycle.status);
+            for(wheel = 0; wheel < PID_WHEELS; wheel++)
+                fprintf(csv, ",%d", cycle.counters[wheel]);
+            for(i = 0; i < MOTION_AXES; i++)
+                fprintf(csv, ",%d", cycle.ref[i]);
+            for(wheel = 0; wheel < PID_WHEELS; wheel++)
+                fprintf(csv, ",%d,%d", cycle.command[wheel], replayed[wheel]);
+            fprintf(csv, ",%.0f\n", cost[n]);
+        }
+        n++;
+    }
+    if(csv)
+        fclose(csv);
+
+    if(n < cycles)
+    {
+        fprintf(stderr, "log truncated after %ld of %ld cycles\n", n, cycles);
+        return 2;
+    }
+
+    printf("capture : %ld cycles, %zu bytes", n, log_length);
+    if(n)
+        printf(", %.1f bytes per cycle, %lu ms", (double)log_length / n, (unsigned long)cycle.time);
+    printf("\n");
+
+    printf("outputs : %ld cycles diverge", diverged);
+    if(diverged)
+    {
+        printf(", largest difference %d\n", max_diff);
+        printf("first   : cycle %ld at %lu ms, recorded", first, (unsigned long)first_diverged.time);
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+            printf(" %d", first_diverged.command[wheel]);
+        printf(", replayed");
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+            printf(" %d", first_replayed[wheel]);
+    }
+    printf("\n");
+
+    if(n)
+    {
+        qsort(cost, n, sizeof(*cost), compare_ns);
+        printf("cost    : %.0f ns average, %.0f min, %.0f median, %.0f p99, %.0f max per cycle\n",
+               total / n, cost[0], cost[n / 2], cost[(n * 99) / 100], cost[n - 1]);
+    }
+
+    free(cost);
+    free(log_data);
+    return diverged ? 1 : 0;
+}
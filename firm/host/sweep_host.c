@@ -0,0 +1,524 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       sweep_host.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Parameter sweep of the position PIDs: closed-loop simulations of the
+ *   holonomic base, the control law being build/libcontrol.a (motion_control.c
+ *   and pid.c built for the host), for every set of a grid of gains:
+ *
+ *     build/sweep [--kp=<values>] [--ki=..] [--kd=..] [--ilimit=..]
+ *                 [--speed=..] [--accel=..] [--axes=xy|teta]
+ *                 [--speed-max=<edges/s>] [--tau=<s>] [--jobs=<n>]
+ *                 [--csv=<file>] [--all=<file>]
+ *
+ *   Values are lists and ranges: "1,2,4", "0:200:50" (first:last[:step]).
+ *   The swept gains go to the x and y axes, or to teta, the other axes
+ *   keeping the ones of the robot (motion_control_gains).
+ *
+ *   Each run follows the same reference script from rest, the wheels being
+ *   first order motors (as cosim_plant.c) behind 12 bits counters, and is
+ *   scored on:
+ *    - tracking: mean position error, % of the steps
+ *    - settle: longest time to get within SWEEP_BAND of the references
+ *    - saturation: wheel commands at MOTION_WHEEL_MAX, %
+ *   The Pareto front of the stable runs is printed, and to the CSV.
+ *
+ *   The control law keeps all its state in motion_control_t and the
+ *   processes it points to: each run has its own, and the runs are spread
+ *   over threads, one per CPU by default.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "motion_control.h"
+
+#define SWEEP_CYCLES            410         /* 8.2 s at 20 ms */
+#define SWEEP_BAND              2.0         /* settled within, % of the step */
+#define SWEEP_UNSTABLE          4.0         /* error stopping a run, in steps */
+#define SWEEP_VALUES_MAX        64
+#define SWEEP_CHUNK             16          /* runs taken at once by a thread */
+#define SWEEP_COUNTER_MASK      0x0FFF
+
+#define SWEEP_PERIOD            (MOTION_CONTROL_PERIOD_MS / 1000.0)
+
+/* Reference script, from rest: one step per axis, then back home */
+typedef struct {
+    uint32_t cycle;
+    int32_t ref[MOTION_AXES];
+} sweep_step_t;
+
+static const sweep_step_t sweep_script[] = {
+    {  10, { 3000,    0,   0 } },
+    { 110, { 3000, 3000,   0 } },
+    { 210, { 3000, 3000, 300 } },
+    { 310, {    0,    0,   0 } }
+};
+#define SWEEP_STEPS             (sizeof(sweep_script) / sizeof(sweep_script[0]))
+
+/* Step amplitude of each axis, the errors are relative to it */
+static const double sweep_scale[MOTION_AXES] = { 3000, 3000, 300 };
+
+/* Swept parameters, in motion_axis_gains_t order */
+typedef enum {
+    SWEEP_KP = 0,
+    SWEEP_KI,
+    SWEEP_KD,
+    SWEEP_ILIMIT,
+    SWEEP_SPEED,
+    SWEEP_ACCEL,
+    SWEEP_PARAMS
+} sweep_param_t;
+
+typedef struct {
+    const char* name;
+    int32_t min;
+    int32_t max;
+    const char* values;                     /* default */
+    int32_t value[SWEEP_VALUES_MAX];
+    uint32_t count;
+} sweep_range_t;
+
+static sweep_range_t sweep_grid[SWEEP_PARAMS] = {
+    [SWEEP_KP]     = { .name = "kp",     .min = -128, .max = 127,     .values = "1:6" },
+    [SWEEP_KI]     = { .name = "ki",     .min = -128, .max = 127,     .values = "0,10,25,50" },
+    [SWEEP_KD]     = { .name = "kd",     .min = -128, .max = 127,     .values = "0,1,2" },
+    [SWEEP_ILIMIT] = { .name = "ilimit", .min = 0,    .max = 1000000, .values = "500,2000" },
+    [SWEEP_SPEED]  = { .name = "speed",  .min = 0,    .max = 1000000, .values = "500,1000,1500" },
+    [SWEEP_ACCEL]  = { .name = "accel",  .min = 0,    .max = 1000000, .values = "50:200:50" }
+};
+
+typedef struct {
+    int32_t param[SWEEP_PARAMS];
+    double tracking;                        /* % */
+    double settle;                          /* ms */
+    double saturation;                      /* % */
+    int stable;
+} sweep_result_t;
+
+/* Shared by the threads */
+typedef struct {
+    uint32_t next;
+    uint32_t runs;
+    sweep_result_t* result;
+} sweep_pool_t;
+
+/* Motors, see cosim_plant.c */
+static double plant_speed_max = 20000.0;    /* edges/s at full drive */
+static double plant_tau = 5.0e-3;           /* s */
+static int sweep_teta;                      /* swept gains to teta, else x and y */
+
+/* Parses "1,2,4" or "first:last[:step]" lists, 0 when valid */
+static int parse_range(sweep_range_t* range, const char* text)
+{
+    long first, last, step;
+    char* end;
+
+    range->count = 0;
+    while(*text)
+    {
+        first = strtol(text, &end, 0);
+        if(end == text)
+            return -1;
+        last = first;
+        step = 1;
+        if(*end == ':')
+        {
+            text = end + 1;
+            last = strtol(text, &end, 0);
+            if(end == text)
+                return -1;
+            if(*end == ':')
+            {
+                text = end + 1;
+                step = strtol(text, &end, 0);
+                if(end == text || step <= 0)
+                    return -1;
+            }
+        }
+        for(; first <= last; first += step)
+        {
+            if(first < range->min || first > range->max || range->count == SWEEP_VALUES_MAX)
+                return -1;
+            range->value[range->count++] = (int32_t)first;
+        }
+        if(*end == ',')
+            end++;
+        else if(*end)
+            return -1;
+        text = end;
+    }
+    return range->count ? 0 : -1;
+}
+
+/* Parameters of a run, the index going over the whole grid */
+static void sweep_params(uint32_t run, int32_t param[SWEEP_PARAMS])
+{
+    int n;
+
+    for(n = SWEEP_PARAMS - 1; n >= 0; n--)
+    {
+        param[n] = sweep_grid[n].value[run % sweep_grid[n].count];
+        run /= sweep_grid[n].count;
+    }
+}
+
+/* One closed-loop run from rest, param NULL for the gains of the robot */
+static void sweep_run(const int32_t param[SWEEP_PARAMS], sweep_result_t* result)
+{
+    PID_process_t process[MOTION_AXES];
+    PID_struct_t pid[MOTION_AXES];
+    motion_control_t control;
+    motion_axis_gains_t gains[MOTION_AXES];
+    double speed[PID_WHEELS] = { 0 }, position[PID_WHEELS] = { 0 };
+    double decay, target, error, tracking = 0;
+    int16_t counters[PID_WHEELS] = { 0 };
+    uint32_t cycle, step = 0, outside = 0, settle = 0, saturated = 0;
+    int32_t command;
+    int axis, wheel;
+
+    memcpy(gains, motion_control_gains, sizeof(gains));
+    if(param)
+    {
+        /* teta is the last axis */
+        for(axis = sweep_teta ? MOTION_AXES - 1 : 0; axis < (sweep_teta ? MOTION_AXES : MOTION_AXES - 1); axis++)
+        {
+            gains[axis].KP = (int8_t)param[SWEEP_KP];
+            gains[axis].KI = (int8_t)param[SWEEP_KI];
+            gains[axis].KD = (int8_t)param[SWEEP_KD];
+            gains[axis].I_limit = (uint32_t)param[SWEEP_ILIMIT];
+            gains[axis].speed_limit = param[SWEEP_SPEED];
+            gains[axis].acceleration_limit = param[SWEEP_ACCEL];
+        }
+        memcpy(result->param, param, sizeof(result->param));
+    }
+
+    /* Own processes, pid_init() hands out PID_PROCESS_MAX of them only */
+    memset(&control, 0, sizeof(control));
+    for(axis = 0; axis < MOTION_AXES; axis++)
+    {
+        memset(&process[axis], 0, sizeof(process[axis]));
+        process[axis].PID = &pid[axis];
+        PID_Reset(&process[axis]);
+        control.axis[axis] = &process[axis];
+    }
+    motion_control_configure(&control, gains);
+
+    decay = exp(-SWEEP_PERIOD / plant_tau);
+    result->stable = 1;
+
+    for(cycle = 0; cycle < SWEEP_CYCLES; cycle++)
+    {
+        if(step < SWEEP_STEPS && cycle == sweep_script[step].cycle)
+        {
+            /* Settle time of the previous step */
+            if(step && outside > settle)
+                settle = outside;
+            outside = 0;
+            for(axis = 0; axis < MOTION_AXES; axis++)
+                PID_Set_Ref_Position(control.axis[axis], sweep_script[step].ref[axis]);
+            step++;
+        }
+
+        motion_control_cycle(&control, counters);
+
+        for(axis = 0; axis < MOTION_AXES; axis++)
+        {
+            error = fabs((double)control.axis[axis]->ref - control.axis[axis]->curr) / sweep_scale[axis];
+            tracking += error;
+            if(error > SWEEP_UNSTABLE)
+                result->stable = 0;
+            if(step && error * 100 > SWEEP_BAND)
+                outside = cycle - sweep_script[step - 1].cycle + 1;
+        }
+        if(!result->stable)
+            break;
+
+        /* Commands held over the period, exact first order response */
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        {
+            command = control.wheel_command[wheel];
+            if(abs(command) >= MOTION_WHEEL_MAX)
+            {
+                saturated++;
+                command = command > 0 ? MOTION_WHEEL_MAX : -MOTION_WHEEL_MAX;
+            }
+#if HB_LCMXO2_VEL_LOOP
+            /* Ideal FPGA velocity loop, within the reach of the motor */
+            target = command / SWEEP_PERIOD;
+            if(fabs(target) > plant_speed_max)
+                target = target > 0 ? plant_speed_max : -plant_speed_max;
+#else
+            target = plant_speed_max * command / MOTION_WHEEL_MAX;
+#endif
+            position[wheel] += target * SWEEP_PERIOD + (speed[wheel] - target) * plant_tau * (1 - decay);
+            speed[wheel] = target + (speed[wheel] - target) * decay;
+            counters[wheel] = (int16_t)((int32_t)floor(position[wheel]) & SWEEP_COUNTER_MASK);
+        }
+    }
+    if(outside > settle)
+        settle = outside;
+
+    result->tracking = 100 * tracking / (SWEEP_CYCLES * MOTION_AXES);
+    result->settle = settle * MOTION_CONTROL_PERIOD_MS;
+    result->saturation = 100.0 * saturated / (SWEEP_CYCLES * PID_WHEELS);
+}
+
+/* Runs taken SWEEP_CHUNK at a time, until the grid is done */
+static void* sweep_worker(void* arg)
+{
+    sweep_pool_t* pool = arg;
+    int32_t param[SWEEP_PARAMS];
+    uint32_t run, last;
+
+    while((run = __atomic_fetch_add(&pool->next, SWEEP_CHUNK, __ATOMIC_RELAXED)) < pool->runs)
+    {
+        last = run + SWEEP_CHUNK < pool->runs ? run + SWEEP_CHUNK : pool->runs;
+        for(; run < last; run++)
+        {
+            sweep_params(run, param);
+            sweep_run(param, &pool->result[run]);
+        }
+    }
+    return NULL;
+}
+
+/* Front order: tracking, then settle, then saturation */
+static const sweep_result_t* sort_base;
+
+static int compare_scores(const void* a, const void* b)
+{
+    const sweep_result_t *x = &sort_base[*(const uint32_t*)a], *y = &sort_base[*(const uint32_t*)b];
+
+    if(x->tracking != y->tracking)
+        return x->tracking < y->tracking ? -1 : 1;
+    if(x->settle != y->settle)
+        return x->settle < y->settle ? -1 : 1;
+    if(x->saturation != y->saturation)
+        return x->saturation < y->saturation ? -1 : 1;
+    return (*(const uint32_t*)a > *(const uint32_t*)b) - (*(const uint32_t*)a < *(const uint32_t*)b);
+}
+
+/* x no worse than y on every score */
+static int covers(const sweep_result_t* x, const sweep_result_t* y)
+{
+    return x->tracking <= y->tracking && x->settle <= y->settle && x->saturation <= y->saturation;
+}
+
+/* Indexes of the stable runs none covers, in front order */
+static uint32_t pareto_front(const sweep_result_t* result, uint32_t runs, uint32_t* front)
+{
+    uint32_t *order, stable = 0, size = 0, n, k;
+
+    order = malloc((runs ? runs : 1) * sizeof(*order));
+    for(n = 0; n < runs; n++)
+        if(result[n].stable)
+            order[stable++] = n;
+
+    /* A run cannot cover one before it in this order, unless equal */
+    sort_base = result;
+    qsort(order, stable, sizeof(*order), compare_scores);
+    for(n = 0; n < stable; n++)
+    {
+        for(k = 0; k < size && !covers(&result[front[k]], &result[order[n]]); k++);
+        if(k == size)
+            front[size++] = order[n];
+    }
+
+    free(order);
+    return size;
+}
+
+static void print_csv_header(FILE* out)
+{
+    int n;
+
+    for(n = 0; n < SWEEP_PARAMS; n++)
+        fprintf(out, "%s,", sweep_grid[n].name);
+    fprintf(out, "stable,tracking_pct,settle_ms,saturation_pct\n");
+}
+
+static void print_csv(FILE* out, const sweep_result_t* result)
+{
+    int n;
+
+    for(n = 0; n < SWEEP_PARAMS; n++)
+        fprintf(out, "%d,", result->param[n]);
+    fprintf(out, "%d,%.3f,%.0f,%.2f\n", result->stable, result->tracking, result->settle, result->saturation);
+}
+
+static int write_csv(const char* path, const sweep_result_t* result, const uint32_t* index, uint32_t count)
+{
+    FILE* out;
+    uint32_t n;
+
+    if(!(out = fopen(path, "w")))
+    {
+        perror(path);
+        return -1;
+    }
+    print_csv_header(out);
+    for(n = 0; n < count; n++)
+        print_csv(out, &result[index ? index[n] : n]);
+    fclose(out);
+    return 0;
+}
+
+static void usage(void)
+{
+    int n;
+
+    fprintf(stderr, "usage: build/sweep [--<parameter>=<values>] [--axes=xy|teta]\n"
+                    "                   [--speed-max=<edges/s>] [--tau=<s>] [--jobs=<n>]\n"
+                    "                   [--csv=<file>] [--all=<file>]\n"
+                    "values: \"1,2,4\" or \"first:last[:step]\", parameters and defaults:\n");
+    for(n = 0; n < SWEEP_PARAMS; n++)
+        fprintf(stderr, "  --%-7s %s\n", sweep_grid[n].name, sweep_grid[n].values);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* values[SWEEP_PARAMS];
+    const char *csv_path = NULL, *all_path = NULL;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    struct timespec start, stop;
+    sweep_pool_t pool = { 0 };
+    sweep_result_t robot;
+    pthread_t* threads;
+    uint32_t runs = 1, stable = 0, size, n, *front;
+    size_t length;
+    double elapsed;
+    int i, k, failed = 0;
+
+    for(k = 0; k < SWEEP_PARAMS; k++)
+        values[k] = sweep_grid[k].values;
+
+    for(i = 1; i < argc; i++)
+    {
+        for(k = 0; k < SWEEP_PARAMS; k++)
+        {
+            length = strlen(sweep_grid[k].name);
+            if(strncmp(argv[i], "--", 2) == 0 && strncmp(argv[i] + 2, sweep_grid[k].name, length) == 0
+               && argv[i][2 + length] == '=')
+            {
+                values[k] = argv[i] + 3 + length;
+                break;
+            }
+        }
+        if(k < SWEEP_PARAMS)
+            continue;
+        if(strcmp(argv[i], "--axes=xy") == 0)
+            sweep_teta = 0;
+        else if(strcmp(argv[i], "--axes=teta") == 0)
+            sweep_teta = 1;
+        else if(strncmp(argv[i], "--speed-max=", 12) == 0)
+            plant_speed_max = atof(argv[i] + 12);
+        else if(strncmp(argv[i], "--tau=", 6) == 0)
+            plant_tau = atof(argv[i] + 6);
+        else if(strncmp(argv[i], "--jobs=", 7) == 0)
+            jobs = atol(argv[i] + 7);
+        else if(strncmp(argv[i], "--csv=", 6) == 0)
+            csv_path = argv[i] + 6;
+        else if(strncmp(argv[i], "--all=", 6) == 0)
+            all_path = argv[i] + 6;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    for(k = 0; k < SWEEP_PARAMS; k++)
+    {
+        if(parse_range(&sweep_grid[k], values[k]))
+        {
+            fprintf(stderr, "bad --%s values '%s', %d of them at most within [%d, %d]\n",
+                    sweep_grid[k].name, values[k], SWEEP_VALUES_MAX, sweep_grid[k].min, sweep_grid[k].max);
+            return 2;
+        }
+        runs *= sweep_grid[k].count;
+    }
+    if(plant_speed_max <= 0 || plant_tau <= 0)
+    {
+        fprintf(stderr, "bad motor model, --speed-max and --tau must be positive\n");
+        return 2;
+    }
+    if(jobs < 1)
+        jobs = 1;
+
+    pool.runs = runs;
+    pool.result = calloc(runs, sizeof(*pool.result));
+    threads = malloc(jobs * sizeof(*threads));
+    front = malloc(runs * sizeof(*front));
+    if(!pool.result || !threads || !front)
+    {
+        fprintf(stderr, "out of memory for %u runs\n", runs);
+        return 2;
+    }
+
+    /* The threads started take all the runs, this one when none could */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < jobs; i++)
+    {
+        if(pthread_create(&threads[i], NULL, sweep_worker, &pool))
+        {
+            fprintf(stderr, "%d threads started out of %ld\n", i, jobs);
+            jobs = i;
+            break;
+        }
+    }
+    if(jobs == 0)
+        sweep_worker(&pool);
+    for(i = 0; i < jobs; i++)
+        pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    elapsed = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+    sweep_run(NULL, &robot);
+    for(n = 0; n < runs; n++)
+        stable += pool.result[n].stable;
+    size = pareto_front(pool.result, runs, front);
+
+    printf("sweep   : %u runs of %.1f s, gains of %s, %ld jobs, %.2f s\n",
+           runs, SWEEP_CYCLES * SWEEP_PERIOD, sweep_teta ? "teta" : "x and y", jobs ? jobs : 1, elapsed);
+    printf("motors  : %.0f edges/s at full drive, %.1f ms time constant\n", plant_speed_max, plant_tau * 1e3);
+    printf("stable  : %u runs, %u on the Pareto front\n", stable, size);
+    printf("robot   : tracking %.3f %%, settle %.0f ms, saturation %.2f %%%s\n",
+           robot.tracking, robot.settle, robot.saturation, robot.stable ? "" : ", unstable");
+    printf("\n");
+    for(k = 0; k < SWEEP_PARAMS; k++)
+        printf("%7s ", sweep_grid[k].name);
+    printf("  track %%  settle ms  sat %%\n");
+    for(n = 0; n < size; n++)
+    {
+        for(k = 0; k < SWEEP_PARAMS; k++)
+            printf("%7d ", pool.result[front[n]].param[k]);
+        printf("%9.3f %10.0f %6.2f\n", pool.result[front[n]].tracking,
+               pool.result[front[n]].settle, pool.result[front[n]].saturation);
+    }
+
+    if(csv_path && write_csv(csv_path, pool.result, front, size))
+        failed = 1;
+    if(all_path && write_csv(all_path, pool.result, NULL, runs))
+        failed = 1;
+
+    free(front);
+    free(threads);
+    free(pool.result);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,189 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       trace2json.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Converts the output of the shell 'trace dump' command (see trace.c)
+ *   to the Chrome trace event format, for ui.perfetto.dev or
+ *   chrome://tracing:
+ *
+ *     build/trace2json < dump.txt > trace.json
+ *
+ *   One thread per task with its run slices, one thread per ISR, queue
+ *   operations as instant events on the running task. Time in us from
+ *   the first record, the 32 bits cycle counter is unwrapped.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "trace.h"
+
+#define TRACE2JSON_NAME_LEN     32
+#define TRACE2JSON_ISR_TID      1000        /* ISR threads are 1000 + exception */
+
+static char task_names[256][TRACE2JSON_NAME_LEN];
+static char queue_names[256][TRACE2JSON_NAME_LEN];
+static char isr_names[256][TRACE2JSON_NAME_LEN];
+
+static double task_start[256];              /* < 0 when not running */
+static double isr_start[256];
+
+static double cpu_hz = 216.0e6;
+static int first_event = 1;
+
+/* Separator before each event of the array */
+static void emit_next(void)
+{
+    printf("%s\n    ", first_event ? "" : ",");
+    first_event = 0;
+}
+
+static void emit_thread_name(int tid, const char* name)
+{
+    emit_next();
+    printf("{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"name\": \"thread_name\", \"args\": {\"name\": \"%s\"}}",
+           tid, name);
+}
+
+static void emit_slice(int tid, const char* name, double start, double end)
+{
+    emit_next();
+    printf("{\"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"name\": \"%s\", \"ts\": %.3f, \"dur\": %.3f}",
+           tid, name, start, end - start);
+}
+
+static void emit_instant(int tid, const char* what, const char* queue, int items, double ts)
+{
+    emit_next();
+    printf("{\"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": %d, \"name\": \"%s %s\", \"ts\": %.3f",
+           tid, what, queue, ts);
+    if(items >= 0)
+        printf(", \"args\": {\"items\": %d}", items);
+    printf("}");
+}
+
+static const char* name_of(char names[][TRACE2JSON_NAME_LEN], unsigned id, const char* prefix)
+{
+    if(!names[id][0])
+        snprintf(names[id], TRACE2JSON_NAME_LEN, "%s %u", prefix, id);
+    return names[id];
+}
+
+int main(void)
+{
+    char line[256], name[TRACE2JSON_NAME_LEN];
+    unsigned long hz, records, lost;
+    unsigned cycles, event, id, arg;
+    uint64_t time = 0, origin = 0;
+    uint32_t last = 0;
+    int started = 0, current = -1;
+    double ts = 0;
+    unsigned i;
+
+    for(i = 0; i < 256; i++)
+        task_start[i] = isr_start[i] = -1;
+
+    printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+    while(fgets(line, sizeof(line), stdin))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if(sscanf(line, "# trace %lu %lu %lu", &hz, &records, &lost) == 3)
+        {
+            cpu_hz = hz;
+            if(lost)
+                fprintf(stderr, "trace2json: %lu records overwritten before the dump\n", lost);
+        }
+        else if(sscanf(line, "T %u %31s", &id, name) == 2 && id < 256)
+        {
+            strcpy(task_names[id], name);
+            emit_thread_name(id, name);
+        }
+        else if(sscanf(line, "Q %u %31s", &id, name) == 2 && id < 256)
+            strcpy(queue_names[id], name);
+        else if(sscanf(line, "I %u %31s", &id, name) == 2 && id < 256)
+        {
+            strcpy(isr_names[id], name);
+            emit_thread_name(TRACE2JSON_ISR_TID + id, name);
+        }
+        else if(sscanf(line, "R %x %x %x %x", &cycles, &event, &id, &arg) == 4 && id < 256)
+        {
+            /* Unwrap DWT->CYCCNT */
+            if(!started)
+                origin = time = cycles;
+            else
+                time += (uint32_t)(cycles - last);
+            last = cycles;
+            started = 1;
+            ts = (double)(time - origin) * 1.0e6 / cpu_hz;
+
+            switch(event)
+            {
+            case TRACE_EV_TASK_IN:
+                task_start[id] = ts;
+                current = id;
+                break;
+
+            case TRACE_EV_TASK_OUT:
+                if(task_start[id] >= 0)
+                    emit_slice(id, name_of(task_names, id, "task"), task_start[id], ts);
+                task_start[id] = -1;
+                current = -1;
+                break;
+
+            case TRACE_EV_QUEUE_SEND:
+            case TRACE_EV_QUEUE_RECEIVE:
+            case TRACE_EV_BLOCK_SEND:
+            case TRACE_EV_BLOCK_RECEIVE:
+                /* Only the task versions of the queue functions are traced */
+                if(current >= 0)
+                    emit_instant(current,
+                                 (event == TRACE_EV_QUEUE_SEND) ? "send" :
+                                 (event == TRACE_EV_QUEUE_RECEIVE) ? "receive" :
+                                 (event == TRACE_EV_BLOCK_SEND) ? "blocked sending to" : "blocked receiving from",
+                                 name_of(queue_names, id, "queue"),
+                                 (event == TRACE_EV_QUEUE_SEND || event == TRACE_EV_QUEUE_RECEIVE) ? (int)arg : -1,
+                                 ts);
+                break;
+
+            case TRACE_EV_ISR_ENTER:
+                isr_start[id] = ts;
+                break;
+
+            case TRACE_EV_ISR_EXIT:
+                if(isr_start[id] >= 0)
+                    emit_slice(TRACE2JSON_ISR_TID + id, name_of(isr_names, id, "exception"), isr_start[id], ts);
+                isr_start[id] = -1;
+                break;
+
+            default:
+                fprintf(stderr, "trace2json: unknown event %u\n", event);
+                break;
+            }
+        }
+    }
+
+    /* Close what is still running at the end of the dump */
+    for(i = 0; i < 256; i++)
+    {
+        if(task_start[i] >= 0)
+            emit_slice(i, name_of(task_names, i, "task"), task_start[i], ts);
+        if(isr_start[i] >= 0)
+            emit_slice(TRACE2JSON_ISR_TID + i, name_of(isr_names, i, "exception"), isr_start[i], ts);
+    }
+
+    printf("\n]}\n");
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       hb_fault.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   This module handles the fault outputs of the motor bridges (DRV8872
+ *   nFAULT, active low) as external interrupts
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "holoboard.h"
+
+/* Fault inputs of the bridges driven by the LCMXO2. The fourth input of
+ * the board (PB2) has no bridge behind the FPGA, it is LCMXO2_IRQ. */
+static GPIO_TypeDef* const hb_fault_port[] = {
+    MOT0_FAULT_GPIO_PORT, MOT1_FAULT_GPIO_PORT, MOT2_FAULT_GPIO_PORT
+};
+static const uint16_t hb_fault_pin[] = {
+    MOT0_FAULT_PIN, MOT1_FAULT_PIN, MOT2_FAULT_PIN
+};
+static const uint32_t hb_fault_line[] = {
+    MOT0_FAULT_EXTI_LINE, MOT1_FAULT_EXTI_LINE, MOT2_FAULT_EXTI_LINE
+};
+static const uint8_t hb_fault_port_source[] = {
+    MOT0_FAULT_EXTI_PORT_SOURCE, MOT1_FAULT_EXTI_PORT_SOURCE, MOT2_FAULT_EXTI_PORT_SOURCE
+};
+static const uint8_t hb_fault_pin_source[] = {
+    MOT0_FAULT_EXTI_PIN_SOURCE, MOT1_FAULT_EXTI_PIN_SOURCE, MOT2_FAULT_EXTI_PIN_SOURCE
+};
+
+/* Another channel count needs its fault inputs above */
+#define HB_FAULT_CHECK_TABLE(_table) \
+    _Static_assert(sizeof(_table) / sizeof(_table[0]) == HB_LCMXO2_NB_CHANNELS, \
+                   #_table ": one entry per LCMXO2 channel")
+HB_FAULT_CHECK_TABLE(hb_fault_port);
+HB_FAULT_CHECK_TABLE(hb_fault_pin);
+HB_FAULT_CHECK_TABLE(hb_fault_line);
+HB_FAULT_CHECK_TABLE(hb_fault_port_source);
+HB_FAULT_CHECK_TABLE(hb_fault_pin_source);
+
+/**
+  * @brief  Initialize the motor fault inputs, interrupts on the falling
+  *         edge (fault asserted). The NVIC is left disabled.
+  * @param  None
+  * @retval None
+  */
+void hb_fault_init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    EXTI_InitTypeDef EXTI_InitStructure;
+    uint8_t ch;
+
+    /* Enable GPIOs and EXTI selection clocks */
+    MOT0_FAULT_GPIO_CLK_ENABLE();
+    MOT1_FAULT_GPIO_CLK_ENABLE();
+    MOT2_FAULT_GPIO_CLK_ENABLE();
+    MOT_FAULT_SYSCFG_CLK_ENABLE();
+
+    /* nFAULT is open-drain */
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Low_Speed; /* 2 MHz */
+    GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_UP;
+
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+    {
+        GPIO_InitStructure.GPIO_Pin = hb_fault_pin[ch];
+        GPIO_Init(hb_fault_port[ch], &GPIO_InitStructure);
+
+        SYSCFG_EXTILineConfig(hb_fault_port_source[ch], hb_fault_pin_source[ch]);
+
+        EXTI_InitStructure.EXTI_Line = hb_fault_line[ch];
+        EXTI_Init(&EXTI_InitStructure);
+        EXTI_ClearITPendingBit(hb_fault_line[ch]);
+    }
+}
+
+void hb_fault_enable(uint32_t nvic_priority)
+{
+    NVIC_SetPriority(MOT_FAULT_IRQn, nvic_priority);
+    NVIC_EnableIRQ(MOT_FAULT_IRQn);
+}
+
+void hb_fault_disable(void)
+{
+    NVIC_DisableIRQ(MOT_FAULT_IRQn);
+}
+
+/**
+  * @brief  Get and clear the pending fault interrupts
+  * @param  None
+  * @retval Channels with a fault edge since the last call, bit n = channel n
+  */
+uint8_t hb_fault_get_it(void)
+{
+    uint8_t ch, channels = 0;
+
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+    {
+        if(EXTI_GetITStatus(hb_fault_line[ch]) == SET)
+        {
+            EXTI_ClearITPendingBit(hb_fault_line[ch]);
+            channels |= 1 << ch;
+        }
+    }
+    return channels;
+}
+
+/**
+  * @brief  Get the current level of the fault inputs
+  * @param  None
+  * @retval Channels with their fault asserted, bit n = channel n
+  */
+uint8_t hb_fault_get_state(void)
+{
+    uint8_t ch, channels = 0;
+
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+        if(GPIO_ReadInputDataBit(hb_fault_port[ch], hb_fault_pin[ch]) == MOT_STATUS_FAULT)
+            channels |= 1 << ch;
+
+    return channels;
+}
@@ -16,12 +16,17 @@
  */
 
 
+#include <stddef.h>
 #include "holoboard.h"
 
-void hb_lcmxo2_init(void)
+#ifndef HB_LCMXO2_COSIM
+
+/* GPIOs and SPI, the FPGA is held in reset */
+static void hb_lcmxo2_setup(void)
 {
     GPIO_InitTypeDef GPIO_InitStructure;
     SPI_InitTypeDef SPI_InitStruct;
+    EXTI_InitTypeDef EXTI_InitStructure;
 
     /* Enable GPIOs Clock */
     SPI_CLK_GPIO_CLK_ENABLE();
@@ -29,6 +34,8 @@ void hb_lcmxo2_init(void)
     SPI_MOSI_GPIO_CLK_ENABLE();
     LCMXO2_SS_GPIO_CLK_ENABLE();
     LCMXO2_RESET_GPIO_CLK_ENABLE();
+    LCMXO2_IRQ_GPIO_CLK_ENABLE();
+    LCMXO2_IRQ_SYSCFG_CLK_ENABLE();
 
     /* Enable Control Interface SPI1 clock */
     SPI_CLK_ENABLE();
@@ -65,13 +72,28 @@ void hb_lcmxo2_init(void)
     GPIO_InitStructure.GPIO_Pin = LCMXO2_RESET_PIN;
     GPIO_Init(LCMXO2_RESET_GPIO_PORT, &GPIO_InitStructure);
 
+    /* Configure LCMXO2_IRQ as rising edge interrupt, pulled down while the
+     * FPGA is not configured. The NVIC is left disabled. */
+    GPIO_InitStructure.GPIO_Pin = LCMXO2_IRQ_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN;
+    GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_DOWN;
+    GPIO_Init(LCMXO2_IRQ_GPIO_PORT, &GPIO_InitStructure);
+
+    SYSCFG_EXTILineConfig(LCMXO2_IRQ_EXTI_PORT_SOURCE, LCMXO2_IRQ_EXTI_PIN_SOURCE);
+    EXTI_InitStructure.EXTI_Line = LCMXO2_IRQ_EXTI_LINE;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+    EXTI_ClearITPendingBit(LCMXO2_IRQ_EXTI_LINE);
+
     /* Default SPI Configuration */
     SPI_StructInit(&SPI_InitStruct);
 
     /* Configure custom fields */
     SPI_InitStruct.SPI_Mode = SPI_Mode_Master;
     SPI_InitStruct.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
-    SPI_InitStruct.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_256;
+    SPI_InitStruct.SPI_BaudRatePrescaler = HB_LCMXO2_SPI_PRESCALER;
     SPI_InitStruct.SPI_DataSize = SPI_DataSize_16b;
     SPI_InitStruct.SPI_CPHA = SPI_CPHA_1Edge;
     SPI_InitStruct.SPI_CPOL = SPI_CPOL_Low;
@@ -85,15 +107,33 @@ void hb_lcmxo2_init(void)
     SPI_Cmd(SPI_COM, ENABLE);
     LCMXO2_RESET_WRITE(LCMXO2_RESET_ON);
     LCMXO2_SS_WRITE(LCMXO2_SS_OFF);
+
+    /* Time base of hb_lcmxo2_delay_us() */
+    hb_sys_cycle_counter_init();
+}
+
+static void hb_lcmxo2_reset(uint8_t active)
+{
+    LCMXO2_RESET_WRITE(active ? LCMXO2_RESET_ON : LCMXO2_RESET_OFF);
 }
 
-uint16_t hb_lcmxo2_tx_rx(uint16_t value)
+/* Busy wait on the DWT cycle counter, the scheduler may not run yet */
+static void hb_lcmxo2_delay_us(uint32_t us)
 {
-	uint8_t timer;
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = us * (SystemCoreClock / 1000000UL);
+
+    while((DWT->CYCCNT - start) < cycles);
+}
 
-	/* Send a new 16 bits word */
-	LCMXO2_SS_WRITE(LCMXO2_SS_ON);
+static void hb_lcmxo2_select(void)
+{
+    LCMXO2_SS_WRITE(LCMXO2_SS_ON);
+}
 
+/* Exchange one 16 bits word, SS must be asserted */
+static uint16_t hb_lcmxo2_tx_rx(uint16_t value)
+{
     SPI_I2S_SendData16(SPI_COM, value);
 
     /* Wait until transmit complete */
@@ -102,31 +142,672 @@ uint16_t hb_lcmxo2_tx_rx(uint16_t value)
     /* Wait until receive complete */
     while(SPI_I2S_GetFlagStatus(SPI_COM, SPI_I2S_FLAG_RXNE) == RESET);
 
-    /* Wait until SPI is not busy anymore */
-    while(SPI_I2S_GetFlagStatus(SPI_COM, SPI_I2S_FLAG_BSY) == SET);
+    /* Return 16 bit received word */
+    return SPI_I2S_ReceiveData16(SPI_COM);
+}
 
-    for(timer=0;timer<50;timer++);
+static void hb_lcmxo2_deselect(void)
+{
+    /* Wait until SPI is not busy anymore, the FPGA latches the last word
+     * on the last SCLK edge so SS can be released right away */
+    while(SPI_I2S_GetFlagStatus(SPI_COM, SPI_I2S_FLAG_BSY) == SET);
 
     LCMXO2_SS_WRITE(LCMXO2_SS_OFF);
-    /* Return 16 bit received word */
+}
 
-    return SPI_I2S_ReceiveData16(SPI_COM);
+void hb_lcmxo2_irq_enable(uint32_t nvic_priority)
+{
+    EXTI_ClearITPendingBit(LCMXO2_IRQ_EXTI_LINE);
+    NVIC_SetPriority(LCMXO2_IRQn, nvic_priority);
+    NVIC_EnableIRQ(LCMXO2_IRQn);
+}
+
+void hb_lcmxo2_irq_disable(void)
+{
+    NVIC_DisableIRQ(LCMXO2_IRQn);
+}
+
+/**
+  * @brief  Get and clear the pending LCMXO2_IRQ interrupt
+  * @param  None
+  * @retval SET when the FPGA pulsed its interrupt line since the last call
+  */
+FlagStatus hb_lcmxo2_irq_get_it(void)
+{
+    if(EXTI_GetITStatus(LCMXO2_IRQ_EXTI_LINE) == RESET)
+        return RESET;
+
+    EXTI_ClearITPendingBit(LCMXO2_IRQ_EXTI_LINE);
+    return SET;
+}
+
+#else
+
+/* Co-simulation build: the SPI transport, the reset line and the time
+ * are provided by the host bridge to the GHDL model of the FPGA (see
+ * firm/host) */
+void hb_lcmxo2_setup(void);
+void hb_lcmxo2_reset(uint8_t active);
+void hb_lcmxo2_delay_us(uint32_t us);
+void hb_lcmxo2_select(void);
+uint16_t hb_lcmxo2_tx_rx(uint16_t value);
+void hb_lcmxo2_deselect(void);
+
+#endif /* HB_LCMXO2_COSIM */
+
+/* Last encoder counters read, kept on a dropped burst so that the
+ * encoders look still instead of jumping */
+static uint16_t hb_lcmxo2_qei[HB_LCMXO2_NB_CHANNELS];
+
+/* Emergency stop state, see hb_lcmxo2_emergency_stop() */
+static volatile uint8_t hb_lcmxo2_busy;
+static volatile uint8_t hb_lcmxo2_stop_pending;
+static volatile uint8_t hb_lcmxo2_stopped;
+
+/* Start-up result and identification, see hb_lcmxo2_init() */
+static HB_LCMXO2_StateTypeDef hb_lcmxo2_state;
+static uint16_t hb_lcmxo2_id;
+static uint16_t hb_lcmxo2_caps;
+
+/* Pre-built write of CONFIG = 0 */
+static const uint16_t hb_lcmxo2_stop_plain[] = {
+	HB_LCMXO2_CMD_WRITE | HB_LCMXO2_REG_CONFIG, 0x0000
+};
+
+#if HB_LCMXO2_SPI_CRC
+
+/* CRC mode bursts, used once the FPGA reports HB_LCMXO2_CAPS_CRC */
+static uint8_t hb_lcmxo2_crc_mode;
+
+/* Pre-built CRC write of CONFIG = 0: command, data, crc, turnaround, ack.
+ * 0x06 is crc8(crc8(0xFF, command), 0x0000). */
+#define HB_LCMXO2_STOP_CRC      0x06
+#define HB_LCMXO2_STOP_ACK      ((HB_LCMXO2_CRC_ACK << 8) | HB_LCMXO2_STOP_CRC)
+
+static const uint16_t hb_lcmxo2_stop_crc[] = {
+	HB_LCMXO2_CMD_WRITE | HB_LCMXO2_CMD_CRC | HB_LCMXO2_CMD_LENGTH(1) | HB_LCMXO2_REG_CONFIG,
+	0x0000, HB_LCMXO2_STOP_CRC, 0x0000, 0x0000
+};
+
+#endif /* HB_LCMXO2_SPI_CRC */
+
+/* Clear CONFIG.PWM_EN, the bridges are braked by the FPGA on the next
+ * clock. The bus must be owned (hb_lcmxo2_busy set). */
+static void hb_lcmxo2_send_stop(void)
+{
+	uint8_t i;
+#if HB_LCMXO2_SPI_CRC
+	uint8_t attempt;
+	uint16_t ack = 0;
+
+	if(hb_lcmxo2_crc_mode)
+	{
+		for(attempt = 0; attempt < HB_LCMXO2_SPI_RETRIES; attempt++)
+		{
+			hb_lcmxo2_select();
+			for(i = 0; i < sizeof(hb_lcmxo2_stop_crc)/sizeof(hb_lcmxo2_stop_crc[0]); i++)
+				ack = hb_lcmxo2_tx_rx(hb_lcmxo2_stop_crc[i]);
+			hb_lcmxo2_deselect();
+			if(ack == HB_LCMXO2_STOP_ACK)
+				break;
+		}
+		return;
+	}
+#endif
+
+	hb_lcmxo2_select();
+	for(i = 0; i < sizeof(hb_lcmxo2_stop_plain)/sizeof(hb_lcmxo2_stop_plain[0]); i++)
+		hb_lcmxo2_tx_rx(hb_lcmxo2_stop_plain[i]);
+	hb_lcmxo2_deselect();
+}
+
+/* Give the bus back, then send the stops requested while it was owned.
+ * An emergency stop arriving once busy is cleared sends its own burst. */
+static void hb_lcmxo2_release(void)
+{
+	hb_lcmxo2_busy = 0;
+	while(hb_lcmxo2_stop_pending)
+	{
+		hb_lcmxo2_busy = 1;
+		hb_lcmxo2_stop_pending = 0;
+		hb_lcmxo2_send_stop();
+		hb_lcmxo2_busy = 0;
+	}
+}
+
+/* SS window of a burst, owns the bus against hb_lcmxo2_emergency_stop() */
+static void hb_lcmxo2_begin(void)
+{
+	hb_lcmxo2_busy = 1;
+	hb_lcmxo2_select();
+}
+
+static void hb_lcmxo2_end(void)
+{
+	hb_lcmxo2_deselect();
+	hb_lcmxo2_release();
+}
+
+#if HB_LCMXO2_SPI_CRC
+
+static HB_LCMXO2_SpiStatsTypeDef hb_lcmxo2_stats;
+
+/* CRC-8 of a 16 bits word, msb first (crc8 in holoboard_pkg.vhd) */
+static uint8_t hb_lcmxo2_crc8(uint8_t crc, uint16_t word)
+{
+	uint8_t i;
+
+	for(i = 0; i < 16; i++)
+	{
+		if((crc ^ (word >> 8)) & 0x80)
+			crc = (uint8_t)((crc << 1) ^ HB_LCMXO2_CRC_POLY);
+		else
+			crc = (uint8_t)(crc << 1);
+		word <<= 1;
+	}
+	return crc;
+}
+
+/* CRC mode read burst, data and status are only updated when the crc word matches */
+static ErrorStatus hb_lcmxo2_read_burst_crc(uint8_t address, uint16_t* data, uint8_t length, uint16_t* status)
+{
+	uint16_t cmd = HB_LCMXO2_CMD_CRC | HB_LCMXO2_CMD_LENGTH(length) | address;
+	uint16_t buffer[HB_LCMXO2_CRC_READ_MAX];
+	uint16_t turnaround;
+	uint8_t crc = hb_lcmxo2_crc8(HB_LCMXO2_CRC_INIT, cmd);
+	uint8_t i;
+	ErrorStatus result;
+
+	hb_lcmxo2_begin();
+
+	/* Command, turnaround (STATUS), data, then the FPGA CRC of the three */
+	hb_lcmxo2_tx_rx(cmd);
+	turnaround = hb_lcmxo2_tx_rx(0x0000);
+	crc = hb_lcmxo2_crc8(crc, turnaround);
+	for(i = 0; i < length; i++)
+	{
+		buffer[i] = hb_lcmxo2_tx_rx(0x0000);
+		crc = hb_lcmxo2_crc8(crc, buffer[i]);
+	}
+	result = (hb_lcmxo2_tx_rx(0x0000) == crc) ? SUCCESS : ERROR;
+
+	hb_lcmxo2_end();
+
+	if(result == SUCCESS)
+	{
+		*status = turnaround;
+		for(i = 0; i < length; i++)
+			data[i] = buffer[i];
+	}
+
+	return result;
+}
+
+/* CRC mode write burst, the FPGA only applies it when the crc word matches */
+static ErrorStatus hb_lcmxo2_write_burst_crc(uint8_t address, const uint16_t* data, uint8_t length, uint16_t* status)
+{
+	uint16_t cmd = HB_LCMXO2_CMD_WRITE | HB_LCMXO2_CMD_CRC | HB_LCMXO2_CMD_LENGTH(length) | address;
+	uint8_t crc = hb_lcmxo2_crc8(HB_LCMXO2_CRC_INIT, cmd);
+	uint8_t i;
+	uint16_t ack;
+
+	hb_lcmxo2_begin();
+
+	/* Command, data, crc, then a turnaround word before the ack */
+	*status = hb_lcmxo2_tx_rx(cmd);
+	for(i = 0; i < length; i++)
+	{
+		hb_lcmxo2_tx_rx(data[i]);
+		crc = hb_lcmxo2_crc8(crc, data[i]);
+	}
+	hb_lcmxo2_tx_rx(crc);
+	hb_lcmxo2_tx_rx(0x0000);
+	ack = hb_lcmxo2_tx_rx(0x0000);
+
+	hb_lcmxo2_end();
+
+	return (ack == ((HB_LCMXO2_CRC_ACK << 8) | crc)) ? SUCCESS : ERROR;
+}
+
+#endif /* HB_LCMXO2_SPI_CRC */
+
+static ErrorStatus hb_lcmxo2_read_burst(uint8_t address, uint16_t* data, uint8_t length, uint16_t* status)
+{
+	hb_lcmxo2_begin();
+
+	/* Command, then a turnaround word while the FPGA fetches the first register */
+	hb_lcmxo2_tx_rx(address);
+	*status = hb_lcmxo2_tx_rx(0x0000);
+
+	while(length--)
+		*data++ = hb_lcmxo2_tx_rx(0x0000);
+
+	hb_lcmxo2_end();
+
+	return SUCCESS;
+}
+
+static ErrorStatus hb_lcmxo2_write_burst(uint8_t address, const uint16_t* data, uint8_t length, uint16_t* status)
+{
+	hb_lcmxo2_begin();
+
+	*status = hb_lcmxo2_tx_rx(HB_LCMXO2_CMD_WRITE | address);
+
+	while(length--)
+		hb_lcmxo2_tx_rx(*data++);
+
+	hb_lcmxo2_end();
+
+	return SUCCESS;
+}
+
+/**
+  * @brief  Start the LCMXO2: reset pulse, then the identification is
+  *         polled until STATUS.READY or HB_LCMXO2_INIT_TIMEOUT_MS. CRC mode
+  *         bursts are used from then on when both HB_LCMXO2_SPI_CRC and the
+  *         FPGA capability are set. Busy waits, callable before the scheduler.
+  * @param  None
+  * @retval HB_LCMXO2_READY, or why the FPGA cannot be used
+  */
+HB_LCMXO2_StateTypeDef hb_lcmxo2_init(void)
+{
+	uint16_t ident[2];	/* ID, CAPS */
+	uint16_t status;
+	uint32_t poll;
+
+	hb_lcmxo2_setup();
+	hb_lcmxo2_delay_us(HB_LCMXO2_RESET_US);
+	hb_lcmxo2_reset(0);
+
+	hb_lcmxo2_state = HB_LCMXO2_NO_ANSWER;
+	for(poll = 0; poll <= (HB_LCMXO2_INIT_TIMEOUT_MS * 1000UL) / HB_LCMXO2_POLL_US; poll++)
+	{
+		if(poll)
+			hb_lcmxo2_delay_us(HB_LCMXO2_POLL_US);
+
+		/* Plain burst, understood by any design */
+		hb_lcmxo2_read_burst(HB_LCMXO2_REG_ID, ident, 2, &status);
+		if((ident[0] >> 8) != HB_LCMXO2_ID_MAGIC)
+		{
+			/* MISO floats until the configuration is done */
+			if(ident[0] == 0x0000 || ident[0] == 0xFFFF)
+				hb_lcmxo2_state = HB_LCMXO2_NO_ANSWER;
+			else
+				hb_lcmxo2_state = HB_LCMXO2_WRONG_ID;
+			continue;
+		}
+
+		hb_lcmxo2_id = ident[0];
+		hb_lcmxo2_caps = ident[1];
+		if((ident[0] != HB_LCMXO2_ID(HB_LCMXO2_ID_MAGIC, HB_LCMXO2_ID_VERSION)) ||
+		   (HB_LCMXO2_CAPS_CHANNELS(ident[1]) != HB_LCMXO2_NB_CHANNELS))
+		{
+			hb_lcmxo2_state = HB_LCMXO2_WRONG_ID;
+			break;
+		}
+		if(status & HB_LCMXO2_STATUS_READY)
+		{
+			hb_lcmxo2_state = HB_LCMXO2_READY;
+			break;
+		}
+		hb_lcmxo2_state = HB_LCMXO2_NOT_READY;
+	}
+
+#if HB_LCMXO2_SPI_CRC
+	hb_lcmxo2_crc_mode = (hb_lcmxo2_state == HB_LCMXO2_READY) && (hb_lcmxo2_caps & HB_LCMXO2_CAPS_CRC);
+#endif
+
+	return hb_lcmxo2_state;
+}
+
+HB_LCMXO2_StateTypeDef hb_lcmxo2_get_state(void)
+{
+	return hb_lcmxo2_state;
+}
+
+/* ID and CAPS registers, zero until a HOLOBOARD design answered */
+uint16_t hb_lcmxo2_get_id(void)
+{
+	return hb_lcmxo2_id;
+}
+
+uint16_t hb_lcmxo2_get_caps(void)
+{
+	return hb_lcmxo2_caps;
+}
+
+/**
+  * @brief  Read consecutive LCMXO2 registers in one SS window. In CRC mode,
+  *         a burst failing the check is retried up to HB_LCMXO2_SPI_RETRIES
+  *         times, then dropped.
+  * @param  address: first register address (HB_LCMXO2_REG_xxx)
+  * @param  data: destination of the register values, left unchanged
+  *         for a dropped burst
+  * @param  length: number of registers to read
+  * @param  status: LCMXO2 STATUS register, sampled at the start of the
+  *         burst and left unchanged for a dropped one, or NULL
+  * @retval ERROR if a burst was dropped, SUCCESS otherwise
+  */
+ErrorStatus hb_lcmxo2_read(uint8_t address, uint16_t* data, uint8_t length, uint16_t* status)
+{
+	uint16_t ignored;
+#if HB_LCMXO2_SPI_CRC
+	ErrorStatus result = SUCCESS;
+	uint8_t chunk, attempt;
+#endif
+
+	if(status == NULL)
+		status = &ignored;
+
+#if HB_LCMXO2_SPI_CRC
+	/* Longer reads are split in several CRC bursts */
+	if(hb_lcmxo2_crc_mode)
+	{
+		while(length)
+		{
+			chunk = (length > HB_LCMXO2_CRC_READ_MAX) ? HB_LCMXO2_CRC_READ_MAX : length;
+
+			hb_lcmxo2_stats.bursts++;
+			for(attempt = 0; attempt < HB_LCMXO2_SPI_RETRIES; attempt++)
+			{
+				if(hb_lcmxo2_read_burst_crc(address, data, chunk, status) == SUCCESS)
+					break;
+				hb_lcmxo2_stats.crc_errors++;
+			}
+			if(attempt == HB_LCMXO2_SPI_RETRIES)
+			{
+				hb_lcmxo2_stats.failures++;
+				result = ERROR;
+			}
+
+			address += chunk;
+			data += chunk;
+			length -= chunk;
+		}
+		return result;
+	}
+#endif
+	return hb_lcmxo2_read_burst(address, data, length, status);
+}
+
+/**
+  * @brief  Write consecutive LCMXO2 registers in one SS window. In CRC mode,
+  *         a burst failing the check is retried up to HB_LCMXO2_SPI_RETRIES
+  *         times, then dropped.
+  * @param  address: first register address (HB_LCMXO2_REG_xxx)
+  * @param  data: values to write
+  * @param  length: number of registers to write
+  * @retval LCMXO2 STATUS register, sampled at the start of the burst
+  */
+uint16_t hb_lcmxo2_write(uint8_t address, const uint16_t* data, uint8_t length)
+{
+	uint16_t status = 0;
+#if HB_LCMXO2_SPI_CRC
+	uint8_t chunk, attempt;
+
+	/* The FPGA stages CRC writes, longer ones are split */
+	if(hb_lcmxo2_crc_mode)
+	{
+		while(length)
+		{
+			chunk = (length > HB_LCMXO2_CRC_WRITE_MAX) ? HB_LCMXO2_CRC_WRITE_MAX : length;
+
+			hb_lcmxo2_stats.bursts++;
+			for(attempt = 0; attempt < HB_LCMXO2_SPI_RETRIES; attempt++)
+			{
+				if(hb_lcmxo2_write_burst_crc(address, data, chunk, &status) == SUCCESS)
+					break;
+				hb_lcmxo2_stats.crc_errors++;
+			}
+			if(attempt == HB_LCMXO2_SPI_RETRIES)
+				hb_lcmxo2_stats.failures++;
+
+			address += chunk;
+			data += chunk;
+			length -= chunk;
+		}
+		return status;
+	}
+#endif
+	hb_lcmxo2_write_burst(address, data, length, &status);
+	return status;
+}
+
+/**
+  * @brief  Get the SPI link statistics, all zero without CRC mode
+  * @param  stats: destination of the statistics
+  * @retval None
+  */
+void hb_lcmxo2_get_spi_stats(HB_LCMXO2_SpiStatsTypeDef* stats)
+{
+#if HB_LCMXO2_SPI_CRC
+	*stats = hb_lcmxo2_stats;
+#else
+	stats->bursts = 0;
+	stats->crc_errors = 0;
+	stats->failures = 0;
+#endif
+}
+
+void hb_lcmxo2_clear_spi_stats(void)
+{
+#if HB_LCMXO2_SPI_CRC
+	hb_lcmxo2_stats.bursts = 0;
+	hb_lcmxo2_stats.crc_errors = 0;
+	hb_lcmxo2_stats.failures = 0;
+#endif
+}
+
+/**
+  * @brief  Brake all the motor bridges as fast as possible, callable from
+  *         an interrupt. When a burst is in progress, the stop is sent as
+  *         soon as it ends. The stop is latched: PWM enable requests are
+  *         refused until hb_lcmxo2_clear_stop().
+  * @param  None
+  * @retval None
+  */
+void hb_lcmxo2_emergency_stop(void)
+{
+	hb_lcmxo2_stopped = 1;
+	hb_lcmxo2_stop_pending = 1;
+	if(!hb_lcmxo2_busy)
+		hb_lcmxo2_release();
+}
+
+void hb_lcmxo2_clear_stop(void)
+{
+	hb_lcmxo2_stopped = 0;
+}
+
+FlagStatus hb_lcmxo2_get_stop(void)
+{
+	return hb_lcmxo2_stopped ? SET : RESET;
+}
+
+/**
+  * @brief  Enable the motor bridges, they are braked while disabled.
+  *         Enabling is refused after an emergency stop.
+  * @param  state: ENABLE or DISABLE
+  * @retval None
+  */
+void hb_lcmxo2_set_pwm_enable(FunctionalState state)
+{
+	uint16_t config = 0;
+
+	if(hb_lcmxo2_stopped)
+		state = DISABLE;
+
+	/* Without CONFIG, disabling still brakes, the velocity loop with it */
+	if(hb_lcmxo2_read(HB_LCMXO2_REG_CONFIG, &config, 1, NULL) != SUCCESS && state == ENABLE)
+		return;
+	if(state == ENABLE)
+		config |= HB_LCMXO2_CONFIG_PWM_EN;
+	else
+		config &= ~HB_LCMXO2_CONFIG_PWM_EN;
+	hb_lcmxo2_write(HB_LCMXO2_REG_CONFIG, &config, 1);
+
+	/* A stop sent during this write may have been overwritten by a retry */
+	if(state == ENABLE && hb_lcmxo2_stopped)
+		hb_lcmxo2_emergency_stop();
 }
 
-void hb_lcmxo2_set_pwm(uint16_t motor, int16_t value)
+void hb_lcmxo2_set_pwm(uint16_t channel, int16_t value)
 {
 	uint16_t speed;
 
+	/* Saturate to the FPGA PWM range */
+	if(value > HB_LCMXO2_PWM_MAX)
+		value = HB_LCMXO2_PWM_MAX;
+	else if(value < -HB_LCMXO2_PWM_MAX)
+		value = -HB_LCMXO2_PWM_MAX;
+
+	/* Sign and magnitude, sign is the msb */
 	if(value < 0)
-		speed = (uint16_t)(((-value)&0x07FF)|0x0800);
+		speed = (uint16_t)(((-value)&0x7FFF)|0x8000);
 	else
-		speed = (uint16_t)value&0x07FF;
-	hb_lcmxo2_tx_rx(motor);
-	hb_lcmxo2_tx_rx(speed);
+		speed = (uint16_t)value&0x7FFF;
+	hb_lcmxo2_write(HB_LCMXO2_REG_PWM_DUTY(channel), &speed, 1);
 }
 
-int16_t hb_lcmxo2_get_qei(uint16_t encoder)
+/**
+  * @brief  Setup the PWM period of a motor, applied at the end of the
+  *         current PWM period. Duty values are relative to this period.
+  * @param  channel: motor channel, 0 to HB_LCMXO2_NB_CHANNELS-1
+  * @param  period: period in FPGA clock cycles minus one (15 bits)
+  * @retval None
+  */
+void hb_lcmxo2_set_pwm_period(uint16_t channel, uint16_t period)
 {
-	hb_lcmxo2_tx_rx(encoder&0x000F);
-	return hb_lcmxo2_tx_rx(0x0000)&0x0FFF;
+	period &= 0x7FFF;
+	hb_lcmxo2_write(HB_LCMXO2_REG_PWM_PERIOD(channel), &period, 1);
+}
+
+/**
+  * @brief  Setup the bridge brake time applied on direction changes
+  * @param  channel: motor channel, 0 to HB_LCMXO2_NB_CHANNELS-1
+  * @param  deadband: duration in FPGA clock cycles, 0 to disable
+  * @retval None
+  */
+void hb_lcmxo2_set_pwm_deadband(uint16_t channel, uint8_t deadband)
+{
+	uint16_t value = deadband;
+
+	hb_lcmxo2_write(HB_LCMXO2_REG_PWM_DEADBAND(channel), &value, 1);
+}
+
+/**
+  * @brief  Setup the duty slew limit of a motor: at each PWM period the
+  *         duty driven moves towards the last hb_lcmxo2_set_pwm() value
+  *         by at most slew steps, a full scale ramp lasts period / slew
+  *         PWM periods
+  * @param  channel: motor channel, 0 to HB_LCMXO2_NB_CHANNELS-1
+  * @param  slew: duty steps per PWM period (15 bits), 0 to disable
+  * @retval None
+  */
+void hb_lcmxo2_set_pwm_slew(uint16_t channel, uint16_t slew)
+{
+	slew &= 0x7FFF;
+	hb_lcmxo2_write(HB_LCMXO2_REG_PWM_SLEW(channel), &slew, 1);
+}
+
+/**
+  * @brief  Setup the encoder inputs glitch filter, common to all channels
+  * @param  filter: a new input level is taken once stable for filter + 1
+  *         FPGA clock cycles
+  * @retval None
+  */
+void hb_lcmxo2_set_qei_filter(uint8_t filter)
+{
+	uint16_t value = filter;
+
+	hb_lcmxo2_write(HB_LCMXO2_REG_QEI_FILTER, &value, 1);
+}
+
+/**
+  * @brief  Setup the encoder sampling and the LCMXO2_IRQ sources
+  * @param  period_us: the encoder counters are sampled by the FPGA every
+  *         period_us, 0 to take them at the start of each read instead
+  * @param  irq_sources: HB_LCMXO2_IRQ_xxx, pulses of LCMXO2_IRQ
+  * @retval None
+  */
+void hb_lcmxo2_set_sample(uint16_t period_us, uint16_t irq_sources)
+{
+	hb_lcmxo2_write(HB_LCMXO2_REG_SAMPLE_PERIOD, &period_us, 1);
+	hb_lcmxo2_write(HB_LCMXO2_REG_IRQ_EN, &irq_sources, 1);
+}
+
+/**
+  * @brief  Setup the FPGA velocity loop: one PI per wheel drives the PWM
+  *         from the encoder counts, PWM_DUTY is not used while enabled.
+  *         It only runs while the bridges are enabled.
+  * @param  period_us: loop period
+  * @param  state: ENABLE or DISABLE
+  * @retval None
+  */
+void hb_lcmxo2_set_vel_loop(uint16_t period_us, FunctionalState state)
+{
+	uint16_t config = 0;
+
+	hb_lcmxo2_write(HB_LCMXO2_REG_VEL_PERIOD, &period_us, 1);
+
+	if(hb_lcmxo2_read(HB_LCMXO2_REG_CONFIG, &config, 1, NULL) != SUCCESS)
+		return;
+	if(state == ENABLE)
+		config |= HB_LCMXO2_CONFIG_VEL_EN;
+	else
+		config &= ~HB_LCMXO2_CONFIG_VEL_EN;
+	hb_lcmxo2_write(HB_LCMXO2_REG_CONFIG, &config, 1);
+}
+
+/**
+  * @brief  Setup the velocity loop gains of a wheel (see velocity_pi.vhd)
+  * @param  channel: motor channel, 0 to HB_LCMXO2_NB_CHANNELS-1
+  * @param  kp: duty steps per encoder count per loop period
+  * @param  ki: duty steps per encoder count per loop period, per loop period
+  * @retval None
+  */
+void hb_lcmxo2_set_vel_gains(uint16_t channel, int16_t kp, int16_t ki)
+{
+	hb_lcmxo2_write(HB_LCMXO2_REG_VEL_KP(channel), (uint16_t*)&kp, 1);
+	hb_lcmxo2_write(HB_LCMXO2_REG_VEL_KI(channel), (uint16_t*)&ki, 1);
+}
+
+/**
+  * @brief  Write the velocity references of all the wheels in one burst
+  * @param  refs: HB_LCMXO2_NB_CHANNELS references, in 1/256 encoder counts
+  *         per loop period
+  * @retval None
+  */
+void hb_lcmxo2_set_vel_ref_all(const int16_t* refs)
+{
+	hb_lcmxo2_write(HB_LCMXO2_REG_VEL_REF(0), (const uint16_t*)refs, HB_LCMXO2_NB_CHANNELS);
+}
+
+int16_t hb_lcmxo2_get_qei(uint16_t channel)
+{
+	if(channel >= HB_LCMXO2_NB_CHANNELS)
+		return 0;
+
+	hb_lcmxo2_read(HB_LCMXO2_REG_QEI(channel), &hb_lcmxo2_qei[channel], 1, NULL);
+	return hb_lcmxo2_qei[channel]&0x0FFF;
+}
+
+/**
+  * @brief  Read all the encoder counters in one burst, so from the same
+  *         FPGA sample
+  * @param  counters: destination of the HB_LCMXO2_NB_CHANNELS counters
+  * @param  status: LCMXO2 STATUS register, sampled at the start of the burst
+  * @retval ERROR if the burst was dropped: counters and status are then
+  *         the ones of the last burst read
+  */
+ErrorStatus hb_lcmxo2_get_qei_all(int16_t* counters, uint16_t* status)
+{
+	ErrorStatus result;
+	uint8_t ch;
+
+	result = hb_lcmxo2_read(HB_LCMXO2_REG_QEI(0), hb_lcmxo2_qei, HB_LCMXO2_NB_CHANNELS, status);
+	for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+		counters[ch] = hb_lcmxo2_qei[ch]&0x0FFF;
+
+	return result;
 }
@@ -17,42 +17,109 @@
 
 #include "holoboard.h"
 
+/* Duty cycles of the on phase, red, green, blue */
+static volatile uint8_t hb_led_duty[LEDn];
+
+/* Current blinking phase, toggled by the blinking timer */
+static volatile uint8_t hb_led_on = 1;
+
+/* Local, Private functions */
+static void hb_led_write(uint8_t red, uint8_t green, uint8_t blue);
+
 /**
-  * @brief  Configure LEDs GPIOs (push-pull, no pull-up)
+  * @brief  Configure the LEDs PWM timer, 8-bit duty cycle per color, and the
+  *         blinking timer. LEDs are OFF and static.
   * @param  None
   * @retval None
   */
 void hb_led_init(void)
 {
     GPIO_InitTypeDef  GPIO_InitStructure;
+    TIM_TimeBaseInitTypeDef TIM_BaseStruct;
+    TIM_OCInitTypeDef TIM_OCStruct;
 
     LEDR_GPIO_CLK_ENABLE();
     LEDG_GPIO_CLK_ENABLE();
     LEDB_GPIO_CLK_ENABLE();
+    LED_PWM_TIM_CLK_ENABLE();
+    LED_BLINK_TIM_CLK_ENABLE();
 
     /* Common configuration for all LEDs */
-    GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
+    GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;
     GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
     GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL;
-    GPIO_InitStructure.GPIO_Speed = GPIO_Fast_Speed;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Low_Speed;
 
     GPIO_InitStructure.GPIO_Pin = LEDR_PIN;
     GPIO_Init(LEDR_GPIO_PORT, &GPIO_InitStructure);
+    GPIO_PinAFConfig(LEDR_GPIO_PORT, LEDR_PIN_SOURCE, LEDR_AF);
 
     GPIO_InitStructure.GPIO_Pin = LEDG_PIN;
     GPIO_Init(LEDG_GPIO_PORT, &GPIO_InitStructure);
+    GPIO_PinAFConfig(LEDG_GPIO_PORT, LEDG_PIN_SOURCE, LEDG_AF);
 
     GPIO_InitStructure.GPIO_Pin = LEDB_PIN;
     GPIO_Init(LEDB_GPIO_PORT, &GPIO_InitStructure);
+    GPIO_PinAFConfig(LEDB_GPIO_PORT, LEDB_PIN_SOURCE, LEDB_AF);
+
+    /* PWM timer: 255 counts period, a 255 duty is always on */
+    TIM_BaseStruct.TIM_Prescaler            = HB_LED_PWM_PRESCALER;
+    TIM_BaseStruct.TIM_CounterMode          = TIM_CounterMode_Up;
+    TIM_BaseStruct.TIM_Period               = 254;
+    TIM_BaseStruct.TIM_ClockDivision        = TIM_CKD_DIV1;
+    TIM_BaseStruct.TIM_RepetitionCounter    = 0;
+    TIM_TimeBaseInit(LED_PWM_TIM, &TIM_BaseStruct);
 
     /* Default state: LEDs OFF */
-    LEDR_WRITE(LEDx_OFF);
-    LEDG_WRITE(LEDx_OFF);
-    LEDB_WRITE(LEDx_OFF);
+    TIM_OCStruct.TIM_OCMode         = TIM_OCMode_PWM1;
+    TIM_OCStruct.TIM_OutputState    = TIM_OutputState_Enable;
+    TIM_OCStruct.TIM_Pulse          = 0;
+    TIM_OCStruct.TIM_OCPolarity     = LED_PWM_POLARITY;
+    LEDR_OC_INIT(&TIM_OCStruct);
+    LEDG_OC_INIT(&TIM_OCStruct);
+    LEDB_OC_INIT(&TIM_OCStruct);
+
+    /* New duty cycles are applied at the end of the period */
+    LEDR_OC_PRELOAD();
+    LEDG_OC_PRELOAD();
+    LEDB_OC_PRELOAD();
+    TIM_ARRPreloadConfig(LED_PWM_TIM, ENABLE);
+    TIM_Cmd(LED_PWM_TIM, ENABLE);
+
+    /* Blinking timer, started by hb_led_set_blink() */
+    TIM_BaseStruct.TIM_Prescaler            = HB_LED_BLINK_PRESCALER;
+    TIM_BaseStruct.TIM_Period               = 0xFFFF;
+    TIM_TimeBaseInit(LED_BLINK_TIM, &TIM_BaseStruct);
+    TIM_ClearITPendingBit(LED_BLINK_TIM, TIM_IT_Update);
+    TIM_ITConfig(LED_BLINK_TIM, TIM_IT_Update, ENABLE);
+    NVIC_SetPriority(LED_BLINK_IRQn, HB_PRIORITY_LED_BLINK);
+    NVIC_EnableIRQ(LED_BLINK_IRQn);
+}
+
+static void hb_led_write(uint8_t red, uint8_t green, uint8_t blue)
+{
+    LEDR_SET_DUTY(red);
+    LEDG_SET_DUTY(green);
+    LEDB_SET_DUTY(blue);
+}
+
+/**
+  * @brief  Setup a new RGB Led color, 8-bit per color
+  * @param  red, green, blue: duty cycles, 0 is off and 255 fully on
+  * @retval None
+  */
+void hb_led_set_rgb(uint8_t red, uint8_t green, uint8_t blue)
+{
+    hb_led_duty[0] = red;
+    hb_led_duty[1] = green;
+    hb_led_duty[2] = blue;
+
+    if(hb_led_on)
+        hb_led_write(red, green, blue);
 }
 
 /**
-  * @brief  Setup a new RGB Led color
+  * @brief  Setup a new RGB Led color, at HB_LED_LEVEL brightness
   * @param  color: Color to setup
   * @retval None
   */
@@ -61,48 +128,68 @@ void hb_led_set_color(HB_LED_ColorTypeDef color)
     switch(color)
     {
     case HB_LED_RED:
-        LEDR_WRITE(LEDx_ON);
-        LEDG_WRITE(LEDx_OFF);
-        LEDB_WRITE(LEDx_OFF);
+        hb_led_set_rgb(HB_LED_LEVEL, 0, 0);
         break;
     case HB_LED_GREEN:
-        LEDR_WRITE(LEDx_OFF);
-        LEDG_WRITE(LEDx_ON);
-        LEDB_WRITE(LEDx_OFF);
+        hb_led_set_rgb(0, HB_LED_LEVEL, 0);
         break;
     case HB_LED_BLUE:
-        LEDR_WRITE(LEDx_OFF);
-        LEDG_WRITE(LEDx_OFF);
-        LEDB_WRITE(LEDx_ON);
+        hb_led_set_rgb(0, 0, HB_LED_LEVEL);
         break;
     case HB_LED_CYAN:
-        LEDR_WRITE(LEDx_OFF);
-        LEDG_WRITE(LEDx_ON);
-        LEDB_WRITE(LEDx_ON);
+        hb_led_set_rgb(0, HB_LED_LEVEL, HB_LED_LEVEL);
         break;
     case HB_LED_YELLOW:
-        LEDR_WRITE(LEDx_ON);
-        LEDG_WRITE(LEDx_ON);
-        LEDB_WRITE(LEDx_OFF);
+        hb_led_set_rgb(HB_LED_LEVEL, HB_LED_LEVEL, 0);
         break;
     case HB_LED_MAGENTA:
-        LEDR_WRITE(LEDx_ON);
-        LEDG_WRITE(LEDx_OFF);
-        LEDB_WRITE(LEDx_ON);
+        hb_led_set_rgb(HB_LED_LEVEL, 0, HB_LED_LEVEL);
         break;
     case HB_LED_WHITE:
-        LEDR_WRITE(LEDx_ON);
-        LEDG_WRITE(LEDx_ON);
-        LEDB_WRITE(LEDx_ON);
+        hb_led_set_rgb(HB_LED_LEVEL, HB_LED_LEVEL, HB_LED_LEVEL);
         break;
 
     default:
     case HB_LED_OFF:
-        LEDR_WRITE(LEDx_OFF);
-        LEDG_WRITE(LEDx_OFF);
-        LEDB_WRITE(LEDx_OFF);
+        hb_led_set_rgb(0, 0, 0);
         break;
 
     }
 
 }
+
+/**
+  * @brief  Setup the blinking, the LED is on then off for half_period_ms
+  * @param  half_period_ms: 1 to 6553 ms, 0 for a static LED
+  * @retval None
+  */
+void hb_led_set_blink(uint16_t half_period_ms)
+{
+    TIM_Cmd(LED_BLINK_TIM, DISABLE);
+
+    /* Restart with the on phase */
+    hb_led_on = 1;
+    hb_led_write(hb_led_duty[0], hb_led_duty[1], hb_led_duty[2]);
+
+    if(half_period_ms)
+    {
+        TIM_SetAutoreload(LED_BLINK_TIM, (uint32_t)half_period_ms * (HB_LED_BLINK_HZ / 1000) - 1);
+        TIM_SetCounter(LED_BLINK_TIM, 0);
+        TIM_Cmd(LED_BLINK_TIM, ENABLE);
+    }
+}
+
+/*
+ * Blinking Timer Interrupt Sub-routine
+ * Switches between the on and off phases.
+ */
+void LED_BLINK_ISR(void)
+{
+    TIM_ClearITPendingBit(LED_BLINK_TIM, TIM_IT_Update);
+
+    hb_led_on = !hb_led_on;
+    if(hb_led_on)
+        hb_led_write(hb_led_duty[0], hb_led_duty[1], hb_led_duty[2]);
+    else
+        hb_led_write(0, 0, 0);
+}
@@ -140,3 +140,162 @@ void SYS_RUNSTATS_ISR (void)
     sysTimerCnt++;
 }
 
+
+/**
+  * @brief  Start the independent watchdog, it cannot be stopped afterwards.
+  *         The counter is frozen while the core is halted by a debugger.
+  *         Clears the reset flags, see hb_sys_iwdg_get_reset().
+  * @param  timeout_ms: time without hb_sys_iwdg_kick() before a reset,
+  *         2 to 8190 ms with the nominal 32 kHz LSI (17 to 47 kHz over
+  *         the temperature and supply range)
+  * @retval None
+  */
+void hb_sys_iwdg_init(uint16_t timeout_ms)
+{
+    RCC_ClearFlag();
+    DBGMCU_APB1PeriphConfig(DBGMCU_IWDG_STOP, ENABLE);
+
+    /* LSI / 64 = 2 ms per count */
+    IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+    IWDG_SetPrescaler(IWDG_Prescaler_64);
+    IWDG_SetReload((timeout_ms / 2 > 0x0FFF) ? 0x0FFF : timeout_ms / 2);
+    IWDG_ReloadCounter();
+    IWDG_Enable();
+}
+
+void hb_sys_iwdg_kick(void)
+{
+    IWDG_ReloadCounter();
+}
+
+/**
+  * @brief  Tell whether the last reset was done by the independent watchdog
+  * @param  None
+  * @retval SET after a watchdog reset, until hb_sys_iwdg_init()
+  */
+FlagStatus hb_sys_iwdg_get_reset(void)
+{
+    return RCC_GetFlagStatus(RCC_FLAG_IWDGRST);
+}
+
+/**
+  * @brief  Start the DWT cycle counter (DWT->CYCCNT), it wraps around
+  *         every 2^32 core clock cycles and stops in sleep mode.
+  *         Left untouched when already running.
+  * @param  None
+  * @retval None
+  */
+void hb_sys_cycle_counter_init(void)
+{
+    if((CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+        return;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    /* The Cortex-M7 DWT is locked after reset */
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+  * @brief  Initialize the low-power timer used as tickless idle wake-up
+  *         source. It is clocked by APB1 like the run-time stats timer,
+  *         so both keep running in sleep mode.
+  * @param  nvic_priority: priority of the auto-reload match interrupt
+  * @retval None
+  */
+void hb_sys_lptim_init(uint32_t nvic_priority)
+{
+    LPTIM_InitTypeDef LPTIM_InitStruct;
+
+    SYS_LPTIM_CLK_ENABLE();
+    RCC_LPTIMClockSourceConfig(SYS_LPTIM, RCC_LPTIMCLKSource_APB);
+
+    /* Configuration and interrupts can only be written while disabled */
+    LPTIM_Cmd(SYS_LPTIM, DISABLE);
+    LPTIM_InitStruct.LPTIM_ClockSource = LPTIM_ClockSource_APBClock_LPosc;
+    LPTIM_InitStruct.LPTIM_Prescaler = SYS_LPTIM_PRESCALER;
+    LPTIM_InitStruct.LPTIM_Waveform = LPTIM_Waveform_PWM_OnePulse;
+    LPTIM_InitStruct.LPTIM_OutputPolarity = LPTIM_OutputPolarity_High;
+    LPTIM_Init(SYS_LPTIM, &LPTIM_InitStruct);
+    LPTIM_ITConfig(SYS_LPTIM, LPTIM_IT_ARRM, ENABLE);
+
+    NVIC_SetPriority(SYS_LPTIM_IRQn, nvic_priority);
+    NVIC_EnableIRQ(SYS_LPTIM_IRQn);
+}
+
+uint32_t hb_sys_lptim_get_hz(void)
+{
+    RCC_ClocksTypeDef clocks;
+
+    RCC_GetClocksFreq(&clocks);
+
+    /* PRESC field, bits 11..9: division by 2^PRESC */
+    return clocks.PCLK1_Frequency >> (SYS_LPTIM_PRESCALER >> 9);
+}
+
+/**
+  * @brief  Start counting from 0, the interrupt is raised when the counter
+  *         matches the period. The counter then wraps around and goes on.
+  * @param  period: counts before the interrupt
+  * @retval None
+  */
+void hb_sys_lptim_start(uint16_t period)
+{
+    LPTIM_Cmd(SYS_LPTIM, ENABLE);
+    LPTIM_ClearFlag(SYS_LPTIM, LPTIM_CLEAR_ARRM);
+    LPTIM_ClearFlag(SYS_LPTIM, LPTIM_CLEAR_ARROK);
+
+    /* ARR is written in the LPTIM clock domain */
+    LPTIM_SetAutoreloadValue(SYS_LPTIM, period);
+    while(LPTIM_GetFlagStatus(SYS_LPTIM, LPTIM_FLAG_ARROK) == RESET);
+
+    LPTIM_SelectOperatingMode(SYS_LPTIM, LPTIM_Mode_Continuous);
+}
+
+/**
+  * @brief  Counts since hb_sys_lptim_start(), valid up to twice the period
+  * @param  None
+  * @retval Elapsed counts
+  */
+uint32_t hb_sys_lptim_get_elapsed(void)
+{
+    FlagStatus wrapped;
+    uint32_t count;
+
+    /* The counter is read twice to get a stable value, the match flag
+     * is sampled again in case the counter wrapped in between */
+    do {
+        wrapped = LPTIM_GetFlagStatus(SYS_LPTIM, LPTIM_FLAG_ARRM);
+        count = LPTIM_GetCounterValue(SYS_LPTIM);
+    } while(count != LPTIM_GetCounterValue(SYS_LPTIM) ||
+            wrapped != LPTIM_GetFlagStatus(SYS_LPTIM, LPTIM_FLAG_ARRM));
+
+    if(wrapped == SET)
+        count += LPTIM_GetAutoreloadValue(SYS_LPTIM) + 1;
+
+    return count;
+}
+
+/**
+  * @brief  Stop the counter, the pending interrupt is discarded
+  * @param  None
+  * @retval None
+  */
+void hb_sys_lptim_stop(void)
+{
+    LPTIM_Cmd(SYS_LPTIM, DISABLE);
+    LPTIM_ClearFlag(SYS_LPTIM, LPTIM_CLEAR_ARRM);
+    NVIC_ClearPendingIRQ(SYS_LPTIM_IRQn);
+}
+
+/*
+ * Low-Power Timer Interrupt Sub-routine
+ * The match interrupt only wakes the core up, it is normally discarded
+ * by hb_sys_lptim_stop() before interrupts are enabled again.
+ */
+void SYS_LPTIM_ISR(void)
+{
+    LPTIM_ClearFlag(SYS_LPTIM, LPTIM_CLEAR_ARRM);
+}
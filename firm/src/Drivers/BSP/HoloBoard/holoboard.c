@@ -18,13 +18,15 @@
  *      o TIM1                  for [MOT] Main Motors DIR and PWM channels 1 to 4
  *      o TIM3 / TIM4           for [QUA] Quadrature Encoders channels A (1) and B (2)
  *      o TIM5 / TIM8           for [ASV] Analog Servos PWM channels 1 to 8
+ *      o TIM2 / TIM7           for [LED] RGB LED PWM channels and blinking
  *      o TIM6                  for [SYS] Run-Time statistics
+ *      o LPTIM1                for [SYS] Tickless idle wake-up
  *      o SPI4                  for [HMI] Human Machine Interface
  *      o CAN1                  for [CAN] CAN bus Interface
  *      o USART1                for [DBG] Debug USART
  *      o USART2                for [RS4] RS485 bus Interface
  *      o USART3                for [DSV] Digital Servo bus Interface
- *      o ADC1 / TIM2 / DMA2    for [MON] Analog monitoring (Scan-mode with DMA, auto)
+ *      o ADC1 / DMA2           for [MON] Analog monitoring (Scan-mode with DMA, auto)
  *      o USB_OTG               for [USB] USB OTG High-Speed 2.0 Interface
  * -----------------------------------------------------------------------------
  * Versionning informations
@@ -48,7 +50,8 @@ void hb_init(void)
 
     /* Modules without custom-configuration */
     hb_led_init();
-    hb_lcmxo2_init();
+    hb_lcmxo2_init();   /* FPGA started and identified, see hb_lcmxo2_get_state() */
+    hb_fault_init();
 
     /* Set Interrupt group priority */
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_4);
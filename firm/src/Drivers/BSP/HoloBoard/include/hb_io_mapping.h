@@ -22,7 +22,7 @@
 ********************************************************************************
 **
 **  RGB LED
-**    3x Digital Outputs
+**    3x PWM Outputs (TIM2 CH1..3), blinking timer (TIM7)
 **
 ********************************************************************************
 */
@@ -34,33 +34,51 @@
 /* Number of instances */
 #define LEDn                            ((uint8_t) 3)
 
-/* MCU I/O connected on the LED anodes */
-#define LEDx_ON                         (Bit_RESET)
-#define LEDx_OFF                        (Bit_SET)
+/* PWM timer, the MCU I/Os are connected on the LED cathodes (active low) */
+#define LED_PWM_TIM                      TIM2
+#define LED_PWM_TIM_CLK_ENABLE()         RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE)
+#define LED_PWM_TIM_CLK_DISABLE()        RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, DISABLE)
+#define LED_PWM_POLARITY                 TIM_OCPolarity_Low
 
-/* LEDR Mapped on PA0 */
+/* Blinking timer */
+#define LED_BLINK_TIM                    TIM7
+#define LED_BLINK_TIM_CLK_ENABLE()       RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM7, ENABLE)
+#define LED_BLINK_TIM_CLK_DISABLE()      RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM7, DISABLE)
+#define LED_BLINK_IRQn                   TIM7_IRQn
+#define LED_BLINK_ISR                    TIM7_IRQHandler
+
+/* LEDR Mapped on PA0 / TIM2_CH1 */
 #define LEDR_GPIO_PORT                   GPIOA
 #define LEDR_GPIO_CLK_ENABLE()           RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, ENABLE)
 #define LEDR_GPIO_CLK_DISABLE()          RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, DISABLE)
 #define LEDR_PIN                         GPIO_Pin_0
-#define LEDR_WRITE(_v)                   GPIO_WriteBit(LEDR_GPIO_PORT, LEDR_PIN, (_v))
-#define LEDR_TOGGLE()                    GPIO_ToggleBits(LEDR_GPIO_PORT, LEDR_PIN)
+#define LEDR_PIN_SOURCE                  GPIO_PinSource0
+#define LEDR_AF                          GPIO_AF1_TIM2
+#define LEDR_OC_INIT(_s)                 TIM_OC1Init(LED_PWM_TIM, (_s))
+#define LEDR_OC_PRELOAD()                TIM_OC1PreloadConfig(LED_PWM_TIM, TIM_OCPreload_Enable)
+#define LEDR_SET_DUTY(_d)                TIM_SetCompare1(LED_PWM_TIM, (_d))
 
-/* LEDG Mapped on PA1 */
+/* LEDG Mapped on PA1 / TIM2_CH2 */
 #define LEDG_GPIO_PORT                   GPIOA
 #define LEDG_GPIO_CLK_ENABLE()           RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, ENABLE)
 #define LEDG_GPIO_CLK_DISABLE()          RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, DISABLE)
 #define LEDG_PIN                         GPIO_Pin_1
-#define LEDG_WRITE(_v)                   GPIO_WriteBit(LEDG_GPIO_PORT, LEDG_PIN, (_v))
-#define LEDG_TOGGLE()                    GPIO_ToggleBits(LEDG_GPIO_PORT, LEDG_PIN)
+#define LEDG_PIN_SOURCE                  GPIO_PinSource1
+#define LEDG_AF                          GPIO_AF1_TIM2
+#define LEDG_OC_INIT(_s)                 TIM_OC2Init(LED_PWM_TIM, (_s))
+#define LEDG_OC_PRELOAD()                TIM_OC2PreloadConfig(LED_PWM_TIM, TIM_OCPreload_Enable)
+#define LEDG_SET_DUTY(_d)                TIM_SetCompare2(LED_PWM_TIM, (_d))
 
-/* LEDB Mapped on PA2 */
+/* LEDB Mapped on PA2 / TIM2_CH3 */
 #define LEDB_GPIO_PORT                   GPIOA
 #define LEDB_GPIO_CLK_ENABLE()           RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, ENABLE)
 #define LEDB_GPIO_CLK_DISABLE()          RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, DISABLE)
 #define LEDB_PIN                         GPIO_Pin_2
-#define LEDB_WRITE(_v)                   GPIO_WriteBit(LEDB_GPIO_PORT, LEDB_PIN, (_v))
-#define LEDB_TOGGLE()                    GPIO_ToggleBits(LEDB_GPIO_PORT, LEDB_PIN)
+#define LEDB_PIN_SOURCE                  GPIO_PinSource2
+#define LEDB_AF                          GPIO_AF1_TIM2
+#define LEDB_OC_INIT(_s)                 TIM_OC3Init(LED_PWM_TIM, (_s))
+#define LEDB_OC_PRELOAD()                TIM_OC3PreloadConfig(LED_PWM_TIM, TIM_OCPreload_Enable)
+#define LEDB_SET_DUTY(_d)                TIM_SetCompare3(LED_PWM_TIM, (_d))
 
 /**
  * @}
@@ -73,13 +91,15 @@
 /**
 ********************************************************************************
 **
-**    Main Motors Full H-Bridges (DRV8872) and QEI through LCMXO2-256HC (SPI)
+**    Main Motors Full H-Bridges (DRV8872) and QEI through LCMXO2-1200HC (SPI)
+**    (32-QFN, fitted instead of the LCMXO2-256HC, too small for the design)
 **    1x Digital Output for LCMXO2 Reset
 **    1x Digital Output for SPI_MISO
 **    1x Digital Output for SPI_CLK
 **    1x Digital Output for SPI_SS (software managed)
 **    1x Digital Input for SPI_MOSI
-**	  4x Digital Inputs for fault feedback (MOT0_FAULT/MOT1_FAULT/MOT2_FAULT/MOT3_FAULT)
+**	  3x Digital Inputs for fault feedback (MOT0_FAULT/MOT1_FAULT/MOT2_FAULT)
+**    1x Digital Input for the LCMXO2 interrupt line (LCMXO2_IRQ)
 **
 ********************************************************************************
 */
@@ -94,6 +114,11 @@
 #define SPI_CLK_DISABLE()                   RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, DISABLE)
 #define SPI_IRQn                            SPI1_IRQn
 
+/* Motor faults: falling edge interrupts, MOT0..2 on EXTI lines 9..7 */
+#define MOT_FAULT_SYSCFG_CLK_ENABLE()       RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE)
+#define MOT_FAULT_IRQn                      EXTI9_5_IRQn
+#define MOT_FAULT_ISR                       EXTI9_5_IRQHandler
+
 /* Sleep, Reset and Fault are active low */
 #define LCMXO2_RESET_ON                       (Bit_SET)
 #define LCMXO2_RESET_OFF                      (Bit_RESET)
@@ -145,24 +170,40 @@
 #define MOT0_FAULT_GPIO_CLK_ENABLE()        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE, ENABLE)
 #define MOT0_FAULT_GPIO_CLK_DISABLE()       RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE, DISABLE)
 #define MOT0_FAULT_PIN                      GPIO_Pin_9
+#define MOT0_FAULT_EXTI_LINE                EXTI_Line9
+#define MOT0_FAULT_EXTI_PORT_SOURCE         EXTI_PortSourceGPIOE
+#define MOT0_FAULT_EXTI_PIN_SOURCE          EXTI_PinSource9
 
 /* MOT1_FAULT Mapped on PE8 */
 #define MOT1_FAULT_GPIO_PORT                GPIOE
 #define MOT1_FAULT_GPIO_CLK_ENABLE()        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE, ENABLE)
 #define MOT1_FAULT_GPIO_CLK_DISABLE()       RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE, DISABLE)
 #define MOT1_FAULT_PIN                      GPIO_Pin_8
+#define MOT1_FAULT_EXTI_LINE                EXTI_Line8
+#define MOT1_FAULT_EXTI_PORT_SOURCE         EXTI_PortSourceGPIOE
+#define MOT1_FAULT_EXTI_PIN_SOURCE          EXTI_PinSource8
 
 /* MOT2_FAULT Mapped on PE7 */
 #define MOT2_FAULT_GPIO_PORT                GPIOE
 #define MOT2_FAULT_GPIO_CLK_ENABLE()        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE, ENABLE)
 #define MOT2_FAULT_GPIO_CLK_DISABLE()       RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE, DISABLE)
 #define MOT2_FAULT_PIN                      GPIO_Pin_7
-
-/* MOT3_FAULT Mapped on PB2 */
-#define MOT3_FAULT_GPIO_PORT                GPIOB
-#define MOT3_FAULT_GPIO_CLK_ENABLE()        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOB, ENABLE)
-#define MOT3_FAULT_GPIO_CLK_DISABLE()       RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOB, DISABLE)
-#define MOT3_FAULT_PIN                      GPIO_Pin_2
+#define MOT2_FAULT_EXTI_LINE                EXTI_Line7
+#define MOT2_FAULT_EXTI_PORT_SOURCE         EXTI_PortSourceGPIOE
+#define MOT2_FAULT_EXTI_PIN_SOURCE          EXTI_PinSource7
+
+/* LCMXO2_IRQ Mapped on PB2, the MOT3_FAULT input (no bridge behind it)
+ * wired to the LCMXO2 IRQ_O output. Rising edge interrupt on EXTI line 2. */
+#define LCMXO2_IRQ_GPIO_PORT                GPIOB
+#define LCMXO2_IRQ_GPIO_CLK_ENABLE()        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOB, ENABLE)
+#define LCMXO2_IRQ_GPIO_CLK_DISABLE()       RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOB, DISABLE)
+#define LCMXO2_IRQ_SYSCFG_CLK_ENABLE()      RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE)
+#define LCMXO2_IRQ_PIN                      GPIO_Pin_2
+#define LCMXO2_IRQ_EXTI_LINE                EXTI_Line2
+#define LCMXO2_IRQ_EXTI_PORT_SOURCE         EXTI_PortSourceGPIOB
+#define LCMXO2_IRQ_EXTI_PIN_SOURCE          EXTI_PinSource2
+#define LCMXO2_IRQn                         EXTI2_IRQn
+#define LCMXO2_ISR                          EXTI2_IRQHandler
 /**
  * @}
  */
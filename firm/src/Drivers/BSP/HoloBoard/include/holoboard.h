@@ -57,6 +57,83 @@
  #define SYS_RUNSTATS_IRQn                   TIM6_DAC_IRQn
  #define SYS_RUNSTATS_ISR                    TIM6_DAC_IRQHandler
 
+ /* Low-power timer waking the core up from the tickless idle */
+ #define SYS_LPTIM                           LPTIM1
+ #define SYS_LPTIM_CLK_ENABLE()              RCC_APB1PeriphClockCmd(RCC_APB1Periph_LPTIM1, ENABLE)
+ #define SYS_LPTIM_CLK_DISABLE()             RCC_APB1PeriphClockCmd(RCC_APB1Periph_LPTIM1, DISABLE)
+ #define SYS_LPTIM_IRQn                      LPTIM1_IRQn
+ #define SYS_LPTIM_ISR                       LPTIM1_IRQHandler
+
+ /* LCMXO2 register file (see holoboard_pkg.vhd)
+  * Command word: bit 15 = write, bits 7..0 = start address, the address
+  * auto-increments on each following word of the same SS window. */
+ #define HB_LCMXO2_NB_CHANNELS               3
+ #define HB_LCMXO2_CMD_WRITE                 0x8000
+ #define HB_LCMXO2_CMD_CRC                   0x4000
+ #define HB_LCMXO2_CMD_LENGTH(_n)            (((_n) & 0x3F) << 8)
+ #define HB_LCMXO2_REG_STATUS                0x00
+ #define HB_LCMXO2_REG_CONFIG                0x01
+ #define HB_LCMXO2_REG_CRC_ERR               0x02
+ #define HB_LCMXO2_REG_QEI_FILTER            0x03
+ #define HB_LCMXO2_REG_SAMPLE_PERIOD         0x04
+ #define HB_LCMXO2_REG_IRQ_EN                0x05
+ #define HB_LCMXO2_REG_VEL_PERIOD            0x06
+ #define HB_LCMXO2_REG_ID                    0x07
+ #define HB_LCMXO2_REG_CAPS                  0x08
+ #define HB_LCMXO2_REG_QEI(_ch)              (0x10 + (_ch))
+ #define HB_LCMXO2_REG_PWM_DUTY(_ch)         (0x20 + (_ch))
+ #define HB_LCMXO2_REG_PWM_PERIOD(_ch)       (0x30 + (_ch))
+ #define HB_LCMXO2_REG_PWM_DEADBAND(_ch)     (0x40 + (_ch))
+ #define HB_LCMXO2_REG_QEI_ERR(_ch)          (0x50 + (_ch))    /* saturates at 255 */
+ #define HB_LCMXO2_REG_PWM_SLEW(_ch)         (0x60 + (_ch))
+ #define HB_LCMXO2_REG_VEL_REF(_ch)          (0x70 + (_ch))
+ #define HB_LCMXO2_REG_VEL_KP(_ch)           (0x80 + (_ch))
+ #define HB_LCMXO2_REG_VEL_KI(_ch)           (0x90 + (_ch))
+
+ /* LCMXO2 CRC mode: CRC-8 (poly 0x07, init 0xFF, msb first) over the
+  * command and data words of a burst. Writes are staged by the FPGA,
+  * which limits them to HB_LCMXO2_CRC_WRITE_MAX words. */
+ #define HB_LCMXO2_CRC_POLY                  0x07
+ #define HB_LCMXO2_CRC_INIT                  0xFF
+ #define HB_LCMXO2_CRC_ACK                   0xA5
+ #define HB_LCMXO2_CRC_WRITE_MAX             HB_LCMXO2_NB_CHANNELS
+ #define HB_LCMXO2_CRC_READ_MAX              16
+
+ /* LCMXO2 CONFIG and STATUS bits */
+ #define HB_LCMXO2_CONFIG_PWM_EN             0x0001
+ #define HB_LCMXO2_CONFIG_VEL_EN             0x0002  /* PWM driven by the FPGA velocity loop */
+ #define HB_LCMXO2_STATUS_PWM_EN             0x0001
+ #define HB_LCMXO2_STATUS_SAMPLE             0x0002  /* encoder sample not read yet */
+ #define HB_LCMXO2_STATUS_QEI_FAULT          0x0004  /* an encoder error counter is not zero */
+ #define HB_LCMXO2_STATUS_VEL_EN             0x0008
+ #define HB_LCMXO2_STATUS_READY              0x0010  /* out of reset, encoder inputs settled */
+
+ /* LCMXO2 identification: ID is magic and version, CAPS the channel count
+  * and the optional blocks of the bitstream */
+ #define HB_LCMXO2_ID_MAGIC                  0xB0
+ #define HB_LCMXO2_ID_VERSION                0x02
+ #define HB_LCMXO2_ID(_magic, _version)      (((_magic) << 8) | (_version))
+ #define HB_LCMXO2_CAPS_CHANNELS(_caps)      ((_caps) & 0x001F)
+ #define HB_LCMXO2_CAPS_CRC                  0x0100  /* CRC mode bursts */
+ #define HB_LCMXO2_CAPS_SAMPLE               0x0200  /* sample timer and LCMXO2_IRQ */
+ #define HB_LCMXO2_CAPS_SLEW                 0x0400  /* PWM slew limit */
+ #define HB_LCMXO2_CAPS_VEL                  0x0800  /* velocity loop */
+
+ /* LCMXO2 start-up: reset pulse, then the identification is polled until
+  * STATUS.READY or the timeout. The configuration from the internal flash
+  * may still run at that time. */
+ #define HB_LCMXO2_RESET_US                  10
+ #define HB_LCMXO2_POLL_US                   100
+ #define HB_LCMXO2_INIT_TIMEOUT_MS           100
+
+ /* LCMXO2 IRQ_EN bits, sources of the LCMXO2_IRQ pulses */
+ #define HB_LCMXO2_IRQ_SAMPLE                0x0001
+ #define HB_LCMXO2_IRQ_QEI_FAULT             0x0002
+
+ /* Largest PWM magnitude accepted by the LCMXO2: pwm_generator.vhd is
+  * fully on once the duty reaches the period (sign is bit 15) */
+ #define HB_LCMXO2_PWM_MAX                   HB_LCMXO2_PWM_PERIOD
+
 /**
 ********************************************************************************
 **
@@ -84,6 +161,31 @@ typedef enum {
     HB_LED_BLINK_FAST   = 2
 } HB_LED_ModeTypeDef;
 
+/* LCMXO2 start-up result, see hb_lcmxo2_init() */
+typedef enum {
+    HB_LCMXO2_NOT_STARTED   = 0, /* hb_lcmxo2_init() not called */
+    HB_LCMXO2_READY         = 1, /* identified and ready */
+    HB_LCMXO2_NO_ANSWER     = 2, /* nothing answers, missing bitstream */
+    HB_LCMXO2_WRONG_ID      = 3, /* another design, version or channel count */
+    HB_LCMXO2_NOT_READY     = 4  /* identified, STATUS.READY never set */
+} HB_LCMXO2_StateTypeDef;
+
+
+/**
+********************************************************************************
+**
+**  Structures
+**
+********************************************************************************
+*/
+
+/* LCMXO2 SPI link statistics, CRC mode only */
+typedef struct {
+    uint32_t bursts;        /* bursts done, retries excluded */
+    uint32_t crc_errors;    /* attempts failing the CRC check, retried */
+    uint32_t failures;      /* bursts dropped after HB_LCMXO2_SPI_RETRIES */
+} HB_LCMXO2_SpiStatsTypeDef;
+
 
 /**
 ********************************************************************************
@@ -101,16 +203,56 @@ void hb_system_clock_config(void);
 void hb_sys_cpu_cache_enable(void);
 void hb_sys_timer_run_time_config();
 uint32_t hb_sys_timer_get_run_time_ticks(void);
+void hb_sys_iwdg_init(uint16_t timeout_ms);
+void hb_sys_iwdg_kick(void);
+FlagStatus hb_sys_iwdg_get_reset(void);
+void hb_sys_cycle_counter_init(void);
+void hb_sys_lptim_init(uint32_t nvic_priority);
+uint32_t hb_sys_lptim_get_hz(void);
+void hb_sys_lptim_start(uint16_t period);
+uint32_t hb_sys_lptim_get_elapsed(void);
+void hb_sys_lptim_stop(void);
 
 /* RGB LED */
 void hb_led_init(void);
 void hb_led_set_color(HB_LED_ColorTypeDef color);
+void hb_led_set_rgb(uint8_t red, uint8_t green, uint8_t blue);
+void hb_led_set_blink(uint16_t half_period_ms);
 
 /* FPGA LCMXO2 */
-void hb_lcmxo2_init(void);
-uint16_t hb_lcmxo2_tx_rx(uint16_t value);
-void hb_lcmxo2_set_pwm(uint16_t motor, int16_t value);
-int16_t hb_lcmxo2_get_qei(uint16_t encoder);
+HB_LCMXO2_StateTypeDef hb_lcmxo2_init(void);
+HB_LCMXO2_StateTypeDef hb_lcmxo2_get_state(void);
+uint16_t hb_lcmxo2_get_id(void);
+uint16_t hb_lcmxo2_get_caps(void);
+ErrorStatus hb_lcmxo2_read(uint8_t address, uint16_t* data, uint8_t length, uint16_t* status);
+uint16_t hb_lcmxo2_write(uint8_t address, const uint16_t* data, uint8_t length);
+void hb_lcmxo2_set_pwm_enable(FunctionalState state);
+void hb_lcmxo2_set_pwm(uint16_t channel, int16_t value);
+void hb_lcmxo2_set_pwm_period(uint16_t channel, uint16_t period);
+void hb_lcmxo2_set_pwm_deadband(uint16_t channel, uint8_t deadband);
+void hb_lcmxo2_set_pwm_slew(uint16_t channel, uint16_t slew);
+void hb_lcmxo2_set_qei_filter(uint8_t filter);
+void hb_lcmxo2_set_sample(uint16_t period_us, uint16_t irq_sources);
+void hb_lcmxo2_set_vel_loop(uint16_t period_us, FunctionalState state);
+void hb_lcmxo2_set_vel_gains(uint16_t channel, int16_t kp, int16_t ki);
+void hb_lcmxo2_set_vel_ref_all(const int16_t* refs);
+int16_t hb_lcmxo2_get_qei(uint16_t channel);
+ErrorStatus hb_lcmxo2_get_qei_all(int16_t* counters, uint16_t* status);
+void hb_lcmxo2_irq_enable(uint32_t nvic_priority);
+void hb_lcmxo2_irq_disable(void);
+FlagStatus hb_lcmxo2_irq_get_it(void);
+void hb_lcmxo2_get_spi_stats(HB_LCMXO2_SpiStatsTypeDef* stats);
+void hb_lcmxo2_clear_spi_stats(void);
+void hb_lcmxo2_emergency_stop(void);
+void hb_lcmxo2_clear_stop(void);
+FlagStatus hb_lcmxo2_get_stop(void);
+
+/* Motor faults */
+void hb_fault_init(void);
+void hb_fault_enable(uint32_t nvic_priority);
+void hb_fault_disable(void);
+uint8_t hb_fault_get_it(void);
+uint8_t hb_fault_get_state(void);
 
 /* Debug Interface */
 void hb_dbg_init(USART_InitTypeDef * USART_InitStruct);
@@ -61,12 +61,6 @@ one of the application files:
 	#define configAPPLICATION_PROVIDES_cOutputBuffer 0
 #endif
 
-typedef struct xCOMMAND_INPUT_LIST
-{
-	const CLI_Command_Definition_t *pxCommandLineDefinition;
-	struct xCOMMAND_INPUT_LIST *pxNext;
-} CLI_Definition_List_Item_t;
-
 /*
  * The callback function that is executed when "help" is entered.  This is the
  * only default command that is always present.
@@ -78,6 +72,11 @@ static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, c
  */
 static int8_t prvGetNumberOfParameters( const char *pcCommandString );
 
+/*
+ * Add a command to the end of the list of registered commands.
+ */
+static void prvRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister, CLI_Definition_List_Item_t *pxNewListItem );
+
 /* The definition of the "help" command.  This command is always at the front
 of the list of registered commands. */
 static const CLI_Command_Definition_t xHelpCommand =
@@ -118,45 +117,71 @@ buffer needs to be placed at a fixed address (rather than by the linker). */
 
 /*-----------------------------------------------------------*/
 
-BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister )
+static void prvRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister, CLI_Definition_List_Item_t *pxNewListItem )
 {
 static CLI_Definition_List_Item_t *pxLastCommandInList = &xRegisteredCommands;
-CLI_Definition_List_Item_t *pxNewListItem;
-BaseType_t xReturn = pdFAIL;
 
-	/* Check the parameter is not NULL. */
-	configASSERT( pxCommandToRegister );
+	taskENTER_CRITICAL();
+	{
+		/* Reference the command being registered from the newly created
+		list item. */
+		pxNewListItem->pxCommandLineDefinition = pxCommandToRegister;
+
+		/* The new list item will get added to the end of the list, so
+		pxNext has nowhere to point. */
+		pxNewListItem->pxNext = NULL;
+
+		/* Add the newly created list item to the end of the already existing
+		list. */
+		pxLastCommandInList->pxNext = pxNewListItem;
+
+		/* Set the end of list marker to the new list item. */
+		pxLastCommandInList = pxNewListItem;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
 
-	/* Create a new list item that will reference the command being registered. */
-	pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
-	configASSERT( pxNewListItem );
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
-	if( pxNewListItem != NULL )
+	BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister )
 	{
-		taskENTER_CRITICAL();
-		{
-			/* Reference the command being registered from the newly created
-			list item. */
-			pxNewListItem->pxCommandLineDefinition = pxCommandToRegister;
+	CLI_Definition_List_Item_t *pxNewListItem;
+	BaseType_t xReturn = pdFAIL;
 
-			/* The new list item will get added to the end of the list, so
-			pxNext has nowhere to point. */
-			pxNewListItem->pxNext = NULL;
+		/* Check the parameter is not NULL. */
+		configASSERT( pxCommandToRegister );
 
-			/* Add the newly created list item to the end of the already existing
-			list. */
-			pxLastCommandInList->pxNext = pxNewListItem;
+		/* Create a new list item that will reference the command being registered. */
+		pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
+		configASSERT( pxNewListItem );
 
-			/* Set the end of list marker to the new list item. */
-			pxLastCommandInList = pxNewListItem;
+		if( pxNewListItem != NULL )
+		{
+			prvRegisterCommand( pxCommandToRegister, pxNewListItem );
+			xReturn = pdPASS;
 		}
-		taskEXIT_CRITICAL();
 
-		xReturn = pdPASS;
+		return xReturn;
 	}
 
-	return xReturn;
-}
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	BaseType_t FreeRTOS_CLIRegisterCommandStatic( const CLI_Command_Definition_t * const pxCommandToRegister, CLI_Definition_List_Item_t *pxCliDefinitionListItemBuffer )
+	{
+		/* Check the parameters are not NULL. */
+		configASSERT( pxCommandToRegister );
+		configASSERT( pxCliDefinitionListItemBuffer );
+
+		prvRegisterCommand( pxCommandToRegister, pxCliDefinitionListItemBuffer );
+
+		return pdPASS;
+	}
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
 /*-----------------------------------------------------------*/
 
 BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  )
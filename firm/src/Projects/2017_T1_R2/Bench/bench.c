@@ -0,0 +1,106 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       bench.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   On-target runner of the control-path benchmarks (bench.h), built with
+ *   BENCH_TARGET: the motion control is not started, the kernels own the
+ *   pid.c settings. The shell 'bench' command runs the kernels one by one
+ *   and dumps their cycles, to be reported by firm/host/bench_host.c
+ *   (--target_dump) in the Google Benchmark formats.
+ *
+ *   Each kernel is timed by batches of calls with the interrupts masked,
+ *   the minimum batch is the kernel alone, the average includes the cache
+ *   misses of the first calls.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+#include "bench.h"
+
+#if BENCH_TARGET
+
+/* Batches of each kernel, a batch lasts less than a millisecond */
+#define BENCH_BATCHES               32
+#define BENCH_BATCH_ITERATIONS      64
+
+/* Dump state, the shell calls bench_dump() until it returns pdFALSE */
+static uint32_t bench_dump_index;
+static bool bench_dump_started;
+
+/**
+  * @brief  Time a kernel and print its line
+  * @param  kernel: the kernel
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+static void bench_kernel(const bench_kernel_t* kernel, char* buffer, size_t length)
+{
+    uint32_t checksum, start, cycles, cycles_min = UINT32_MAX;
+    uint64_t cycles_total = 0;
+    uint16_t batch;
+
+    checksum = bench_check(kernel);
+
+    kernel->setup();
+    for(batch = 0; batch < BENCH_BATCHES; batch++)
+    {
+        taskENTER_CRITICAL();
+        start = DWT->CYCCNT;
+        kernel->run(BENCH_BATCH_ITERATIONS);
+        cycles = DWT->CYCCNT - start;
+        taskEXIT_CRITICAL();
+
+        cycles_total += cycles;
+        if(cycles < cycles_min)
+            cycles_min = cycles;
+    }
+
+    snprintf(buffer, length, "B %s %u %u %lu %lu %08lx %08lx\n\r",
+             kernel->name, BENCH_BATCH_ITERATIONS, BENCH_BATCHES,
+             (unsigned long)cycles_min, (unsigned long)(cycles_total / BENCH_BATCHES),
+             (unsigned long)checksum, (unsigned long)kernel->reference);
+}
+
+/**
+  * @brief  Run the benchmarks, one kernel per call.
+  *         Lines:  # bench <cpu_hz> <kernels>
+  *                 B <name> <iterations per batch> <batches> <min cycles> <avg cycles> <checksum> <reference>
+  *                 # end
+  *         Cycles of a batch, checksums in hexadecimal.
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval pdTRUE while there is more to dump
+  */
+BaseType_t bench_dump(char* buffer, size_t length)
+{
+    if(!bench_dump_started)
+    {
+        /* Cycle counter started by trace_init() */
+        snprintf(buffer, length, "# bench %lu %lu\n\r",
+                 (unsigned long)configCPU_CLOCK_HZ, (unsigned long)bench_nb_kernels);
+        bench_dump_index = 0;
+        bench_dump_started = true;
+        return pdTRUE;
+    }
+
+    if(bench_dump_index < bench_nb_kernels)
+    {
+        bench_kernel(&bench_kernels[bench_dump_index++], buffer, length);
+        return pdTRUE;
+    }
+
+    snprintf(buffer, length, "# end\n\r");
+    bench_dump_started = false;
+    return pdFALSE;
+}
+
+#endif /* BENCH_TARGET */
@@ -0,0 +1,315 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       bench_kernels.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Control-path kernels of the benchmarks, see bench.h. Built for the
+ *   target and for the host: no hardware access, the PID processes have
+ *   no PWM output and the encoder counters come from the inputs.
+ *
+ *   The inputs are drawn by a xorshift generator from a fixed seed, so the
+ *   checksums only change with the results of the kernels. The setups
+ *   write the wheel desaturation, feed-forward and output settings of
+ *   pid.c: the benchmarks do not run along with the motion control.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "pid.h"
+#include "bench.h"
+
+/* Inputs of a run, a power of two */
+#define BENCH_INPUTS            256
+#define BENCH_SEED              0x4847B0B0UL
+
+/* Wheel commands limit, as the PWM period of the motion control */
+#define BENCH_WHEEL_LIMIT       1000
+
+static int32_t bench_input[BENCH_INPUTS];
+static uint32_t bench_step;                     /* calls since the setup */
+
+/* PID processes as pid_init() hands them out, without its pool */
+static PID_process_t bench_process[MOTION_AXES];
+static PID_struct_t bench_pid[MOTION_AXES];
+static PID_holonomic_t bench_base;
+
+/* Kernel states */
+static int32_t bench_wheel_position[PID_WHEELS];
+static int32_t bench_wheel_command[PID_WHEELS];
+static int32_t bench_rotation[PID_WHEELS];
+static int32_t bench_position;
+static encoder_t bench_encoders[PID_WHEELS];
+static uint16_t bench_counters[PID_WHEELS];
+
+/* Next input, 'offset' picks another one of the same step */
+#define BENCH_INPUT(_offset)    (bench_input[(bench_step + (_offset)) & (BENCH_INPUTS - 1)])
+
+/**
+  * @brief  Draw the inputs, uniform in [-range, range]
+  * @param  range: largest input
+  * @retval None
+  */
+static void bench_inputs(int32_t range)
+{
+    uint32_t state = BENCH_SEED;
+    uint16_t n;
+
+    for(n = 0; n < BENCH_INPUTS; n++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        bench_input[n] = (int32_t)(state % (2 * range + 1)) - range;
+    }
+    bench_step = 0;
+}
+
+/**
+  * @brief  Reset a PID process to the gains of the motion control
+  * @param  axis: process number
+  * @retval The process
+  */
+static PID_process_t* bench_process_init(uint8_t axis)
+{
+    PID_process_t* process = &bench_process[axis];
+
+    memset(process, 0, sizeof(*process));
+    process->PID = &bench_pid[axis];
+    PID_Reset(process);
+    PID_Set_Coefficient(process->PID, 8, 5, 2, 2000);
+    PID_Set_limitation(process, 400, 60);
+    return process;
+}
+
+/* -----------------------------------------------------------------------------
+ * PID_Process: position errors
+ * -----------------------------------------------------------------------------
+ */
+
+static void bench_pid_setup(void)
+{
+    bench_process_init(0);
+    bench_inputs(500);
+}
+
+static uint32_t bench_pid_run(uint32_t iterations)
+{
+    uint32_t checksum = BENCH_CHECKSUM_INIT;
+
+    while(iterations--)
+    {
+        checksum = bench_fold(checksum, PID_Process(&bench_pid[0], BENCH_INPUT(0)));
+        bench_step++;
+    }
+    return checksum;
+}
+
+/* -----------------------------------------------------------------------------
+ * PID_Process_Speed: wheel moving by the inputs, fixed speed reference
+ * -----------------------------------------------------------------------------
+ */
+
+static void bench_speed_setup(void)
+{
+    PID_Set_Ref_Speed(bench_process_init(0), 20);
+    bench_position = 0;
+    bench_inputs(40);
+}
+
+static uint32_t bench_speed_run(uint32_t iterations)
+{
+    uint32_t checksum = BENCH_CHECKSUM_INIT;
+
+    while(iterations--)
+    {
+        bench_position += BENCH_INPUT(0);
+        PID_Process_Speed(&bench_process[0], bench_position);
+        checksum = bench_fold(checksum, bench_process[0].last_ref);
+        bench_step++;
+    }
+    return checksum;
+}
+
+/* -----------------------------------------------------------------------------
+ * PID_Manage_limitation: speed and acceleration saturations
+ * -----------------------------------------------------------------------------
+ */
+
+static void bench_limitation_setup(void)
+{
+    bench_process_init(0);
+    bench_inputs(600);
+}
+
+static uint32_t bench_limitation_run(uint32_t iterations)
+{
+    uint32_t checksum = BENCH_CHECKSUM_INIT;
+
+    while(iterations--)
+    {
+        checksum = bench_fold(checksum, PID_Manage_limitation(&bench_process[0], BENCH_INPUT(0)));
+        bench_step++;
+    }
+    return checksum;
+}
+
+/* -----------------------------------------------------------------------------
+ * PID_Process_holonomic: wheels to axes matrix, the 3 axes reference profiles
+ * and PIDs, axes to wheels matrix, wheels feed-forward and desaturation
+ * -----------------------------------------------------------------------------
+ */
+
+static void bench_holonomic_setup(void)
+{
+    uint8_t n;
+
+    for(n = 0; n < MOTION_AXES; n++)
+        PID_Set_Profile(bench_process_init(n), 150, 10);
+    /* Rotation commands are 12 times larger on the wheels */
+    PID_Set_limitation(&bench_process[MOTION_AXES - 1], 40, 10);
+    PID_Set_Profile(&bench_process[MOTION_AXES - 1], 15, 1);
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        PID_Set_Wheel_Feed_Forward(&bench_base, n, 110, 20, 15);
+        bench_wheel_position[n] = 0;
+    }
+    PID_Set_Wheel_Output(&bench_base, PID_WHEEL_OUTPUT_PWM);
+    PID_Set_Desaturation(&bench_base, BENCH_WHEEL_LIMIT, PID_DESAT_ROTATION);
+    bench_inputs(30);
+}
+
+static uint32_t bench_holonomic_run(uint32_t iterations)
+{
+    uint32_t checksum = BENCH_CHECKSUM_INIT;
+    uint8_t n;
+
+    while(iterations--)
+    {
+        /* Wheels and references moving around the start position */
+        for(n = 0; n < PID_WHEELS; n++)
+            bench_wheel_position[n] += BENCH_INPUT(n) - bench_wheel_position[n] / 8;
+        for(n = 0; n < MOTION_AXES; n++)
+            bench_process[n].ref += BENCH_INPUT(PID_WHEELS + n) / 4 - bench_process[n].ref / 8;
+
+        PID_Process_holonomic(&bench_base, &bench_process[0], &bench_process[1], &bench_process[2],
+                              bench_wheel_position, bench_wheel_command);
+
+        for(n = 0; n < PID_WHEELS; n++)
+            checksum = bench_fold(checksum, bench_wheel_command[n]);
+        bench_step++;
+    }
+    return checksum;
+}
+
+/* -----------------------------------------------------------------------------
+ * PID_Desaturate: wheel commands up to twice the limit, by priority
+ * -----------------------------------------------------------------------------
+ */
+
+static void bench_desaturate_setup(PID_desat_priority_t priority)
+{
+    PID_Set_Desaturation(&bench_base, BENCH_WHEEL_LIMIT, priority);
+    bench_inputs(2 * BENCH_WHEEL_LIMIT);
+}
+
+static void bench_desaturate_scale_setup(void)
+{
+    bench_desaturate_setup(PID_DESAT_SCALE);
+}
+
+static void bench_desaturate_rotation_setup(void)
+{
+    bench_desaturate_setup(PID_DESAT_ROTATION);
+}
+
+static void bench_desaturate_translation_setup(void)
+{
+    bench_desaturate_setup(PID_DESAT_TRANSLATION);
+}
+
+static uint32_t bench_desaturate_run(uint32_t iterations)
+{
+    uint32_t checksum = BENCH_CHECKSUM_INIT;
+    uint8_t n;
+
+    while(iterations--)
+    {
+        for(n = 0; n < PID_WHEELS; n++)
+        {
+            bench_wheel_command[n] = BENCH_INPUT(n);
+            bench_rotation[n] = BENCH_INPUT(PID_WHEELS + n) / 2;
+        }
+
+        PID_Desaturate(&bench_base, bench_wheel_command, bench_rotation);
+
+        for(n = 0; n < PID_WHEELS; n++)
+            checksum = bench_fold(checksum, bench_wheel_command[n]);
+        bench_step++;
+    }
+    return checksum;
+}
+
+/* -----------------------------------------------------------------------------
+ * encoder_update: wheel positions from wrapping 12 bits counters, the part
+ * of encoder_get_position() after the SPI read
+ * -----------------------------------------------------------------------------
+ */
+
+static void bench_encoder_setup(void)
+{
+    memset(bench_encoders, 0, sizeof(bench_encoders));
+    memset(bench_counters, 0, sizeof(bench_counters));
+    bench_inputs(100);
+}
+
+static uint32_t bench_encoder_run(uint32_t iterations)
+{
+    uint32_t checksum = BENCH_CHECKSUM_INIT;
+    uint8_t n;
+
+    while(iterations--)
+    {
+        for(n = 0; n < PID_WHEELS; n++)
+        {
+            bench_counters[n] = (bench_counters[n] + BENCH_INPUT(n)) & 0x0FFF;
+            checksum = bench_fold(checksum, encoder_update(&bench_encoders[n], (int16_t)bench_counters[n]));
+        }
+        bench_step++;
+    }
+    return checksum;
+}
+
+/* -----------------------------------------------------------------------------
+ * Kernels list
+ * -----------------------------------------------------------------------------
+ */
+
+const bench_kernel_t bench_kernels[] = {
+    { "PID_Process",                bench_pid_setup,                    bench_pid_run,          0xBA318C6F },
+    { "PID_Process_Speed",          bench_speed_setup,                  bench_speed_run,        0x8D2DC763 },
+    { "PID_Manage_limitation",      bench_limitation_setup,             bench_limitation_run,   0x26873255 },
+    { "PID_Process_holonomic",      bench_holonomic_setup,              bench_holonomic_run,    0x6015621A },
+    { "PID_Desaturate/scale",       bench_desaturate_scale_setup,       bench_desaturate_run,   0x22CADB2E },
+    { "PID_Desaturate/rotation",    bench_desaturate_rotation_setup,    bench_desaturate_run,   0xD58FE197 },
+    { "PID_Desaturate/translation", bench_desaturate_translation_setup, bench_desaturate_run,   0x17F006A6 },
+    { "encoder_update",             bench_encoder_setup,                bench_encoder_run,      0x3DB039CA }
+};
+
+const uint32_t bench_nb_kernels = sizeof(bench_kernels) / sizeof(bench_kernels[0]);
+
+/**
+  * @brief  Run a kernel from its setup for its reference checksum
+  * @param  kernel: the kernel
+  * @retval Checksum of the outputs, to compare with kernel->reference
+  */
+uint32_t bench_check(const bench_kernel_t* kernel)
+{
+    kernel->setup();
+    return kernel->run(BENCH_CHECK_ITERATIONS);
+}
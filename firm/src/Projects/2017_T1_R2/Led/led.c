@@ -18,90 +18,58 @@
 /* Inclusion */
 #include "main.h"
 
-static const char * const welcomeMessage  = WELCOME_MESSAGE;
-
-
-/* Local Variable Mutex */
-static xSemaphoreHandle xLedColorMutex;
-static xSemaphoreHandle xLedModeMutex;
-static HB_LED_ColorTypeDef LedColor=HB_LED_BLUE;
-static HB_LED_ModeTypeDef LedMode=HB_LED_BLINK_SLOW;
-
-/* Local, Private functions */
-static void OS_LedTask(void *pvParameters);
-
+/* The LED is driven by the PWM and blinking timers, see hb_led.c. The
+ * critical sections keep the blinking ISR from reading a half-written
+ * color. */
 
 BaseType_t led_start(void)
 {
-	xLedColorMutex = xSemaphoreCreateMutex();
-	xLedModeMutex = xSemaphoreCreateMutex();
+    led_set_color(HB_LED_BLUE);
+    led_set_mode(HB_LED_BLINK_SLOW);
 
-    return xTaskCreate(OS_LedTask, "LED", OS_TASK_STACK_LED, NULL, OS_TASK_PRIORITY_LED, NULL );
+    return pdPASS;
 }
 
-static void OS_LedTask( void *pvParameters )
+void led_set_color(HB_LED_ColorTypeDef color)
 {
-    TickType_t xNextWakeTime;
-
-    uint32_t blinkCounter = 0;
-    uint32_t blinkPeriod = 0;
-
-    /* Initialise xNextWakeTime - this only needs to be done once. */
-    xNextWakeTime = xTaskGetTickCount();
-
-    /* Remove compiler warning about unused parameter. */
-    ( void ) pvParameters;
-
-    /* Send the welcome message. */
-    //serial_puts(welcomeMessage);
-
-    for( ;; )
-    {
-        switch(LedMode)
-        {
-            case HB_LED_BLINK_SLOW:
-                blinkPeriod = LED_BLINK_SLOW;
-                break;
-
-            case HB_LED_BLINK_FAST:
-                blinkPeriod = LED_BLINK_FAST;
-                break;
-
-            default:
-            case HB_LED_STATIC:
-                        break;
-        }
-
-        /* Handles blinking counter */
-        if(blinkCounter++ > blinkPeriod)
-            blinkCounter = 0;
-
-        if((blinkCounter > blinkPeriod / 2) || LedMode == HB_LED_STATIC) {
-
-            /* Duration ON */
-            hb_led_set_color(LedColor);
-            vTaskDelayUntil( &xNextWakeTime, LED_PWM_DUTY_TICK);
-
-            /* Duration OFF */
-            hb_led_set_color(HB_LED_OFF);
-            vTaskDelayUntil( &xNextWakeTime, LED_PWM_PERIOD_TICK-LED_PWM_DUTY_TICK);
-
-        } else {
-            vTaskDelayUntil( &xNextWakeTime, LED_PWM_PERIOD_TICK);
-        }
-    }
+    taskENTER_CRITICAL();
+    hb_led_set_color(color);
+    taskEXIT_CRITICAL();
 }
 
-void led_set_color(HB_LED_ColorTypeDef color)
+/**
+  * @brief  Setup a color mix, 8-bit per color
+  * @param  red, green, blue: 0 is off and 255 fully on
+  * @retval None
+  */
+void led_set_rgb(uint8_t red, uint8_t green, uint8_t blue)
 {
-	xSemaphoreTake(xLedColorMutex, 10);
-	LedColor = color;
-	xSemaphoreGive(xLedColorMutex);
+    taskENTER_CRITICAL();
+    hb_led_set_rgb(red, green, blue);
+    taskEXIT_CRITICAL();
 }
 
 void led_set_mode(HB_LED_ModeTypeDef mode)
 {
-	xSemaphoreTake(xLedModeMutex, 10);
-	LedMode = mode;
-	xSemaphoreGive(xLedModeMutex);
+    uint16_t half_period_ms;
+
+    switch(mode)
+    {
+        case HB_LED_BLINK_SLOW:
+            half_period_ms = LED_BLINK_SLOW_MS;
+            break;
+
+        case HB_LED_BLINK_FAST:
+            half_period_ms = LED_BLINK_FAST_MS;
+            break;
+
+        default:
+        case HB_LED_STATIC:
+            half_period_ms = 0;
+            break;
+    }
+
+    taskENTER_CRITICAL();
+    hb_led_set_blink(half_period_ms);
+    taskEXIT_CRITICAL();
 }
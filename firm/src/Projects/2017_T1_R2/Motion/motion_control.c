@@ -0,0 +1,326 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       motion_control.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Control law of the motion control system, see motion_control.h.
+ *   The gains and limits are the ones of the robot: a change here is a
+ *   change of the replayed behaviour too.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "motion_control.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Wheels velocity feed-forward (see PID_FF_struct_t), on the velocity and
+ * acceleration of the reference profiles. Identified per wheel, robot
+ * lifted, by the shell 'ident start' command (motion_ident_cycle()):
+ *  - KS: smallest PWM that gets the wheel turning
+ *  - KV: 100 * (PWM - KS) / steady-state speed (ticks per control period)
+ *  - KA: KV * time constant of the wheel (control periods)
+ * The command prints the values to copy here. Zero disables the
+ * corresponding term.
+ */
+#define MOTOR1_FF_KV    0
+#define MOTOR1_FF_KA    0
+#define MOTOR1_FF_KS    0
+#define MOTOR2_FF_KV    0
+#define MOTOR2_FF_KA    0
+#define MOTOR2_FF_KS    0
+#define MOTOR3_FF_KV    0
+#define MOTOR3_FF_KA    0
+#define MOTOR3_FF_KS    0
+
+/* Per wheel tables, one row per motor */
+static const int16_t motion_wheel_ff[][3] = {
+    { MOTOR1_FF_KV, MOTOR1_FF_KA, MOTOR1_FF_KS },
+    { MOTOR2_FF_KV, MOTOR2_FF_KA, MOTOR2_FF_KS },
+    { MOTOR3_FF_KV, MOTOR3_FF_KA, MOTOR3_FF_KS }
+};
+_Static_assert(sizeof(motion_wheel_ff) / sizeof(motion_wheel_ff[0]) == PID_WHEELS,
+               "motion_wheel_ff: one row per wheel");
+
+/* Position PIDs of the axes: x, y, teta. The profiles move the references
+ * at about half the wheels top speed, full speed in 15 periods; a teta unit
+ * is 12 wheel ticks */
+const motion_axis_gains_t motion_control_gains[MOTION_AXES] = {
+    /* KP  KI  KD  I_limit  speed  acceleration  profile speed  acceleration */
+    {  1,  0,  0,  0,       1000,  150,          150,           10 },
+    {  1,  0,  0,  0,       1000,  150,          150,           10 },
+    {  1,  0,  0,  0,       1000,  40,           15,            1  }
+};
+
+#if !HB_LCMXO2_VEL_LOOP
+/* Feed-forward identification, see motion_ident_cycle() */
+#define MOTION_IDENT_KS_STEP            4                       /* PWM added per period looking for KS */
+#define MOTION_IDENT_KS_MAX             (MOTION_WHEEL_MAX / 4)
+#define MOTION_IDENT_TURNING            2                       /* ticks per period, the wheel turns */
+#define MOTION_IDENT_PWM                (MOTION_WHEEL_MAX / 2)  /* PWM step */
+#define MOTION_IDENT_REST_PERIODS       25                      /* wheels stopping */
+#define MOTION_IDENT_SETTLE_PERIODS     25                      /* after the first one of the step */
+#define MOTION_IDENT_MEASURE_PERIODS    25                      /* steady-state speed */
+#define MOTION_IDENT_ALL                ((1 << PID_WHEELS) - 1)
+#endif
+
+/**
+  * @brief  Position PIDs, wheels feed-forward and desaturation, once at
+  *         start-up: takes the PID_PROCESS_MAX processes of pid_init()
+  * @param  control: state of the control law, zeroed
+  * @retval None
+  */
+void motion_control_init(motion_control_t* control)
+{
+    uint8_t i;
+
+    for(i = 0; i < MOTION_AXES; i++)
+    {
+        control->axis[i] = pid_init();
+        configASSERT(control->axis[i] != NULL);
+    }
+    motion_control_configure(control, motion_control_gains);
+}
+
+/**
+  * @brief  Gains of the axes, wheels feed-forward and desaturation.
+  *         The host parameter sweep calls it with other gains, on its own
+  *         processes (firm/host/sweep_host.c).
+  * @param  control: state of the control law, with its processes
+  * @param  gains: one entry per axis
+  * @retval None
+  */
+void motion_control_configure(motion_control_t* control, const motion_axis_gains_t gains[MOTION_AXES])
+{
+    uint8_t i;
+
+    for(i = 0; i < MOTION_AXES; i++)
+    {
+        PID_Set_Coefficient(control->axis[i]->PID, gains[i].KP, gains[i].KI, gains[i].KD, gains[i].I_limit);
+        PID_Set_limitation(control->axis[i], gains[i].speed_limit, gains[i].acceleration_limit);
+        PID_Set_Profile(control->axis[i], gains[i].profile_speed, gains[i].profile_acceleration);
+    }
+    for(i = 0; i < PID_WHEELS; i++)
+        PID_Set_Wheel_Feed_Forward(&control->base, i, motion_wheel_ff[i][0], motion_wheel_ff[i][1], motion_wheel_ff[i][2]);
+    PID_Set_Desaturation(&control->base, MOTION_WHEEL_MAX, PID_DESAT_ROTATION);
+#if HB_LCMXO2_VEL_LOOP
+    /* Wheel velocity loops in the FPGA, only the pose control runs here */
+    PID_Set_Wheel_Output(&control->base, PID_WHEEL_OUTPUT_VELOCITY);
+#else
+    PID_Set_Wheel_Output(&control->base, PID_WHEEL_OUTPUT_PWM);
+#endif
+}
+
+/**
+  * @brief  Wheel positions of an FPGA sample, without the control law
+  * @param  control: state of the control law
+  * @param  counters: QEI counters of the sample
+  * @retval None
+  */
+void motion_control_sample(motion_control_t* control, const int16_t counters[PID_WHEELS])
+{
+    uint8_t wheel;
+
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        control->wheel_position[wheel] = encoder_update(&control->encoder[wheel], counters[wheel]);
+}
+
+/**
+  * @brief  One control cycle: wheel positions, then the wheel commands
+  *         for the current axes references
+  * @param  control: state of the control law
+  * @param  counters: QEI counters of an FPGA sample
+  * @retval None
+  */
+void motion_control_cycle(motion_control_t* control, const int16_t counters[PID_WHEELS])
+{
+    motion_control_sample(control, counters);
+
+    PID_Process_holonomic(&control->base, control->axis[0], control->axis[1], control->axis[2],
+                          control->wheel_position, control->wheel_command);
+}
+
+/**
+  * @brief  Cycle with the bridges stopped: references and profiles follow
+  *         the wheel positions, integrators cleared and the wheel commands
+  *         zeroed, so that the control law restarts from where the robot is
+  * @param  control: state of the control law
+  * @param  counters: QEI counters of an FPGA sample
+  * @retval None
+  */
+void motion_control_hold(motion_control_t* control, const int16_t counters[PID_WHEELS])
+{
+    motion_control_sample(control, counters);
+
+    PID_Hold_holonomic(&control->base, control->axis[0], control->axis[1], control->axis[2],
+                       control->wheel_position);
+    memset(control->wheel_command, 0, sizeof(control->wheel_command));
+}
+
+#if !HB_LCMXO2_VEL_LOOP
+/**
+  * @brief  Start the feed-forward identification
+  * @param  ident: identification state
+  * @param  wheel_position: wheel positions of the current cycle
+  * @retval None
+  */
+void motion_ident_start(motion_ident_t* ident, const int32_t wheel_position[PID_WHEELS])
+{
+    uint8_t wheel;
+
+    memset(ident, 0, sizeof(*ident));
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        ident->last[wheel] = wheel_position[wheel];
+    ident->phase = MOTION_IDENT_FRICTION;
+}
+
+/* Fraction of the steady-state speed covered over the first period of a
+ * step by a first-order wheel started from rest, x = time constant / period */
+static double motion_ident_first_period(double x)
+{
+    return 1.0 - x * (1.0 - exp(-1.0 / x));
+}
+
+/* KV, KA of the wheels from the step response, pdFAIL if a wheel did not
+ * turn forward */
+static BaseType_t motion_ident_compute(motion_ident_t* ident)
+{
+    double speed, ratio, low, high, x, kv, ka;
+    uint8_t wheel, n;
+
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+    {
+        speed = (double)ident->travel[wheel] / MOTION_IDENT_MEASURE_PERIODS;
+        if(speed < MOTION_IDENT_TURNING || ident->first[wheel] < 0)
+            return pdFAIL;
+        kv = 100.0 * (MOTION_IDENT_PWM - ident->KS[wheel]) / speed;
+
+        /* Time constant matching the first period, by bisection: the
+         * fraction decreases from 1 (no lag) to 0 */
+        ratio = ident->first[wheel] / speed;
+        low = 0.001;
+        high = 100.0;
+        for(n = 0; n < 40; n++)
+        {
+            x = (low + high) / 2;
+            if(motion_ident_first_period(x) > ratio)
+                low = x;
+            else
+                high = x;
+        }
+        ka = kv * (low + high) / 2;
+
+        ident->KV[wheel] = (int16_t)fmin(kv + 0.5, INT16_MAX);
+        ident->KA[wheel] = (int16_t)fmin(ka + 0.5, INT16_MAX);
+    }
+    return pdPASS;
+}
+
+/**
+  * @brief  One cycle of the feed-forward identification, robot lifted and
+  *         position control suspended. Each wheel, on its own PWM:
+  *          - ramps up by MOTION_IDENT_KS_STEP per period until it turns: KS,
+  *            the PWM of the period before (the wheel lags by about a period)
+  *          - rests, then takes a MOTION_IDENT_PWM step: KV from the
+  *            steady-state speed, the time constant (KA) from the ticks
+  *            over the first period
+  * @param  ident: identification state, see motion_ident_start()
+  * @param  wheel_position: wheel positions of the cycle
+  * @param  pwm: wheel PWM for the next period
+  * @retval pdTRUE while running, then the phase is MOTION_IDENT_DONE with
+  *         the values or MOTION_IDENT_FAILED, the wheels stopped
+  */
+BaseType_t motion_ident_cycle(motion_ident_t* ident, const int32_t wheel_position[PID_WHEELS], int32_t pwm[PID_WHEELS])
+{
+    int32_t speed[PID_WHEELS];
+    uint8_t wheel;
+
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+    {
+        speed[wheel] = wheel_position[wheel] - ident->last[wheel];
+        ident->last[wheel] = wheel_position[wheel];
+    }
+    ident->periods++;
+
+    switch(ident->phase)
+    {
+    case MOTION_IDENT_FRICTION:
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        {
+            if(ident->turning & (1 << wheel))
+                continue;
+            if(abs(speed[wheel]) >= MOTION_IDENT_TURNING)
+            {
+                ident->KS[wheel] = ident->pwm[wheel] > MOTION_IDENT_KS_STEP ? ident->pwm[wheel] - MOTION_IDENT_KS_STEP : 0;
+                ident->turning |= 1 << wheel;
+            }
+            else if(ident->pwm[wheel] >= MOTION_IDENT_KS_MAX)
+                ident->phase = MOTION_IDENT_STOPPING;
+            else
+                ident->pwm[wheel] += MOTION_IDENT_KS_STEP;
+        }
+        if(ident->turning == MOTION_IDENT_ALL)
+            ident->phase = MOTION_IDENT_REST;
+        if(ident->phase != MOTION_IDENT_FRICTION)
+        {
+            memset(ident->pwm, 0, sizeof(ident->pwm));
+            ident->periods = 0;
+        }
+        break;
+
+    case MOTION_IDENT_REST:
+        if(ident->periods >= MOTION_IDENT_REST_PERIODS)
+        {
+            for(wheel = 0; wheel < PID_WHEELS; wheel++)
+                ident->pwm[wheel] = MOTION_IDENT_PWM;
+            ident->phase = MOTION_IDENT_STEP;
+        }
+        break;
+
+    case MOTION_IDENT_STEP:
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+            ident->first[wheel] = speed[wheel];
+        ident->phase = MOTION_IDENT_SETTLE;
+        ident->periods = 0;
+        break;
+
+    case MOTION_IDENT_SETTLE:
+        if(ident->periods >= MOTION_IDENT_SETTLE_PERIODS)
+        {
+            ident->phase = MOTION_IDENT_MEASURE;
+            ident->periods = 0;
+        }
+        break;
+
+    case MOTION_IDENT_MEASURE:
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+            ident->travel[wheel] += speed[wheel];
+        if(ident->periods >= MOTION_IDENT_MEASURE_PERIODS)
+        {
+            ident->valid = (motion_ident_compute(ident) == pdPASS);
+            memset(ident->pwm, 0, sizeof(ident->pwm));
+            ident->phase = MOTION_IDENT_STOPPING;
+            ident->periods = 0;
+        }
+        break;
+
+    case MOTION_IDENT_STOPPING:
+        if(ident->periods >= MOTION_IDENT_REST_PERIODS)
+            ident->phase = ident->valid ? MOTION_IDENT_DONE : MOTION_IDENT_FAILED;
+        break;
+
+    default:
+        break;
+    }
+
+    memcpy(pwm, ident->pwm, sizeof(ident->pwm));
+    return ident->phase > MOTION_IDENT_IDLE && ident->phase < MOTION_IDENT_DONE ? pdTRUE : pdFALSE;
+}
+#endif
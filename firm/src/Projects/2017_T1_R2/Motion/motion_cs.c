@@ -15,24 +15,64 @@
  */
 
 #include "main.h"
-#include "pid.h"
+#include "motion_control.h"
+#include "replay.h"
+#include "recorder.h"
 
 /* Local definitions */
 #define MOTION_CONTROL_PERIOD_TICKS	(MOTION_CONTROL_PERIOD_MS / portTICK_PERIOD_MS)
-#define MAX_SPEED 	2047
-#define MOTOR1		0x0084
-#define MOTOR2 		0x0082
-#define MOTOR3		0x0081
-#define ENCODER1	0x0004
-#define ENCODER2	0x0002
-#define ENCODER3	0x0001
-#define TICK_PER_REV 1400
+/* A control cycle is run without the FPGA sample after this */
+#define MOTION_SAMPLE_TIMEOUT_TICKS	(MOTION_CONTROL_PERIOD_TICKS + MOTION_CONTROL_PERIOD_TICKS / 2)
+#define MAX_SPEED 	HB_LCMXO2_PWM_MAX
+#define TICK_PER_REV 2800
 #define WHEEL_PERIMETER 188.5
 
+/* Open-loop robot speed (x, y, teta) to wheel speeds, see robot_set_speed() */
+static const double motion_speed_to_wheels[][MOTION_AXES] = {
+	{ -1.366, -0.366, 20.1261 },
+	{  1,     -1,     20.1261 },
+	{  0.366,  1.366, 20.1261 }
+};
+_Static_assert(sizeof(motion_speed_to_wheels) / sizeof(motion_speed_to_wheels[0]) == PID_WHEELS,
+               "motion_speed_to_wheels: one row per wheel");
+
+/* Static kernel objects */
+static StaticTask_t motion_cs_tcb OS_DTCM;
+static StackType_t motion_cs_stack[OS_TASK_STACK_MOTION_CS] OS_DTCM;
+static TaskHandle_t motion_cs_handle;
+
+/* Control cycles run on the timeout, without an FPGA sample */
+static uint32_t motion_sample_missed;
+
+/* LCMXO2 start-up results, see hb_lcmxo2_init() */
+static const char* const motion_lcmxo2_states[] = {
+	"not started", "ready", "no answer", "wrong ID", "not ready"
+};
+
+/* Status published by the control task, read by any task */
+static SEQLOCK(motion_status_t) motion_status;
+
 /* Local, Private functions */
 static void motion_cs_task(void *pvParameters);
-static int16_t encoder1_Old, encoder2_Old, encoder3_Old;
-static int32_t encoder1_Value=0,encoder2_Value=0,encoder3_Value=0;
+static void motion_cs_publish(PID_process_t *pPIDx, PID_process_t *pPIDy, PID_process_t *pPIDteta, uint16_t lcmxo2_status);
+static void motion_cs_halt(const char* reason);
+
+/* Control law, see motion_control.c */
+static motion_control_t motion_control;
+
+#if !HB_LCMXO2_VEL_LOOP
+/* Wheels feed-forward identification, requested by the shell, run by the
+ * control task instead of the position control */
+static motion_ident_t motion_ident;
+static volatile uint8_t motion_ident_request;
+static uint8_t motion_identifying;
+
+static const char* const motion_ident_phases[] = {
+	"idle", "friction", "rest", "step", "settle", "measure", "stopping", "done", "failed"
+};
+
+static void motion_cs_identify(const int16_t counters[PID_WHEELS]);
+#endif
 
 /* -----------------------------------------------------------------------------
  * Initializations
@@ -41,12 +81,12 @@ static int32_t encoder1_Value=0,encoder2_Value=0,encoder3_Value=0;
 
 BaseType_t motion_cs_start(void)
 {
-  BaseType_t ret;
-
   // Start the motion control task
-  ret = xTaskCreate(motion_cs_task, "MOTION_CS", OS_TASK_STACK_MOTION_CS, NULL, OS_TASK_PRIORITY_MOTION_CS, NULL );
+  motion_cs_handle = xTaskCreateStatic(motion_cs_task, "MOTION_CS", OS_TASK_STACK_MOTION_CS, NULL, OS_TASK_PRIORITY_MOTION_CS, motion_cs_stack, &motion_cs_tcb);
+  if(motion_cs_handle == NULL)
+    return pdFAIL;
 
-  return ret;
+  return pdPASS;
 
 }
 
@@ -75,34 +115,10 @@ void motion_cs_init(void)
 
 int32_t encoder_get_position(uint16_t QEI)
 {
-	int16_t encoder;
-	int16_t delta;
-
-	encoder = hb_lcmxo2_get_qei(QEI)*16;
-	switch(QEI)
-	{
-	case ENCODER1:
-	   	delta = encoder - encoder1_Old;
-	    encoder1_Old = encoder;
-	    encoder1_Value += (int32_t)delta/16;
-	    return encoder1_Value;
-	    break;
-	case ENCODER2:
-	   	delta = encoder - encoder2_Old;
-	    encoder2_Old = encoder;
-	    encoder2_Value += (int32_t)delta/16;
-	    return encoder2_Value;
-	    break;
-	case ENCODER3:
-	   	delta = encoder - encoder3_Old;
-	    encoder3_Old = encoder;
-	    encoder3_Value += (int32_t)delta/16;
-	    return encoder3_Value;
-	    break;
-	default :
+	if(QEI >= PID_WHEELS)
 		return 0;
-	}
-	return 0;
+
+	return encoder_update(&motion_control.encoder[QEI], hb_lcmxo2_get_qei(QEI));
 }
 
 
@@ -111,64 +127,256 @@ int32_t encoder_get_position(uint16_t QEI)
  * Speed setters
  * -----------------------------------------------------------------------------
  */
-void motor1_set_speed(int speed)
+void motor_set_speed(uint16_t channel, int speed)
 {
 	if(speed >= MAX_SPEED)
 		speed = MAX_SPEED;
 	if(speed <= -MAX_SPEED)
 		speed = -MAX_SPEED;
-	hb_lcmxo2_set_pwm(MOTOR1, speed);
+	hb_lcmxo2_set_pwm(channel, speed);
 }
 
-void motor2_set_speed(int speed)
+void motors_set_speed(const int32_t speed[PID_WHEELS])
 {
-	if(speed >= MAX_SPEED)
-		speed = MAX_SPEED;
-	if(speed <= -MAX_SPEED)
-		speed = -MAX_SPEED;
-	hb_lcmxo2_set_pwm(MOTOR2, speed);
+	uint16_t wheel;
+
+	for(wheel=0;wheel<PID_WHEELS;wheel++)
+		motor_set_speed(wheel, speed[wheel]);
 }
 
-void motor3_set_speed(int speed)
+#if HB_LCMXO2_VEL_LOOP
+/* Wheel velocities in counts per control period, to the FPGA loop references
+ * in 1/256 count per loop period */
+void motors_set_velocity(const int32_t velocity[PID_WHEELS])
 {
-	if(speed >= MAX_SPEED)
-		speed = MAX_SPEED;
-	if(speed <= -MAX_SPEED)
-		speed = -MAX_SPEED;
-	hb_lcmxo2_set_pwm(MOTOR3, speed);
+	int16_t refs[HB_LCMXO2_NB_CHANNELS] = {0};
+	int32_t ref;
+	uint16_t wheel;
+
+	for(wheel=0;wheel<PID_WHEELS;wheel++)
+	{
+		ref = (velocity[wheel] * 256 * HB_LCMXO2_VEL_PERIOD_US) / (MOTION_CONTROL_PERIOD_MS * 1000);
+		if(ref > INT16_MAX) ref = INT16_MAX;
+		if(ref < -INT16_MAX) ref = -INT16_MAX;
+		refs[wheel] = (int16_t)ref;
+	}
+	hb_lcmxo2_set_vel_ref_all(refs);
+}
+#endif
+
+void robot_set_speed(int speed_x, int speed_y, int speed_teta)
+{
+	int32_t speed_motor[PID_WHEELS];
+	int32_t rotation_motor[PID_WHEELS];
+	uint8_t wheel;
+
+	for(wheel=0;wheel<PID_WHEELS;wheel++)
+	{
+		rotation_motor[wheel] = (int32_t)(speed_teta*motion_speed_to_wheels[wheel][2]);
+		speed_motor[wheel] = (int32_t)(speed_x*motion_speed_to_wheels[wheel][0] + speed_y*motion_speed_to_wheels[wheel][1]) + rotation_motor[wheel];
+	}
+
+	PID_Desaturate(&motion_control.base, speed_motor, rotation_motor);
+
+	motors_set_speed(speed_motor);
 }
+/* -----------------------------------------------------------------------------
+ * Speed getters
+ * -----------------------------------------------------------------------------
+ */
 
 
-void motors_set_speed(int speed_motor1, int speed_motor2, int speed_motor3)
+#if !HB_LCMXO2_VEL_LOOP
+/* -----------------------------------------------------------------------------
+ * Feed-forward identification
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+  * @brief  Identify the wheels feed-forward from the next control cycle,
+  *         robot lifted: the wheels are driven in open loop for about 3 s
+  *         (motion_ident_cycle()), then the new values are used and the
+  *         pose reached is held
+  * @retval pdFAIL if already running, or the bridges stopped
+  */
+BaseType_t motion_identify(void)
 {
-	motor1_set_speed(speed_motor1);
-	motor2_set_speed(speed_motor2);
-	motor3_set_speed(speed_motor3);
+	if(motion_ident_request || motion_identifying || hb_lcmxo2_get_stop() == SET)
+		return pdFAIL;
+
+	motion_ident_request = 1;
+	return pdPASS;
 }
 
-void robot_set_speed(int speed_x, int speed_y, int speed_teta)
+/**
+  * @brief  Print the identification state, and the values once done
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void motion_identify_print(char* buffer, size_t length)
 {
-	int16_t speed_motor1;
-	int16_t speed_motor2;
-	int16_t speed_motor3;
+	size_t len = 0;
+	uint8_t wheel;
+
+	len += snprintf(buffer + len, length - len, "ident   : %s\n\r",
+	                motion_ident_request ? "requested" : motion_ident_phases[motion_ident.phase]);
+	if(motion_ident_request || motion_ident.phase != MOTION_IDENT_DONE)
+		return;
+	for(wheel = 0; wheel < PID_WHEELS && len < length; wheel++)
+		len += snprintf(buffer + len, length - len, "MOTOR%u  : KV %d, KA %d, KS %d\n\r", wheel + 1,
+		                motion_ident.KV[wheel], motion_ident.KA[wheel], motion_ident.KS[wheel]);
+	if(len < length)
+		snprintf(buffer + len, length - len, "in use, copy them to the MOTORx_FF_ defines of motion_control.c\n\r");
+}
 
-	speed_motor1 = (int16_t)(speed_x*-1.366 + speed_y*-0.366 + speed_teta*20.1261);
-	speed_motor2 = (int16_t)(speed_x*1 + speed_y*-1 + speed_teta*20.1261);
-	speed_motor3 = (int16_t)(speed_x*0.366 + speed_y*1.366 + speed_teta*20.1261);
+/* One cycle of the identification instead of the position control; then the
+ * new values are used, and the pose reached is held */
+static void motion_cs_identify(const int16_t counters[PID_WHEELS])
+{
+	uint8_t wheel;
 
-	motors_set_speed(speed_motor1,speed_motor2,speed_motor3);
+	motion_control_sample(&motion_control, counters);
+	if(motion_ident_request)
+	{
+		motion_ident_start(&motion_ident, motion_control.wheel_position);
+		motion_identifying = 1;
+		motion_ident_request = 0;
+#if REPLAY_CAPTURE
+		/* Cycles without the control law cannot be replayed */
+		replay_stop();
+#endif
+	}
+
+	motion_identifying = motion_ident_cycle(&motion_ident, motion_control.wheel_position, motion_control.wheel_command);
+	motors_set_speed(motion_control.wheel_command);
+	if(motion_identifying)
+		return;
+
+	if(motion_ident.phase == MOTION_IDENT_DONE)
+		for(wheel = 0; wheel < PID_WHEELS; wheel++)
+			PID_Set_Wheel_Feed_Forward(&motion_control.base, wheel, motion_ident.KV[wheel], motion_ident.KA[wheel], motion_ident.KS[wheel]);
+	PID_Hold_holonomic(&motion_control.base, motion_control.axis[0], motion_control.axis[1], motion_control.axis[2],
+	                   motion_control.wheel_position);
 }
+#endif
+
+
 /* -----------------------------------------------------------------------------
- * Speed getters
+ * Status publication
  * -----------------------------------------------------------------------------
  */
 
+/* Called by the control task after each cycle, never blocks */
+static void motion_cs_publish(PID_process_t *pPIDx, PID_process_t *pPIDy, PID_process_t *pPIDteta, uint16_t lcmxo2_status)
+{
+	static motion_status_t status;
+	int32_t pose[MOTION_AXES];
+	uint8_t i;
+
+	pose[0] = PID_Get_Cur_Position(pPIDx);
+	pose[1] = PID_Get_Cur_Position(pPIDy);
+	pose[2] = PID_Get_Cur_Position(pPIDteta);
+	for(i=0;i<MOTION_AXES;i++)
+	{
+		status.speed[i] = status.cycle ? pose[i] - status.pose[i] : 0;
+		status.pose[i] = pose[i];
+	}
+	for(i=0;i<PID_WHEELS;i++)
+		status.wheel[i] = motion_control.wheel_position[i];
+	status.faults = hb_fault_get_state();
+	status.stopped = (hb_lcmxo2_get_stop() == SET);
+	status.qei_fault = (lcmxo2_status & HB_LCMXO2_STATUS_QEI_FAULT) != 0;
+	status.sample_missed = motion_sample_missed;
+	status.time = xTaskGetTickCount();
+	status.cycle++;
+
+	seqlock_publish(&motion_status, &status);
+}
+
+/**
+  * @brief  Copy the status of the last control cycle, lock-free
+  * @param  status: destination
+  * @retval None
+  */
+void motion_get_status(motion_status_t* status)
+{
+	seqlock_snapshot(&motion_status, status);
+}
+
+/**
+  * @brief  Print the status of the last control cycle
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void motion_cs_print(char* buffer, size_t length)
+{
+	motion_status_t status;
+	size_t len = 0;
+	uint8_t ch;
+
+	motion_get_status(&status);
+
+	len += snprintf(buffer + len, length - len,
+	                "cycle   : %lu at %lu ms\n\r"
+	                "pose    : x %ld, y %ld, teta %ld\n\r"
+	                "speed   : x %ld, y %ld, teta %ld per cycle\n\r"
+	                "bridges : %s, faults 0x%02x\n\r"
+	                "encoders: %s, %lu samples missed\n\r",
+	                (unsigned long)status.cycle, (unsigned long)(status.time * portTICK_PERIOD_MS),
+	                (long)status.pose[0], (long)status.pose[1], (long)status.pose[2],
+	                (long)status.speed[0], (long)status.speed[1], (long)status.speed[2],
+	                status.stopped ? "stopped" : "running", status.faults,
+	                status.qei_fault ? "errors" : "ok", (unsigned long)status.sample_missed);
+	for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS && len < length; ch++)
+		len += snprintf(buffer + len, length - len, "wheel %u : %ld\n\r", ch, (long)status.wheel[ch]);
+	if(len < length)
+		snprintf(buffer + len, length - len, "lcmxo2  : %s, ID 0x%04x, caps 0x%04x\n\r",
+		         motion_lcmxo2_states[hb_lcmxo2_get_state()], hb_lcmxo2_get_id(), hb_lcmxo2_get_caps());
+}
+
+/* Without the FPGA there is nothing to drive: report why once, then keep
+ * checking in, a watchdog reset would not bring the FPGA back */
+static void motion_cs_halt(const char* reason)
+{
+	char str[80];
+
+	snprintf(str, sizeof(str), "\n\rLCMXO2: %s (ID 0x%04x), motion stopped\n\r", reason, hb_lcmxo2_get_id());
+	serial_puts(str);
+
+	for( ;; )
+	{
+		vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS / 2));
+		supervisor_alive(SUPERVISOR_ALIVE_MOTION_CS);
+	}
+}
 
 /* -----------------------------------------------------------------------------
  * Aversive mutexes management
  * -----------------------------------------------------------------------------
  */
 
+/* -----------------------------------------------------------------------------
+ * LCMXO2 interrupt line
+ * -----------------------------------------------------------------------------
+ */
+
+/* Encoder sample ready or encoder fault: wake the control task up */
+void LCMXO2_ISR(void)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	TRACE_ISR_ENTER();
+
+	if(hb_lcmxo2_irq_get_it() == SET)
+		vTaskNotifyGiveFromISR(motion_cs_handle, &xHigherPriorityTaskWoken);
+
+	TRACE_ISR_EXIT();
+
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
 /* -----------------------------------------------------------------------------
  * Main Motion Control System Managment Task
  * TODO: handle re-init of the task
@@ -179,47 +387,150 @@ void motion_cs_task(void *pvParameters)
 {
   TickType_t xNextWakeTime;
   PID_process_t *pPID_1, *pPID_2, *pPID_3;
-  int32_t posx=0,posy=3700,posteta=0;
+  int32_t posx=0,posy=7400,posteta=0;
   uint16_t timer=0;
+  uint16_t pwm_config[HB_LCMXO2_NB_CHANNELS];
+  int16_t counters[HB_LCMXO2_NB_CHANNELS];
+  uint16_t lcmxo2_status = 0;
+  uint32_t woken, missed = 0;
+  ErrorStatus read;
+  uint8_t i, sampled;
   char str[60];
-  /* Initialise xNextWakeTime - this only needs to be done once. */
-  xNextWakeTime = xTaskGetTickCount();
-  /* Wait for 1s to let lcmxo2 startup*/
-  vTaskDelayUntil( &xNextWakeTime, MOTION_CONTROL_PERIOD_TICKS*10);
-  LCMXO2_RESET_WRITE(LCMXO2_RESET_OFF);
-  vTaskDelayUntil( &xNextWakeTime, MOTION_CONTROL_PERIOD_TICKS*10);
-  motor1_set_speed(0);
-  motor2_set_speed(0);
-  motor3_set_speed(0);
-  pPID_1 = pid_init();		//position PID 1
-  pPID_2 = pid_init();
-  pPID_3 = pid_init();
-  PID_Set_Pwm(pPID_1,(void*)hb_lcmxo2_set_pwm,(void*)MOTOR1);
-  PID_Set_Pwm(pPID_2,(void*)hb_lcmxo2_set_pwm,(void*)MOTOR2);
-  PID_Set_Pwm(pPID_3,(void*)hb_lcmxo2_set_pwm,(void*)MOTOR3);
-  PID_Set_Encoder(pPID_1, (void*)encoder_get_position,(void*)ENCODER1);
-  PID_Set_Encoder(pPID_2, (void*)encoder_get_position,(void*)ENCODER2);
-  PID_Set_Encoder(pPID_3, (void*)encoder_get_position,(void*)ENCODER3);
-  PID_Set_Coefficient(pPID_1->PID,1,0,0,0);
-  PID_Set_Coefficient(pPID_2->PID,1,0,0,0);
-  PID_Set_Coefficient(pPID_3->PID,1,0,0,0);
-  PID_Set_limitation(pPID_1,500,75 );
-  PID_Set_limitation(pPID_2,500,75);
-  PID_Set_limitation(pPID_3,500,20);
-
-  PID_Set_Ref_Position(pPID_1,0);//7600);
-  PID_Set_Ref_Position(pPID_2,3700);
-  PID_Set_Ref_Position(pPID_3,0);//-4790);
+  /* The LCMXO2 was started by hb_init(), nothing to drive without it */
+  if(hb_lcmxo2_get_state() != HB_LCMXO2_READY)
+	  motion_cs_halt(motion_lcmxo2_states[hb_lcmxo2_get_state()]);
+#if HB_LCMXO2_VEL_LOOP
+  if(!(hb_lcmxo2_get_caps() & HB_LCMXO2_CAPS_VEL))
+	  motion_cs_halt("no velocity loop");
+#endif
+  /* Same period, dead-band and slew on all the motors, one burst each */
+  for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+	  pwm_config[i] = HB_LCMXO2_PWM_PERIOD;
+  hb_lcmxo2_write(HB_LCMXO2_REG_PWM_PERIOD(0), pwm_config, HB_LCMXO2_NB_CHANNELS);
+  for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+	  pwm_config[i] = HB_LCMXO2_PWM_DEADBAND;
+  hb_lcmxo2_write(HB_LCMXO2_REG_PWM_DEADBAND(0), pwm_config, HB_LCMXO2_NB_CHANNELS);
+  for(i=0;i<HB_LCMXO2_NB_CHANNELS;i++)
+	  pwm_config[i] = HB_LCMXO2_PWM_SLEW;
+  hb_lcmxo2_write(HB_LCMXO2_REG_PWM_SLEW(0), pwm_config, HB_LCMXO2_NB_CHANNELS);
+  hb_lcmxo2_set_qei_filter(HB_LCMXO2_QEI_FILTER);
+  /* Control cycles on the FPGA encoder samples, on the tick without them */
+  sampled = HB_LCMXO2_SAMPLE_IRQ && (hb_lcmxo2_get_caps() & HB_LCMXO2_CAPS_SAMPLE) != 0;
+  if(sampled)
+  {
+	  hb_lcmxo2_set_sample(MOTION_CONTROL_PERIOD_MS * 1000, HB_LCMXO2_IRQ_SAMPLE | HB_LCMXO2_IRQ_QEI_FAULT);
+	  hb_lcmxo2_irq_enable(OS_ISR_PRIORITY_LCMXO2);
+  }
+  for(i=0;i<PID_WHEELS;i++)
+	  motor_set_speed(i, 0);
+#if HB_LCMXO2_VEL_LOOP
+  /* Wheel velocity loops in the FPGA, stopped until the first cycle */
+  for(i=0;i<PID_WHEELS;i++)
+	  hb_lcmxo2_set_vel_gains(i, HB_LCMXO2_VEL_KP, HB_LCMXO2_VEL_KI);
+  motors_set_velocity(motion_control.wheel_command);
+  hb_lcmxo2_set_vel_loop(HB_LCMXO2_VEL_PERIOD_US, ENABLE);
+#endif
+  hb_lcmxo2_set_pwm_enable(ENABLE);
+  motion_control_init(&motion_control);
+  pPID_1 = motion_control.axis[0];		//position PID 1
+  pPID_2 = motion_control.axis[1];
+  pPID_3 = motion_control.axis[2];
+
+  PID_Set_Ref_Position(pPID_1,0);//15200);
+  PID_Set_Ref_Position(pPID_2,7400);
+  PID_Set_Ref_Position(pPID_3,0);//-9580);
   /* Remove compiler warning about unused parameter. */
   ( void ) pvParameters;
 
+  xNextWakeTime = xTaskGetTickCount();
   for( ;; )
   {
-	  PID_Process_holonomic(pPID_1,pPID_2,pPID_3);
+	  if(sampled)
+	  {
+		  /* Wakes-up on the FPGA sample, on time without it */
+		  woken = ulTaskNotifyTake(pdTRUE, MOTION_SAMPLE_TIMEOUT_TICKS);
+		  read = hb_lcmxo2_get_qei_all(counters, &lcmxo2_status);
+		  if(!woken)
+		  {
+			  motion_sample_missed++;
+			  if(++missed >= HB_LCMXO2_SAMPLE_MISSED)
+			  {
+				  /* No interrupt line: back to the tick for good */
+				  hb_lcmxo2_irq_disable();
+				  hb_lcmxo2_set_sample(0, 0);
+				  sampled = 0;
+				  xNextWakeTime = xTaskGetTickCount();
+				  serial_puts("\n\rLCMXO2: no encoder sample interrupt, control cycles on the tick\n\r");
+			  }
+		  }
+		  else if(read == SUCCESS && !(lcmxo2_status & HB_LCMXO2_STATUS_SAMPLE))
+			  continue;	// encoder fault pulse, no new sample
+		  else
+			  missed = 0;
+	  }
+	  else
+	  {
+		  vTaskDelayUntil(&xNextWakeTime, MOTION_CONTROL_PERIOD_TICKS);
+		  read = hb_lcmxo2_get_qei_all(counters, &lcmxo2_status);
+	  }
+	  if(read != SUCCESS)
+		  continue;	// burst dropped (see 'spi'), no cycle on stale counters, the supervisor trips if it lasts
+
+	  if(hb_lcmxo2_get_stop() == SET)
+	  {
+		  /* Bridges braked: nothing winds up until motion_fault_clear() */
+		  motion_control_hold(&motion_control, counters);
+#if HB_LCMXO2_VEL_LOOP
+		  motors_set_velocity(motion_control.wheel_command);
+#else
+		  motors_set_speed(motion_control.wheel_command);
+		  if(motion_identifying)
+		  {
+			  motion_identifying = 0;
+			  motion_ident.phase = MOTION_IDENT_FAILED;
+		  }
+#endif
+#if REPLAY_CAPTURE
+		  /* Cycles without the control law cannot be replayed */
+		  replay_stop();
+#endif
+#if RECORDER
+		  recorder_record(xTaskGetTickCount(), lcmxo2_status, &motion_control);
+#endif
+		  motion_cs_publish(pPID_1,pPID_2,pPID_3,lcmxo2_status);
+		  supervisor_alive(SUPERVISOR_ALIVE_MOTION_CS);
+		  continue;
+	  }
+#if !HB_LCMXO2_VEL_LOOP
+	  if(motion_ident_request || motion_identifying)
+	  {
+		  motion_cs_identify(counters);
+#if RECORDER
+		  recorder_record(xTaskGetTickCount(), lcmxo2_status, &motion_control);
+#endif
+		  motion_cs_publish(pPID_1,pPID_2,pPID_3,lcmxo2_status);
+		  supervisor_alive(SUPERVISOR_ALIVE_MOTION_CS);
+		  continue;
+	  }
+#endif
+	  motion_control_cycle(&motion_control, counters);
+#if HB_LCMXO2_VEL_LOOP
+	  motors_set_velocity(motion_control.wheel_command);
+#else
+	  motors_set_speed(motion_control.wheel_command);
+#endif
+#if REPLAY_CAPTURE
+	  /* The references of the cycle, before the next ones are set */
+	  replay_record(xTaskGetTickCount(), lcmxo2_status, counters, &motion_control);
+#endif
+#if RECORDER
+	  recorder_record(xTaskGetTickCount(), lcmxo2_status, &motion_control);
+#endif
+	  motion_cs_publish(pPID_1,pPID_2,pPID_3,lcmxo2_status);
 	  timer++;
 	  if(timer==100)
 	  {
-		  PID_Set_Ref_Position(pPID_1,3900);
+		  PID_Set_Ref_Position(pPID_1,7800);
 	  }
 	  if(timer==200)
 	  {
@@ -232,8 +543,7 @@ void motion_cs_task(void *pvParameters)
 
 	  // sprintf(str,"dummy3=%u \t old_dummy3=%u \t delta3=%u\n\r",dummy3, old_dummy3, (dummy3-old_dummy3)&0x0FFF);
 	  //serial_puts(str);
-	  /* Wakes-up when required */
-	  vTaskDelayUntil( &xNextWakeTime, MOTION_CONTROL_PERIOD_TICKS);
+	  supervisor_alive(SUPERVISOR_ALIVE_MOTION_CS);
   }
 }
 
@@ -0,0 +1,189 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       motion_fault.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Motor bridges fault monitoring: the fault interrupt brakes all the
+ *   bridges right away, faults are latched and reported on the debug port
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+
+/* Latched faults, written by the fault ISR */
+typedef struct {
+    uint32_t count;         /* fault edges since the last clear */
+    TickType_t time;        /* tick of the first one */
+} motion_fault_t;
+
+static motion_fault_t motion_faults[HB_LCMXO2_NB_CHANNELS];
+static volatile uint32_t motion_fault_new;  /* latched, not reported yet */
+static TaskHandle_t motion_fault_task_handle;
+
+/* Static kernel objects */
+static StaticTask_t OS_FaultTCB OS_DTCM;
+static StackType_t OS_FaultStack[OS_TASK_STACK_FAULT] OS_DTCM;
+
+/* Local, Private functions */
+static void OS_FaultTask(void *pvParameters);
+static void motion_fault_latch(uint8_t channels, TickType_t now);
+
+BaseType_t motion_fault_start(void)
+{
+    motion_fault_task_handle = xTaskCreateStatic(OS_FaultTask, "FAULT", OS_TASK_STACK_FAULT, NULL, OS_TASK_PRIORITY_FAULT, OS_FaultStack, &OS_FaultTCB);
+    if(motion_fault_task_handle == NULL)
+        return pdFAIL;
+
+    /* A bridge already in fault gives no edge */
+    if(hb_fault_get_state())
+    {
+        hb_lcmxo2_emergency_stop();
+        motion_fault_latch(hb_fault_get_state(), xTaskGetTickCount());
+#if RECORDER
+        recorder_trigger(RECORDER_TRIGGER_FAULT);
+#endif
+    }
+    hb_fault_enable(OS_ISR_PRIORITY_MOT_FAULT);
+
+    return pdPASS;
+}
+
+static void motion_fault_latch(uint8_t channels, TickType_t now)
+{
+    uint8_t ch;
+
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+    {
+        if(channels & (1 << ch))
+        {
+            if(motion_faults[ch].count++ == 0)
+                motion_faults[ch].time = now;
+        }
+    }
+    atomic_or32(&motion_fault_new, channels);
+}
+
+/* Brake first, bookkeeping after */
+void MOT_FAULT_ISR(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    hb_lcmxo2_emergency_stop();
+    TRACE_ISR_ENTER();
+
+    motion_fault_latch(hb_fault_get_it(), xTaskGetTickCountFromISR());
+#if RECORDER
+    recorder_trigger(RECORDER_TRIGGER_FAULT);
+#endif
+    vTaskNotifyGiveFromISR(motion_fault_task_handle, &xHigherPriorityTaskWoken);
+
+    TRACE_ISR_EXIT();
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void OS_FaultTask(void *pvParameters)
+{
+    char str[80];
+    uint8_t channels, ch;
+    motion_fault_t fault;
+
+    /* Remove compiler warning about unused parameter. */
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Faults latched before the scheduler started are already pending */
+        channels = (uint8_t)atomic_swap32(&motion_fault_new, 0);
+
+        for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+        {
+            if(channels & (1 << ch))
+            {
+                taskENTER_CRITICAL();
+                fault = motion_faults[ch];
+                taskEXIT_CRITICAL();
+
+                snprintf(str, sizeof(str), "\n\rFAULT: motor %u at %lu ms, bridges braked\n\r",
+                         ch, (unsigned long)(fault.time * portTICK_PERIOD_MS));
+                serial_puts(str);
+            }
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/**
+  * @brief  Print the latched faults
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void motion_fault_print(char* buffer, size_t length)
+{
+    motion_fault_t faults[HB_LCMXO2_NB_CHANNELS];
+    uint8_t state = hb_fault_get_state();
+    size_t len = 0;
+    uint8_t ch;
+
+    taskENTER_CRITICAL();
+    memcpy(faults, motion_faults, sizeof(faults));
+    taskEXIT_CRITICAL();
+
+    len += snprintf(buffer + len, length - len, "bridges : %s\n\r",
+                    (hb_lcmxo2_get_stop() == SET) ? "stopped" : "running");
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS && len < length; ch++)
+    {
+        len += snprintf(buffer + len, length - len, "motor %u : %s, %lu fault(s)",
+                        ch, (state & (1 << ch)) ? "FAULT" : "ok", (unsigned long)faults[ch].count);
+        if(faults[ch].count && len < length)
+            len += snprintf(buffer + len, length - len, ", first at %lu ms",
+                            (unsigned long)(faults[ch].time * portTICK_PERIOD_MS));
+        if(len < length)
+            len += snprintf(buffer + len, length - len, "\n\r");
+    }
+}
+
+/**
+  * @brief  Clear the latched faults and restart the bridges with a zero
+  *         duty. Refused while a bridge still reports a fault. The control
+  *         task held the pose while stopped (motion_control_hold()), it
+  *         restarts from there.
+  * @param  None
+  * @retval pdPASS if the bridges were restarted
+  */
+BaseType_t motion_fault_clear(void)
+{
+    uint8_t ch;
+#if HB_LCMXO2_VEL_LOOP
+    int16_t refs[HB_LCMXO2_NB_CHANNELS] = { 0 };
+#endif
+
+    if(hb_fault_get_state())
+        return pdFAIL;
+
+    taskENTER_CRITICAL();
+    memset(motion_faults, 0, sizeof(motion_faults));
+    atomic_store32(&motion_fault_new, 0);
+    taskEXIT_CRITICAL();
+
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS; ch++)
+        hb_lcmxo2_set_pwm(ch, 0);
+#if HB_LCMXO2_VEL_LOOP
+    /* The stop also cleared CONFIG.VEL_EN */
+    hb_lcmxo2_set_vel_ref_all(refs);
+    hb_lcmxo2_set_vel_loop(HB_LCMXO2_VEL_PERIOD_US, ENABLE);
+#endif
+    hb_lcmxo2_clear_stop();
+    hb_lcmxo2_set_pwm_enable(ENABLE);
+
+    return pdPASS;
+}
@@ -0,0 +1,286 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       recorder.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Flight recorder: the control task writes every cycle (references, pose,
+ *   wheels, commands, LCMXO2 STATUS and bridges) in a ring, at full rate
+ *   whatever the debug port can carry. A trigger freezes the window around
+ *   its cycle, RECORDER_PRE cycles before and RECORDER_POST after by
+ *   default; the shell then dumps it at its own pace, and re-arms.
+ *
+ *   Triggers, the first one wins until re-armed:
+ *    - a bridge fault, from the fault ISR (motion_fault.c)
+ *    - a following error above the threshold on an axis, against the
+ *      profiled reference: off by default, it has to clear the error of a
+ *      normal move
+ *    - the shell 'recorder trigger' command
+ *
+ *   The ring is in the main SRAM with the other .bss, not in the DTCM.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+#include "recorder.h"
+
+#if RECORDER
+
+/* Ring index of a cycle */
+#define RECORDER_INDEX(_cycle)  ((_cycle) % RECORDER_SAMPLES)
+
+typedef enum {
+    RECORDER_ARMED = 0,         /* recording, waiting for a trigger */
+    RECORDER_TRIGGERED,         /* recording the cycles after the trigger */
+    RECORDER_FROZEN             /* window ready, nothing written */
+} recorder_state_t;
+
+/* Dump sequence, one or more shell outputs per step */
+typedef enum {
+    RECORDER_DUMP_HEADER = 0,
+    RECORDER_DUMP_SAMPLES,
+    RECORDER_DUMP_END
+} recorder_dump_step_t;
+
+/* One control cycle, 56 bytes */
+typedef struct {
+    TickType_t time;
+    uint16_t status;                    /* LCMXO2 STATUS */
+    uint8_t faults;                     /* bridges reporting a fault, one bit per motor */
+    uint8_t stopped;                    /* bridges braked by an emergency stop */
+    int32_t ref[MOTION_AXES];           /* profiled */
+    int32_t pose[MOTION_AXES];
+    int32_t wheel[PID_WHEELS];          /* ticks */
+    int32_t command[PID_WHEELS];
+} recorder_sample_t;
+_Static_assert(sizeof(recorder_sample_t) == 56,
+               "recorder_sample_t: the ring, RECORDER_SAMPLES of them, is sized for 56 bytes");
+
+static recorder_sample_t recorder_ring[RECORDER_SAMPLES];
+
+/* Written by the control task, or by the shell within a critical section */
+static volatile recorder_state_t recorder_state;
+static uint32_t recorder_cycles;        /* recorded since armed */
+static uint32_t recorder_trigger_cycle;
+static uint32_t recorder_remaining;     /* cycles to record after the trigger */
+static uint32_t recorder_cause;
+static uint32_t recorder_pre = RECORDER_PRE;
+static uint32_t recorder_post = RECORDER_POST;
+
+/* Written by any task or ISR */
+static volatile uint32_t recorder_request;
+static volatile uint32_t recorder_threshold;
+
+/* Dump state, the shell calls recorder_dump() until it returns pdFALSE */
+static recorder_dump_step_t recorder_dump_step;
+static uint32_t recorder_dump_cycle;
+
+static const char* const recorder_states[] = {
+    "armed", "triggered", "frozen"
+};
+
+/**
+  * @brief  Record a control cycle, called by the control task after it
+  * @param  time: tick of the cycle
+  * @param  status: LCMXO2 STATUS read with the counters
+  * @param  control: control law, with the profiled references of the
+  *         cycle and the wheel commands it computed
+  * @retval None
+  */
+void recorder_record(uint32_t time, uint16_t status, const motion_control_t* control)
+{
+    recorder_sample_t* sample;
+    uint32_t cause, threshold;
+    uint8_t n;
+
+    if(recorder_state == RECORDER_FROZEN)
+        return;
+
+    sample = &recorder_ring[RECORDER_INDEX(recorder_cycles)];
+    sample->time = time;
+    sample->status = status;
+    sample->faults = hb_fault_get_state();
+    sample->stopped = (hb_lcmxo2_get_stop() == SET);
+    for(n = 0; n < MOTION_AXES; n++)
+    {
+        sample->ref[n] = control->axis[n]->prof_position;
+        sample->pose[n] = control->axis[n]->curr;
+    }
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        sample->wheel[n] = control->wheel_position[n];
+        sample->command[n] = control->wheel_command[n];
+    }
+    recorder_cycles++;
+
+    cause = atomic_swap32(&recorder_request, 0);
+    threshold = recorder_threshold;
+    if(threshold)
+    {
+        for(n = 0; n < MOTION_AXES; n++)
+            if((uint32_t)abs(sample->ref[n] - sample->pose[n]) > threshold)
+                cause |= RECORDER_TRIGGER_ERROR;
+    }
+
+    if(recorder_state == RECORDER_ARMED && cause)
+    {
+        recorder_cause = cause;
+        recorder_trigger_cycle = recorder_cycles - 1;
+        recorder_remaining = recorder_post;
+        recorder_state = RECORDER_TRIGGERED;
+    }
+    else if(recorder_state == RECORDER_TRIGGERED)
+        recorder_remaining--;
+
+    if(recorder_state == RECORDER_TRIGGERED && recorder_remaining == 0)
+        recorder_state = RECORDER_FROZEN;
+}
+
+/**
+  * @brief  Freeze the window around the next control cycle, any task or ISR
+  * @param  cause: RECORDER_TRIGGER_xxx
+  * @retval None
+  */
+void recorder_trigger(uint32_t cause)
+{
+    atomic_or32(&recorder_request, cause);
+}
+
+/**
+  * @brief  Discard the window and record again
+  * @param  pre: cycles kept before the trigger
+  * @param  post: cycles recorded after the trigger
+  * @retval pdFAIL if the window does not fit in the ring
+  */
+BaseType_t recorder_arm(uint32_t pre, uint32_t post)
+{
+    if(pre >= RECORDER_SAMPLES || post >= RECORDER_SAMPLES - pre)
+        return pdFAIL;
+
+    /* The control task has a higher priority */
+    taskENTER_CRITICAL();
+    recorder_pre = pre;
+    recorder_post = post;
+    recorder_cycles = 0;
+    recorder_cause = 0;
+    atomic_store32(&recorder_request, 0);
+    recorder_state = RECORDER_ARMED;
+    recorder_dump_step = RECORDER_DUMP_HEADER;
+    taskEXIT_CRITICAL();
+
+    return pdPASS;
+}
+
+/**
+  * @brief  Position error triggering the recorder
+  * @param  threshold: PID units on any axis, 0 => no trigger
+  * @retval None
+  */
+void recorder_set_threshold(uint32_t threshold)
+{
+    recorder_threshold = threshold;
+}
+
+/**
+  * @brief  Print the recorder state
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void recorder_print(char* buffer, size_t length)
+{
+    size_t len = 0;
+
+    len += snprintf(buffer + len, length - len,
+                    "state   : %s, %lu cycles recorded\n\r"
+                    "window  : %lu before, %lu after the trigger, %lu at most\n\r"
+                    "trigger : faults, shell",
+                    recorder_states[recorder_state], (unsigned long)recorder_cycles,
+                    (unsigned long)recorder_pre, (unsigned long)recorder_post,
+                    (unsigned long)(RECORDER_SAMPLES - 1));
+    if(recorder_threshold && len < length)
+        len += snprintf(buffer + len, length - len, ", error above %lu",
+                        (unsigned long)recorder_threshold);
+    if(recorder_state != RECORDER_ARMED && len < length)
+        snprintf(buffer + len, length - len, "\n\rfired   : cause 0x%02lx at %lu ms\n\r",
+                 (unsigned long)recorder_cause,
+                 (unsigned long)(recorder_ring[RECORDER_INDEX(recorder_trigger_cycle)].time * portTICK_PERIOD_MS));
+    else if(len < length)
+        snprintf(buffer + len, length - len, "\n\r");
+}
+
+/**
+  * @brief  Dump the frozen window, the recorder stays frozen until re-armed.
+  *         Lines:  # recorder <samples> <trigger> <cause> <period ms>
+  *                 S <cycle from the trigger> <ms> <STATUS> <faults> <stopped>
+  *                   <refs> <pose> <wheel positions> <wheel commands>
+  *                 # end
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval pdTRUE while there is more to dump
+  */
+BaseType_t recorder_dump(char* buffer, size_t length)
+{
+    const recorder_sample_t* sample;
+    uint32_t first;
+    size_t len = 0;
+    uint8_t n;
+
+    buffer[0] = '\0';
+    if(recorder_state != RECORDER_FROZEN)
+    {
+        recorder_print(buffer, length);
+        return pdFALSE;
+    }
+
+    first = recorder_trigger_cycle > recorder_pre ? recorder_trigger_cycle - recorder_pre : 0;
+
+    switch(recorder_dump_step)
+    {
+    case RECORDER_DUMP_HEADER:
+        snprintf(buffer, length, "# recorder %lu %lu %lu %u\n\r",
+                 (unsigned long)(recorder_cycles - first), (unsigned long)(recorder_trigger_cycle - first),
+                 (unsigned long)recorder_cause, MOTION_CONTROL_PERIOD_MS);
+        recorder_dump_cycle = first;
+        recorder_dump_step = RECORDER_DUMP_SAMPLES;
+        return pdTRUE;
+
+    case RECORDER_DUMP_SAMPLES:
+        /* A line is 60 to 180 characters */
+        while(recorder_dump_cycle < recorder_cycles && len + 180 < length)
+        {
+            sample = &recorder_ring[RECORDER_INDEX(recorder_dump_cycle)];
+            len += snprintf(buffer + len, length - len, "S %ld %lu 0x%04x 0x%02x %u",
+                            (long)(recorder_dump_cycle - recorder_trigger_cycle),
+                            (unsigned long)(sample->time * portTICK_PERIOD_MS),
+                            sample->status, sample->faults, sample->stopped);
+            for(n = 0; n < MOTION_AXES; n++)
+                len += snprintf(buffer + len, length - len, " %ld", (long)sample->ref[n]);
+            for(n = 0; n < MOTION_AXES; n++)
+                len += snprintf(buffer + len, length - len, " %ld", (long)sample->pose[n]);
+            for(n = 0; n < PID_WHEELS; n++)
+                len += snprintf(buffer + len, length - len, " %ld", (long)sample->wheel[n]);
+            for(n = 0; n < PID_WHEELS; n++)
+                len += snprintf(buffer + len, length - len, " %ld", (long)sample->command[n]);
+            len += snprintf(buffer + len, length - len, "\n\r");
+            recorder_dump_cycle++;
+        }
+        if(recorder_dump_cycle >= recorder_cycles)
+            recorder_dump_step = RECORDER_DUMP_END;
+        return pdTRUE;
+
+    case RECORDER_DUMP_END:
+    default:
+        snprintf(buffer, length, "# end\n\r");
+        recorder_dump_step = RECORDER_DUMP_HEADER;
+        return pdFALSE;
+    }
+}
+
+#endif /* RECORDER */
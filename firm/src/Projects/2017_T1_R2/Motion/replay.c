@@ -0,0 +1,226 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       replay.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Replay capture: the control task logs the inputs of every cycle (QEI
+ *   counters, LCMXO2 STATUS, tick, axes references) and its wheel
+ *   commands, delta encoded (replay.h). The log starts with the first
+ *   cycle, so that firm/host/replay_host.c replays it from the same state
+ *   through motion_control.c and pid.c, and compares the commands.
+ *
+ *   Once full, or stopped, the capture cannot resume: the control state
+ *   would be missing from the log. It is dumped as text on the debug port.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+#include "replay.h"
+
+#if REPLAY_CAPTURE
+
+/* 20 ms cycles of 7 to 10 bytes, more than a match */
+#define REPLAY_LOG_SIZE     (48 * 1024)
+
+/* Dump sequence, one or more shell outputs per step */
+typedef enum {
+    REPLAY_DUMP_HEADER = 0,
+    REPLAY_DUMP_DATA,
+    REPLAY_DUMP_END
+} replay_dump_step_t;
+
+/* Fields of the last record, the next one is relative to them */
+typedef struct {
+    uint32_t time;
+    uint32_t period;
+    uint16_t status;
+    int16_t counters[PID_WHEELS];
+    int32_t ref[MOTION_AXES];
+    int32_t command[PID_WHEELS];
+} replay_last_t;
+
+/* Written by the control task only, read once stopped */
+static uint8_t replay_log[REPLAY_LOG_SIZE];
+static uint32_t replay_length;
+static uint32_t replay_cycles;
+static uint32_t replay_dropped;         /* cycles not recorded, log full */
+static volatile bool replay_running = true;
+static replay_last_t replay_last;
+
+/* Dump state, the shell calls replay_dump() until it returns pdFALSE */
+static replay_dump_step_t replay_dump_step;
+static uint32_t replay_dump_index;
+
+/* Unsigned LEB128, returns the next byte */
+static uint8_t* replay_put(uint8_t* p, uint32_t value)
+{
+    while(value >= 0x80)
+    {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+/**
+  * @brief  Log a control cycle, called by the control task after it
+  * @param  time: tick of the cycle
+  * @param  status: LCMXO2 STATUS read with the counters
+  * @param  counters: QEI counters of the cycle
+  * @param  control: control law, with the references used by the cycle
+  *         and the wheel commands it computed
+  * @retval None
+  */
+void replay_record(uint32_t time, uint16_t status, const int16_t counters[PID_WHEELS],
+                   const motion_control_t* control)
+{
+    uint8_t *start, *p;
+    uint8_t header = 0;
+    uint32_t period;
+    uint8_t n;
+
+    if(!replay_running)
+        return;
+
+    if(replay_length + REPLAY_RECORD_MAX > REPLAY_LOG_SIZE)
+    {
+        replay_dropped++;
+        return;
+    }
+
+    start = &replay_log[replay_length];
+    p = start + 1;
+
+    period = time - replay_last.time;
+    replay_last.time = time;
+    if(period != replay_last.period)
+    {
+        header |= REPLAY_HDR_PERIOD;
+        p = replay_put(p, period);
+        replay_last.period = period;
+    }
+
+    if(status != replay_last.status)
+    {
+        header |= REPLAY_HDR_STATUS;
+        p = replay_put(p, status);
+        replay_last.status = status;
+    }
+
+    for(n = 0; n < MOTION_AXES; n++)
+        if(control->axis[n]->ref != replay_last.ref[n])
+            header |= REPLAY_HDR_REF;
+    if(header & REPLAY_HDR_REF)
+    {
+        for(n = 0; n < MOTION_AXES; n++)
+        {
+            p = replay_put(p, replay_zigzag(control->axis[n]->ref - replay_last.ref[n]));
+            replay_last.ref[n] = control->axis[n]->ref;
+        }
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        p = replay_put(p, replay_zigzag(replay_counter_delta(counters[n], replay_last.counters[n])));
+        replay_last.counters[n] = counters[n];
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        p = replay_put(p, replay_zigzag(control->wheel_command[n] - replay_last.command[n]));
+        replay_last.command[n] = control->wheel_command[n];
+    }
+
+    *start = header;
+    replay_length += p - start;
+    replay_cycles++;
+}
+
+/**
+  * @brief  Stop the capture for good, the log is kept
+  * @param  None
+  * @retval None
+  */
+void replay_stop(void)
+{
+    replay_running = false;
+}
+
+/**
+  * @brief  Print the capture state
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void replay_print(char* buffer, size_t length)
+{
+    snprintf(buffer, length,
+             "capture : %s\n\r"
+             "cycles  : %lu, %lu dropped\n\r"
+             "log     : %lu / %lu bytes\n\r",
+             replay_running ? (replay_dropped ? "full" : "on") : "stopped",
+             (unsigned long)replay_cycles, (unsigned long)replay_dropped,
+             (unsigned long)replay_length, (unsigned long)REPLAY_LOG_SIZE);
+}
+
+/**
+  * @brief  Dump the log. The capture is stopped.
+  *         Lines:  # replay <cycles> <bytes> <dropped> <wheels> <velocity loop>
+  *                 D <bytes>, hexadecimal
+  *                 # end
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval pdTRUE while there is more to dump
+  */
+BaseType_t replay_dump(char* buffer, size_t length)
+{
+    size_t len = 0;
+    uint32_t end;
+
+    /* The control task has a higher priority, it is not in replay_record() */
+    replay_stop();
+    buffer[0] = '\0';
+
+    switch(replay_dump_step)
+    {
+    case REPLAY_DUMP_HEADER:
+        snprintf(buffer, length, "# replay %lu %lu %lu %u %u\n\r",
+                 (unsigned long)replay_cycles, (unsigned long)replay_length,
+                 (unsigned long)replay_dropped, PID_WHEELS, HB_LCMXO2_VEL_LOOP);
+        replay_dump_index = 0;
+        replay_dump_step = REPLAY_DUMP_DATA;
+        return pdTRUE;
+
+    case REPLAY_DUMP_DATA:
+        /* "D " + 2 characters per byte + "\n\r" */
+        while(replay_dump_index < replay_length && len + 2 * REPLAY_DUMP_BYTES + 5 < length)
+        {
+            end = replay_dump_index + REPLAY_DUMP_BYTES;
+            if(end > replay_length)
+                end = replay_length;
+            len += snprintf(buffer + len, length - len, "D ");
+            while(replay_dump_index < end)
+                len += snprintf(buffer + len, length - len, "%02x", replay_log[replay_dump_index++]);
+            len += snprintf(buffer + len, length - len, "\n\r");
+        }
+        if(replay_dump_index >= replay_length)
+            replay_dump_step = REPLAY_DUMP_END;
+        return pdTRUE;
+
+    case REPLAY_DUMP_END:
+    default:
+        snprintf(buffer, length, "# end\n\r");
+        replay_dump_step = REPLAY_DUMP_HEADER;
+        return pdFALSE;
+    }
+}
+
+#endif /* REPLAY_CAPTURE */
@@ -0,0 +1,135 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       supervisor.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Tasks liveness supervisor: the independent watchdog is only kicked
+ *   when every supervised task checked in during the last period
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+
+/* Tells a post-mortem record from the power-on content of the RAM */
+#define SUPERVISOR_MAGIC    0x57D0A11EUL
+
+/* Post-mortem record, not cleared by the startup code */
+typedef struct {
+    uint32_t magic;
+    EventBits_t alive;      /* check-ins of the last complete period */
+    uint32_t resets;        /* watchdog resets since power-on */
+} supervisor_record_t;
+
+static supervisor_record_t supervisor_record __attribute__((section(".noinit")));
+
+/* Check-ins of the period before the watchdog reset, valid if wdg_reset */
+static EventBits_t supervisor_last_alive;
+static bool supervisor_wdg_reset;
+
+static EventGroupHandle_t supervisor_events;
+
+/* Static kernel objects */
+static StaticEventGroup_t supervisor_events_buffer OS_DTCM;
+static StaticTask_t OS_SupervisorTCB OS_DTCM;
+static StackType_t OS_SupervisorStack[OS_TASK_STACK_SUPERVISOR] OS_DTCM;
+
+/* Local, Private functions */
+static void OS_SupervisorTask(void *pvParameters);
+
+BaseType_t supervisor_start(void)
+{
+    if(supervisor_record.magic != SUPERVISOR_MAGIC)
+    {
+        supervisor_record.magic = SUPERVISOR_MAGIC;
+        supervisor_record.resets = 0;
+        supervisor_record.alive = 0;
+    }
+
+    supervisor_wdg_reset = (hb_sys_iwdg_get_reset() == SET);
+    if(supervisor_wdg_reset)
+    {
+        supervisor_last_alive = supervisor_record.alive;
+        supervisor_record.resets++;
+    }
+
+    supervisor_events = xEventGroupCreateStatic(&supervisor_events_buffer);
+
+    if(xTaskCreateStatic(OS_SupervisorTask, "SUPERVISOR", OS_TASK_STACK_SUPERVISOR, NULL, OS_TASK_PRIORITY_SUPERVISOR, OS_SupervisorStack, &OS_SupervisorTCB) == NULL)
+        return pdFAIL;
+
+    hb_sys_iwdg_init(SUPERVISOR_TIMEOUT_MS);
+
+    return pdPASS;
+}
+
+/**
+  * @brief  Check-in of a supervised task, to be called at least once per
+  *         SUPERVISOR_PERIOD_MS
+  * @param  task: SUPERVISOR_ALIVE_xxx bit of the calling task
+  * @retval None
+  */
+void supervisor_alive(EventBits_t task)
+{
+    xEventGroupSetBits(supervisor_events, task);
+}
+
+static void OS_SupervisorTask(void *pvParameters)
+{
+    TickType_t xNextWakeTime;
+    EventBits_t alive;
+    char str[80];
+
+    /* Remove compiler warning about unused parameter. */
+    ( void ) pvParameters;
+
+    if(supervisor_wdg_reset)
+    {
+        snprintf(str, sizeof(str), "\n\rWATCHDOG RESET: last alive 0x%02lx, missing 0x%02lx\n\r",
+                 (unsigned long)supervisor_last_alive,
+                 (unsigned long)(SUPERVISOR_ALIVE_ALL & ~supervisor_last_alive));
+        serial_puts(str);
+    }
+
+    xNextWakeTime = xTaskGetTickCount();
+
+    for( ;; )
+    {
+        vTaskDelayUntil(&xNextWakeTime, pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+
+        alive = xEventGroupClearBits(supervisor_events, SUPERVISOR_ALIVE_ALL);
+        supervisor_record.alive = alive;
+
+        if((alive & SUPERVISOR_ALIVE_ALL) == SUPERVISOR_ALIVE_ALL)
+            hb_sys_iwdg_kick();
+    }
+}
+
+/**
+  * @brief  Print the post-mortem record of the last watchdog reset
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void supervisor_print(char* buffer, size_t length)
+{
+    if(supervisor_wdg_reset)
+        snprintf(buffer, length,
+                 "last reset  : watchdog\n\r"
+                 "last alive  : 0x%02lx (missing 0x%02lx)\n\r"
+                 "wdg resets  : %lu since power-on\n\r",
+                 (unsigned long)supervisor_last_alive,
+                 (unsigned long)(SUPERVISOR_ALIVE_ALL & ~supervisor_last_alive),
+                 (unsigned long)supervisor_record.resets);
+    else
+        snprintf(buffer, length,
+                 "last reset  : not the watchdog\n\r"
+                 "wdg resets  : %lu since power-on\n\r",
+                 (unsigned long)supervisor_record.resets);
+}
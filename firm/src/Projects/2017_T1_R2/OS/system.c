@@ -20,6 +20,9 @@
 #define SHELL_EOL                       "\n\r"
 #define SHELL_SYS_PFX           "[SYS] "    // For returns of Sys command
 
+/* Tasks reported by sys_get_run_time_stats(), kernel ones included */
+#define SYS_STATS_TASKS_MAX             10
+
 /* This example demonstrates how a human readable table of run time stats
 information is generated from raw data provided by uxTaskGetSystemState().
 The human readable table is written to pcWriteBuffer.  (see the vTaskList()
@@ -31,7 +34,7 @@ void sys_get_run_time_stats(char *pcWriteBuffer)
     const char * const pcLineSeparator =
                     SHELL_SYS_PFX"-----------------------------------------"SHELL_EOL;
 
-    TaskStatus_t *pxTaskStatusArray;
+    static TaskStatus_t pxTaskStatusArray[SYS_STATS_TASKS_MAX];
     volatile UBaseType_t uxArraySize, x;
     uint32_t ulTotalRunTime;
     uint32_t ulStatsAsPercentage;
@@ -43,11 +46,9 @@ void sys_get_run_time_stats(char *pcWriteBuffer)
    function is executing. */
    uxArraySize = uxTaskGetNumberOfTasks();
 
-   /* Allocate a TaskStatus_t structure for each task.  An array could be
-   allocated statically at compile time. */
-   pxTaskStatusArray = pvPortMalloc( uxArraySize * sizeof( TaskStatus_t ) );
-
-   if( pxTaskStatusArray != NULL )
+   /* One TaskStatus_t structure per task, allocated statically: nothing
+   is reported if there are more tasks than SYS_STATS_TASKS_MAX. */
+   if( uxArraySize <= SYS_STATS_TASKS_MAX )
    {
       /* Generate raw status information about each task. */
       uxArraySize = uxTaskGetSystemState( pxTaskStatusArray,
@@ -101,8 +102,5 @@ void sys_get_run_time_stats(char *pcWriteBuffer)
          sprintf( pcWriteBuffer,SHELL_SYS_PFX"%-20s %10lu   %3lu%%"SHELL_EOL, "TOTAL", 100*ulTotalRunTime, 100UL);
          pcWriteBuffer += strlen( ( char * ) pcWriteBuffer );
       }
-
-      /* The array is no longer needed, free the memory it consumes. */
-      vPortFree( pxTaskStatusArray );
    }
 }
@@ -0,0 +1,209 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       tickless.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Tickless idle (portSUPPRESS_TICKS_AND_SLEEP): the SysTick is stopped
+ *   and the core sleeps (WFI) until the next task timeout, woken up by
+ *   LPTIM1 or by any other interrupt.
+ *
+ *   Only the sleep mode is used: the clocks, the LCMXO2 SPI link and the
+ *   run-time stats timer (TIM6) keep running, so the idle task is still
+ *   charged the time slept and the wake-up has no PLL or regulator
+ *   restart. LPTIM1 and TIM6 share the APB1 clock.
+ *
+ *   The wake-up latency, from the tick boundary the core should have woken
+ *   up on to the tick being processed, is measured on every timer wake-up.
+ *
+ *   The core does not sleep while the trace recorder runs: the DWT cycle
+ *   counter of its timestamps may stop in sleep, the idle time would be
+ *   missing from the trace.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+
+/* Statistics, see tickless_print() */
+typedef struct {
+    uint32_t sleeps;            /* low-power entries */
+    uint32_t aborted;           /* entries given up, a task became ready */
+    uint32_t early;             /* woken up by another interrupt */
+    uint32_t ticks;             /* suppressed tick interrupts */
+    uint32_t latency_last;      /* LPTIM counts, up to the counter read */
+    uint32_t latency_max;
+    uint32_t latency_over;      /* wake-ups later than TICKLESS_LATENCY_MAX_US */
+} tickless_stats_t;
+
+static tickless_stats_t tickless_stats;
+
+/* Timings, set by tickless_init() */
+static uint32_t tickless_lptim_hz;
+static uint32_t tickless_cycles_per_tick;       /* SysTick reload + 1 */
+static uint32_t tickless_cycles_per_count;      /* core cycles per LPTIM count */
+static uint32_t tickless_latency_max;           /* LPTIM counts */
+static TickType_t tickless_max_ticks;           /* longest sleep, 16-bit LPTIM */
+
+/**
+  * @brief  Start the wake-up timer, to be called before the scheduler
+  * @param  None
+  * @retval None
+  */
+void tickless_init(void)
+{
+    /* Measures the time the SysTick is stopped outside of the LPTIM count */
+    hb_sys_cycle_counter_init();
+
+    tickless_lptim_hz = hb_sys_lptim_get_hz();
+    tickless_cycles_per_tick = configCPU_CLOCK_HZ / configTICK_RATE_HZ;
+    tickless_cycles_per_count = configCPU_CLOCK_HZ / tickless_lptim_hz;
+    tickless_latency_max = (TICKLESS_LATENCY_MAX_US * tickless_lptim_hz) / 1000000UL;
+    tickless_max_ticks = 0xFFFF / (tickless_lptim_hz / configTICK_RATE_HZ);
+
+    hb_sys_lptim_init(OS_ISR_PRIORITY_TICKLESS);
+}
+
+/**
+  * @brief  portSUPPRESS_TICKS_AND_SLEEP(), called by the idle task with the
+  *         scheduler suspended
+  * @param  expected_idle: ticks before the next task timeout
+  * @retval None
+  */
+void tickless_sleep(TickType_t expected_idle)
+{
+    uint32_t cycles_left, cycles_stop, cycles_start, cycles_read, cycles_elapsed;
+    uint32_t period, elapsed, latency, next;
+    TickType_t ticks;
+
+    /* The idle task polls instead, the trace timestamps keep counting */
+    if(trace_is_running())
+        return;
+
+    if(expected_idle > tickless_max_ticks)
+        expected_idle = tickless_max_ticks;
+
+    /* PRIMASK, not BASEPRI: masked interrupts still wake the core up */
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    /* A tick interrupt already pending is not slept over */
+    if((eTaskConfirmSleepModeStatus() == eAbortSleep) ||
+       (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+    {
+        tickless_stats.aborted++;
+        __enable_irq();
+        return;
+    }
+
+    /* Stop the SysTick, the rest of the current tick is slept too */
+    cycles_stop = DWT->CYCCNT;
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    cycles_left = SysTick->VAL;
+
+    period = (cycles_left + tickless_cycles_per_tick * (expected_idle - 1)) / tickless_cycles_per_count;
+    hb_sys_lptim_start(period);
+    cycles_start = DWT->CYCCNT;
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    elapsed = hb_sys_lptim_get_elapsed();
+    cycles_read = DWT->CYCCNT;
+    hb_sys_lptim_stop();
+
+    tickless_stats.sleeps++;
+    if(elapsed >= period)
+    {
+        latency = elapsed - period;
+        tickless_stats.latency_last = latency;
+        if(latency > tickless_stats.latency_max)
+            tickless_stats.latency_max = latency;
+        if(latency > tickless_latency_max)
+            tickless_stats.latency_over++;
+    }
+    else
+    {
+        tickless_stats.early++;
+    }
+
+    /* LPTIM time plus the time the SysTick was stopped around it. The
+     * DWT intervals do not span the WFI, the counter may stop in sleep. */
+    cycles_elapsed = elapsed * tickless_cycles_per_count
+                     + (cycles_start - cycles_stop) + (DWT->CYCCNT - cycles_read);
+
+    /* Restart the SysTick for the rest of the current tick */
+    if(cycles_elapsed >= cycles_left)
+    {
+        ticks = 1 + (cycles_elapsed - cycles_left) / tickless_cycles_per_tick;
+        next = tickless_cycles_per_tick - (cycles_elapsed - cycles_left) % tickless_cycles_per_tick;
+    }
+    else
+    {
+        ticks = 0;
+        next = cycles_left - cycles_elapsed;
+    }
+    SysTick->LOAD = next - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = tickless_cycles_per_tick - 1;
+
+    /* The last tick boundary is left to the tick interrupt, it unblocks
+     * the tasks waiting for it. Ticks are pended while the scheduler is
+     * suspended, they are processed by xTaskResumeAll(). */
+    if(ticks > expected_idle)
+        ticks = expected_idle;
+    if(ticks)
+    {
+        vTaskStepTick(ticks - 1);
+        SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+        tickless_stats.ticks += ticks - 1;
+    }
+
+    __enable_irq();
+}
+
+/**
+  * @brief  Print the tickless idle statistics
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void tickless_print(char* buffer, size_t length)
+{
+    tickless_stats_t stats;
+
+    taskENTER_CRITICAL();
+    stats = tickless_stats;
+    taskEXIT_CRITICAL();
+
+    snprintf(buffer, length,
+             "sleeps      : %lu (%lu aborted, %lu woken early)\n\r"
+             "ticks saved : %lu\n\r"
+             "latency     : %lu ns last, %lu ns max\n\r"
+             "over %3u us : %lu\n\r",
+             (unsigned long)stats.sleeps, (unsigned long)stats.aborted, (unsigned long)stats.early,
+             (unsigned long)stats.ticks,
+             (unsigned long)((stats.latency_last * 1000000000ULL) / tickless_lptim_hz),
+             (unsigned long)((stats.latency_max * 1000000000ULL) / tickless_lptim_hz),
+             TICKLESS_LATENCY_MAX_US, (unsigned long)stats.latency_over);
+}
+
+/**
+  * @brief  Clear the tickless idle statistics
+  * @param  None
+  * @retval None
+  */
+void tickless_clear(void)
+{
+    taskENTER_CRITICAL();
+    memset(&tickless_stats, 0, sizeof(tickless_stats));
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,218 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       trace.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Scheduling trace recorder: context switches, queue operations and
+ *   application ISRs are recorded in a RAM ring that keeps the most recent
+ *   events. The ring is dumped as text on the debug port, to be converted
+ *   by firm/host/trace2json for Perfetto / chrome://tracing.
+ *
+ *   Records are stamped with the DWT cycle counter, which may stop while
+ *   the core sleeps: the tickless idle is suspended while recording, so
+ *   that the idle time stays in the timestamps.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+
+/* Ring size in records, power of two (8 KB) */
+#define TRACE_RING_SIZE     1024
+
+/* Tasks named in the dump header, kernel ones included */
+#define TRACE_TASKS_MAX     10
+
+/* Dump sequence, one or more shell outputs per step */
+typedef enum {
+    TRACE_DUMP_HEADER = 0,
+    TRACE_DUMP_RECORDS,
+    TRACE_DUMP_END
+} trace_dump_step_t;
+
+static trace_record_t trace_ring[TRACE_RING_SIZE];
+static volatile uint32_t trace_head;    /* records written since trace_start() */
+static volatile bool trace_running;
+
+/* Dump state, the shell calls trace_dump() until it returns pdFALSE */
+static trace_dump_step_t trace_dump_step;
+static uint32_t trace_dump_index;
+
+/* Names of the TRACE_QUEUE_xxx numbers */
+static const char* const trace_queue_names[] = {
+    "queue", "SERIAL_RX", "SERIAL_TX"
+};
+
+/* Names of the instrumented ISRs, by exception number */
+static const struct {
+    uint8_t exception;
+    const char* name;
+} trace_isr_names[] = {
+    { DBG_IRQn + 16,        "SERIAL_ISR" },
+    { MOT_FAULT_IRQn + 16,  "MOT_FAULT_ISR" },
+    { LCMXO2_IRQn + 16,     "LCMXO2_ISR" }
+};
+
+/**
+  * @brief  Start the cycle counter, recording is started by trace_start()
+  * @param  None
+  * @retval None
+  */
+void trace_init(void)
+{
+    hb_sys_cycle_counter_init();
+}
+
+/**
+  * @brief  Clear the ring and start recording
+  * @param  None
+  * @retval None
+  */
+void trace_start(void)
+{
+    taskENTER_CRITICAL();
+    trace_head = 0;
+    trace_dump_step = TRACE_DUMP_HEADER;
+    trace_running = true;
+    taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  Stop recording, the ring keeps the last TRACE_RING_SIZE records
+  * @param  None
+  * @retval None
+  */
+void trace_stop(void)
+{
+    trace_running = false;
+}
+
+/**
+  * @brief  Recording state, the tickless idle does not sleep while recording
+  * @param  None
+  * @retval true between trace_start() and trace_stop()
+  */
+bool trace_is_running(void)
+{
+    return trace_running;
+}
+
+/**
+  * @brief  Store a record, called by the kernel hooks and the ISRs
+  * @param  event: TRACE_EV_xxx
+  * @param  id, arg: see the TRACE_EV_xxx definitions
+  * @retval None
+  */
+void trace_record(uint8_t event, uint8_t id, uint16_t arg)
+{
+    trace_record_t* record;
+    UBaseType_t mask;
+
+    if(!trace_running)
+        return;
+
+    /* Called from tasks, ISRs and kernel critical sections */
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    record = &trace_ring[trace_head & (TRACE_RING_SIZE - 1)];
+    record->cycles = DWT->CYCCNT;
+    record->event = event;
+    record->id = id;
+    record->arg = arg;
+    trace_head++;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+  * @brief  Print the recorder state
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval None
+  */
+void trace_print(char* buffer, size_t length)
+{
+    uint32_t head = trace_head;
+
+    snprintf(buffer, length,
+             "recording : %s\n\r"
+             "records   : %lu (%lu kept)\n\r",
+             trace_running ? "on" : "off",
+             (unsigned long)head,
+             (unsigned long)((head > TRACE_RING_SIZE) ? TRACE_RING_SIZE : head));
+}
+
+/**
+  * @brief  Dump the ring, oldest record first. Recording is stopped.
+  *         Lines:  # trace <cpu_hz> <records> <lost>
+  *                 T <task number> <name>
+  *                 Q <queue number> <name>
+  *                 I <exception number> <name>
+  *                 R <cycles> <event> <id> <arg>, hexadecimal
+  *                 # end
+  * @param  buffer: destination string
+  * @param  length: size of the destination
+  * @retval pdTRUE while there is more to dump
+  */
+BaseType_t trace_dump(char* buffer, size_t length)
+{
+    static TaskStatus_t tasks[TRACE_TASKS_MAX];
+    UBaseType_t nb_tasks, i;
+    uint32_t head, first;
+    trace_record_t* record;
+    size_t len = 0;
+
+    buffer[0] = '\0';
+    trace_stop();
+    head = trace_head;
+    first = (head > TRACE_RING_SIZE) ? head - TRACE_RING_SIZE : 0;
+
+    switch(trace_dump_step)
+    {
+    case TRACE_DUMP_HEADER:
+        len += snprintf(buffer + len, length - len, "# trace %lu %lu %lu\n\r",
+                        (unsigned long)configCPU_CLOCK_HZ, (unsigned long)(head - first), (unsigned long)first);
+
+        nb_tasks = uxTaskGetNumberOfTasks();
+        if(nb_tasks <= TRACE_TASKS_MAX)
+        {
+            nb_tasks = uxTaskGetSystemState(tasks, nb_tasks, NULL);
+            for(i = 0; i < nb_tasks && len < length; i++)
+                len += snprintf(buffer + len, length - len, "T %lu %s\n\r",
+                                (unsigned long)tasks[i].xTaskNumber, tasks[i].pcTaskName);
+        }
+        for(i = 0; i < sizeof(trace_queue_names) / sizeof(trace_queue_names[0]) && len < length; i++)
+            len += snprintf(buffer + len, length - len, "Q %lu %s\n\r",
+                            (unsigned long)i, trace_queue_names[i]);
+        for(i = 0; i < sizeof(trace_isr_names) / sizeof(trace_isr_names[0]) && len < length; i++)
+            len += snprintf(buffer + len, length - len, "I %u %s\n\r",
+                            trace_isr_names[i].exception, trace_isr_names[i].name);
+
+        trace_dump_index = first;
+        trace_dump_step = TRACE_DUMP_RECORDS;
+        return pdTRUE;
+
+    case TRACE_DUMP_RECORDS:
+        /* "R 01234567 01 02 0003\n\r", 23 characters */
+        while(trace_dump_index < head && len + 24 < length)
+        {
+            record = &trace_ring[trace_dump_index & (TRACE_RING_SIZE - 1)];
+            len += snprintf(buffer + len, length - len, "R %08lx %02x %02x %04x\n\r",
+                            (unsigned long)record->cycles, record->event, record->id, record->arg);
+            trace_dump_index++;
+        }
+        if(trace_dump_index >= head)
+            trace_dump_step = TRACE_DUMP_END;
+        return pdTRUE;
+
+    case TRACE_DUMP_END:
+    default:
+        snprintf(buffer, length, "# end\n\r");
+        trace_dump_step = TRACE_DUMP_HEADER;
+        return pdFALSE;
+    }
+}
@@ -27,8 +27,11 @@
  *
  *  /!\ Keep in mind that PID gains are sample time dependent
  *
- *  /!\ Do not forget to set a heap size in your linker for mallocs
- *  /!\ At least 4096 bytes /!\
+ *  /!\ pid_init() hands out statically allocated processes, at most
+ *  /!\ PID_PROCESS_MAX of them /!\
+ *
+ * - The holonomic functions keep no state of their own: the base
+ * (PID_holonomic_t) and the processes belong to the caller.
  *
  * See ./example for more informations
  *
@@ -49,6 +52,24 @@
 
 #include "pid.h"
 #include <stdlib.h>
+#include <math.h>
+
+// Holonomic base geometry, 3 omni wheels at 120 degrees: axes (x, y, teta)
+// from the wheel positions, and wheel commands from the axes commands.
+// Another base (e.g. 4 mecanum wheels) only changes these matrices.
+#if PID_WHEELS != 3
+#error "PID Library: no holonomic base geometry for this number of wheels"
+#endif
+static const double pid_wheels_to_axes[MOTION_AXES][PID_WHEELS] = {
+    { -0.4553,  0.3333,  0.1220 },
+    { -0.1220, -0.3333,  0.4553 },
+    { -0.028,  -0.028,  -0.028  }
+};
+static const double pid_axes_to_wheels[PID_WHEELS][MOTION_AXES] = {
+    { -1.366, -0.366, -12.0115 },
+    {  1,     -1,     -12.0115 },
+    {  0.366,  1.366, -12.0115 }
+};
 
 static inline void
 safe_setpwm(void (*f)(void *, int32_t), void * param, int32_t value)
@@ -99,6 +120,89 @@ int32_t PID_Process(PID_struct_t *PID, int32_t error){
     return command;
  }
 
+int32_t PID_Process_Feed_Forward(PID_FF_struct_t *FF, int32_t v_ref){
+    int32_t command;
+    int32_t a_ref;
+
+    a_ref = v_ref - FF->last_ref;
+    FF->last_ref = v_ref;
+
+    command = v_ref*FF->KV/100 + a_ref*FF->KA/100;
+
+    // Coulomb friction compensation
+    if(v_ref > 0)
+    {
+        command += FF->KS;
+    }else if(v_ref < 0)
+    {
+        command -= FF->KS;
+    }
+
+    return command;
+}
+
+/*
+ * Move the profiled reference one period towards the reference: trapezoidal
+ * velocity profile, within the profile speed and acceleration limits, that
+ * stops on the reference. Returns the profile velocity of the period, the
+ * feed-forward velocity. Without a profile the reference steps, and there is
+ * no feed-forward.
+ */
+int32_t PID_Process_Profile(PID_process_t *pPID){
+    int32_t distance, speed;
+
+    if(!pPID->prof_speed_Limit)
+    {
+        pPID->prof_position = pPID->ref;
+        pPID->prof_speed = 0;
+        return 0;
+    }
+
+    distance = pPID->ref - pPID->prof_position;
+
+    // Fastest speed that still stops on the reference: braking from v by
+    // A_limit per period covers v*(v+A_limit)/(2*A_limit)
+    if(pPID->prof_acceleration_Limit)
+    {
+        speed = (int32_t)((sqrt((double)pPID->prof_acceleration_Limit * pPID->prof_acceleration_Limit
+                                + 8.0 * pPID->prof_acceleration_Limit * abs(distance))
+                           - pPID->prof_acceleration_Limit) / 2);
+    }else
+    {
+        speed = abs(distance);
+    }
+    if(speed > pPID->prof_speed_Limit)
+    {
+        speed = pPID->prof_speed_Limit;
+    }
+    if(distance < 0)
+    {
+        speed = -speed;
+    }
+
+    // Acceleration saturation
+    if(pPID->prof_acceleration_Limit)
+    {
+        if((speed - pPID->prof_speed) > pPID->prof_acceleration_Limit)
+        {
+            speed = pPID->prof_speed + pPID->prof_acceleration_Limit;
+        }else if((pPID->prof_speed - speed) > pPID->prof_acceleration_Limit)
+        {
+            speed = pPID->prof_speed - pPID->prof_acceleration_Limit;
+        }
+    }
+
+    // Land on the reference
+    if((distance > 0 && speed > distance) || (distance < 0 && speed < distance))
+    {
+        speed = distance;
+    }
+
+    pPID->prof_position += speed;
+    pPID->prof_speed = speed;
+    return speed;
+}
+
 void PID_Process_Speed(PID_process_t *sPID, uint32_t position){
     int32_t command=0;
 
@@ -186,55 +290,181 @@ void PID_Process_Position(PID_process_t *pPID, PID_process_t *sPID, int32_t posi
     }
 }
 
-void PID_Process_holonomic(PID_process_t *pPIDx,PID_process_t *pPIDy,PID_process_t *pPIDteta)
+// Current position of the axes, from the wheel positions
+static void pid_holonomic_position(PID_process_t *pPID[MOTION_AXES], const int32_t wheel_position[PID_WHEELS])
 {
-    int32_t ref_speedx=0,ref_speedy=0,ref_speedteta=0;
-    int32_t motor1_pos,motor2_pos,motor3_pos;
-    int32_t motor1_speed,motor2_speed,motor3_speed;
-    int32_t posx=0, posy=0, posteta=0;
-    char str[60];
+    double pos;
+    uint8_t axis, wheel;
 
-    motor1_pos = safe_getencoder(pPIDx->get_encoder,pPIDx->encoder_Channel);
-    motor2_pos = safe_getencoder(pPIDy->get_encoder,pPIDy->encoder_Channel);
-    motor3_pos = safe_getencoder(pPIDteta->get_encoder,pPIDteta->encoder_Channel);
+    for(axis = 0; axis < MOTION_AXES; axis++)
+    {
+        pos = 0;
+        for(wheel = 0; wheel < PID_WHEELS; wheel++)
+        {
+            pos += wheel_position[wheel] * pid_wheels_to_axes[axis][wheel];
+        }
+        pPID[axis]->curr = (int32_t)pos;
+    }
+}
 
-    // Compute current position
-    posx = (int32_t)(motor1_pos*-0.4553 + motor2_pos*0.3333 + motor3_pos*0.1220);
-    posy = (int32_t)(motor1_pos*-0.1220 + motor2_pos*-0.3333 + motor3_pos*0.4553);
-    posteta = (int32_t)(motor1_pos*-0.028 + motor2_pos*-0.028 + motor3_pos*-0.028);
+void PID_Process_holonomic(PID_holonomic_t *base,
+                           PID_process_t *pPIDx,PID_process_t *pPIDy,PID_process_t *pPIDteta,
+                           const int32_t wheel_position[PID_WHEELS], int32_t wheel_command[PID_WHEELS])
+{
+    PID_process_t *pPID[MOTION_AXES] = { pPIDx, pPIDy, pPIDteta };
+    int32_t ref_speed[MOTION_AXES], ff_speed[MOTION_AXES];
+    int32_t ff_rotation_accel;
+    int32_t motor_rotation[PID_WHEELS];
+    double speed, ff, ff_rotation;
+    uint8_t axis, wheel;
+
+    pid_holonomic_position(pPID, wheel_position);
+
+    // Compute position errors on the profiled references, the profile
+    // velocities being the feed-forward
+    ff_rotation_accel = -pPIDteta->prof_speed;
+    for(axis = 0; axis < MOTION_AXES; axis++)
+    {
+        ff_speed[axis] = PID_Process_Profile(pPID[axis]);
+        ref_speed[axis] = PID_Process(pPID[axis]->PID, pPID[axis]->prof_position - pPID[axis]->curr);
+        ref_speed[axis] = PID_Manage_limitation(pPID[axis], ref_speed[axis]);
+    }
+    ff_rotation_accel += pPIDteta->prof_speed;
 
-	sprintf(str,"Posx=%i \t Posy=%i \t Posteta=%i \n\r",posx, posy, posteta);
-	serial_puts(str);
+    // Project on each wheel, teta being the last axis
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+    {
+        speed = 0;
+        ff = 0;
+        for(axis = 0; axis < MOTION_AXES - 1; axis++)
+        {
+            speed += ref_speed[axis] * pid_axes_to_wheels[wheel][axis];
+            ff += ff_speed[axis] * pid_axes_to_wheels[wheel][axis];
+        }
+        ff_rotation = ff_speed[axis] * pid_axes_to_wheels[wheel][axis];
+        ff += ff_rotation;
+        motor_rotation[wheel] = (int32_t)(ref_speed[axis] * pid_axes_to_wheels[wheel][axis]);
+        wheel_command[wheel] = (int32_t)speed + motor_rotation[wheel];
+        // The velocity loop only needs the profile velocity. The rotation
+        // part of the feed-forward is rotation for the desaturation too,
+        // the friction compensation staying with the translation
+        if(base->wheel_output == PID_WHEEL_OUTPUT_VELOCITY)
+        {
+            wheel_command[wheel] += (int32_t)ff;
+            motor_rotation[wheel] += (int32_t)ff_rotation;
+        }else
+        {
+            wheel_command[wheel] += PID_Process_Feed_Forward(&base->wheel_ff[wheel], (int32_t)ff);
+            motor_rotation[wheel] += (int32_t)((ff_rotation * base->wheel_ff[wheel].KV
+                                    + ff_rotation_accel * pid_axes_to_wheels[wheel][axis] * base->wheel_ff[wheel].KA) / 100);
+        }
+    }
 
-    // Compute position errors
-    ref_speedx = PID_Process(pPIDx->PID, pPIDx->ref - posx);
-    ref_speedx = PID_Manage_limitation(pPIDx, ref_speedx);
-    ref_speedy = PID_Process(pPIDy->PID, pPIDy->ref - posy);
-    ref_speedy = PID_Manage_limitation(pPIDy, ref_speedy);
-    ref_speedteta = PID_Process(pPIDteta->PID, pPIDteta->ref - posteta);
-    ref_speedteta = PID_Manage_limitation(pPIDteta, ref_speedteta);
-
-    motor1_speed = (int32_t)(ref_speedx*-1.366 + ref_speedy*-0.366 + ref_speedteta*-12.0115);
-    motor2_speed = (int32_t)(ref_speedx*1 + ref_speedy*-1 + ref_speedteta*-12.0115);
-    motor3_speed = (int32_t)(ref_speedx*0.366 + ref_speedy*1.366 + ref_speedteta*-12.0115);
-
-    if(motor1_speed >= 1000)
-    	motor1_speed = 1000;
-    if(motor1_speed <= -1000)
-    	motor1_speed = -1000;
-    if(motor2_speed >= 1000)
-    	motor2_speed = 1000;
-    if(motor2_speed <= -1000)
-    	motor2_speed = -1000;
-    if(motor3_speed >= 1000)
-    	motor3_speed = 1000;
-    if(motor3_speed <= -1000)
-    	motor3_speed = -1000;
+    // Keep the commanded motion direction when a wheel saturates
+    PID_Desaturate(base, wheel_command, motor_rotation);
+}
 
-    // Send new motor reference
-    safe_setpwm(pPIDx->set_pwm, pPIDx->pwm_channel,(int16_t)motor1_speed);
-    safe_setpwm(pPIDy->set_pwm, pPIDy->pwm_channel,(int16_t)motor2_speed);
-    safe_setpwm(pPIDteta->set_pwm, pPIDteta->pwm_channel,(int16_t)motor3_speed);
+void PID_Set_Desaturation(PID_holonomic_t *base, int32_t limit, PID_desat_priority_t priority){
+    base->desat_limit = limit;
+    base->desat_priority = priority;
+}
+
+/*
+ * Bring the wheel commands back within the desaturation limit.
+ * motor[] holds the full commands, rotation[] their rotation part (the
+ * remainder being translation). Depending on the priority, either all the
+ * commands are scaled by the same factor, or the prioritized part is kept
+ * (scaled down only if it saturates by itself) and the other part is scaled
+ * by the largest factor that fits.
+ */
+void PID_Desaturate(const PID_holonomic_t *base, int32_t motor[PID_WHEELS], const int32_t rotation[PID_WHEELS]){
+    int32_t primary[PID_WHEELS], secondary[PID_WHEELS];
+    int32_t desat_limit = base->desat_limit;
+    PID_desat_priority_t desat_priority = base->desat_priority;
+    int32_t max = 0;
+    float scale = 1.0f;
+    uint8_t n;
+
+    if(!desat_limit)
+    {
+        return;
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        if(abs(motor[n]) > max)
+        {
+            max = abs(motor[n]);
+        }
+    }
+
+    if(max <= desat_limit)
+    {
+        return;
+    }
+
+    if(desat_priority == PID_DESAT_SCALE)
+    {
+        for(n = 0; n < PID_WHEELS; n++)
+        {
+            motor[n] = (int32_t)((int64_t)motor[n] * desat_limit / max);
+        }
+        return;
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        if(desat_priority == PID_DESAT_ROTATION)
+        {
+            primary[n] = rotation[n];
+        }else
+        {
+            primary[n] = motor[n] - rotation[n];
+        }
+        secondary[n] = motor[n] - primary[n];
+    }
+
+    // The prioritized part saturates by itself: scale it, drop the other
+    max = 0;
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        if(abs(primary[n]) > max)
+        {
+            max = abs(primary[n]);
+        }
+    }
+
+    if(max > desat_limit)
+    {
+        for(n = 0; n < PID_WHEELS; n++)
+        {
+            motor[n] = (int32_t)((int64_t)primary[n] * desat_limit / max);
+        }
+        return;
+    }
+
+    // Largest common factor keeping |primary + scale*secondary| <= limit
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        if(secondary[n] > 0)
+        {
+            if((desat_limit - primary[n]) < scale * secondary[n])
+            {
+                scale = (float)(desat_limit - primary[n]) / secondary[n];
+            }
+        }else if(secondary[n] < 0)
+        {
+            if((-desat_limit - primary[n]) > scale * secondary[n])
+            {
+                scale = (float)(-desat_limit - primary[n]) / secondary[n];
+            }
+        }
+    }
+
+    for(n = 0; n < PID_WHEELS; n++)
+    {
+        motor[n] = primary[n] + (int32_t)(secondary[n] * scale);
+    }
 }
 
 void PID_Set_Coefficient(PID_struct_t *PID,int8_t KP,int8_t KI,int8_t KD,uint32_t I_limit){
@@ -245,6 +475,54 @@ void PID_Set_Coefficient(PID_struct_t *PID,int8_t KP,int8_t KI,int8_t KD,uint32_
     PID->I_limit = I_limit;
 }
 
+void PID_Set_Wheel_Feed_Forward(PID_holonomic_t *base, uint8_t wheel, int16_t KV, int16_t KA, int16_t KS){
+    if(wheel >= PID_WHEELS)
+    {
+        return;
+    }
+    base->wheel_ff[wheel].KV = KV;
+    base->wheel_ff[wheel].KA = KA;
+    base->wheel_ff[wheel].KS = KS;
+    base->wheel_ff[wheel].last_ref = 0;
+}
+
+/*
+ * Hold the current pose: references and profiles on the position of the
+ * wheels, PID and feed-forward states cleared. After the wheels were driven
+ * outside of the position control (motion_ident_cycle()).
+ */
+void PID_Hold_holonomic(PID_holonomic_t *base,
+                        PID_process_t *pPIDx,PID_process_t *pPIDy,PID_process_t *pPIDteta,
+                        const int32_t wheel_position[PID_WHEELS])
+{
+    PID_process_t *pPID[MOTION_AXES] = { pPIDx, pPIDy, pPIDteta };
+    uint8_t axis, wheel;
+
+    pid_holonomic_position(pPID, wheel_position);
+    for(axis = 0; axis < MOTION_AXES; axis++)
+    {
+        pPID[axis]->ref = pPID[axis]->curr;
+        pPID[axis]->prof_position = pPID[axis]->curr;
+        pPID[axis]->prof_speed = 0;
+        pPID[axis]->last_ref = 0;
+        pPID[axis]->PID->err = 0;
+        pPID[axis]->PID->err_I = 0;
+        pPID[axis]->PID->last_err = 0;
+    }
+    for(wheel = 0; wheel < PID_WHEELS; wheel++)
+    {
+        base->wheel_ff[wheel].last_ref = 0;
+    }
+}
+
+/*
+ * Wheel commands of PID_Process_holonomic(): PWM, or wheel velocities in
+ * encoder counts per period when the FPGA runs the velocity loops.
+ */
+void PID_Set_Wheel_Output(PID_holonomic_t *base, PID_wheel_output_t output){
+    base->wheel_output = output;
+}
+
 void PID_Reset(PID_process_t *xPID){
     xPID->PID->I_limit = 0;
     xPID->PID->err = 0;
@@ -252,11 +530,14 @@ void PID_Reset(PID_process_t *xPID){
     xPID->PID->last_err = 0;
     xPID->last = 0;
     xPID->last_ref = 0;
+    xPID->prof_position = 0;
+    xPID->prof_speed = 0;
 
     // Reset PID gains
     PID_Set_Coefficient(xPID->PID,0,0,0,0);
 	
     PID_Set_limitation(xPID,0,0);
+    PID_Set_Profile(xPID,0,0);
 }
 
 void PID_Set_limitation(PID_process_t *xPID,int32_t S_limit, int32_t A_limit){
@@ -266,6 +547,12 @@ void PID_Set_limitation(PID_process_t *xPID,int32_t S_limit, int32_t A_limit){
     xPID->last_ref = 0;
 }
 
+void PID_Set_Profile(PID_process_t *pPID, int32_t S_limit, int32_t A_limit){
+    // Reference profile limits, per period, see PID_Process_Profile()
+    pPID->prof_speed_Limit = S_limit;
+    pPID->prof_acceleration_Limit = A_limit;
+}
+
 int32_t PID_Manage_limitation(PID_process_t *xPID, int32_t param){
 	int32_t value;
 	value = param;
@@ -301,9 +588,17 @@ int32_t PID_Manage_limitation(PID_process_t *xPID, int32_t param){
 }
 
 PID_process_t* pid_init(void){
+    static PID_process_t process[PID_PROCESS_MAX];
+    static PID_struct_t pid[PID_PROCESS_MAX];
+    static uint8_t used = 0;
     PID_process_t *xPID;
-    xPID =(PID_process_t *) malloc(sizeof(PID_process_t));
-    xPID->PID=(PID_struct_t *) malloc(sizeof(PID_struct_t));
+
+    if(used == PID_PROCESS_MAX)
+        return NULL;
+
+    xPID = &process[used];
+    xPID->PID = &pid[used];
+    used++;
     PID_Reset(xPID);
     return xPID;
 }
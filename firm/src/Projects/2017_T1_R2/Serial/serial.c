@@ -21,6 +21,12 @@ static USART_InitTypeDef Serial_Config;
 static QueueHandle_t Serial_RxQueue;
 static QueueHandle_t Serial_TxQueue;
 
+/* Static kernel objects */
+static StaticQueue_t Serial_RxQueueBuffer OS_DTCM;
+static StaticQueue_t Serial_TxQueueBuffer OS_DTCM;
+static uint8_t Serial_RxQueueStorage[SERIAL_RX_QUEUE_LEN * sizeof(char)] OS_DTCM;
+static uint8_t Serial_TxQueueStorage[SERIAL_TX_QUEUE_LEN * sizeof(char)] OS_DTCM;
+
 BaseType_t serial_init(void)
 {
     /*
@@ -38,8 +44,10 @@ BaseType_t serial_init(void)
     hb_dbg_init(&Serial_Config);
 
     /* Create Serial Queues */
-    Serial_RxQueue = xQueueCreate(SERIAL_RX_QUEUE_LEN, sizeof(char));
-    Serial_TxQueue = xQueueCreate(SERIAL_TX_QUEUE_LEN, sizeof(char));
+    Serial_RxQueue = xQueueCreateStatic(SERIAL_RX_QUEUE_LEN, sizeof(char), Serial_RxQueueStorage, &Serial_RxQueueBuffer);
+    Serial_TxQueue = xQueueCreateStatic(SERIAL_TX_QUEUE_LEN, sizeof(char), Serial_TxQueueStorage, &Serial_TxQueueBuffer);
+    vQueueSetQueueNumber(Serial_RxQueue, TRACE_QUEUE_SERIAL_RX);
+    vQueueSetQueueNumber(Serial_TxQueue, TRACE_QUEUE_SERIAL_TX);
 
     /* Enable hardware */
     hb_dbg_enable(OS_ISR_PRIORITY_SER);
@@ -126,6 +134,8 @@ void SERIAL_ISR (void)
     // We have not woken a task at the start of the ISR.
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+    TRACE_ISR_ENTER();
+
     // Hand RX Interrupt
     if(USART_GetITStatus(SERIAL_COM, USART_IT_RXNE) != RESET)
     {
@@ -158,5 +168,7 @@ void SERIAL_ISR (void)
         }
 
     }
+
+    TRACE_ISR_EXIT();
 }
 
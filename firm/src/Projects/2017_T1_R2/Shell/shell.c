@@ -0,0 +1,465 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       shell.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Command shell on the debug serial port (FreeRTOS+CLI)
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include "main.h"
+#include "recorder.h"
+
+/* Longest command line, terminator included */
+#define SHELL_INPUT_LEN     64
+
+/* Static kernel objects */
+static StaticTask_t OS_ShellTCB OS_DTCM;
+static StackType_t OS_ShellStack[OS_TASK_STACK_SHELL] OS_DTCM;
+
+/* Local, Private functions */
+static void OS_ShellTask(void *pvParameters);
+static BaseType_t shell_cmd_spi(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t shell_cmd_qei(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t shell_cmd_fault(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t shell_cmd_wdg(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t shell_cmd_trace(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t shell_cmd_idle(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t shell_cmd_motion(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+#if !HB_LCMXO2_VEL_LOOP
+static BaseType_t shell_cmd_ident(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+#endif
+#if REPLAY_CAPTURE
+static BaseType_t shell_cmd_replay(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+#endif
+#if RECORDER
+static BaseType_t shell_cmd_recorder(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+#endif
+#if BENCH_TARGET
+static BaseType_t shell_cmd_bench(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+#endif
+
+/* Commands */
+static const CLI_Command_Definition_t shell_cmd_spi_def = {
+    "spi",
+    "\n\rspi [clear]:\n\r  LCMXO2 SPI link statistics, 'clear' resets them\n\r",
+    shell_cmd_spi,
+    -1
+};
+
+static const CLI_Command_Definition_t shell_cmd_qei_def = {
+    "qei",
+    "\n\rqei [clear]:\n\r  Encoders illegal transitions counted by the LCMXO2, 'clear' resets them\n\r",
+    shell_cmd_qei,
+    -1
+};
+
+static const CLI_Command_Definition_t shell_cmd_fault_def = {
+    "fault",
+    "\n\rfault [clear]:\n\r  Motor faults latched, 'clear' restarts the bridges\n\r",
+    shell_cmd_fault,
+    -1
+};
+
+static const CLI_Command_Definition_t shell_cmd_wdg_def = {
+    "wdg",
+    "\n\rwdg:\n\r  Watchdog post-mortem: tasks alive before the last watchdog reset\n\r",
+    shell_cmd_wdg,
+    0
+};
+
+static const CLI_Command_Definition_t shell_cmd_trace_def = {
+    "trace",
+    "\n\rtrace [start|stop|dump]:\n\r  Scheduling trace recorder, 'dump' prints it for trace2json\n\r",
+    shell_cmd_trace,
+    -1
+};
+
+static const CLI_Command_Definition_t shell_cmd_idle_def = {
+    "idle",
+    "\n\ridle [clear]:\n\r  Tickless idle sleeps and wake-up latency, 'clear' resets them\n\r",
+    shell_cmd_idle,
+    -1
+};
+
+static const CLI_Command_Definition_t shell_cmd_motion_def = {
+    "motion",
+    "\n\rmotion:\n\r  Pose, speed and bridges state of the last control cycle\n\r",
+    shell_cmd_motion,
+    0
+};
+
+#if !HB_LCMXO2_VEL_LOOP
+static const CLI_Command_Definition_t shell_cmd_ident_def = {
+    "ident",
+    "\n\rident [start]:\n\r  Wheels feed-forward identification, robot lifted, 'start' drives the wheels for about 3 s\n\r",
+    shell_cmd_ident,
+    -1
+};
+#endif
+
+#if REPLAY_CAPTURE
+static const CLI_Command_Definition_t shell_cmd_replay_def = {
+    "replay",
+    "\n\rreplay [stop|dump]:\n\r  Control cycles capture, 'dump' prints it for replay_host\n\r",
+    shell_cmd_replay,
+    -1
+};
+#endif
+
+#if RECORDER
+static const CLI_Command_Definition_t shell_cmd_recorder_def = {
+    "recorder",
+    "\n\rrecorder [arm [<pre> <post>]|trigger|threshold <error>|dump]:\n\r  Flight recorder of the control cycles, 'dump' prints the frozen window\n\r",
+    shell_cmd_recorder,
+    -1
+};
+#endif
+
+#if BENCH_TARGET
+static const CLI_Command_Definition_t shell_cmd_bench_def = {
+    "bench",
+    "\n\rbench:\n\r  Control-path benchmarks, cycles for bench_host --target_dump\n\r",
+    shell_cmd_bench,
+    0
+};
+#endif
+
+/* Commands list items, one per command */
+static CLI_Definition_List_Item_t shell_cmd_spi_item;
+static CLI_Definition_List_Item_t shell_cmd_qei_item;
+static CLI_Definition_List_Item_t shell_cmd_fault_item;
+static CLI_Definition_List_Item_t shell_cmd_wdg_item;
+static CLI_Definition_List_Item_t shell_cmd_trace_item;
+static CLI_Definition_List_Item_t shell_cmd_idle_item;
+static CLI_Definition_List_Item_t shell_cmd_motion_item;
+#if !HB_LCMXO2_VEL_LOOP
+static CLI_Definition_List_Item_t shell_cmd_ident_item;
+#endif
+#if REPLAY_CAPTURE
+static CLI_Definition_List_Item_t shell_cmd_replay_item;
+#endif
+#if RECORDER
+static CLI_Definition_List_Item_t shell_cmd_recorder_item;
+#endif
+#if BENCH_TARGET
+static CLI_Definition_List_Item_t shell_cmd_bench_item;
+#endif
+
+BaseType_t shell_start(void)
+{
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_spi_def, &shell_cmd_spi_item);
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_qei_def, &shell_cmd_qei_item);
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_fault_def, &shell_cmd_fault_item);
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_wdg_def, &shell_cmd_wdg_item);
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_trace_def, &shell_cmd_trace_item);
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_idle_def, &shell_cmd_idle_item);
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_motion_def, &shell_cmd_motion_item);
+#if !HB_LCMXO2_VEL_LOOP
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_ident_def, &shell_cmd_ident_item);
+#endif
+#if REPLAY_CAPTURE
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_replay_def, &shell_cmd_replay_item);
+#endif
+#if RECORDER
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_recorder_def, &shell_cmd_recorder_item);
+#endif
+#if BENCH_TARGET
+    FreeRTOS_CLIRegisterCommandStatic(&shell_cmd_bench_def, &shell_cmd_bench_item);
+#endif
+
+    if(xTaskCreateStatic(OS_ShellTask, "SHELL", OS_TASK_STACK_SHELL, NULL, OS_TASK_PRIORITY_SHELL, OS_ShellStack, &OS_ShellTCB) == NULL)
+        return pdFAIL;
+
+    return pdPASS;
+}
+
+static void OS_ShellTask(void *pvParameters)
+{
+    static char input[SHELL_INPUT_LEN];
+    char *output = FreeRTOS_CLIGetOutputBuffer();
+    uint8_t length = 0;
+    BaseType_t more;
+    char ch;
+
+    /* Remove compiler warning about unused parameter. */
+    ( void ) pvParameters;
+
+    serial_puts(WELCOME_MESSAGE);
+
+    for( ;; )
+    {
+        /* serial_get() times out every SERIAL_RX_TIMEOUT */
+        supervisor_alive(SUPERVISOR_ALIVE_SHELL);
+
+        if(serial_get(&ch) != pdPASS)
+            continue;
+
+        if(ch == '\r')
+        {
+            serial_puts("\n\r");
+            if(length)
+            {
+                input[length] = '\0';
+                /* Long outputs (trace dump) take seconds to print */
+                do {
+                    more = FreeRTOS_CLIProcessCommand(input, output, configCOMMAND_INT_MAX_OUTPUT_SIZE);
+                    serial_puts(output);
+                    supervisor_alive(SUPERVISOR_ALIVE_SHELL);
+                } while(more != pdFALSE);
+                length = 0;
+            }
+            serial_puts("> ");
+        }
+        else if(ch == '\b' || ch == 0x7F)
+        {
+            if(length)
+            {
+                length--;
+                serial_puts("\b \b");
+            }
+        }
+        else if(ch >= ' ' && length < SHELL_INPUT_LEN - 1)
+        {
+            input[length++] = ch;
+            serial_put(ch);
+        }
+    }
+}
+
+/* -----------------------------------------------------------------------------
+ * Commands
+ * -----------------------------------------------------------------------------
+ */
+
+static BaseType_t shell_cmd_spi(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    HB_LCMXO2_SpiStatsTypeDef stats;
+    uint16_t fpga_errors = 0;
+    const uint16_t zero = 0;
+    const char *param;
+    BaseType_t param_len;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    /* The motion task also talks to the LCMXO2 but has a higher priority:
+     * it is never in the middle of a burst while the shell runs, it only
+     * has to be kept from preempting the shell bursts. */
+    vTaskSuspendAll();
+    if(param != NULL && param_len == 5 && strncmp(param, "clear", 5) == 0)
+    {
+        hb_lcmxo2_clear_spi_stats();
+        hb_lcmxo2_write(HB_LCMXO2_REG_CRC_ERR, &zero, 1);
+    }
+    hb_lcmxo2_read(HB_LCMXO2_REG_CRC_ERR, &fpga_errors, 1, NULL);
+    hb_lcmxo2_get_spi_stats(&stats);
+    xTaskResumeAll();
+
+    snprintf(pcWriteBuffer, xWriteBufferLen,
+             "bursts      : %lu\n\r"
+             "crc errors  : %lu (retried)\n\r"
+             "failures    : %lu (dropped)\n\r"
+             "fpga errors : %u (rejected writes)\n\r",
+             (unsigned long)stats.bursts, (unsigned long)stats.crc_errors,
+             (unsigned long)stats.failures, fpga_errors);
+
+    return pdFALSE;
+}
+
+static BaseType_t shell_cmd_qei(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    uint16_t qei_errors[HB_LCMXO2_NB_CHANNELS];
+    const uint16_t zeros[HB_LCMXO2_NB_CHANNELS] = { 0 };
+    const char *param;
+    BaseType_t param_len;
+    size_t len = 0;
+    uint8_t ch;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    /* SPI access, see shell_cmd_spi() */
+    vTaskSuspendAll();
+    if(param != NULL && param_len == 5 && strncmp(param, "clear", 5) == 0)
+        hb_lcmxo2_write(HB_LCMXO2_REG_QEI_ERR(0), zeros, HB_LCMXO2_NB_CHANNELS);
+    memset(qei_errors, 0, sizeof(qei_errors));
+    hb_lcmxo2_read(HB_LCMXO2_REG_QEI_ERR(0), qei_errors, HB_LCMXO2_NB_CHANNELS, NULL);
+    xTaskResumeAll();
+
+    for(ch = 0; ch < HB_LCMXO2_NB_CHANNELS && len < xWriteBufferLen; ch++)
+        len += snprintf(pcWriteBuffer + len, xWriteBufferLen - len, "encoder %u : %u illegal transition(s)\n\r",
+                        ch, qei_errors[ch]);
+
+    return pdFALSE;
+}
+
+static BaseType_t shell_cmd_fault(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    const char *param;
+    BaseType_t param_len;
+    size_t len = 0;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    if(param != NULL && param_len == 5 && strncmp(param, "clear", 5) == 0)
+    {
+        /* SPI access, see shell_cmd_spi() */
+        vTaskSuspendAll();
+        if(motion_fault_clear() != pdPASS)
+            len = snprintf(pcWriteBuffer, xWriteBufferLen, "fault still asserted, not cleared\n\r");
+        xTaskResumeAll();
+    }
+
+    if(len < xWriteBufferLen)
+        motion_fault_print(pcWriteBuffer + len, xWriteBufferLen - len);
+
+    return pdFALSE;
+}
+
+static BaseType_t shell_cmd_wdg(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    ( void ) pcCommandString;
+
+    supervisor_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+static BaseType_t shell_cmd_trace(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    const char *param;
+    BaseType_t param_len;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    if(param != NULL && param_len == 4 && strncmp(param, "dump", 4) == 0)
+        return trace_dump(pcWriteBuffer, xWriteBufferLen);
+
+    if(param != NULL && param_len == 5 && strncmp(param, "start", 5) == 0)
+        trace_start();
+    else if(param != NULL && param_len == 4 && strncmp(param, "stop", 4) == 0)
+        trace_stop();
+
+    trace_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+static BaseType_t shell_cmd_idle(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    const char *param;
+    BaseType_t param_len;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    if(param != NULL && param_len == 5 && strncmp(param, "clear", 5) == 0)
+        tickless_clear();
+
+    tickless_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+/* Lock-free copy, never delays the control task */
+static BaseType_t shell_cmd_motion(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    ( void ) pcCommandString;
+
+    motion_cs_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+#if !HB_LCMXO2_VEL_LOOP
+static BaseType_t shell_cmd_ident(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    const char *param;
+    BaseType_t param_len;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    if(param != NULL && param_len == 5 && strncmp(param, "start", 5) == 0 && motion_identify() != pdPASS)
+    {
+        snprintf(pcWriteBuffer, xWriteBufferLen, "Identification already running, or bridges stopped\n\r");
+        return pdFALSE;
+    }
+
+    motion_identify_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+#endif
+
+#if REPLAY_CAPTURE
+static BaseType_t shell_cmd_replay(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    const char *param;
+    BaseType_t param_len;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    if(param != NULL && param_len == 4 && strncmp(param, "dump", 4) == 0)
+        return replay_dump(pcWriteBuffer, xWriteBufferLen);
+
+    if(param != NULL && param_len == 4 && strncmp(param, "stop", 4) == 0)
+        replay_stop();
+
+    replay_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+#endif
+
+#if RECORDER
+static BaseType_t shell_cmd_recorder(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    const char *param, *pre, *post;
+    BaseType_t param_len, len;
+
+    param = FreeRTOS_CLIGetParameter(pcCommandString, 1, &param_len);
+
+    if(param != NULL && param_len == 4 && strncmp(param, "dump", 4) == 0)
+        return recorder_dump(pcWriteBuffer, xWriteBufferLen);
+
+    if(param != NULL && param_len == 3 && strncmp(param, "arm", 3) == 0)
+    {
+        pre = FreeRTOS_CLIGetParameter(pcCommandString, 2, &len);
+        post = FreeRTOS_CLIGetParameter(pcCommandString, 3, &len);
+        if(pre == NULL || post == NULL)
+            recorder_arm(RECORDER_PRE, RECORDER_POST);
+        else if(recorder_arm(strtoul(pre, NULL, 0), strtoul(post, NULL, 0)) != pdPASS)
+        {
+            snprintf(pcWriteBuffer, xWriteBufferLen, "The window does not fit in the ring\n\r");
+            return pdFALSE;
+        }
+    }
+    else if(param != NULL && param_len == 7 && strncmp(param, "trigger", 7) == 0)
+        recorder_trigger(RECORDER_TRIGGER_SHELL);
+    else if(param != NULL && param_len == 9 && strncmp(param, "threshold", 9) == 0)
+    {
+        param = FreeRTOS_CLIGetParameter(pcCommandString, 2, &param_len);
+        if(param != NULL)
+            recorder_set_threshold(strtoul(param, NULL, 0));
+    }
+
+    recorder_print(pcWriteBuffer, xWriteBufferLen);
+
+    return pdFALSE;
+}
+#endif
+
+#if BENCH_TARGET
+/* One kernel per call, the shell checks in with the supervisor between them */
+static BaseType_t shell_cmd_bench(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    ( void ) pcCommandString;
+
+    return bench_dump(pcWriteBuffer, xWriteBufferLen);
+}
+#endif
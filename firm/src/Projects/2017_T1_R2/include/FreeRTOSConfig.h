@@ -96,7 +96,7 @@
 #define configTICK_RATE_HZ						( 1000 )
 #define configMAX_PRIORITIES					( 6 )
 #define configMINIMAL_STACK_SIZE				( ( unsigned short ) 130 )
-#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 15360 ) )
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 0 ) ) // no heap, all the kernel objects are static
 #define configMAX_TASK_NAME_LEN					( 16 )
 #define configUSE_TRACE_FACILITY				1
 #define configUSE_16_BIT_TICKS					0
@@ -105,16 +105,25 @@
 #define configQUEUE_REGISTRY_SIZE				8
 #define configCHECK_FOR_STACK_OVERFLOW			2
 #define configUSE_RECURSIVE_MUTEXES				1
-#define configUSE_MALLOC_FAILED_HOOK			1
+#define configUSE_MALLOC_FAILED_HOOK			0
 #define configUSE_APPLICATION_TASK_TAG			0
 #define configUSE_COUNTING_SEMAPHORES			1
-#define configUSE_TICKLESS_IDLE					0
+#define configUSE_TICKLESS_IDLE					2 // tickless_sleep(), not the SysTick one of port.c
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP	2
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) tickless_sleep( xExpectedIdleTime )
+
+/* Memory allocation: static only, heap_4.c is excluded from the build */
+#define configSUPPORT_STATIC_ALLOCATION			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		0
 
 /* Run-time stats */
 #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() hb_sys_timer_run_time_config()
 #define portGET_RUN_TIME_COUNTER_VALUE()         hb_sys_timer_get_run_time_ticks()
 #define configGENERATE_RUN_TIME_STATS	        1
-#define configUSE_STATS_FORMATTING_FUNCTIONS	1
+#define configUSE_STATS_FORMATTING_FUNCTIONS	0 // vTaskList() allocates, see sys_get_run_time_stats()
+
+/* Scheduling trace recorder, see trace.h. Set to 0 to compile the hooks out */
+#define TRACE_RECORDER							1
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 			        0
@@ -186,8 +195,14 @@ files. */
 	/* Library includes. */
 	#include "stm32f7xx_hal_conf.h"
 
+	/* FreeRTOS trace hooks */
+	#include "trace.h"
+
 	extern uint32_t SystemCoreClock;
 
+	/* Tickless idle, see tickless.c */
+	extern void tickless_sleep( uint32_t xExpectedIdleTime );
+
 	/* Normal assert() semantics without relying on the provision of an assert.h
 	header file. */
 	extern void vAssertCalled( uint32_t ulLine, const char *pcFile );
@@ -0,0 +1,56 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       bench.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Microbenchmarks of the control-path kernels (PID, holonomic matrices,
+ *   encoder positions), shared by two runners:
+ *    - firm/host/bench_host.c, Linux build in the Google Benchmark style,
+ *    - bench.c, on the target with BENCH_TARGET, timed with the DWT cycle
+ *      counter and dumped on the debug port by the 'bench' command.
+ *   Every kernel first runs BENCH_CHECK_ITERATIONS times from its setup and
+ *   the checksum of its outputs must match its reference: a change of the
+ *   results is a change of the reference, made in the same commit.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+
+/* Calls of the checksum run */
+#define BENCH_CHECK_ITERATIONS      1000
+
+/* Checksum of the outputs, FNV-1a over 32 bits words */
+#define BENCH_CHECKSUM_INIT         2166136261UL
+
+static inline uint32_t bench_fold(uint32_t checksum, int32_t value)
+{
+    return (checksum ^ (uint32_t)value) * 16777619UL;
+}
+
+/* A kernel: run() calls it 'iterations' times on inputs prepared by
+ * setup() and returns the checksum of the outputs. The kernel state
+ * (integrators, positions) goes on from a run to the next one. */
+typedef struct {
+    const char* name;                           /* Google Benchmark name, "kernel/arg" */
+    void (*setup)(void);
+    uint32_t (*run)(uint32_t iterations);
+    uint32_t reference;                         /* checksum of the first BENCH_CHECK_ITERATIONS */
+} bench_kernel_t;
+
+extern const bench_kernel_t bench_kernels[];
+extern const uint32_t bench_nb_kernels;
+
+/* Setup and checksum run, returns the checksum */
+uint32_t bench_check(const bench_kernel_t* kernel);
+
+#endif /* __BENCH_H */
@@ -0,0 +1,50 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       encoder.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Wheel positions from the 12 bits wrapping QEI counters of the LCMXO2.
+ *   Without any hardware access, so that the control task and the
+ *   benchmarks (bench.h) run the same code.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __ENCODER_H
+#define __ENCODER_H
+
+#include <stdint.h>
+
+/* Position of one wheel, to be zero-initialized */
+typedef struct {
+    int16_t old;            /* last counter, shifted to the 16 bits MSBs */
+    int32_t value;          /* position, ticks */
+} encoder_t;
+
+/**
+  * @brief  Extend a 12 bits counter to the wheel position. The counter
+  *         must not move by more than half a turn of it between two calls.
+  * @param  encoder: position of the wheel
+  * @param  counter: QEI counter read from the LCMXO2
+  * @retval Position of the wheel, ticks
+  */
+static inline int32_t encoder_update(encoder_t* encoder, int16_t counter)
+{
+    int16_t shifted;
+    int16_t delta;
+
+    /* The 16 bits difference wraps as the 12 bits counter does */
+    shifted = counter * 16;
+    delta = shifted - encoder->old;
+    encoder->old = shifted;
+    encoder->value += (int32_t)delta / 16;
+    return encoder->value;
+}
+
+#endif /* __ENCODER_H */
@@ -28,13 +28,10 @@
 ********************************************************************************
 */
 
-/* LED PWM Period and Brightness value (global), ticks unit*/
-#define LED_PWM_PERIOD_TICK      20
-#define LED_PWM_DUTY_TICK        1
-
-/* Slow blinking periods (ticks x PWM_PERIOD unit) */
-#define LED_BLINK_SLOW          100
-#define LED_BLINK_FAST           10
+/* Blinking half-periods (ms): the LED is on, then off for this duration.
+ * The brightness of the predefined colors is HB_LED_LEVEL (hb_config.h) */
+#define LED_BLINK_SLOW_MS       1000
+#define LED_BLINK_FAST_MS        100
 
 /**
 ********************************************************************************
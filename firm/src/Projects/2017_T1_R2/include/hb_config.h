@@ -37,6 +37,109 @@
 /* NVIC priority of the system runstats timer */
 #define HB_PRIORITY_SYS_RUNSTATS    (15) // configLIBRARY_LOWEST_INTERRUPT_PRIORITY
 
+/**
+ ********************************************************************************
+ **
+ ** System Tickless Idle
+ **
+ ********************************************************************************
+ */
+
+/* Prescaler of the wake-up low-power timer, clocked by APB1 at 48 MHz:
+ *   LPTIM_Prescaler_DIV16 -> 3 MHz, 3000 counts per tick, up to 21 ticks
+ *   LPTIM_Prescaler_DIV64 -> 750 kHz, 750 counts per tick, up to 87 ticks
+ */
+#define SYS_LPTIM_PRESCALER         LPTIM_Prescaler_DIV16
+
+/**
+ ********************************************************************************
+ **
+ ** RGB LED
+ **
+ ********************************************************************************
+ */
+
+/* PWM timer prescaler, APB1 Timers running at 96000 kHz:
+ *   249 -> 384 kHz counter, 1.5 kHz PWM with 255 steps
+ */
+#define HB_LED_PWM_PRESCALER        (249)
+
+/* Blinking timer prescaler, the frequency it gives */
+#define HB_LED_BLINK_PRESCALER      (9599)
+#define HB_LED_BLINK_HZ             (10000)
+
+/* Brightness of hb_led_set_color(), 0 to 255 */
+#define HB_LED_LEVEL                (13) // 5%
+
+/* NVIC priority of the blinking timer */
+#define HB_PRIORITY_LED_BLINK       (15) // configLIBRARY_LOWEST_INTERRUPT_PRIORITY
+
+/**
+ ********************************************************************************
+ **
+ ** LCMXO2 Motors PWM
+ **
+ ********************************************************************************
+ */
+
+/* PWM period, in FPGA clock cycles minus one (up to 32767).
+ * PWM frequency is 133 MHz / (period + 1), with period + 1 duty steps:
+ *   2047 -> 65 kHz, 11-bit
+ *   6649 -> 20 kHz, ~12.7-bit
+ */
+#define HB_LCMXO2_PWM_PERIOD        (2047)
+
+/* Bridge brake time on direction change, in FPGA clock cycles (up to 255) */
+#define HB_LCMXO2_PWM_DEADBAND      (0)
+
+/* Wheel velocity loop in the FPGA, 0 = PWM computed by the motion task.
+ * The motion task then only runs the pose control and writes the wheel
+ * velocities, the FPGA PI runs every wheel every HB_LCMXO2_VEL_PERIOD_US.
+ * Gains (see velocity_pi.vhd), to be tuned with the robot lifted:
+ *  - KP: duty steps per encoder count per loop period
+ *  - KI: same, added every loop period */
+#define HB_LCMXO2_VEL_LOOP          (0)
+#define HB_LCMXO2_VEL_PERIOD_US     (100)
+#define HB_LCMXO2_VEL_KP            (400)
+#define HB_LCMXO2_VEL_KI            (20)
+
+/* Duty slew limit, in duty steps per PWM period (up to 32767, 0 = none).
+ * The FPGA ramps between the motion task updates instead of stepping:
+ *   2 -> full scale in 1024 periods, 15.8 ms at 65 kHz, within the 20 ms
+ *        control period
+ * Not used with the velocity loop, it updates the duty every 100 us. */
+#if HB_LCMXO2_VEL_LOOP
+#define HB_LCMXO2_PWM_SLEW          (0)
+#else
+#define HB_LCMXO2_PWM_SLEW          (2)
+#endif
+
+/* Encoder inputs glitch filter, in FPGA clock cycles minus one (up to 255).
+ * Pulses shorter than filter + 1 cycles are ignored, which also bounds the
+ * edge rate: 2 -> 22 ns, up to 44 M edges/s. */
+#define HB_LCMXO2_QEI_FILTER        (2)
+
+/* Control cycles on the FPGA encoder samples (1 = enabled), when the FPGA
+ * has them (CAPS.SAMPLE). Needs the LCMXO2 IRQ_O output wired to PB2, a
+ * rework of the board (see hb_io_mapping.h), the motion task runs on the
+ * tick otherwise. It also goes back to the tick after HB_LCMXO2_SAMPLE_MISSED
+ * samples missed in a row. */
+#define HB_LCMXO2_SAMPLE_IRQ        (0)
+#define HB_LCMXO2_SAMPLE_MISSED     (3)
+
+/* SPI1 baudrate prescaler, SPI1 is on APB2 running at 48 MHz:
+ *   SPI_BaudRatePrescaler_2 -> 24 MHz
+ *   SPI_BaudRatePrescaler_4 -> 12 MHz
+ */
+#define HB_LCMXO2_SPI_PRESCALER     SPI_BaudRatePrescaler_4
+
+/* CRC-8 over each SPI burst, checked on both sides (1 = enabled).
+ * Costs 1 word per read burst and 3 words per write burst. */
+#define HB_LCMXO2_SPI_CRC           (1)
+
+/* Attempts of a burst failing the CRC check before it is dropped */
+#define HB_LCMXO2_SPI_RETRIES       (3)
+
 
 
 #endif /* __HB_CONFIG_H */
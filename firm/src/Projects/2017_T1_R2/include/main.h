@@ -64,10 +64,13 @@
 #include "FreeRTOS_CLI.h"
 #include "task.h"
 #include "semphr.h"
+#include "event_groups.h"
 
 
 /* Project files */
 #include "hardware_const.h"
+#include "seqlock.h"
+#include "encoder.h"
 
 
  /**
@@ -101,12 +104,22 @@
  * OS Tasks Priorities.
  * Higher value means higher priority
  */
-#define OS_TASK_PRIORITY_LED          ( tskIDLE_PRIORITY + 2 )
+#define OS_TASK_PRIORITY_SHELL        ( tskIDLE_PRIORITY + 1 ) // below MOTION_CS, see shell_cmd_spi()
+#define OS_TASK_PRIORITY_FAULT        ( tskIDLE_PRIORITY + 3 )
 #define OS_TASK_PRIORITY_MOTION_CS    ( tskIDLE_PRIORITY + 4 )
+#define OS_TASK_PRIORITY_SUPERVISOR   ( tskIDLE_PRIORITY + 4 )
 /*
- * OS Tasks Stacks sizes, in bytes
+ * OS Tasks Stacks sizes, in words (StackType_t)
  */
-#define OS_TASK_STACK_LED               configMINIMAL_STACK_SIZE
+#define OS_TASK_STACK_SHELL             500
+#define OS_TASK_STACK_FAULT             300
+#define OS_TASK_STACK_SUPERVISOR        300
+
+/*
+ * Kernel objects are allocated statically (no FreeRTOS heap): control
+ * blocks, stacks and queue storage are placed in the DTCM.
+ */
+#define OS_DTCM                         __attribute__((section(".dtcm")))
 #define OS_TASK_STACK_MOTION_CS         500
 
  /* NVIC Priorities. Lower value means higher priority.
@@ -115,12 +128,57 @@
   * ISR Save FreeRTOS API Routines!
   */
 #define OS_ISR_PRIORITY_SER             ( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY + 1 )
+#define OS_ISR_PRIORITY_MOT_FAULT       ( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY )
+#define OS_ISR_PRIORITY_LCMXO2          ( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY + 1 )
+#define OS_ISR_PRIORITY_TICKLESS        ( configLIBRARY_LOWEST_INTERRUPT_PRIORITY ) // only wakes the core up
 
  /*
   * Events periodicity
   */
 #define MOTION_CONTROL_PERIOD_MS      20
 
+ /*
+  * Benchmarks build: the shell 'bench' command times the control-path
+  * kernels (bench.c), the motion control task is not started.
+  */
+#define BENCH_TARGET                  0
+
+ /*
+  * Replay capture: the inputs and outputs of every control cycle, from the
+  * first one, are logged in RAM for the shell 'replay dump' command and
+  * firm/host/replay_host.c. The log holds about a match (replay.c).
+  */
+#define REPLAY_CAPTURE                1
+
+ /*
+  * Flight recorder: every control cycle in a ring, frozen around a trigger
+  * (bridge fault, position error, shell) for the shell 'recorder dump'
+  * command (recorder.c).
+  */
+#define RECORDER                      1
+
+ /*
+  * Supervisor: every supervised task checks in at least once per period,
+  * the watchdog resets the board after SUPERVISOR_TIMEOUT_MS without all
+  * of them (LCMXO2 held in reset by hb_init(), bridges off).
+  * The timeout covers the motion start-up delays.
+  */
+#define SUPERVISOR_PERIOD_MS          100
+#define SUPERVISOR_TIMEOUT_MS         1000
+#define SUPERVISOR_ALIVE_MOTION_CS    ( 1 << 0 )
+#define SUPERVISOR_ALIVE_SHELL        ( 1 << 1 )
+#if BENCH_TARGET
+#define SUPERVISOR_ALIVE_ALL          ( SUPERVISOR_ALIVE_SHELL )
+#else
+#define SUPERVISOR_ALIVE_ALL          ( SUPERVISOR_ALIVE_MOTION_CS | SUPERVISOR_ALIVE_SHELL )
+#endif
+
+ /*
+  * Tickless idle: wake-up latency budget, a small part of the motion
+  * control period. Later wake-ups are counted, see tickless_print().
+  */
+#define TICKLESS_LATENCY_MAX_US       10
+
 /**
 ********************************************************************************
 **
@@ -136,14 +194,58 @@
  */
 
 /* FreeRTOS prototypes for the standard FreeRTOS callback/hook functions */
-void vApplicationMallocFailedHook( void );
 void vApplicationIdleHook( void );
 void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName );
 void vApplicationTickHook( void );
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize );
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize );
 
 /* OS handlers */
 void sys_get_run_time_stats(char *pcWriteBuffer);
 
+/* Supervisor */
+BaseType_t supervisor_start(void);
+void supervisor_alive(EventBits_t task);
+void supervisor_print(char* buffer, size_t length);
+
+/* Trace recorder */
+void trace_init(void);
+void trace_start(void);
+void trace_stop(void);
+bool trace_is_running(void);
+void trace_print(char* buffer, size_t length);
+BaseType_t trace_dump(char* buffer, size_t length);
+
+/* Replay capture */
+#if REPLAY_CAPTURE
+void replay_stop(void);
+void replay_print(char* buffer, size_t length);
+BaseType_t replay_dump(char* buffer, size_t length);
+#endif
+
+/* Flight recorder */
+#if RECORDER
+#define RECORDER_TRIGGER_FAULT        ( 1 << 0 )  // bridge fault
+#define RECORDER_TRIGGER_ERROR        ( 1 << 1 )  // position error above the threshold
+#define RECORDER_TRIGGER_SHELL        ( 1 << 2 )  // 'recorder trigger' command
+void recorder_trigger(uint32_t cause);
+BaseType_t recorder_arm(uint32_t pre, uint32_t post);
+void recorder_set_threshold(uint32_t threshold);
+void recorder_print(char* buffer, size_t length);
+BaseType_t recorder_dump(char* buffer, size_t length);
+#endif
+
+/* Benchmarks */
+#if BENCH_TARGET
+BaseType_t bench_dump(char* buffer, size_t length);
+#endif
+
+/* Tickless idle */
+void tickless_init(void);
+void tickless_sleep(TickType_t expected_idle);
+void tickless_print(char* buffer, size_t length);
+void tickless_clear(void);
+
 /*
  * -----------------------------------------------------------------------------
  * Hardware Management
@@ -154,6 +256,7 @@ void sys_get_run_time_stats(char *pcWriteBuffer);
 BaseType_t led_start(void);
 void led_set_mode(HB_LED_ModeTypeDef mode);
 void led_set_color(HB_LED_ColorTypeDef color);
+void led_set_rgb(uint8_t red, uint8_t green, uint8_t blue);
 
 /* Serial Interface */
 BaseType_t serial_init(void);
@@ -162,6 +265,9 @@ BaseType_t serial_puts(const char* str);
 BaseType_t serial_get(const char* str);
 int serial_printf(const char * restrict format, ... );
 
+/* Command Shell */
+BaseType_t shell_start(void);
+
 /*
  * -----------------------------------------------------------------------------
  * Sub-Systems
@@ -169,8 +275,36 @@ int serial_printf(const char * restrict format, ... );
  */
 
 /* Motion Control System */
+#define MOTION_AXES                   3       // x, y, teta
+
+/* Published once per control cycle, see motion_get_status() */
+typedef struct {
+    uint32_t cycle;                           // control cycles since start, 0 before the first one
+    TickType_t time;                          // tick of the cycle
+    int32_t pose[MOTION_AXES];                // position of the robot, PID units
+    int32_t speed[MOTION_AXES];               // per control period
+    int32_t wheel[HB_LCMXO2_NB_CHANNELS];     // encoder positions, ticks
+    uint8_t faults;                           // bridges reporting a fault, one bit per motor
+    uint8_t stopped;                          // bridges braked by an emergency stop
+    uint8_t qei_fault;                        // an encoder error counter is not zero
+    uint32_t sample_missed;                   // cycles run without an FPGA sample
+} motion_status_t;
+
 BaseType_t motion_cs_start(void);
-void motor1_set_speed(int speed);
+void motor_set_speed(uint16_t channel, int speed);
+#if HB_LCMXO2_VEL_LOOP
+void motors_set_velocity(const int32_t velocity[HB_LCMXO2_NB_CHANNELS]);
+#else
+BaseType_t motion_identify(void);
+void motion_identify_print(char* buffer, size_t length);
+#endif
+void motion_get_status(motion_status_t* status);
+void motion_cs_print(char* buffer, size_t length);
+
+/* Motor Faults */
+BaseType_t motion_fault_start(void);
+void motion_fault_print(char* buffer, size_t length);
+BaseType_t motion_fault_clear(void);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,95 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       motion_control.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Control law of the motion control system: encoder counters in, wheel
+ *   commands out. Without any hardware or kernel access, so that the same
+ *   code runs in motion_cs_task() and in the host replay of a capture
+ *   (replay.h, firm/host/replay_host.c).
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __MOTION_CONTROL_H
+#define __MOTION_CONTROL_H
+
+#include "pid.h"
+
+#if HB_LCMXO2_VEL_LOOP
+/* Wheel commands are velocities, encoder counts per control period */
+#define MOTION_WHEEL_MAX    1000
+#else
+#define MOTION_WHEEL_MAX    HB_LCMXO2_PWM_MAX
+#endif
+
+/* Gains and limits of an axis, see PID_Set_Coefficient(), PID_Set_limitation()
+ * and PID_Set_Profile() */
+typedef struct {
+    int8_t KP;
+    int8_t KI;
+    int8_t KD;
+    uint32_t I_limit;
+    int32_t speed_limit;                        /* 0 => no limit */
+    int32_t acceleration_limit;                 /* 0 => no limit */
+    int32_t profile_speed;                      /* 0 => no profile, the reference steps */
+    int32_t profile_acceleration;               /* 0 => no limit */
+} motion_axis_gains_t;
+
+/* The ones of the robot */
+extern const motion_axis_gains_t motion_control_gains[MOTION_AXES];
+
+/* State of the control law, set up by motion_control_init() */
+typedef struct {
+    PID_process_t* axis[MOTION_AXES];           /* position PIDs: x, y, teta */
+    PID_holonomic_t base;                       /* wheels feed-forward, desaturation */
+    encoder_t encoder[PID_WHEELS];
+    int32_t wheel_position[PID_WHEELS];         /* ticks */
+    int32_t wheel_command[PID_WHEELS];          /* PWM, counts per period with the FPGA velocity loop */
+} motion_control_t;
+
+void motion_control_init(motion_control_t* control);
+void motion_control_configure(motion_control_t* control, const motion_axis_gains_t gains[MOTION_AXES]);
+void motion_control_sample(motion_control_t* control, const int16_t counters[PID_WHEELS]);
+void motion_control_cycle(motion_control_t* control, const int16_t counters[PID_WHEELS]);
+void motion_control_hold(motion_control_t* control, const int16_t counters[PID_WHEELS]);
+
+#if !HB_LCMXO2_VEL_LOOP
+/* Wheels feed-forward identification, see motion_ident_cycle() */
+typedef enum {
+    MOTION_IDENT_IDLE = 0,
+    MOTION_IDENT_FRICTION,                      /* PWM ramp until each wheel turns: KS */
+    MOTION_IDENT_REST,                          /* wheels stopping */
+    MOTION_IDENT_STEP,                          /* first period of the PWM step */
+    MOTION_IDENT_SETTLE,
+    MOTION_IDENT_MEASURE,                       /* steady-state speed: KV, then KA */
+    MOTION_IDENT_STOPPING,                      /* wheels stopping, then done or failed */
+    MOTION_IDENT_DONE,
+    MOTION_IDENT_FAILED
+} motion_ident_phase_t;
+
+typedef struct {
+    motion_ident_phase_t phase;
+    uint16_t periods;                           /* in the phase */
+    uint8_t turning;                            /* wheels past KS, one bit each */
+    uint8_t valid;                              /* KV, KA and KS identified */
+    int32_t pwm[PID_WHEELS];
+    int32_t last[PID_WHEELS];                   /* wheel positions of the previous period */
+    int32_t first[PID_WHEELS];                  /* ticks over the first period of the step */
+    int32_t travel[PID_WHEELS];                 /* ticks over the measure */
+    int16_t KV[PID_WHEELS];
+    int16_t KA[PID_WHEELS];
+    int16_t KS[PID_WHEELS];
+} motion_ident_t;
+
+void motion_ident_start(motion_ident_t* ident, const int32_t wheel_position[PID_WHEELS]);
+BaseType_t motion_ident_cycle(motion_ident_t* ident, const int32_t wheel_position[PID_WHEELS], int32_t pwm[PID_WHEELS]);
+#endif
+
+#endif /* __MOTION_CONTROL_H */
@@ -31,7 +31,13 @@
  * ---------------------
  */
 
-/* Memory 152 bytes */
+/* Number of PID processes pid_init() can hand out, one per robot axis */
+#define PID_PROCESS_MAX		3
+
+/* Wheels of the holonomic base, one motor and encoder channel each */
+#define PID_WHEELS			HB_LCMXO2_NB_CHANNELS
+
+/* Memory 20 bytes */
 typedef struct PID_struct_t{
     int8_t KP;     	// Proportional gain
     int8_t KI;       	// Integrative gain
@@ -42,7 +48,17 @@ typedef struct PID_struct_t{
     int32_t I_limit;
 }PID_struct_t;
 
-/* Memory 184 bytes */
+/* Velocity feed-forward, identified per wheel (motion_ident_cycle()):
+ * command = KV*v_ref/100 + KA*a_ref/100 + sign(v_ref)*KS
+ */
+typedef struct PID_FF_struct_t{
+    int16_t KV;         // Velocity gain (x100)
+    int16_t KA;         // Acceleration gain (x100)
+    int16_t KS;         // Coulomb friction compensation (command unit)
+    int32_t last_ref;   // Previous velocity reference
+}PID_FF_struct_t;
+
+/* Memory 64 bytes, Cortex-M7 */
 typedef struct PID_process_t{
 	void (*set_pwm)(void *, int32_t);
 	void *pwm_channel;
@@ -54,6 +70,12 @@ typedef struct PID_process_t{
     int32_t last;
     int32_t ref;
     int32_t last_ref;
+    // Reference profile, see PID_Set_Profile(): the position PID follows
+    // prof_position, which moves to ref at bounded speed and acceleration
+    int32_t prof_position;
+    int32_t prof_speed;         // Profile velocity, per period, feed-forward
+    int32_t prof_speed_Limit;   // 0 => no profile, the reference steps
+    int32_t prof_acceleration_Limit; // 0 => no limit
     // PID structure
     PID_struct_t *PID;
     int32_t speed_Limit;     	// Speed saturation, 0 => no limit
@@ -61,17 +83,51 @@ typedef struct PID_process_t{
 }PID_process_t;
 
 
+/* Wheel commands desaturation policy, used when one wheel exceeds the limit */
+typedef enum {
+    PID_DESAT_SCALE       = 0,  // Scale all the wheel commands together
+    PID_DESAT_ROTATION    = 1,  // Keep rotation, scale translation first
+    PID_DESAT_TRANSLATION = 2   // Keep translation, scale rotation first
+} PID_desat_priority_t;
+
+/* Unit of the wheel commands of PID_Process_holonomic() */
+typedef enum {
+    PID_WHEEL_OUTPUT_PWM      = 0,  // PWM, through the wheels feed-forward
+    PID_WHEEL_OUTPUT_VELOCITY = 1   // Encoder counts per period, to the FPGA velocity loop
+} PID_wheel_output_t;
+
+/* Holonomic base of PID_Process_holonomic(), held by the caller with its
+ * processes: zeroed, no feed-forward, no desaturation and PWM commands */
+typedef struct PID_holonomic_t{
+    PID_FF_struct_t wheel_ff[PID_WHEELS];   // Velocity feed-forward of each wheel
+    int32_t desat_limit;                    // Wheel commands desaturation, 0 => no limit
+    PID_desat_priority_t desat_priority;
+    PID_wheel_output_t wheel_output;        // Wheel commands unit, see PID_Set_Wheel_Output()
+}PID_holonomic_t;
+
 /*
  * PID Functions Prototypes
  */
 int32_t PID_Process(PID_struct_t *PID, int32_t error);
+int32_t PID_Process_Feed_Forward(PID_FF_struct_t *FF, int32_t v_ref);
+int32_t PID_Process_Profile(PID_process_t *pPID);
 void PID_Process_Speed(PID_process_t *sPID, uint32_t position);
 void PID_Process_Position(PID_process_t *pPID, PID_process_t *sPID, int32_t position);
-void PID_Process_holonomic(PID_process_t *pPIDx,PID_process_t *pPIDy,PID_process_t *pPIDteta);
+void PID_Process_holonomic(PID_holonomic_t *base,
+                           PID_process_t *pPIDx,PID_process_t *pPIDy,PID_process_t *pPIDteta,
+                           const int32_t wheel_position[PID_WHEELS], int32_t wheel_command[PID_WHEELS]);
+void PID_Set_Desaturation(PID_holonomic_t *base, int32_t limit, PID_desat_priority_t priority);
+void PID_Desaturate(const PID_holonomic_t *base, int32_t motor[PID_WHEELS], const int32_t rotation[PID_WHEELS]);
 void PID_Set_Coefficient(PID_struct_t *PID,int8_t KP,int8_t KI,int8_t KD,uint32_t I_limit);
+void PID_Set_Wheel_Feed_Forward(PID_holonomic_t *base, uint8_t wheel, int16_t KV, int16_t KA, int16_t KS);
+void PID_Set_Wheel_Output(PID_holonomic_t *base, PID_wheel_output_t output);
+void PID_Hold_holonomic(PID_holonomic_t *base,
+                        PID_process_t *pPIDx,PID_process_t *pPIDy,PID_process_t *pPIDteta,
+                        const int32_t wheel_position[PID_WHEELS]);
 void PID_Reset(PID_process_t *xPID);
 int32_t PID_Manage_limitation(PID_process_t *xPID, int32_t param);
 void PID_Set_limitation(PID_process_t *xPID,int32_t S_limit, int32_t A_limit);
+void PID_Set_Profile(PID_process_t *pPID, int32_t S_limit, int32_t A_limit);
 PID_process_t* pid_init(void);
 void PID_Set_Pwm(PID_process_t *xPID, void (*set_pwm)(void *, int32_t), void *pwm_channel);
 void PID_Set_Encoder(PID_process_t *xPID, int32_t (*get_encoder)(void *), void *encoder_channel);
@@ -0,0 +1,41 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       recorder.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Flight recorder of the control cycles, see recorder.c. The control
+ *   task side, the shell side is in main.h.
+ *
+ *   Dump lines, see recorder_dump():
+ *      # recorder <samples> <trigger> <cause> <period ms>
+ *      S <cycle from the trigger> <ms> <STATUS> <faults> <stopped>
+ *        <refs> <pose> <wheel positions> <wheel commands>
+ *      # end
+ *   The refs are the profiled references the PIDs follow (PID_Process_Profile()).
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __RECORDER_H
+#define __RECORDER_H
+
+#include "motion_control.h"
+
+/* Ring of the last control cycles, 56 bytes each: 20 s at 20 ms */
+#define RECORDER_SAMPLES            1024
+
+/* Default window, cycles before and after the trigger cycle */
+#define RECORDER_PRE                768
+#define RECORDER_POST               (RECORDER_SAMPLES - RECORDER_PRE - 1)
+
+#if RECORDER
+void recorder_record(uint32_t time, uint16_t status, const motion_control_t* control);
+#endif
+
+#endif /* __RECORDER_H */
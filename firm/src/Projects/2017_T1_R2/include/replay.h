@@ -0,0 +1,74 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       replay.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Replay capture of the control cycles: log format, shared by replay.c
+ *   and firm/host/replay_host.c.
+ *
+ *   One record per control cycle, each field relative to the previous
+ *   record (all zero before the first one):
+ *    - header byte, REPLAY_HDR_xxx
+ *    - ticks since the previous cycle, if REPLAY_HDR_PERIOD
+ *    - LCMXO2 STATUS, if REPLAY_HDR_STATUS
+ *    - MOTION_AXES references deltas, if REPLAY_HDR_REF
+ *    - PID_WHEELS QEI counters deltas, modulo the 12 bits counters
+ *    - PID_WHEELS wheel commands deltas
+ *   Values are LEB128 varints, deltas zigzag encoded first: a cycle of
+ *   constant references and period takes 7 to 10 bytes.
+ *
+ *   Dump lines, see replay_dump():
+ *      # replay <cycles> <bytes> <dropped> <wheels> <velocity loop>
+ *      D <REPLAY_DUMP_BYTES bytes at most, hexadecimal>
+ *      # end
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <stdint.h>
+
+#include "motion_control.h"
+
+/* Record header */
+#define REPLAY_HDR_PERIOD           0x01    /* the period changed, it follows */
+#define REPLAY_HDR_STATUS           0x02    /* the STATUS changed, it follows */
+#define REPLAY_HDR_REF              0x04    /* a reference changed, the deltas follow */
+
+#define REPLAY_COUNTER_MASK         0x0FFF
+#define REPLAY_DUMP_BYTES           32
+
+/* Longest record, 5 bytes per 32 bits varint */
+#define REPLAY_RECORD_MAX           (1 + 5 + 3 + 5 * (MOTION_AXES + 2 * PID_WHEELS))
+
+/* Signed to unsigned, small magnitudes to small values */
+static inline uint32_t replay_zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t replay_unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/* Counters delta, -2048 to 2047 */
+static inline int32_t replay_counter_delta(int16_t counter, int16_t last)
+{
+    return (int32_t)(((counter - last) & REPLAY_COUNTER_MASK) ^ 0x0800) - 0x0800;
+}
+
+#if REPLAY_CAPTURE
+void replay_record(uint32_t time, uint16_t status, const int16_t counters[PID_WHEELS],
+                   const motion_control_t* control);
+#endif
+
+#endif /* __REPLAY_H */
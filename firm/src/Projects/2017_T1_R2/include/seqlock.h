@@ -0,0 +1,139 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       seqlock.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Lock-free sharing between tasks and ISRs, without a kernel call:
+ *    - seqlock over two buffers, for multi-words snapshots with a single
+ *      writer. The writer never waits. A reader copies the buffer last
+ *      published and retries only if the writer published again meanwhile,
+ *      so a reader preempting the writer always gets a consistent copy.
+ *    - atomic read-modify-write of single words (LDREX / STREX).
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __SEQLOCK_H
+#define __SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* Seqlock of a _type snapshot, to be zero-initialized (static storage) */
+#define SEQLOCK(_type)                  \
+    struct {                            \
+        volatile uint32_t seq;          \
+        _type buffer[2];                \
+    }
+
+/* Single writer: copy *(_data) to the lock */
+#define seqlock_publish(_lock, _data)   \
+    seqlock_write(&(_lock)->seq, (_lock)->buffer, (_data), sizeof((_lock)->buffer[0]))
+
+/* Any number of readers: copy the last published snapshot to *(_data) */
+#define seqlock_snapshot(_lock, _data)  \
+    seqlock_read(&(_lock)->seq, (_lock)->buffer, (_data), sizeof((_lock)->buffer[0]))
+
+/**
+  * @brief  Publish a snapshot: the buffer readers do not use is written,
+  *         then swapped in by the sequence increment
+  * @param  seq: sequence of the lock
+  * @param  buffers: the two buffers of the lock
+  * @param  data: snapshot to publish
+  * @param  size: size of a buffer
+  * @retval None
+  */
+static inline void seqlock_write(volatile uint32_t* seq, void* buffers, const void* data, size_t size)
+{
+    uint32_t next = *seq + 1;
+
+    memcpy((uint8_t*)buffers + (next & 1) * size, data, size);
+    __DMB();
+    *seq = next;
+}
+
+/**
+  * @brief  Copy the last published snapshot
+  * @param  seq: sequence of the lock
+  * @param  buffers: the two buffers of the lock
+  * @param  data: destination
+  * @param  size: size of a buffer
+  * @retval None
+  */
+static inline void seqlock_read(volatile uint32_t* seq, const void* buffers, void* data, size_t size)
+{
+    uint32_t start;
+
+    /* The buffer read may be rewritten as soon as the sequence moves */
+    do {
+        start = *seq;
+        __DMB();
+        memcpy(data, (const uint8_t*)buffers + (start & 1) * size, size);
+        __DMB();
+    } while(*seq != start);
+}
+
+/* Aligned words are read and written in one access */
+static inline uint32_t atomic_load32(volatile uint32_t* word)
+{
+    return *word;
+}
+
+static inline void atomic_store32(volatile uint32_t* word, uint32_t value)
+{
+    *word = value;
+}
+
+/* Read-modify-write, an exception between LDREX and STREX makes it retry.
+ * The previous value is returned. */
+static inline uint32_t atomic_add32(volatile uint32_t* word, uint32_t value)
+{
+    uint32_t old;
+
+    do {
+        old = __LDREXW(word);
+    } while(__STREXW(old + value, word));
+
+    return old;
+}
+
+static inline uint32_t atomic_or32(volatile uint32_t* word, uint32_t mask)
+{
+    uint32_t old;
+
+    do {
+        old = __LDREXW(word);
+    } while(__STREXW(old | mask, word));
+
+    return old;
+}
+
+static inline uint32_t atomic_and32(volatile uint32_t* word, uint32_t mask)
+{
+    uint32_t old;
+
+    do {
+        old = __LDREXW(word);
+    } while(__STREXW(old & mask, word));
+
+    return old;
+}
+
+static inline uint32_t atomic_swap32(volatile uint32_t* word, uint32_t value)
+{
+    uint32_t old;
+
+    do {
+        old = __LDREXW(word);
+    } while(__STREXW(value, word));
+
+    return old;
+}
+
+#endif /* __SEQLOCK_H */
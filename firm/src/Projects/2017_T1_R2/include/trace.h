@@ -0,0 +1,72 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       trace.h
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Scheduling trace recorder: FreeRTOS trace hooks stored as 8 bytes
+ *   records in a RAM ring, time-stamped with the DWT cycle counter.
+ *   Included by FreeRTOSConfig.h, see trace.c and firm/host/trace2json
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <stdint.h>
+
+/* Events, record id and arg fields in brackets */
+#define TRACE_EV_TASK_IN            1   /* task switched in (task number, -) */
+#define TRACE_EV_TASK_OUT           2   /* task switched out (task number, -) */
+#define TRACE_EV_QUEUE_SEND         3   /* item sent (queue number, items before) */
+#define TRACE_EV_QUEUE_RECEIVE      4   /* item received (queue number, items before) */
+#define TRACE_EV_BLOCK_SEND         5   /* running task blocks, queue full (queue number, -) */
+#define TRACE_EV_BLOCK_RECEIVE      6   /* running task blocks, queue empty (queue number, -) */
+#define TRACE_EV_ISR_ENTER          7   /* (exception number, -) */
+#define TRACE_EV_ISR_EXIT           8   /* (exception number, -) */
+
+/* Queue numbers, 0 is any queue or semaphore not named by trace_name_queue() */
+#define TRACE_QUEUE_SERIAL_RX       1
+#define TRACE_QUEUE_SERIAL_TX       2
+
+/* 8 bytes record, as dumped in hexadecimal by trace_dump() */
+typedef struct {
+    uint32_t cycles;        /* DWT->CYCCNT */
+    uint8_t event;          /* TRACE_EV_xxx */
+    uint8_t id;
+    uint16_t arg;
+} trace_record_t;
+
+void trace_record(uint8_t event, uint8_t id, uint16_t arg);
+
+#if TRACE_RECORDER
+
+/* Current exception number, 0 in thread mode */
+#define TRACE_EXCEPTION()           ((uint8_t)(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk))
+
+/* To be used at the start and the end of the application ISRs */
+#define TRACE_ISR_ENTER()           trace_record(TRACE_EV_ISR_ENTER, TRACE_EXCEPTION(), 0)
+#define TRACE_ISR_EXIT()            trace_record(TRACE_EV_ISR_EXIT, TRACE_EXCEPTION(), 0)
+
+/* FreeRTOS hooks, expanded in tasks.c and queue.c */
+#define traceTASK_SWITCHED_IN()                 trace_record(TRACE_EV_TASK_IN, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_SWITCHED_OUT()                trace_record(TRACE_EV_TASK_OUT, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#define traceQUEUE_SEND(pxQueue)                trace_record(TRACE_EV_QUEUE_SEND, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE(pxQueue)             trace_record(TRACE_EV_QUEUE_RECEIVE, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)    trace_record(TRACE_EV_BLOCK_SEND, (uint8_t)(pxQueue)->uxQueueNumber, 0)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) trace_record(TRACE_EV_BLOCK_RECEIVE, (uint8_t)(pxQueue)->uxQueueNumber, 0)
+
+#else
+
+#define TRACE_ISR_ENTER()
+#define TRACE_ISR_EXIT()
+
+#endif /* TRACE_RECORDER */
+
+#endif /* __TRACE_H */
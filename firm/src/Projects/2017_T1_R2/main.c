@@ -27,15 +27,26 @@
 
 int main( void )
 {
+  BaseType_t ret = pdPASS;
 
   /* HoloBoard Initializations */;
    hb_init();
+   trace_init();
+   tickless_init();
 
   // Serial is started first to ensure correct print outs
-  serial_init();
-
-  led_start();
-  motion_cs_start();
+  ret &= serial_init();
+  ret &= shell_start();
+
+  ret &= led_start();
+#if !BENCH_TARGET
+  ret &= motion_cs_start();
+#endif
+  ret &= motion_fault_start();
+  ret &= supervisor_start();
+
+  /* Kernel objects are static, creation only fails on a programming error */
+  configASSERT(ret == pdPASS);
 
   /* Start FreeRTOS Scheduler */
   vTaskStartScheduler();
@@ -1,59 +1,97 @@
-LIBRARY  ieee; 
-  USE ieee.std_logic_1164.all; 
-  USE ieee.numeric_std.all; 
-	 
-ENTITY QEI IS 
+LIBRARY  ieee;
+  USE ieee.std_logic_1164.all;
+  USE ieee.numeric_std.all;
+
+-- Quadrature decoder, counts the four edges of each CHA/CHB cycle:
+-- up when CHA leads CHB, Gray sequence (A,B) 00 -> 10 -> 11 -> 01.
+-- Each input goes through a two-flop synchronizer then a glitch filter:
+-- a new level is only taken once stable for FILTER_I + 1 clocks.
+-- Both filtered inputs changing on the same clock is an illegal transition,
+-- it is not counted and pulses ERROR_O.
+
+ENTITY QEI IS
 	PORT (
 		RESET_I			: IN  	STD_LOGIC;
 		CLK_I      		: IN  	STD_LOGIC;
 		QE_CHA_I		: IN 	STD_LOGIC;
 		QE_CHB_I		: IN 	STD_LOGIC;
-		HOLD_I			: IN 	STD_LOGIC;
-		QE_COUNTER_O	: OUT	STD_LOGIC_VECTOR(11 downto 0)
+		FILTER_I		: IN 	UNSIGNED(7 DOWNTO 0);										-- clocks a level must be stable, minus one
+		QE_COUNTER_O	: OUT	STD_LOGIC_VECTOR(11 downto 0);
+		ERROR_O			: OUT	STD_LOGIC												-- one clock pulse per illegal transition
 		);
 END QEI;
 
 ARCHITECTURE BEHAVIOR OF QEI IS
 
 	SIGNAL counter 		: SIGNED(11 downto 0);
-	SIGNAL cha_latched, cha_buffered : STD_LOGIC;
-	SIGNAL chb_latched 	: STD_LOGIC;
-	SIGNAL hold_latched	: STD_LOGIC;
+	SIGNAL cha_latched, cha_sync : STD_LOGIC;											-- synchronizers
+	SIGNAL chb_latched, chb_sync : STD_LOGIC;
+	SIGNAL cha_count, chb_count : UNSIGNED(7 DOWNTO 0);									-- clocks the input differs from the filtered level
+	SIGNAL cha_filtered, chb_filtered : STD_LOGIC;
 
 	BEGIN
-	
+
 	PROCESS(RESET_I, CLK_I)
+		VARIABLE cha_next, chb_next : STD_LOGIC;
+		VARIABLE transition : STD_LOGIC_VECTOR(3 DOWNTO 0);
 		BEGIN
 			IF (RESET_I = '1') THEN
 				counter <= (OTHERS => '0');
 				cha_latched <= '0';
 				chb_latched <= '0';
-				cha_buffered <= '0';
+				cha_sync <= '0';
+				chb_sync <= '0';
+				cha_count <= (OTHERS => '0');
+				chb_count <= (OTHERS => '0');
+				cha_filtered <= '0';
+				chb_filtered <= '0';
+				ERROR_O <= '0';
 			ELSIF( rising_edge(CLK_I) ) THEN
 				cha_latched <= QE_CHA_I;
 				chb_latched <= QE_CHB_I;
-				cha_buffered <= cha_latched;
-				IF(cha_buffered ='0' AND cha_latched ='1' AND chb_latched ='0') OR 
-				  (cha_buffered ='1' AND cha_latched ='0' AND chb_latched ='1') THEN
-					IF(chb_latched='1')THEN
-						counter <= counter + 1;
-					ELSE
-						counter <= counter - 1;
-					END IF;
+				cha_sync <= cha_latched;
+				chb_sync <= chb_latched;
+				ERROR_O <= '0';
+
+				-- Glitch filters
+				cha_next := cha_filtered;
+				IF (cha_sync = cha_filtered) THEN
+					cha_count <= (OTHERS => '0');
+				ELSIF (cha_count >= FILTER_I) THEN
+					cha_next := cha_sync;
+					cha_count <= (OTHERS => '0');
+				ELSE
+					cha_count <= cha_count + 1;
+				END IF;
+
+				chb_next := chb_filtered;
+				IF (chb_sync = chb_filtered) THEN
+					chb_count <= (OTHERS => '0');
+				ELSIF (chb_count >= FILTER_I) THEN
+					chb_next := chb_sync;
+					chb_count <= (OTHERS => '0');
+				ELSE
+					chb_count <= chb_count + 1;
 				END IF;
+
+				cha_filtered <= cha_next;
+				chb_filtered <= chb_next;
+
+				-- Decoder, previous (A,B) & new (A,B)
+				transition := cha_filtered & chb_filtered & cha_next & chb_next;
+				CASE transition IS
+					WHEN "0010" | "1011" | "1101" | "0100" =>
+						counter <= counter + 1;
+					WHEN "0001" | "0111" | "1110" | "1000" =>
+						counter <= counter - 1;
+					WHEN "0011" | "1100" | "0110" | "1001" =>
+						ERROR_O <= '1';
+					WHEN OTHERS =>
+						NULL;
+				END CASE;
 			END IF;
 	END PROCESS;
-	--PROCESS(RESET_I, CLK_I)
-		--BEGIN
-			--IF (RESET_I = '1') THEN
-				--QE_COUNTER_O <= (OTHERS => '0');
-				--hold_latched <= '0';
-			--ELSIF( rising_edge(CLK_I) ) THEN
-				--hold_latched <= HOLD_I;
-				--IF(hold_latched ='0' AND HOLD_I ='1')THEN
-					QE_COUNTER_O <= std_logic_vector(counter);
-				--END IF;
-			--END IF;
-	--END PROCESS;
-
-END BEHAVIOR;
\ No newline at end of file
+
+	QE_COUNTER_O <= std_logic_vector(counter);
+
+END BEHAVIOR;
@@ -5,47 +5,56 @@ LIBRARY lattice;
 	USE lattice.all;
 LIBRARY machxo2;
 	USE machxo2.all;
+LIBRARY work;
+	USE work.holoboard_pkg.all;
   
+-- One encoder input pair and one bridge output pair per channel, indexed
+-- 0 to G_NB_CHANNELS-1 (QEn_CHA/QEn_CHB, PWMn_IN1/PWMn_IN2 on the board).
+-- The register file holds up to 16 channels (low nibble of the address).
+-- IRQ_O goes to the MCU: encoder sample ready or encoder fault.
+-- Device: LCMXO2-1200HC in 32-QFN (SG32), the footprint of the LCMXO2-256HC
+-- of the first boards, which with 256 LUTs and 256 flip-flops cannot hold
+-- the register file, the PWM and the encoder channels.
+-- Each bridge is driven by PWM_DUTY or by the velocity PI, one controller
+-- shared by the channels. The register banks are in distributed RAM and
+-- come out through a channel scan, one channel per clock in turn, read by
+-- the PI and loaded by the PWM generators when their channel comes.
+
 ENTITY HOLOBOARD IS 
+	GENERIC (
+		G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS									-- motor + encoder channels
+		);
 	PORT (
 		RESET_I		: IN  	STD_LOGIC;
 		SPI_CLK_I   : IN	STD_LOGIC;
 		SPI_SS_I    : IN 	STD_LOGIC;
 		SPI_MOSI_I  : IN	STD_LOGIC;
 		SPI_MISO_O	: OUT	STD_LOGIC;
-		QE0_CHA_I	: IN 	STD_LOGIC;
-		QE0_CHB_I	: IN 	STD_LOGIC;
-		QE1_CHA_I	: IN 	STD_LOGIC;
-		QE1_CHB_I	: IN 	STD_LOGIC;
-		QE2_CHA_I	: IN 	STD_LOGIC;
-		QE2_CHB_I	: IN 	STD_LOGIC;
-		--QE3_CHA_I	: IN 	STD_LOGIC;
-		--QE3_CHB_I	: IN 	STD_LOGIC;
-		PWM0_IN1_O	: OUT	STD_LOGIC;
-		PWM0_IN2_O	: OUT	STD_LOGIC;
-		PWM1_IN1_O	: OUT	STD_LOGIC;
-		PWM1_IN2_O	: OUT	STD_LOGIC;
-		PWM2_IN1_O	: OUT	STD_LOGIC;
-		PWM2_IN2_O	: OUT	STD_LOGIC		
-		--PWM3_IN1_O	: OUT	STD_LOGIC;
-		--PWM3_IN2_O	: OUT	STD_LOGIC
+		QE_CHA_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+		QE_CHB_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+		PWM_IN1_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+		PWM_IN2_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+		IRQ_O		: OUT	STD_LOGIC
 		);
 END HOLOBOARD;
 
 ARCHITECTURE BEHAVIOR OF HOLOBOARD IS
 
 	SIGNAL clk  : STD_LOGIC;																		-- generale clock = 133 Mhz
-   	SIGNAL qei_counter0, qei_counter1, qei_counter2 : STD_LOGIC_VECTOR(11 DOWNTO 0);	-- qei_counters
-	SIGNAL pwm0_mem, pwm1_mem, pwm2_mem : STD_LOGIC_VECTOR(11 DOWNTO 0);					-- pwm mem (signed)
-	SIGNAL pwm0_value, pwm1_value, pwm2_value : UNSIGNED(10 DOWNTO 0);			-- pwm input for pwm generator
-	SIGNAL pwm0_sens, pwm1_sens, pwm2_sens: STD_LOGIC;									-- 0 = Forward ; 1 = Reverse
-	SIGNAL pwm0, pwm1, pwm2: STD_LOGIC;														-- pwm output from pwm generator
-	SIGNAL memory_address : STD_LOGIC_VECTOR(3 DOWNTO 0);
-	SIGNAL memory_rw : STD_LOGIC;																	-- 0 = read ; 1 = write
+	SIGNAL qei_words : T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);									-- qei counters, register file format
+	SIGNAL qei_errors : STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);								-- illegal transition pulses
+	SIGNAL qei_filter : UNSIGNED(7 DOWNTO 0);														-- glitch filter length
+	SIGNAL scan : UNSIGNED(3 DOWNTO 0);																-- channel scan, registers of one channel per clock
+	SIGNAL pwm_duty : STD_LOGIC_VECTOR(15 DOWNTO 0);												-- pwm registers of the scan channel (see holoboard_pkg.vhd)
+	SIGNAL pwm_period, pwm_slew : UNSIGNED(14 DOWNTO 0);
+	SIGNAL pwm_deadband : UNSIGNED(7 DOWNTO 0);
+	SIGNAL vel_ref, vel_kp, vel_ki : SIGNED(15 DOWNTO 0);											-- velocity loop registers of the scan channel
+	SIGNAL vel_en, vel_enable, vel_tick : STD_LOGIC;												-- loop runs while the bridges are enabled
+	SIGNAL vel_duty : T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);
+	SIGNAL pwm_en, pwm_reset : STD_LOGIC;															-- bridges braked while pwm is disabled
 	SIGNAL to_spi	: std_logic_vector(15 downto 0);												-- data to send with SPI
 	SIGNAL from_spi	: std_logic_vector(15 downto 0);												-- data received from SPI
-	SIGNAL spi_irq, spi_irq_latched, tx_load, address_received : STD_LOGIC;
-	SIGNAL data_received : STD_LOGIC;
+	SIGNAL spi_rx_valid, spi_cs_active : STD_LOGIC;
    
 	COMPONENT OSCH																					-- : internal oscillator				
 		GENERIC(
@@ -64,47 +73,89 @@ ARCHITECTURE BEHAVIOR OF HOLOBOARD IS
 			SS_I    		:	IN	STD_LOGIC;
 			MOSI_I  		:	IN	STD_LOGIC;
 			MISO_O			:	OUT	STD_LOGIC;
-			DATA_TO_TX_O  	: 	IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
-			TX_LOAD_I		:	IN	STD_LOGIC;
+			TX_DATA_I	  	: 	IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
 			RX_DATA_O	 	: 	OUT STD_LOGIC_VECTOR(15 DOWNTO 0);
-			IRQ_O			:	OUT	STD_LOGIC
+			RX_VALID_O		:	OUT	STD_LOGIC;
+			CS_ACTIVE_O		:	OUT	STD_LOGIC
 		);
 	END COMPONENT;
-    
-	COMPONENT RAM is
-    port (
-        Data: in  std_logic_vector(11 downto 0); 
-        Clock: in  std_logic; 
-        WE: in  std_logic; 
-        ClockEn1: in  std_logic;
-		ClockEn2: in  std_logic;		
-        Q: out  std_logic_vector(11 downto 0));
-	END COMPONENT;
 
+	COMPONENT MEMORY_MANAGER IS 																	-- : register file instanciation
+		GENERIC (
+			G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+			);
+		PORT (
+			RESET_I			: IN  	STD_LOGIC;
+			CLK_I      		: IN  	STD_LOGIC;
+			RX_DATA_I		: IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			RX_VALID_I		: IN 	STD_LOGIC;
+			CS_ACTIVE_I		: IN 	STD_LOGIC;
+			TX_DATA_O		: OUT	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			QEI_I			: IN 	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);
+			QEI_ERR_I		: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			QEI_FILTER_O	: OUT	UNSIGNED(7 DOWNTO 0);
+			SCAN_O			: OUT	UNSIGNED(3 DOWNTO 0);
+			PWM_DUTY_O		: OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			PWM_PERIOD_O	: OUT 	UNSIGNED(14 DOWNTO 0);
+			PWM_DEADBAND_O	: OUT 	UNSIGNED(7 DOWNTO 0);
+			PWM_SLEW_O		: OUT 	UNSIGNED(14 DOWNTO 0);
+			PWM_EN_O		: OUT	STD_LOGIC;
+			VEL_REF_O		: OUT 	SIGNED(15 DOWNTO 0);
+			VEL_KP_O		: OUT 	SIGNED(15 DOWNTO 0);
+			VEL_KI_O		: OUT 	SIGNED(15 DOWNTO 0);
+			VEL_EN_O		: OUT	STD_LOGIC;
+			VEL_TICK_O		: OUT	STD_LOGIC;
+			IRQ_O			: OUT	STD_LOGIC
+		);
+	END COMPONENT;
+    
 	COMPONENT PWM_GENERATOR IS 																		-- : PWM generator instanciation	
+	GENERIC (
+		G_WIDTH		: NATURAL := 15
+		);
 	PORT (
 		RESET_I		: IN  	STD_LOGIC;
 		CLK_I      	: IN  	STD_LOGIC;
-		PWM0_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
-		PWM1_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
-		PWM2_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
---		PWM3_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
-		PWM0_O	: OUT  	STD_LOGIC;
-		PWM1_O	: OUT  	STD_LOGIC;
-		PWM2_O	: OUT  	STD_LOGIC
-		--PWM3_O	: OUT  	STD_LOGIC
-);
+		PERIOD_I	: IN 	UNSIGNED(G_WIDTH-1 DOWNTO 0);
+		DUTY_I		: IN 	STD_LOGIC_VECTOR(G_WIDTH DOWNTO 0);
+		DEADBAND_I	: IN 	UNSIGNED(7 DOWNTO 0);
+		SLEW_I		: IN 	UNSIGNED(G_WIDTH-1 DOWNTO 0);
+		LOAD_I		: IN 	STD_LOGIC;
+		PERIOD_END_O: OUT	STD_LOGIC;
+		IN1_O		: OUT  	STD_LOGIC;
+		IN2_O		: OUT  	STD_LOGIC
+		);
 	END COMPONENT;
 	
-	COMPONENT QEI IS 
-	PORT (
-		RESET_I			: IN  	STD_LOGIC;
-		CLK_I      		: IN  	STD_LOGIC;
-		QE_CHA_I		: IN 	STD_LOGIC;
-		QE_CHB_I		: IN 	STD_LOGIC;
-		HOLD_I			: IN 	STD_LOGIC;
-		QE_COUNTER_O	: OUT	STD_LOGIC_VECTOR(11 downto 0)
-		);
+	COMPONENT VELOCITY_PI IS
+	GENERIC (
+		G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+		);
+	PORT (
+		RESET_I		: IN  	STD_LOGIC;
+		CLK_I      	: IN  	STD_LOGIC;
+		ENABLE_I	: IN 	STD_LOGIC;
+		TICK_I		: IN 	STD_LOGIC;
+		COUNTER_I	: IN 	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);
+		SCAN_I		: IN 	UNSIGNED(3 DOWNTO 0);
+		REF_I		: IN 	SIGNED(15 DOWNTO 0);
+		KP_I		: IN 	SIGNED(15 DOWNTO 0);
+		KI_I		: IN 	SIGNED(15 DOWNTO 0);
+		LIMIT_I		: IN 	UNSIGNED(14 DOWNTO 0);
+		DUTY_O		: OUT	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1)
+		);
+	END COMPONENT;
+
+	COMPONENT QEI IS 
+	PORT (
+		RESET_I			: IN  	STD_LOGIC;
+		CLK_I      		: IN  	STD_LOGIC;
+		QE_CHA_I		: IN 	STD_LOGIC;
+		QE_CHB_I		: IN 	STD_LOGIC;
+		FILTER_I		: IN 	UNSIGNED(7 DOWNTO 0);
+		QE_COUNTER_O	: OUT	STD_LOGIC_VECTOR(11 downto 0);
+		ERROR_O			: OUT	STD_LOGIC
+		);
 	END COMPONENT;
 
 BEGIN-- internal oscillator
@@ -112,90 +163,48 @@ BEGIN-- internal oscillator
     GENERIC MAP (NOM_FREQ  => "133.00")																-- set clock to 133Mhz
     PORT MAP (STDBY => '0', OSC => clk, SEDSTDBY => OPEN);
 
--- Quadrature Encodeur interface
-	QEI0 : QEI
-	PORT MAP (RESET_i => RESET_i, CLK_i => clk, QE_CHA_i => QE0_CHA_i, QE_CHB_i => QE0_CHB_i, HOLD_I => SPI_SS_I, QE_COUNTER_o => qei_counter0);
-
-	QEI1 : QEI
-	PORT MAP (RESET_i => RESET_i, CLK_i => clk, QE_CHA_i => QE1_CHA_i, QE_CHB_i => QE1_CHB_i, HOLD_I => SPI_SS_I, QE_COUNTER_o => qei_counter1);
-	
-	QEI2 : QEI
-	PORT MAP (RESET_i => RESET_i, CLK_i => clk, QE_CHA_i => QE2_CHA_i, QE_CHB_i => QE2_CHB_i, HOLD_I => SPI_SS_I, QE_COUNTER_o => qei_counter2);
-	--QEI3 : QEI
-	--PORT MAP (RESET_i => RESET_i, CLK_i => clk, QE_CHA_i => QE3_CHA_i, QE_CHB_i => QE3_CHB_i, HOLD_I => SPI_SS_I, QE_COUNTER_o => qei_counter3);
+	ASSERT G_NB_CHANNELS >= 1 and G_NB_CHANNELS <= 16
+		REPORT "HOLOBOARD: 1 to 16 channels" SEVERITY FAILURE;
 
+-- MCU interface
 	SPI : SIMPLE_SPI
-	PORT MAP (RESET_i => RESET_i, CLK_i => clk, SCLK_I => SPI_CLK_I, SS_I => SPI_SS_I, MOSI_I => SPI_MOSI_I, MISO_O => SPI_MISO_O, DATA_TO_TX_O => to_spi,
-			TX_LOAD_I => tx_load, RX_DATA_O => from_spi, IRQ_O => spi_irq);
-			
-	MEM1 : RAM
-	PORT MAP (Data(11 downto 0)=> from_spi(11 downto 0), Clock=> clk, WE=>memory_rw, ClockEn1=>memory_address(2), ClockEn2=>data_received, Q(11 downto 0)=>pwm0_mem);
-	
-	MEM2 : RAM
-	PORT MAP (Data(11 downto 0)=> from_spi(11 downto 0), Clock=> clk, WE=>memory_rw, ClockEn1=>memory_address(1), ClockEn2=>data_received, Q(11 downto 0)=>pwm1_mem);
-	
-	MEM3 : RAM
-	PORT MAP (Data(11 downto 0)=> from_spi(11 downto 0), Clock=> clk, WE=>memory_rw, ClockEn1=>memory_address(0), ClockEn2=>data_received, Q(11 downto 0)=>pwm2_mem);
---	MEM4 : RAM
---	PORT MAP (Data(11 downto 0)=> from_spi(11 downto 0), Clock=> clk, WE=>memory_rw, ClockEn1=>memory_address(0), ClockEn2=>data_received, Q(11 downto 0)=>pwm2_mem);
-
+	PORT MAP (RESET_i => RESET_i, CLK_i => clk, SCLK_I => SPI_CLK_I, SS_I => SPI_SS_I, MOSI_I => SPI_MOSI_I, MISO_O => SPI_MISO_O, TX_DATA_I => to_spi,
+			RX_DATA_O => from_spi, RX_VALID_O => spi_rx_valid, CS_ACTIVE_O => spi_cs_active);
+
+	REGS : MEMORY_MANAGER
+	GENERIC MAP (G_NB_CHANNELS => G_NB_CHANNELS)
+	PORT MAP (RESET_I => RESET_I, CLK_I => clk, RX_DATA_I => from_spi, RX_VALID_I => spi_rx_valid, CS_ACTIVE_I => spi_cs_active, TX_DATA_O => to_spi,
+			QEI_I => qei_words, QEI_ERR_I => qei_errors, QEI_FILTER_O => qei_filter, SCAN_O => scan, PWM_DUTY_O => pwm_duty, PWM_PERIOD_O => pwm_period,
+			PWM_DEADBAND_O => pwm_deadband, PWM_SLEW_O => pwm_slew, PWM_EN_O => pwm_en, VEL_REF_O => vel_ref, VEL_KP_O => vel_kp,
+			VEL_KI_O => vel_ki, VEL_EN_O => vel_en, VEL_TICK_O => vel_tick, IRQ_O => IRQ_O);
 
-	PWM : PWM_GENERATOR 
-	PORT MAP ( 	RESET_I => RESET_I,	CLK_I => clk, PWM0_VALUE_I => pwm0_value, PWM1_VALUE_I => pwm1_value, PWM2_VALUE_I => pwm2_value,
-				PWM0_O => pwm0, PWM1_O => pwm1, PWM2_O => pwm2);
+	pwm_reset <= RESET_I or not pwm_en;
+	vel_enable <= vel_en and pwm_en;
 
-	PROCESS(clk, RESET_I)											
+-- Velocity loop, one PI for all the channels
+	VEL : VELOCITY_PI
+	GENERIC MAP (G_NB_CHANNELS => G_NB_CHANNELS)
+	PORT MAP ( 	RESET_I => RESET_I, CLK_I => clk, ENABLE_I => vel_enable, TICK_I => vel_tick, COUNTER_I => qei_words, SCAN_I => scan,
+				REF_I => vel_ref, KP_I => vel_kp, KI_I => vel_ki, LIMIT_I => pwm_period, DUTY_O => vel_duty);
+
+-- Channels: quadrature encoder interface and motor
+	CHANNELS : FOR i IN 0 TO G_NB_CHANNELS-1 GENERATE
+		SIGNAL qei_counter : STD_LOGIC_VECTOR(11 DOWNTO 0);
+		SIGNAL duty : STD_LOGIC_VECTOR(15 DOWNTO 0);
+		SIGNAL load : STD_LOGIC;																	-- registers of this channel on the scan
 	BEGIN
-		IF (RESET_I = '1') THEN
-			memory_rw <= '0';
-			memory_address <= (OTHERS => '0');
-			address_received <= '0';
-			spi_irq_latched <= '1';
-			data_received <= '0';
-		ELSIF( rising_edge(clk) ) THEN
-			spi_irq_latched <= spi_irq;
-			data_received <= '0';
-			IF(spi_irq = '1' and spi_irq_latched = '0')THEN
-				IF(address_received = '0') THEN
-					memory_rw <= from_spi(7);					-- bit 7 determine if set or get
-					memory_address <= from_spi(3 DOWNTO 0);		-- address is the three lsb bits		
-					address_received <= '1';					-- set the received flag
-					if(from_spi(7) = '0' and from_spi(0) = '1')THEN
-						to_spi(11 downto 0) <= qei_counter2;
-						tx_load <= '1';
-					elsif(from_spi(7) = '0' and from_spi(1) = '1')THEN
-						to_spi(11 downto 0) <= qei_counter1;
-						tx_load <= '1';	
-					elsif(from_spi(7) = '0' and from_spi(2) = '1')THEN
-						to_spi(11 downto 0) <= qei_counter0;
-						tx_load <= '1';							
-					END IF;
-				ELSE
-					data_received <= '1';
-					address_received <= '0';					-- clear the received flag
-					tx_load <= '0';
-				END IF;
-			END IF;
-		END IF;	
-END PROCESS;
-
-pwm0_sens 	<= 	pwm0_mem(11);																-- if msb = 1 then sens is Reverse
-pwm0_value 	<= 	unsigned(pwm0_mem(10 downto 0));									-- so pwm value need to be convert in unsigned
-PWM0_IN1_O 	<= 	not pwm0 WHEN pwm0_sens = '0' ELSE '1';										-- driven logic  of DRC8872
-PWM0_IN2_O 	<= 	not pwm0 WHEN pwm0_sens = '1' ELSE '1';
-
-pwm1_sens 	<= 	pwm1_mem(11);
-pwm1_value 	<= 	unsigned(pwm1_mem(10 downto 0));					-- same as pwm0
-PWM1_IN1_O 	<= 	not pwm1 WHEN pwm1_sens = '0' ELSE '1';
-PWM1_IN2_O 	<= 	not pwm1 WHEN pwm1_sens = '1' ELSE '1';
-
-pwm2_sens 	<= 	pwm2_mem(11);
-pwm2_value 	<= 	unsigned(pwm2_mem(10 downto 0));					-- same as pwm0
-PWM2_IN1_O 	<= 	not pwm2 WHEN pwm2_sens = '0' ELSE '1';
-PWM2_IN2_O 	<= 	not pwm2 WHEN pwm2_sens = '1' ELSE '1';
-
---pwm3_sens 	<= 	pwm3_mem(11);
---pwm3_value 	<= 	unsigned(pwm3_mem(10 downto 0));					-- same as pwm0
---PWM3_IN1_O 	<= 	not pwm3 WHEN pwm3_sens = '0' ELSE '1';
---PWM3_IN2_O 	<= 	not pwm3 WHEN pwm3_sens = '1' ELSE '1';
-END BEHAVIOR;
\ No newline at end of file
+		QEIx : QEI
+		PORT MAP (RESET_i => RESET_i, CLK_i => clk, QE_CHA_i => QE_CHA_I(i), QE_CHB_i => QE_CHB_I(i), FILTER_I => qei_filter, QE_COUNTER_o => qei_counter,
+				ERROR_O => qei_errors(i));
+
+		qei_words(i) <= "0000" & qei_counter;
+
+		duty <= vel_duty(i) WHEN vel_en = '1' ELSE pwm_duty;
+		load <= '1' WHEN scan = i ELSE '0';
+
+		PWMx : PWM_GENERATOR
+		PORT MAP ( 	RESET_I => pwm_reset, CLK_I => clk, PERIOD_I => pwm_period, DUTY_I => duty, DEADBAND_I => pwm_deadband, SLEW_I => pwm_slew,
+					LOAD_I => load, PERIOD_END_O => OPEN, IN1_O => PWM_IN1_O(i), IN2_O => PWM_IN2_O(i));
+	END GENERATE;
+
+END BEHAVIOR;
\ No newline at end of file
@@ -0,0 +1,160 @@
+LIBRARY  ieee;
+	USE ieee.std_logic_1164.all;
+	USE ieee.numeric_std.all;
+
+-- Shared definitions of the HOLOBOARD FPGA: number of motor channels and
+-- register map seen by the MCU through SIMPLE_SPI.
+--
+-- SPI transaction (16-bit words, one chip-select window):
+--   command word: bit 15 = write, bits 7..0 = start address
+--   write burst : command, data0, data1, ... (address auto-increments)
+--   read burst  : command, turnaround, data0, data1, ...
+-- Every word shifted out while no register is pending returns STATUS,
+-- so the command and turnaround words of a read also carry it.
+-- Accesses to an unmapped address are ignored (reads return zero).
+-- Registers are as wide as the values they hold, unused high bits are
+-- ignored on write and read back zero.
+--
+-- CRC mode (command bit 14 set, bits 13..8 = burst length N):
+--   write burst : command, data0..dataN-1, crc, turnaround, ack
+--   read burst  : command, turnaround, data0..dataN-1, crc
+-- The CRC-8 (see crc8) covers the command and the N data words, and for
+-- a read the STATUS of the turnaround word in between; it is sent as
+-- x"00" & crc. A write is staged and only applied when its crc
+-- word matches, the ack word is x"A5" & crc then, x"00" & crc otherwise
+-- and CRC_ERR counts the rejected bursts. A CRC write burst is at most
+-- one register bank long, G_NB_CHANNELS words (see memory_manager.vhd).
+-- Words past the end of a CRC burst are ignored and return STATUS.
+--
+-- Sampling (SAMPLE_PERIOD not zero): the encoder counters are snapshot
+-- every SAMPLE_PERIOD us instead of at chip-select, STATUS.SAMPLE is set
+-- until a read burst starts in the QEI bank. A sample due while the chip
+-- select is active is taken when it is released, so one burst always reads
+-- counters of the same instant. IRQ_O pulses for C_IRQ_PULSE
+-- clocks on each sample and when an encoder error counter leaves zero,
+-- as enabled in IRQ_EN.
+--
+-- Slew limit (PWM_SLEW not zero): each PWM period, the duty driven moves
+-- towards the PWM_DUTY target by at most PWM_SLEW steps, through zero on a
+-- direction change. A full scale ramp lasts PERIOD / PWM_SLEW PWM periods.
+-- PWM_DUTY reads back the target.
+--
+-- Velocity loop (CONFIG.VEL_EN set): every VEL_PERIOD us a PI shared by the
+-- channels (see velocity_pi.vhd) drives the PWM of each one in turn from
+-- the encoder counts towards VEL_REF, PWM_DUTY is not used. Braking (CONFIG.PWM_EN clear) also
+-- clears the integrals. PWM_SLEW still applies to the PI output.
+--
+-- Identification: ID and CAPS are read-only constants of the bitstream,
+-- STATUS.READY is set C_READY_CLOCKS after reset, once the encoder inputs
+-- went through their synchronizers and filters. The MCU polls them after
+-- releasing the reset instead of waiting a fixed time, and picks the
+-- protocol variant from the CAPS bits.
+
+PACKAGE HOLOBOARD_PKG IS
+
+	CONSTANT C_NB_CHANNELS		: NATURAL := 3;											-- motor + encoder channels, default of the HOLOBOARD generic
+	CONSTANT C_CLK_PER_US		: NATURAL := 133;										-- OSCH clock
+
+	TYPE T_WORD_ARRAY IS ARRAY(NATURAL RANGE <>) OF STD_LOGIC_VECTOR(15 DOWNTO 0);
+
+	-- Command word
+	CONSTANT C_CMD_WRITE_BIT	: NATURAL := 15;
+	CONSTANT C_CMD_CRC_BIT		: NATURAL := 14;
+	CONSTANT C_CMD_LENGTH_MSB	: NATURAL := 13;										-- burst length, CRC mode only
+	CONSTANT C_CMD_LENGTH_LSB	: NATURAL := 8;
+
+	-- Register map, banks are indexed by channel in the low nibble
+	CONSTANT C_REG_STATUS		: UNSIGNED(7 DOWNTO 0) := x"00";						-- RO
+	CONSTANT C_REG_CONFIG		: UNSIGNED(7 DOWNTO 0) := x"01";						-- RW
+	CONSTANT C_REG_CRC_ERR		: UNSIGNED(7 DOWNTO 0) := x"02";						-- RO, rejected CRC writes, any write clears
+	CONSTANT C_REG_QEI_FILTER	: UNSIGNED(7 DOWNTO 0) := x"03";						-- RW, encoder glitch filter, in clock cycles minus one
+	CONSTANT C_REG_SAMPLE_PERIOD: UNSIGNED(7 DOWNTO 0) := x"04";						-- RW, encoder sampling in us, 0 = at chip-select
+	CONSTANT C_REG_IRQ_EN		: UNSIGNED(7 DOWNTO 0) := x"05";						-- RW, IRQ_O sources
+	CONSTANT C_REG_VEL_PERIOD	: UNSIGNED(7 DOWNTO 0) := x"06";						-- RW, velocity loop period in us, 0 = stopped
+	CONSTANT C_REG_ID			: UNSIGNED(7 DOWNTO 0) := x"07";						-- RO, C_ID_MAGIC & C_ID_VERSION
+	CONSTANT C_REG_CAPS			: UNSIGNED(7 DOWNTO 0) := x"08";						-- RO, channel count and optional blocks
+	CONSTANT C_BANK_QEI			: UNSIGNED(3 DOWNTO 0) := x"1";							-- RO, snapshot taken at chip-select or sample
+	CONSTANT C_BANK_PWM_DUTY	: UNSIGNED(3 DOWNTO 0) := x"2";							-- RW, msb = sens, 0 = Forward ; 1 = Reverse
+	CONSTANT C_BANK_PWM_PERIOD	: UNSIGNED(3 DOWNTO 0) := x"3";							-- RW, in clock cycles minus one
+	CONSTANT C_BANK_PWM_DEADBAND: UNSIGNED(3 DOWNTO 0) := x"4";							-- RW, in clock cycles
+	CONSTANT C_BANK_QEI_ERR		: UNSIGNED(3 DOWNTO 0) := x"5";							-- RO, illegal encoder transitions up to 255, any write clears
+	CONSTANT C_BANK_PWM_SLEW	: UNSIGNED(3 DOWNTO 0) := x"6";							-- RW, largest duty change per PWM period, 0 = none
+	CONSTANT C_BANK_VEL_REF		: UNSIGNED(3 DOWNTO 0) := x"7";							-- RW, signed, 1/256 counts per loop period
+	CONSTANT C_BANK_VEL_KP		: UNSIGNED(3 DOWNTO 0) := x"8";							-- RW, signed, duty steps per count per loop period
+	CONSTANT C_BANK_VEL_KI		: UNSIGNED(3 DOWNTO 0) := x"9";							-- RW, signed, same per loop period
+
+	-- CONFIG bits
+	CONSTANT C_CONFIG_PWM_EN	: NATURAL := 0;											-- 0 = bridges braked
+	CONSTANT C_CONFIG_VEL_EN	: NATURAL := 1;											-- 1 = PWM driven by the velocity loop
+
+	-- STATUS bits
+	CONSTANT C_STATUS_PWM_EN	: NATURAL := 0;											-- copy of CONFIG.PWM_EN
+	CONSTANT C_STATUS_SAMPLE	: NATURAL := 1;											-- encoder sample not read yet
+	CONSTANT C_STATUS_QEI_FAULT	: NATURAL := 2;											-- an encoder error counter is not zero
+	CONSTANT C_STATUS_VEL_EN	: NATURAL := 3;											-- copy of CONFIG.VEL_EN
+	CONSTANT C_STATUS_READY		: NATURAL := 4;											-- out of reset, encoder inputs settled
+
+	-- Identification
+	CONSTANT C_ID_MAGIC			: STD_LOGIC_VECTOR(7 DOWNTO 0) := x"B0";				-- HOLOBOARD register file
+	CONSTANT C_ID_VERSION		: STD_LOGIC_VECTOR(7 DOWNTO 0) := x"02";				-- register map and protocol revision
+	CONSTANT C_READY_CLOCKS		: NATURAL := 512;										-- 3.8 us, past the longest glitch filter
+
+	-- CAPS bits, the channel count is in bits 4..0
+	CONSTANT C_CAPS_CHANNELS_MSB: NATURAL := 4;
+	CONSTANT C_CAPS_CRC			: NATURAL := 8;											-- CRC mode bursts
+	CONSTANT C_CAPS_SAMPLE		: NATURAL := 9;											-- sample timer and IRQ_O
+	CONSTANT C_CAPS_SLEW		: NATURAL := 10;										-- PWM slew limit
+	CONSTANT C_CAPS_VEL			: NATURAL := 11;										-- velocity loop
+
+	-- IRQ_EN bits
+	CONSTANT C_IRQ_SAMPLE		: NATURAL := 0;
+	CONSTANT C_IRQ_QEI_FAULT	: NATURAL := 1;
+	CONSTANT C_IRQ_PULSE		: NATURAL := 64;										-- IRQ_O pulse, 480 ns
+
+	-- Reset values
+	CONSTANT C_PWM_PERIOD_RESET	: NATURAL := 2047;										-- 65 kHz / 11-bit
+	CONSTANT C_QEI_FILTER_RESET	: NATURAL := 2;											-- 3 clocks, 22 ns
+	CONSTANT C_VEL_PERIOD_RESET	: NATURAL := 100;										-- 10 kHz
+
+	-- CRC mode
+	CONSTANT C_CRC_INIT			: STD_LOGIC_VECTOR(7 DOWNTO 0) := x"FF";				-- catches all-zero frames
+	CONSTANT C_CRC_POLY			: STD_LOGIC_VECTOR(7 DOWNTO 0) := x"07";				-- x^8 + x^2 + x + 1
+	CONSTANT C_CRC_ACK			: STD_LOGIC_VECTOR(7 DOWNTO 0) := x"A5";				-- ack word msb, write applied
+
+	-- CRC-8 of a 16-bit word, msb first
+	FUNCTION crc8(crc : STD_LOGIC_VECTOR(7 DOWNTO 0); data : STD_LOGIC_VECTOR(15 DOWNTO 0)) RETURN STD_LOGIC_VECTOR;
+
+	-- CAPS register of a HOLOBOARD with nb_channels channels
+	FUNCTION caps_word(nb_channels : NATURAL) RETURN STD_LOGIC_VECTOR;
+
+END HOLOBOARD_PKG;
+
+PACKAGE BODY HOLOBOARD_PKG IS
+
+	FUNCTION crc8(crc : STD_LOGIC_VECTOR(7 DOWNTO 0); data : STD_LOGIC_VECTOR(15 DOWNTO 0)) RETURN STD_LOGIC_VECTOR IS
+		VARIABLE result : STD_LOGIC_VECTOR(7 DOWNTO 0);
+	BEGIN
+		result := crc;
+		FOR i IN 15 DOWNTO 0 LOOP
+			IF ((result(7) xor data(i)) = '1') THEN
+				result := (result(6 DOWNTO 0) & '0') xor C_CRC_POLY;
+			ELSE
+				result := result(6 DOWNTO 0) & '0';
+			END IF;
+		END LOOP;
+		RETURN result;
+	END FUNCTION;
+
+	FUNCTION caps_word(nb_channels : NATURAL) RETURN STD_LOGIC_VECTOR IS
+		VARIABLE result : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	BEGIN
+		result := (OTHERS => '0');
+		result(C_CAPS_CHANNELS_MSB DOWNTO 0) := std_logic_vector(to_unsigned(nb_channels, C_CAPS_CHANNELS_MSB+1));
+		result(C_CAPS_CRC) := '1';
+		result(C_CAPS_SAMPLE) := '1';
+		result(C_CAPS_SLEW) := '1';
+		result(C_CAPS_VEL) := '1';
+		RETURN result;
+	END FUNCTION;
+
+END HOLOBOARD_PKG;
@@ -1,83 +1,549 @@
-LIBRARY  ieee; 
-  USE ieee.std_logic_1164.all; 
-  USE ieee.numeric_std.all; 
-	 
-ENTITY MEMORY_MANAGER IS 
+LIBRARY  ieee;
+	USE ieee.std_logic_1164.all;
+	USE ieee.numeric_std.all;
+LIBRARY work;
+	USE work.holoboard_pkg.all;
+
+-- Register file of the HOLOBOARD, accessed word by word through SIMPLE_SPI
+-- (see holoboard_pkg.vhd for the register map and transaction format).
+-- The first word of a chip-select window is the command, following words
+-- are data at auto-incremented addresses.
+-- TX_DATA_O is taken by SIMPLE_SPI when a word completes and shifted out
+-- during the word after the next one, hence the turnaround word of reads.
+-- It holds STATUS from the start of a window until the command word, so
+-- the turnaround word of a CRC read carries the STATUS the crc covers.
+-- CRC mode writes are staged and applied one register per clock once the
+-- crc word has been checked. The stage holds G_NB_CHANNELS words, one
+-- register bank.
+-- The per channel banks written by the MCU are kept in distributed RAM
+-- (see RAM.vhd), each register as wide as the value it holds, and reach
+-- the channels through a scan: SCAN_O selects one channel per clock, in
+-- turn, and the bank outputs carry the registers of that channel.
+-- Register writes go through one write port register, a clock after the
+-- SPI word or the commit step. The banks are set to their reset values in
+-- the first 16 clocks after reset, SPI bank writes are ignored meanwhile.
+-- A read burst in a RAM bank waits for its channel on the scan before
+-- loading TX_DATA_O, at most G_NB_CHANNELS-1 clocks, well inside the word
+-- SIMPLE_SPI gives it. The CRC write stage is a RAM too.
+-- The encoder sample timer and the IRQ_O pulse are also kept here, next
+-- to the snapshot and the error counters they report on, as well as the
+-- velocity loop timer. A sample never lands inside a chip-select window,
+-- it is delayed to the end of the window, IRQ_O and STATUS.SAMPLE with it.
+
+ENTITY MEMORY_MANAGER IS
+	GENERIC (
+		G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS									-- 1 to 16, the CRC write bursts are as long
+		);
 	PORT (
 		RESET_I			: IN  	STD_LOGIC;
 		CLK_I      		: IN  	STD_LOGIC;
-		DATA0_I			: IN 	STD_LOGIC_VECTOR(15 downto 0);
-		DATA1_I			: IN 	STD_LOGIC_VECTOR(15 downto 0);
-		DATA2_I			: IN 	STD_LOGIC_VECTOR(15 downto 0);
-		DATA3_I			: IN 	STD_LOGIC_VECTOR(15 downto 0);
-		DATA4_O			: OUT	STD_LOGIC_VECTOR(15 downto 0);
-		DATA5_O			: OUT 	STD_LOGIC_VECTOR(15 downto 0);
-		DATA6_O			: OUT	STD_LOGIC_VECTOR(15 downto 0);
-		DATA7_O			: OUT 	STD_LOGIC_VECTOR(15 downto 0);		
-		MEMADD_I		: IN 	STD_LOGIC_VECTOR(2 downto 0);
-		MEMDATA_I		: IN	STD_LOGIC_VECTOR(15 downto 0);
-		MEMDATA_O		: OUT	STD_LOGIC_VECTOR(15 downto 0);
-		EN_I			: IN 	STD_LOGIC;
-		RW_I			: IN 	STD_LOGIC
+		RX_DATA_I		: IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);						-- word received from SPI
+		RX_VALID_I		: IN 	STD_LOGIC;											-- one clock pulse per received word
+		CS_ACTIVE_I		: IN 	STD_LOGIC;											-- chip-select window in progress
+		TX_DATA_O		: OUT	STD_LOGIC_VECTOR(15 DOWNTO 0);						-- word to send with SPI
+		QEI_I			: IN 	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);
+		QEI_ERR_I		: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);				-- one clock pulse per illegal transition
+		QEI_FILTER_O	: OUT	UNSIGNED(7 DOWNTO 0);
+		SCAN_O			: OUT	UNSIGNED(3 DOWNTO 0);								-- channel of the bank outputs below
+		PWM_DUTY_O		: OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		PWM_PERIOD_O	: OUT 	UNSIGNED(14 DOWNTO 0);
+		PWM_DEADBAND_O	: OUT 	UNSIGNED(7 DOWNTO 0);
+		PWM_SLEW_O		: OUT 	UNSIGNED(14 DOWNTO 0);
+		PWM_EN_O		: OUT	STD_LOGIC;
+		VEL_REF_O		: OUT 	SIGNED(15 DOWNTO 0);
+		VEL_KP_O		: OUT 	SIGNED(15 DOWNTO 0);
+		VEL_KI_O		: OUT 	SIGNED(15 DOWNTO 0);
+		VEL_EN_O		: OUT	STD_LOGIC;
+		VEL_TICK_O		: OUT	STD_LOGIC;											-- one clock pulse per velocity loop period
+		IRQ_O			: OUT	STD_LOGIC											-- sample ready or encoder fault, active high
 	);
 END MEMORY_MANAGER;
 
 ARCHITECTURE BEHAVIOR OF MEMORY_MANAGER IS
 
-	SIGNAL en_latched :  STD_LOGIC;
+	TYPE T_COUNT_ARRAY IS ARRAY(NATURAL RANGE <>) OF STD_LOGIC_VECTOR(11 DOWNTO 0);
+	TYPE T_ERROR_ARRAY IS ARRAY(NATURAL RANGE <>) OF UNSIGNED(7 DOWNTO 0);
+
+	COMPONENT RAM IS
+	GENERIC (
+		G_WIDTH		: NATURAL := 16
+		);
+	PORT (
+		CLK_I      	: IN  	STD_LOGIC;
+		WE_I		: IN 	STD_LOGIC;
+		WADDR_I		: IN 	UNSIGNED(3 DOWNTO 0);
+		DATA_I		: IN 	STD_LOGIC_VECTOR(G_WIDTH-1 DOWNTO 0);
+		RADDR_I		: IN 	UNSIGNED(3 DOWNTO 0);
+		DATA_O		: OUT	STD_LOGIC_VECTOR(G_WIDTH-1 DOWNTO 0)
+		);
+	END COMPONENT;
+
+	-- Banks kept in RAM, read through the channel scan
+	FUNCTION ram_bank(bank : UNSIGNED(3 DOWNTO 0)) RETURN BOOLEAN IS
+	BEGIN
+		RETURN bank = C_BANK_PWM_DUTY or bank = C_BANK_PWM_PERIOD or bank = C_BANK_PWM_DEADBAND or bank = C_BANK_PWM_SLEW or
+				bank = C_BANK_VEL_REF or bank = C_BANK_VEL_KP or bank = C_BANK_VEL_KI;
+	END FUNCTION;
+
+	SIGNAL cs_latched		: STD_LOGIC;
+	SIGNAL cmd_received		: STD_LOGIC;											-- 0 = next word is a command
+	SIGNAL cmd_write		: STD_LOGIC;											-- 0 = read ; 1 = write
+	SIGNAL cmd_crc			: STD_LOGIC;											-- 1 = CRC mode burst
+	SIGNAL length			: UNSIGNED(5 DOWNTO 0);									-- CRC mode burst length
+	SIGNAL count			: UNSIGNED(6 DOWNTO 0);									-- data words of the burst so far
+	SIGNAL crc				: STD_LOGIC_VECTOR(7 DOWNTO 0);							-- running CRC of the burst
+	SIGNAL tx_hold			: STD_LOGIC;											-- keep the ack word until the end of the window
+	SIGNAL tx_data			: STD_LOGIC_VECTOR(15 DOWNTO 0);						-- TX_DATA_O
+	SIGNAL stage			: STD_LOGIC_VECTOR(15 DOWNTO 0);						-- CRC write burst (RAM), applied once checked
+	SIGNAL commit			: STD_LOGIC;
+	SIGNAL commit_index		: UNSIGNED(5 DOWNTO 0);
+	SIGNAL crc_errors		: UNSIGNED(15 DOWNTO 0);
+	SIGNAL address			: UNSIGNED(7 DOWNTO 0);									-- auto-incremented address
+	SIGNAL prefetch			: STD_LOGIC;											-- load the first word of a read burst
+	SIGNAL read_pending		: STD_LOGIC;											-- read step waiting for its channel on the scan
+	SIGNAL read_ready		: STD_LOGIC;											-- read_data valid
+	SIGNAL scan				: UNSIGNED(3 DOWNTO 0);									-- channel of the RAM outputs
+	SIGNAL ram_we			: STD_LOGIC;											-- write port register
+	SIGNAL ram_stage		: STD_LOGIC;											-- 1 = CRC write stage, 0 = register banks
+	SIGNAL ram_address		: UNSIGNED(7 DOWNTO 0);
+	SIGNAL ram_data			: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL init				: STD_LOGIC;											-- banks set to their reset values
+	SIGNAL bank_waddr		: UNSIGNED(3 DOWNTO 0);
+	SIGNAL bank_data		: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL period_data		: STD_LOGIC_VECTOR(14 DOWNTO 0);
+	SIGNAL stage_we, duty_we, period_we, deadband_we, slew_we, ref_we, kp_we, ki_we : STD_LOGIC;
+	SIGNAL qei_snapshot		: T_COUNT_ARRAY(0 TO G_NB_CHANNELS-1);
+	SIGNAL qei_errors		: T_ERROR_ARRAY(0 TO G_NB_CHANNELS-1);					-- saturated at 255
+	SIGNAL qei_filter		: UNSIGNED(7 DOWNTO 0);
+	SIGNAL qei_fault		: STD_LOGIC;											-- an error counter is not zero
+	SIGNAL qei_fault_last	: STD_LOGIC;
+	SIGNAL sample_period	: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL sample_prescaler	: UNSIGNED(7 DOWNTO 0);									-- clocks in the current us
+	SIGNAL sample_count		: UNSIGNED(15 DOWNTO 0);								-- us since the last sample
+	SIGNAL sample_ready		: STD_LOGIC;											-- sample not read yet
+	SIGNAL sample_pending	: STD_LOGIC;											-- sample due, waiting for the end of the window
+	SIGNAL irq_en			: STD_LOGIC_VECTOR(C_IRQ_QEI_FAULT DOWNTO 0);
+	SIGNAL irq_count		: UNSIGNED(6 DOWNTO 0);									-- IRQ_O pulse clocks left
+	SIGNAL pwm_duty			: STD_LOGIC_VECTOR(15 DOWNTO 0);						-- RAM outputs
+	SIGNAL pwm_period		: STD_LOGIC_VECTOR(14 DOWNTO 0);
+	SIGNAL pwm_deadband		: STD_LOGIC_VECTOR(7 DOWNTO 0);
+	SIGNAL pwm_slew			: STD_LOGIC_VECTOR(14 DOWNTO 0);
+	SIGNAL vel_period		: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL vel_prescaler	: UNSIGNED(7 DOWNTO 0);									-- clocks in the current us
+	SIGNAL vel_count		: UNSIGNED(15 DOWNTO 0);								-- us since the last tick
+	SIGNAL vel_ref			: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL vel_kp			: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL vel_ki			: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL config			: STD_LOGIC_VECTOR(C_CONFIG_VEL_EN DOWNTO 0);
+	SIGNAL status			: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	CONSTANT C_CAPS			: STD_LOGIC_VECTOR(15 DOWNTO 0) := caps_word(G_NB_CHANNELS);
+	SIGNAL ready			: STD_LOGIC;
+	SIGNAL ready_count		: UNSIGNED(9 DOWNTO 0);									-- clocks since reset
+	SIGNAL read_data		: STD_LOGIC_VECTOR(15 DOWNTO 0);						-- register at the current address
+
+	BEGIN
+
+	-- Register banks, written through the write port register and set to
+	-- their reset values by the init sweep
+	init <= '1' WHEN ready_count < 16 ELSE '0';
+	bank_waddr <= ready_count(3 DOWNTO 0) WHEN init = '1' ELSE ram_address(3 DOWNTO 0);
+	bank_data <= (OTHERS => '0') WHEN init = '1' ELSE ram_data;
+	period_data <= std_logic_vector(to_unsigned(C_PWM_PERIOD_RESET, 15)) WHEN init = '1' ELSE ram_data(14 DOWNTO 0);
+	stage_we <= ram_we and ram_stage;
+	duty_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_PWM_DUTY) ELSE '0';
+	period_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_PWM_PERIOD) ELSE '0';
+	deadband_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_PWM_DEADBAND) ELSE '0';
+	slew_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_PWM_SLEW) ELSE '0';
+	ref_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_VEL_REF) ELSE '0';
+	kp_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_VEL_KP) ELSE '0';
+	ki_we <= '1' WHEN init = '1' or (ram_we = '1' and ram_stage = '0' and ram_address(7 DOWNTO 4) = C_BANK_VEL_KI) ELSE '0';
+
+	STAGE_RAM : RAM
+	GENERIC MAP (G_WIDTH => 16)
+	PORT MAP (CLK_I => CLK_I, WE_I => stage_we, WADDR_I => ram_address(3 DOWNTO 0), DATA_I => ram_data, RADDR_I => commit_index(3 DOWNTO 0), DATA_O => stage);
 
+	DUTY_RAM : RAM
+	GENERIC MAP (G_WIDTH => 16)
+	PORT MAP (CLK_I => CLK_I, WE_I => duty_we, WADDR_I => bank_waddr, DATA_I => bank_data, RADDR_I => scan, DATA_O => pwm_duty);
+
+	PERIOD_RAM : RAM
+	GENERIC MAP (G_WIDTH => 15)
+	PORT MAP (CLK_I => CLK_I, WE_I => period_we, WADDR_I => bank_waddr, DATA_I => period_data, RADDR_I => scan, DATA_O => pwm_period);
+
+	DEADBAND_RAM : RAM
+	GENERIC MAP (G_WIDTH => 8)
+	PORT MAP (CLK_I => CLK_I, WE_I => deadband_we, WADDR_I => bank_waddr, DATA_I => bank_data(7 DOWNTO 0), RADDR_I => scan, DATA_O => pwm_deadband);
+
+	SLEW_RAM : RAM
+	GENERIC MAP (G_WIDTH => 15)
+	PORT MAP (CLK_I => CLK_I, WE_I => slew_we, WADDR_I => bank_waddr, DATA_I => bank_data(14 DOWNTO 0), RADDR_I => scan, DATA_O => pwm_slew);
+
+	REF_RAM : RAM
+	GENERIC MAP (G_WIDTH => 16)
+	PORT MAP (CLK_I => CLK_I, WE_I => ref_we, WADDR_I => bank_waddr, DATA_I => bank_data, RADDR_I => scan, DATA_O => vel_ref);
+
+	KP_RAM : RAM
+	GENERIC MAP (G_WIDTH => 16)
+	PORT MAP (CLK_I => CLK_I, WE_I => kp_we, WADDR_I => bank_waddr, DATA_I => bank_data, RADDR_I => scan, DATA_O => vel_kp);
+
+	KI_RAM : RAM
+	GENERIC MAP (G_WIDTH => 16)
+	PORT MAP (CLK_I => CLK_I, WE_I => ki_we, WADDR_I => bank_waddr, DATA_I => bank_data, RADDR_I => scan, DATA_O => vel_ki);
+
+	-- RAM banks only read the channel on the scan
+	read_ready <= '0' WHEN ram_bank(address(7 DOWNTO 4)) and to_integer(address(3 DOWNTO 0)) < G_NB_CHANNELS and address(3 DOWNTO 0) /= scan ELSE '1';
+
+	-- Read multiplexer
+	PROCESS(address, status, config, crc_errors, qei_filter, sample_period, irq_en, vel_period, qei_snapshot, qei_errors, pwm_duty, pwm_period, pwm_deadband, pwm_slew,
+			vel_ref, vel_kp, vel_ki)
+		VARIABLE channel : NATURAL;
 	BEGIN
-	
+		channel := to_integer(address(3 DOWNTO 0));
+		read_data <= (OTHERS => '0');
+		IF (address = C_REG_STATUS) THEN
+			read_data <= status;
+		ELSIF (address = C_REG_CONFIG) THEN
+			read_data(config'RANGE) <= config;
+		ELSIF (address = C_REG_CRC_ERR) THEN
+			read_data <= std_logic_vector(crc_errors);
+		ELSIF (address = C_REG_QEI_FILTER) THEN
+			read_data(7 DOWNTO 0) <= std_logic_vector(qei_filter);
+		ELSIF (address = C_REG_SAMPLE_PERIOD) THEN
+			read_data <= sample_period;
+		ELSIF (address = C_REG_IRQ_EN) THEN
+			read_data(irq_en'RANGE) <= irq_en;
+		ELSIF (address = C_REG_VEL_PERIOD) THEN
+			read_data <= vel_period;
+		ELSIF (address = C_REG_ID) THEN
+			read_data <= C_ID_MAGIC & C_ID_VERSION;
+		ELSIF (address = C_REG_CAPS) THEN
+			read_data <= C_CAPS;
+		ELSIF (channel < G_NB_CHANNELS) THEN
+			IF (address(7 DOWNTO 4) = C_BANK_QEI) THEN
+				read_data <= "0000" & qei_snapshot(channel);
+			ELSIF (address(7 DOWNTO 4) = C_BANK_PWM_DUTY) THEN
+				read_data <= pwm_duty;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_PWM_PERIOD) THEN
+				read_data <= '0' & pwm_period;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_PWM_DEADBAND) THEN
+				read_data <= x"00" & pwm_deadband;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_PWM_SLEW) THEN
+				read_data <= '0' & pwm_slew;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_VEL_REF) THEN
+				read_data <= vel_ref;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_VEL_KP) THEN
+				read_data <= vel_kp;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_VEL_KI) THEN
+				read_data <= vel_ki;
+			ELSIF (address(7 DOWNTO 4) = C_BANK_QEI_ERR) THEN
+				read_data <= x"00" & std_logic_vector(qei_errors(channel));
+			END IF;
+		END IF;
+	END PROCESS;
+
 	PROCESS(RESET_I, CLK_I)
+		VARIABLE wr_en		: BOOLEAN;
+		VARIABLE wr_address	: UNSIGNED(7 DOWNTO 0);
+		VARIABLE wr_data	: STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE channel	: NATURAL;
+		VARIABLE sample		: BOOLEAN;
+		VARIABLE irq		: BOOLEAN;
 	BEGIN
 		IF (RESET_I = '1') THEN
-			MEMDATA_O <= (OTHERS => '0');
-			DATA4_O <= (OTHERS => '0');
-			DATA5_O <= (OTHERS => '0');
-			DATA6_O <= (OTHERS => '0');
-			DATA7_O <= (OTHERS => '0');			
-			en_latched <= '0';
+			cs_latched <= '0';
+			cmd_received <= '0';
+			cmd_write <= '0';
+			cmd_crc <= '0';
+			length <= (OTHERS => '0');
+			count <= (OTHERS => '0');
+			crc <= C_CRC_INIT;
+			tx_hold <= '0';
+			commit <= '0';
+			commit_index <= (OTHERS => '0');
+			crc_errors <= (OTHERS => '0');
+			address <= (OTHERS => '0');
+			prefetch <= '0';
+			read_pending <= '0';
+			scan <= (OTHERS => '0');
+			ram_we <= '0';
+			ram_stage <= '0';
+			ram_address <= (OTHERS => '0');
+			ram_data <= (OTHERS => '0');
+			qei_snapshot <= (OTHERS => (OTHERS => '0'));
+			qei_errors <= (OTHERS => (OTHERS => '0'));
+			qei_filter <= to_unsigned(C_QEI_FILTER_RESET, 8);
+			qei_fault_last <= '0';
+			sample_period <= (OTHERS => '0');
+			sample_prescaler <= (OTHERS => '0');
+			sample_count <= (OTHERS => '0');
+			sample_ready <= '0';
+			sample_pending <= '0';
+			irq_en <= (OTHERS => '0');
+			irq_count <= (OTHERS => '0');
+			IRQ_O <= '0';
+			vel_period <= std_logic_vector(to_unsigned(C_VEL_PERIOD_RESET, 16));
+			vel_prescaler <= (OTHERS => '0');
+			vel_count <= (OTHERS => '0');
+			VEL_TICK_O <= '0';
+			config <= (OTHERS => '0');
+			ready <= '0';
+			ready_count <= (OTHERS => '0');
+			tx_data <= (OTHERS => '0');
 		ELSIF( rising_edge(CLK_I) ) THEN
-			en_latched	<= EN_I;
-			CASE MEMADD_I IS
-				WHEN "000" =>
-					IF (RW_I='0')THEN
-						MEMDATA_O <= DATA0_I;						
-					END IF;
-				WHEN "001" =>
-					IF (RW_I='0')THEN
-						MEMDATA_O <= DATA1_I;						
-					END IF;
-				WHEN "010" =>
-					IF (RW_I='0')THEN
-						MEMDATA_O <= DATA2_I;						
-					END IF;
-				WHEN "011" =>
-					IF (RW_I='0')THEN
-						MEMDATA_O <= DATA3_I;						
+			cs_latched <= CS_ACTIVE_I;
+			prefetch <= '0';
+			ram_we <= '0';
+			wr_en := false;
+			wr_address := address;
+			wr_data := RX_DATA_I;
+			sample := false;
+			irq := false;
+
+			-- STATUS.READY, the register file answers from reset anyway
+			IF (ready_count = C_READY_CLOCKS-1) THEN
+				ready <= '1';
+			ELSE
+				ready_count <= ready_count + 1;
+			END IF;
+
+			-- Channel scan
+			IF (scan = G_NB_CHANNELS-1) THEN
+				scan <= (OTHERS => '0');
+			ELSE
+				scan <= scan + 1;
+			END IF;
+
+			-- Sample timer, 1 us steps
+			IF (unsigned(sample_period) = 0) THEN
+				sample_prescaler <= (OTHERS => '0');
+				sample_count <= (OTHERS => '0');
+			ELSIF (sample_prescaler = C_CLK_PER_US-1) THEN
+				sample_prescaler <= (OTHERS => '0');
+				IF (sample_count >= unsigned(sample_period) - 1) THEN
+					sample_count <= (OTHERS => '0');
+					sample := true;
+				ELSE
+					sample_count <= sample_count + 1;
+				END IF;
+			ELSE
+				sample_prescaler <= sample_prescaler + 1;
+			END IF;
+
+			-- A sample due inside a chip-select window is taken when the
+			-- window ends, a burst never sees the snapshot change under it
+			IF (CS_ACTIVE_I = '1') THEN
+				IF (sample) THEN
+					sample_pending <= '1';
+				END IF;
+				sample := false;
+			ELSIF (sample_pending = '1') THEN
+				sample_pending <= '0';
+				sample := true;
+			END IF;
+
+			-- Velocity loop timer, 1 us steps
+			VEL_TICK_O <= '0';
+			IF (unsigned(vel_period) = 0) THEN
+				vel_prescaler <= (OTHERS => '0');
+				vel_count <= (OTHERS => '0');
+			ELSIF (vel_prescaler = C_CLK_PER_US-1) THEN
+				vel_prescaler <= (OTHERS => '0');
+				IF (vel_count >= unsigned(vel_period) - 1) THEN
+					vel_count <= (OTHERS => '0');
+					VEL_TICK_O <= '1';
+				ELSE
+					vel_count <= vel_count + 1;
+				END IF;
+			ELSE
+				vel_prescaler <= vel_prescaler + 1;
+			END IF;
+
+			IF (sample or (unsigned(sample_period) = 0 and CS_ACTIVE_I = '1' and cs_latched = '0')) THEN
+				-- Sample, or new chip-select window when not sampling: freeze
+				-- the encoders until the next one
+				FOR i IN 0 TO G_NB_CHANNELS-1 LOOP
+					qei_snapshot(i) <= QEI_I(i)(11 DOWNTO 0);
+				END LOOP;
+			END IF;
+
+			-- Interrupt line, one pulse per event
+			qei_fault_last <= qei_fault;
+			IF (sample and irq_en(C_IRQ_SAMPLE) = '1') THEN
+				irq := true;
+			END IF;
+			IF (qei_fault = '1' and qei_fault_last = '0' and irq_en(C_IRQ_QEI_FAULT) = '1') THEN
+				irq := true;
+			END IF;
+			IF (irq) THEN
+				irq_count <= to_unsigned(C_IRQ_PULSE, irq_count'length);
+				IRQ_O <= '1';
+			ELSIF (irq_count > 1) THEN
+				irq_count <= irq_count - 1;
+			ELSE
+				irq_count <= (OTHERS => '0');
+				IRQ_O <= '0';
+			END IF;
+
+			FOR i IN 0 TO G_NB_CHANNELS-1 LOOP
+				IF (QEI_ERR_I(i) = '1' and qei_errors(i) /= 255) THEN
+					qei_errors(i) <= qei_errors(i) + 1;
+				END IF;
+			END LOOP;
+
+			IF (commit = '1') THEN
+				-- Checked CRC write burst, one register per clock
+				wr_en := true;
+				wr_address := address + commit_index;
+				wr_data := stage;
+				commit_index <= commit_index + 1;
+				IF (commit_index + 1 = length) THEN
+					commit <= '0';
+				END IF;
+			END IF;
+
+			IF (CS_ACTIVE_I = '0') THEN
+				cmd_received <= '0';
+				tx_hold <= '0';
+				read_pending <= '0';
+				tx_data <= status;
+			ELSIF (RX_VALID_I = '1' and cmd_received = '0') THEN
+				-- Command word
+				cmd_received <= '1';
+				cmd_write <= RX_DATA_I(C_CMD_WRITE_BIT);
+				cmd_crc <= RX_DATA_I(C_CMD_CRC_BIT);
+				length <= unsigned(RX_DATA_I(C_CMD_LENGTH_MSB DOWNTO C_CMD_LENGTH_LSB));
+				count <= (OTHERS => '0');
+				IF (RX_DATA_I(C_CMD_WRITE_BIT) = '0') THEN
+					crc <= crc8(crc8(C_CRC_INIT, RX_DATA_I), tx_data);			-- STATUS of the turnaround word
+				ELSE
+					crc <= crc8(C_CRC_INIT, RX_DATA_I);
+				END IF;
+				address <= unsigned(RX_DATA_I(7 DOWNTO 0));
+				prefetch <= not RX_DATA_I(C_CMD_WRITE_BIT);
+				IF (RX_DATA_I(C_CMD_WRITE_BIT) = '0' and unsigned(RX_DATA_I(7 DOWNTO 4)) = C_BANK_QEI) THEN
+					sample_ready <= '0';
+				END IF;
+			ELSIF (prefetch = '1' or read_pending = '1' or (RX_VALID_I = '1' and cmd_write = '0')) THEN
+				-- Read burst, one word ahead of the SPI. The first word is
+				-- sent after the turnaround word, the crc word after the last one.
+				-- A RAM bank word waits for its channel on the scan.
+				read_pending <= '0';
+				IF (cmd_crc = '0' or count < length) THEN
+					IF (read_ready = '1') THEN
+						tx_data <= read_data;
+						crc <= crc8(crc, read_data);
+						count <= count + 1;
+						address <= address + 1;
+					ELSE
+						read_pending <= '1';
 					END IF;
-				WHEN "100" =>
-					MEMDATA_O <= (OTHERS => '0');
-					IF (RW_I='1' and en_latched='0' and EN_I='1')THEN
-						DATA4_O <= MEMDATA_I(15 DOWNTO 0);
+				ELSIF (count = length) THEN
+					tx_data <= x"00" & crc;
+					count <= count + 1;
+				ELSE
+					tx_data <= status;
+				END IF;
+			ELSIF (RX_VALID_I = '1') THEN
+				-- Write burst
+				IF (cmd_crc = '0') THEN
+					wr_en := true;
+					address <= address + 1;
+				ELSIF (count < length) THEN
+					IF (count < G_NB_CHANNELS) THEN
+						ram_we <= '1';
+						ram_stage <= '1';
+						ram_address <= "0000" & count(3 DOWNTO 0);
+						ram_data <= RX_DATA_I;
 					END IF;
-				WHEN "101" =>
-					MEMDATA_O <= (OTHERS => '0');
-					IF (RW_I='1' and en_latched='0' and EN_I='1')THEN
-						DATA5_O <= MEMDATA_I(15 DOWNTO 0);
+					crc <= crc8(crc, RX_DATA_I);
+					count <= count + 1;
+				ELSIF (count = length) THEN
+					-- crc word, the ack word is sent two words later
+					IF (RX_DATA_I = x"00" & crc and length <= G_NB_CHANNELS) THEN
+						IF (length /= 0) THEN
+							commit <= '1';
+						END IF;
+						commit_index <= (OTHERS => '0');
+						tx_data <= C_CRC_ACK & crc;
+					ELSE
+						crc_errors <= crc_errors + 1;
+						tx_data <= x"00" & crc;
 					END IF;
-				WHEN "110" =>
-					MEMDATA_O <= (OTHERS => '0');
-					IF (RW_I='1' and en_latched='0' and EN_I='1')THEN
-						DATA6_O <= MEMDATA_I(15 DOWNTO 0);
-					END IF;	
-				WHEN "111" =>
-					MEMDATA_O <= (OTHERS => '0');
-					IF (RW_I='1' and en_latched='0' and EN_I='1')THEN
-						DATA7_O <= MEMDATA_I(15 DOWNTO 0);
-					END IF;					
-				WHEN OTHERS => NULL;
-			END CASE;
+					tx_hold <= '1';
+					count <= count + 1;
+				END IF;
+			ELSIF (tx_hold = '0' and cmd_received = '1' and cmd_write = '1') THEN
+				tx_data <= status;
+			END IF;
+
+			IF (wr_en) THEN
+				-- RAM banks a clock later, through the write port register
+				IF (init = '0') THEN
+					ram_we <= '1';
+				END IF;
+				ram_stage <= '0';
+				ram_address <= wr_address;
+				ram_data <= wr_data;
+
+				channel := to_integer(wr_address(3 DOWNTO 0));
+				IF (wr_address = C_REG_CONFIG) THEN
+					config <= wr_data(config'RANGE);
+				ELSIF (wr_address = C_REG_CRC_ERR) THEN
+					crc_errors <= (OTHERS => '0');
+				ELSIF (wr_address = C_REG_QEI_FILTER) THEN
+					qei_filter <= unsigned(wr_data(7 DOWNTO 0));
+				ELSIF (wr_address = C_REG_SAMPLE_PERIOD) THEN
+					sample_period <= wr_data;
+					sample_prescaler <= (OTHERS => '0');
+					sample_count <= (OTHERS => '0');
+					sample_pending <= '0';
+				ELSIF (wr_address = C_REG_IRQ_EN) THEN
+					irq_en <= wr_data(irq_en'RANGE);
+				ELSIF (wr_address = C_REG_VEL_PERIOD) THEN
+					vel_period <= wr_data;
+					vel_prescaler <= (OTHERS => '0');
+					vel_count <= (OTHERS => '0');
+				ELSIF (channel < G_NB_CHANNELS and wr_address(7 DOWNTO 4) = C_BANK_QEI_ERR) THEN
+					qei_errors(channel) <= (OTHERS => '0');
+				END IF;
+			END IF;
+
+			IF (sample) THEN
+				sample_ready <= '1';
+			END IF;
 		END IF;
 	END PROCESS;
-END BEHAVIOR;
\ No newline at end of file
+
+-- Combinational assignments
+	PROCESS(config, sample_ready, qei_fault, ready)
+	BEGIN
+		status <= (OTHERS => '0');
+		status(C_STATUS_PWM_EN) <= config(C_CONFIG_PWM_EN);
+		status(C_STATUS_SAMPLE) <= sample_ready;
+		status(C_STATUS_QEI_FAULT) <= qei_fault;
+		status(C_STATUS_VEL_EN) <= config(C_CONFIG_VEL_EN);
+		status(C_STATUS_READY) <= ready;
+	END PROCESS;
+	PROCESS(qei_errors)
+	BEGIN
+		qei_fault <= '0';
+		FOR i IN 0 TO G_NB_CHANNELS-1 LOOP
+			IF (qei_errors(i) /= 0) THEN
+				qei_fault <= '1';
+			END IF;
+		END LOOP;
+	END PROCESS;
+	TX_DATA_O <= tx_data;
+	SCAN_O <= scan;
+	PWM_DUTY_O <= pwm_duty;
+	PWM_PERIOD_O <= unsigned(pwm_period);
+	PWM_DEADBAND_O <= unsigned(pwm_deadband);
+	PWM_SLEW_O <= unsigned(pwm_slew);
+	PWM_EN_O <= config(C_CONFIG_PWM_EN);
+	VEL_REF_O <= signed(vel_ref);
+	VEL_KP_O <= signed(vel_kp);
+	VEL_KI_O <= signed(vel_ki);
+	VEL_EN_O <= config(C_CONFIG_VEL_EN);
+	QEI_FILTER_O <= qei_filter;
+
+END BEHAVIOR;
@@ -1,57 +1,137 @@
-LIBRARY  ieee; 
-  USE ieee.std_logic_1164.all; 
-  USE ieee.numeric_std.all; 
+LIBRARY  ieee;
+  USE ieee.std_logic_1164.all;
+  USE ieee.numeric_std.all;
 
-	 
-ENTITY PWM_GENERATOR IS 
+-- One PWM channel driving a DRV8872 H-bridge (IN1/IN2).
+-- PWM frequency is CLK_I / (PERIOD_I + 1), the duty resolution is PERIOD_I + 1 steps.
+-- Period, duty and direction are double-buffered: a new value only takes effect
+-- at the end of the current PWM period.
+-- On a direction change, both bridge inputs are held high (brake) during
+-- DEADBAND_I clock cycles before the new direction is driven.
+-- With SLEW_I not zero, the duty loaded at each period boundary moves
+-- towards DUTY_I by at most SLEW_I, crossing zero on a direction change:
+-- the MCU updates are spread as ramps instead of torque steps.
+-- The inputs are only valid while LOAD_I is high (register file channel
+-- scan, see memory_manager.vhd), so the shadow registers are loaded at the
+-- first LOAD_I pulse from the period boundary. The period length is not
+-- affected, the previous duty is kept for up to one scan round.
+
+ENTITY PWM_GENERATOR IS
+	GENERIC (
+		G_WIDTH		: NATURAL := 15												-- period / duty magnitude width
+		);
 	PORT (
 		RESET_I		: IN  	STD_LOGIC;
 		CLK_I      	: IN  	STD_LOGIC;
-		PWM0_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
-		PWM1_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
-		PWM2_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
---		PWM3_VALUE_I: IN UNSIGNED(10 DOWNTO 0);
-		PWM0_O	: OUT  	STD_LOGIC;
-		PWM1_O	: OUT  	STD_LOGIC;
-		PWM2_O	: OUT  	STD_LOGIC
---		PWM3_O	: OUT  	STD_LOGIC
+		PERIOD_I	: IN 	UNSIGNED(G_WIDTH-1 DOWNTO 0);							-- period, in clock cycles minus one
+		DUTY_I		: IN 	STD_LOGIC_VECTOR(G_WIDTH DOWNTO 0);						-- msb = direction, then magnitude
+		DEADBAND_I	: IN 	UNSIGNED(7 DOWNTO 0);									-- direction change dead-band, 0 = none
+		SLEW_I		: IN 	UNSIGNED(G_WIDTH-1 DOWNTO 0);							-- largest duty change per period, 0 = none
+		LOAD_I		: IN 	STD_LOGIC;												-- the inputs above are valid
+		PERIOD_END_O: OUT	STD_LOGIC;												-- one clock pulse at each period boundary
+		IN1_O		: OUT  	STD_LOGIC;
+		IN2_O		: OUT  	STD_LOGIC
 		);
 END PWM_GENERATOR;
 
 ARCHITECTURE BEHAVIOR OF PWM_GENERATOR IS
 
-	SIGNAL counter : UNSIGNED(10 DOWNTO 0);
-	CONSTANT MAX_VALUE : UNSIGNED(10 DOWNTO 0) := to_unsigned(2047,11);
+	SIGNAL counter 			: UNSIGNED(G_WIDTH-1 DOWNTO 0);
+	SIGNAL period_active 	: UNSIGNED(G_WIDTH-1 DOWNTO 0);
+	SIGNAL duty_active 		: UNSIGNED(G_WIDTH-1 DOWNTO 0);
+	SIGNAL sens_active 		: STD_LOGIC;										-- 0 = Forward ; 1 = Reverse
+	SIGNAL deadband_cnt		: UNSIGNED(7 DOWNTO 0);
+	SIGNAL load_pending		: STD_LOGIC;										-- period boundary passed, waiting for LOAD_I
+	SIGNAL pwm				: STD_LOGIC;
+
 	BEGIN
 		PROCESS(RESET_I, CLK_I)
+			VARIABLE target, duty, delta : SIGNED(G_WIDTH+1 DOWNTO 0);					-- signed duties, target - duty fits
+			VARIABLE sens_next : STD_LOGIC;
+			VARIABLE load : BOOLEAN;
 			BEGIN
 				IF (RESET_I = '1') THEN
-					counter <= (OTHERS => '0');			
+					counter <= (OTHERS => '0');
+					period_active <= (OTHERS => '1');
+					duty_active <= (OTHERS => '0');
+					sens_active <= '0';
+					deadband_cnt <= (OTHERS => '0');
+					load_pending <= '0';
+					PERIOD_END_O <= '0';
 				ELSIF (rising_edge(CLK_I)) THEN
-					IF (counter = MAX_VALUE) THEN
+					PERIOD_END_O <= '0';
+					IF (deadband_cnt /= 0) THEN
+						deadband_cnt <= deadband_cnt - 1;
+					END IF;
+
+					load := false;
+					IF (counter >= period_active) THEN
+						-- Period boundary
 						counter <= (OTHERS => '0');
+						PERIOD_END_O <= '1';
+						IF (LOAD_I = '1') THEN
+							load := true;
+						ELSE
+							load_pending <= '1';
+						END IF;
 					ELSE
 						counter <= counter + 1;
+						IF (load_pending = '1' and LOAD_I = '1') THEN
+							load := true;
+						END IF;
+					END IF;
+
+					IF (load) THEN
+						-- Load the shadow registers
+						load_pending <= '0';
+						period_active <= PERIOD_I;
+						target := signed(resize(unsigned(DUTY_I(G_WIDTH-1 DOWNTO 0)), G_WIDTH+2));
+						IF (DUTY_I(G_WIDTH) = '1') THEN
+							target := -target;
+						END IF;
+						duty := signed(resize(duty_active, G_WIDTH+2));
+						IF (sens_active = '1') THEN
+							duty := -duty;
+						END IF;
+						delta := target - duty;
+
+						IF (SLEW_I = 0 or abs(delta) <= signed(resize(SLEW_I, G_WIDTH+2))) THEN
+							-- Target reached
+							duty_active <= unsigned(DUTY_I(G_WIDTH-1 DOWNTO 0));
+							sens_next := DUTY_I(G_WIDTH);
+						ELSE
+							-- One slew step towards the target
+							IF (delta > 0) THEN
+								duty := duty + signed(resize(SLEW_I, G_WIDTH+2));
+							ELSE
+								duty := duty - signed(resize(SLEW_I, G_WIDTH+2));
+							END IF;
+							IF (duty < 0) THEN
+								sens_next := '1';
+								duty := -duty;
+							ELSIF (duty > 0) THEN
+								sens_next := '0';
+							ELSE
+								sens_next := sens_active;
+							END IF;
+							duty_active <= unsigned(duty(G_WIDTH-1 DOWNTO 0));
+						END IF;
+
+						sens_active <= sens_next;
+						IF (sens_next /= sens_active) THEN
+							deadband_cnt <= DEADBAND_I;
+						END IF;
 					END IF;
 				END IF;
 		END PROCESS;
-				
-		PWM0_O <= 	'0' WHEN RESET_I='1' ELSE
-					'1' WHEN PWM0_VALUE_I >= MAX_VALUE ELSE
-					'1' WHEN counter <= PWM0_VALUE_I ELSE '0';
-					
-		PWM1_O <= 	'0' WHEN RESET_I='1' ELSE
-					'0' WHEN PWM1_VALUE_I = to_unsigned(0,12) ELSE 
-					'1' WHEN PWM1_VALUE_I >= MAX_VALUE ELSE
-					'1' WHEN counter <= PWM1_VALUE_I ELSE '0';
-					
-		PWM2_O <= 	'0' WHEN RESET_I='1' ELSE
-					'0' WHEN PWM2_VALUE_I = to_unsigned(0,12) ELSE 
-					'1' WHEN PWM2_VALUE_I >= MAX_VALUE ELSE
-					'1' WHEN counter <= PWM2_VALUE_I ELSE '0';	
-
-		--PWM3_O <= 	'0' WHEN RESET_I='1' ELSE
-					--'0' WHEN PWM3_VALUE_I = to_unsigned(0,12) ELSE 
-					--'1' WHEN PWM3_VALUE_I >= MAX_VALUE ELSE
-					--'1' WHEN counter <= PWM3_VALUE_I ELSE '0';	
-END BEHAVIOR;
\ No newline at end of file
+
+		pwm <= 	'0' WHEN duty_active = 0 ELSE
+				'1' WHEN duty_active >= period_active ELSE
+				'1' WHEN counter < duty_active ELSE '0';
+
+		-- Driven logic of DRV8872, both inputs high = brake
+		IN1_O <= 	'1' WHEN RESET_I = '1' OR deadband_cnt /= 0 ELSE
+					not pwm WHEN sens_active = '0' ELSE '1';
+		IN2_O <= 	'1' WHEN RESET_I = '1' OR deadband_cnt /= 0 ELSE
+					not pwm WHEN sens_active = '1' ELSE '1';
+END BEHAVIOR;
@@ -1,76 +1,137 @@
-LIBRARY  ieee; 
-  USE ieee.std_logic_1164.all; 
-  USE ieee.std_logic_unsigned.all; 
-  USE ieee.numeric_std.all; 
-  
-ENTITY SIMPLE_SPI IS 
-	PORT (		
+LIBRARY  ieee;
+  USE ieee.std_logic_1164.all;
+  USE ieee.numeric_std.all;
+
+-- SPI slave, mode 0 (CPOL = 0, CPHA = 0), 16-bit words, msb first.
+-- Several words can be exchanged in one chip-select window.
+-- TX_DATA_I is taken when a word completes and shifted out during the
+-- next word; the first word of a window shifts out TX_DATA_I as it was
+-- when SS_I fell.
+--
+-- The shift registers run directly on SCLK_I (rising edge = sample,
+-- falling edge = shift out), so the link speed is not bound to CLK_I.
+-- SS_I high asynchronously clears the SCLK domain between windows.
+-- A completed word is handed to the CLK_I domain through a toggle and
+-- a 3-flop synchronizer; SS_I goes through the same synchronizer depth
+-- so CS_ACTIVE_O never falls before the last RX_VALID_O of a window.
+-- TX_DATA_I is sampled in the SCLK domain: it must not change during the
+-- last bit of a word, which the register file guarantees by updating it
+-- right after RX_VALID_O.
+-- Constraints: SS_I high for at least 4 CLK_I periods between windows,
+-- 16 SCLK_I periods longer than 4 CLK_I periods (SCLK_I < 500 MHz at 133 MHz).
+
+ENTITY SIMPLE_SPI IS
+	PORT (
 		RESET_I			:	IN	STD_LOGIC;
 		CLK_I     		:	IN	STD_LOGIC;
 		SCLK_I   		:	IN	STD_LOGIC;
 		SS_I    		:	IN	STD_LOGIC;
 		MOSI_I  		:	IN	STD_LOGIC;
 		MISO_O			:	OUT	STD_LOGIC;
-		DATA_TO_TX_O  	: 	IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
-		TX_LOAD_I		:	IN	STD_LOGIC;
+		TX_DATA_I	  	: 	IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
 		RX_DATA_O	 	: 	OUT STD_LOGIC_VECTOR(15 DOWNTO 0);
-		IRQ_O			:	OUT	STD_LOGIC
+		RX_VALID_O		:	OUT	STD_LOGIC;										-- one clock pulse per received word
+		CS_ACTIVE_O		:	OUT	STD_LOGIC										-- 1 while SS_I is low
 	);
 END SIMPLE_SPI;
 
 ARCHITECTURE BEHAVIORAL OF SIMPLE_SPI IS
 
-	SIGNAL rx_data 				: STD_LOGIC_VECTOR(15 DOWNTO 0);
-	SIGNAL index				: NATURAL RANGE 0 TO 15;
-	SIGNAL tx_data 				: STD_LOGIC_VECTOR(15 DOWNTO 0);
-	SIGNAL sclk_latched 		: STD_LOGIC;
-	SIGNAL sclk_buffered 		: STD_LOGIC;
-	SIGNAL ss_latched 			: STD_LOGIC;
-	SIGNAL mosi_latched			: STD_LOGIC;
-	SIGNAL tx_load_latched		: STD_LOGIC;
-	SIGNAL tx_load_buffered		: STD_LOGIC;
-	
+	-- SCLK domain
+	SIGNAL spi_reset			: STD_LOGIC;
+	SIGNAL rx_shift 			: STD_LOGIC_VECTOR(14 DOWNTO 0);
+	SIGNAL rx_hold 				: STD_LOGIC_VECTOR(15 DOWNTO 0);					-- last completed word
+	SIGNAL index				: UNSIGNED(3 DOWNTO 0);
+	SIGNAL tx_shift 			: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL tx_next 				: STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL tx_started			: STD_LOGIC;										-- 0 = first bit comes from TX_DATA_I
+	SIGNAL word_done			: STD_LOGIC;
+	SIGNAL done_toggle			: STD_LOGIC;
+
+	-- CLK domain
+	SIGNAL done_sync			: STD_LOGIC_VECTOR(2 DOWNTO 0);
+	SIGNAL done_latched			: STD_LOGIC;
+	SIGNAL ss_sync				: STD_LOGIC_VECTOR(2 DOWNTO 0);
+
 	BEGIN
-	
-	PROCESS(CLK_i, RESET_i)	
+
+	spi_reset <= RESET_I or SS_I;
+
+	-- Receive: sample MOSI on rising edges
+	PROCESS(SCLK_I, spi_reset)
 		BEGIN
-			IF(RESET_i = '1') THEN
-				rx_data <= (OTHERS => '0');
-				index <= 0;
-				tx_data <= (OTHERS => '0');
-				IRQ_O <= '1';
-				sclk_latched <= '0';
-				sclk_buffered <= '0';
-				ss_latched <= '0';
-				mosi_latched <= '0';
-				tx_load_latched <= '0';
-			ELSIF( rising_edge(CLK_I) ) THEN
-				sclk_latched <= SCLK_I;
-				sclk_buffered <= sclk_latched;
-				ss_latched <= SS_I;
-				mosi_latched <= MOSI_i;
-				tx_load_latched <= TX_LOAD_I;
-				tx_load_buffered <= tx_load_latched;
-				
-				IF(tx_load_buffered = '0' and tx_load_latched = '1') THEN
-					tx_data <= DATA_TO_TX_O;
+			IF(spi_reset = '1') THEN
+				rx_shift <= (OTHERS => '0');
+				index <= (OTHERS => '0');
+				word_done <= '0';
+			ELSIF( rising_edge(SCLK_I) ) THEN
+				rx_shift <= rx_shift(13 DOWNTO 0) & MOSI_I;
+				index <= index + 1;
+				word_done <= '0';
+				IF(index = 15) THEN
+					word_done <= '1';
 				END IF;
+			END IF;
+	END PROCESS;
 
-				IF( ss_latched = '0' ) THEN
-					IF(sclk_buffered = '0' and sclk_latched = '1') THEN
-						IRQ_O <= '0';
-						rx_data <= rx_data(14 DOWNTO 0) & mosi_latched;
-					ELSIF(sclk_buffered = '1' and sclk_latched = '0') THEN
-						tx_data <= tx_data(14 DOWNTO 0) & '0';
-					END IF;
+	-- Completed word and next word to send, kept across chip-select windows
+	PROCESS(SCLK_I, RESET_I)
+		BEGIN
+			IF(RESET_I = '1') THEN
+				rx_hold <= (OTHERS => '0');
+				tx_next <= (OTHERS => '0');
+				done_toggle <= '0';
+			ELSIF( rising_edge(SCLK_I) ) THEN
+				IF(SS_I = '0' and index = 15) THEN
+					rx_hold <= rx_shift & MOSI_I;
+					tx_next <= TX_DATA_I;
+					done_toggle <= not done_toggle;
+				END IF;
+			END IF;
+	END PROCESS;
+
+	-- Transmit: shift MISO on falling edges
+	PROCESS(SCLK_I, spi_reset)
+		BEGIN
+			IF(spi_reset = '1') THEN
+				tx_shift <= (OTHERS => '0');
+				tx_started <= '0';
+			ELSIF( falling_edge(SCLK_I) ) THEN
+				tx_started <= '1';
+				IF(tx_started = '0') THEN
+					tx_shift <= TX_DATA_I(14 DOWNTO 0) & '0';
+				ELSIF(word_done = '1') THEN
+					tx_shift <= tx_next;
 				ELSE
-					IRQ_O <= '1';
+					tx_shift <= tx_shift(14 DOWNTO 0) & '0';
+				END IF;
+			END IF;
+	END PROCESS;
+
+	MISO_O <= TX_DATA_I(15) WHEN tx_started = '0' ELSE tx_shift(15);
+
+	-- Clock domain crossing
+	PROCESS(CLK_I, RESET_I)
+		BEGIN
+			IF(RESET_I = '1') THEN
+				done_sync <= (OTHERS => '0');
+				done_latched <= '0';
+				ss_sync <= (OTHERS => '1');
+				RX_DATA_O <= (OTHERS => '0');
+				RX_VALID_O <= '0';
+			ELSIF( rising_edge(CLK_I) ) THEN
+				done_sync <= done_sync(1 DOWNTO 0) & done_toggle;
+				done_latched <= done_sync(2);
+				ss_sync <= ss_sync(1 DOWNTO 0) & SS_I;
+				RX_VALID_O <= '0';
+				IF(done_sync(2) /= done_latched) THEN
+					RX_DATA_O <= rx_hold;									-- stable for the next 16 SCLK periods
+					RX_VALID_O <= '1';
 				END IF;
 			END IF;
 	END PROCESS;
 
 -- Combinational assignments
-	MISO_O <= tx_data(15);
-	RX_DATA_O <= rx_data;
-	
-END BEHAVIORAL;
\ No newline at end of file
+	CS_ACTIVE_O <= not ss_sync(2);
+
+END BEHAVIORAL;
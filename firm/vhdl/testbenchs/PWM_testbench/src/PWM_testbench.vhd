@@ -1,43 +1,48 @@
 LIBRARY ieee;
 USE ieee.std_logic_1164.ALL;
-USE ieee.std_logic_unsigned.all;
+USE ieee.numeric_std.ALL;
+LIBRARY work;
+USE work.holoboard_pkg.ALL;
+USE work.spi_master_bfm_pkg.ALL;
+
+-- Self-checking test of the motor outputs of HOLOBOARD: duty and direction
+-- written through the SPI register file, bridge inputs measured against
+-- the DRV8872 truth table (IN1/IN2 low = driven, both high = brake),
+-- dead-band and slew limited ramps timed in PWM periods, bridges driven
+-- by the velocity loop.
+-- Run with "make PWM_testbench" from the testbenchs directory.
 
 ENTITY PWM_testbench IS END;
 
 ARCHITECTURE BEHAVIOR OF PWM_testbench IS
-	COMPONENT HOLOBOARD IS 
+	COMPONENT HOLOBOARD IS
+		GENERIC (
+			G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+			);
 		PORT (
 			RESET_I		: IN  	STD_LOGIC;
-			SPI_CLK_I   : INOUT	STD_LOGIC;
+			SPI_CLK_I   : IN	STD_LOGIC;
 			SPI_SS_I    : IN 	STD_LOGIC;
-			SPI_MOSI_I  : INOUT	STD_LOGIC;
-			SPI_MISO_O	: INOUT	STD_LOGIC;
-			QE0_CHA_I	: IN 	STD_LOGIC;
-			QE0_CHB_I	: IN 	STD_LOGIC;
-			QE1_CHA_I	: IN 	STD_LOGIC;
-			QE1_CHB_I	: IN 	STD_LOGIC;
-			QE2_CHA_I	: IN 	STD_LOGIC;
-			QE2_CHB_I	: IN 	STD_LOGIC;
-			QE3_CHA_I	: IN 	STD_LOGIC;
-			QE3_CHB_I	: IN 	STD_LOGIC;
-			HOLD_QEx_I	: IN 	STD_LOGIC;
-			PWM0_IN1_O	: OUT	STD_LOGIC;
-			PWM0_IN2_O	: OUT	STD_LOGIC;
-			PWM1_IN1_O	: OUT	STD_LOGIC;
-			PWM1_IN2_O	: OUT	STD_LOGIC;
-			PWM2_IN1_O	: OUT	STD_LOGIC;	
-			PWM2_IN2_O	: OUT	STD_LOGIC;
-			PWM3_IN1_O	: OUT	STD_LOGIC;
-			PWM3_IN2_O	: OUT	STD_LOGIC
+			SPI_MOSI_I  : IN	STD_LOGIC;
+			SPI_MISO_O	: OUT	STD_LOGIC;
+			QE_CHA_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			QE_CHB_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			PWM_IN1_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			PWM_IN2_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			IRQ_O		: OUT	STD_LOGIC
 			);
 	END COMPONENT;
-	
+
+	CONSTANT SPI_PERIOD : TIME := 83.333 ns;												-- 12 MHz
+	CONSTANT CLK_PERIOD : TIME := 1 us / 133.0;											-- OSCH model
+	CONSTANT C_PERIOD : NATURAL := 99;													-- 100 clocks per PWM period
+	CONSTANT C_REVERSE : STD_LOGIC_VECTOR(15 DOWNTO 0) := x"8000";
+
 	SIGNAL reset, spi_ss : std_logic := '1';
-	SIGNAL qe0_a,qe0_b,qe1_a,qe1_b : std_logic := '0';
-	SIGNAL spi_clk, spi_mosi, spi_miso : std_logic := '1';
-	SIGNAl hold	: std_logic := '0';
-	SIGNAl pwm0, pwm1, pwm2, pwm3 : std_logic := '0';
-	
+	SIGNAL spi_clk, spi_mosi, spi_miso : std_logic := '0';
+	SIGNAL in1, in2 : std_logic_vector(0 TO C_NB_CHANNELS-1);
+	SIGNAL qe_idle : std_logic_vector(0 TO C_NB_CHANNELS-1) := (OTHERS => '0');
+
 BEGIN
 	-- Instantiate the Unit Under Test (UUT)
 	UUT : HOLOBOARD
@@ -46,57 +51,132 @@ BEGIN
 				SPI_SS_I => spi_ss,
 				SPI_MOSI_I => spi_mosi,
 				SPI_MISO_O => spi_miso,
-				QE0_CHA_I => qe0_a,
-				QE0_CHB_I => qe0_b,
-				QE1_CHA_I => qe0_b,
-				QE1_CHB_I => qe0_a,
-				QE2_CHA_I => qe1_a,
-				QE2_CHB_I => qe1_b,
-				QE3_CHA_I => qe1_b,
-				QE3_CHB_I => qe1_a,
-				HOLD_QEx_I => hold,
-				PWM0_IN1_O => pwm0,
- 				PWM1_IN1_O => pwm1,
- 				PWM2_IN1_O => pwm2,	
- 				PWM3_IN1_O => pwm3);
-				
+				QE_CHA_I => qe_idle,
+				QE_CHB_I => qe_idle,
+				PWM_IN1_O => in1,
+				PWM_IN2_O => in2,
+				IRQ_O => OPEN);
+
 	PROCESS
+		VARIABLE status : STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE errors : NATURAL := 0;
+		VARIABLE t_release : TIME;
+		VARIABLE low_clocks, ramp_periods : NATURAL;
+
+		-- Percentage of time each bridge input is low over 10 PWM periods
+		PROCEDURE check_duty(ch : IN NATURAL; in1_low, in2_low : IN NATURAL; what : IN STRING) IS
+			CONSTANT STEP : TIME := CLK_PERIOD / 8;
+			CONSTANT SAMPLES : NATURAL := 10 * (C_PERIOD + 1) * 8;
+			VARIABLE low1, low2 : NATURAL := 0;
+		BEGIN
+			-- Let the double-buffered registers take effect
+			WAIT FOR 2 * (C_PERIOD + 1) * CLK_PERIOD;
+			FOR i IN 1 TO SAMPLES LOOP
+				WAIT FOR STEP;
+				IF (in1(ch) = '0') THEN low1 := low1 + 1; END IF;
+				IF (in2(ch) = '0') THEN low2 := low2 + 1; END IF;
+			END LOOP;
+			-- One clock of tolerance per period
+			IF (abs(low1 * 100 / SAMPLES - in1_low) > 1) THEN
+				tb_check(low1 * 100 / SAMPLES, in1_low, what & ", IN1 low %", errors);
+			END IF;
+			IF (abs(low2 * 100 / SAMPLES - in2_low) > 1) THEN
+				tb_check(low2 * 100 / SAMPLES, in2_low, what & ", IN2 low %", errors);
+			END IF;
+		END PROCEDURE;
+
+		PROCEDURE write_reg(address : IN NATURAL; value : IN STD_LOGIC_VECTOR(15 DOWNTO 0)) IS
+		BEGIN
+			spi_write(address, (0 => value), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		END PROCEDURE;
+
 	BEGIN
 		WAIT FOR 1 us;
-			reset <= '0';
+		reset <= '0';
 		WAIT FOR 100 ns;
-			spi_ss <= '0';
-		WAIT for 40us;
-			spi_ss <= '1';
+
+		-- Bridges braked until enabled
+		FOR ch IN 0 TO C_NB_CHANNELS-1 LOOP
+			write_reg(16#30# + ch, std_logic_vector(to_unsigned(C_PERIOD, 16)));
+		END LOOP;
+		write_reg(16#20#, std_logic_vector(to_unsigned(50, 16)));
+		check_duty(0, 0, 0, "disabled");
+		write_reg(to_integer(C_REG_CONFIG), x"0001");
+
+		-- Forward drives IN1, reverse drives IN2
+		write_reg(16#20#, std_logic_vector(to_unsigned(25, 16)));
+		write_reg(16#21#, C_REVERSE or std_logic_vector(to_unsigned(60, 16)));
+		write_reg(16#22#, x"0000");
+		check_duty(0, 25, 0, "channel 0 forward 25%");
+		check_duty(1, 0, 60, "channel 1 reverse 60%");
+		check_duty(2, 0, 0, "channel 2 zero duty");
+
+		-- Duty at or above the period is fully on
+		write_reg(16#22#, std_logic_vector(to_unsigned(C_PERIOD + 1, 16)));
+		check_duty(2, 100, 0, "channel 2 full duty");
+		write_reg(16#22#, C_REVERSE or x"7FFF");
+		check_duty(2, 0, 100, "channel 2 saturated reverse");
+
+		-- Dead-band: both inputs high for 50 clocks on a direction change
+		write_reg(16#40#, std_logic_vector(to_unsigned(50, 16)));
+		write_reg(16#20#, std_logic_vector(to_unsigned(C_PERIOD + 1, 16)));
+		check_duty(0, 100, 0, "channel 0 before direction change");
+		write_reg(16#20#, C_REVERSE or std_logic_vector(to_unsigned(C_PERIOD + 1, 16)));
+		WAIT UNTIL in1(0) = '1';
+		t_release := now;
+		WAIT UNTIL in2(0) = '0';
+		tb_check((now - t_release + CLK_PERIOD/2) / CLK_PERIOD, 50, "dead-band clocks", errors);
+		check_duty(0, 0, 100, "channel 0 after direction change");
+
+		-- Slew limit: 10 steps per period, zero to full duty in 10 periods.
+		-- The ramp is over once IN1 stays low for a whole period.
+		write_reg(16#22#, x"0000");
+		write_reg(16#62#, std_logic_vector(to_unsigned(10, 16)));
+		check_duty(2, 0, 0, "channel 2 stopped");
+		write_reg(16#22#, std_logic_vector(to_unsigned(C_PERIOD + 1, 16)));
+		t_release := now;
+		low_clocks := 0;
+		WHILE (low_clocks <= C_PERIOD + 1) LOOP
+			WAIT FOR CLK_PERIOD;
+			IF (in1(2) = '0') THEN
+				low_clocks := low_clocks + 1;
+			ELSE
+				low_clocks := 0;
+			END IF;
+			EXIT WHEN now - t_release > 20 * (C_PERIOD + 1) * CLK_PERIOD;
+		END LOOP;
+		ramp_periods := (now - t_release) / ((C_PERIOD + 1) * CLK_PERIOD) - 1;
+		IF (ramp_periods < 9 or ramp_periods > 10) THEN
+			tb_check(ramp_periods, 10, "slew ramp periods", errors);
+		END IF;
+
+		-- Full forward to full reverse ramps through zero, then holds
+		write_reg(16#22#, C_REVERSE or std_logic_vector(to_unsigned(C_PERIOD + 1, 16)));
+		WAIT FOR 20 * (C_PERIOD + 1) * CLK_PERIOD;
+		check_duty(2, 0, 100, "channel 2 slewed to reverse");
+
+		-- Velocity loop, encoders still: proportional only, the duty is
+		-- KP * VEL_REF / 256 once the first tick (10 us) is done
+		write_reg(to_integer(C_REG_VEL_PERIOD), std_logic_vector(to_unsigned(10, 16)));
+		write_reg(16#70#, std_logic_vector(to_unsigned(256, 16)));
+		write_reg(16#71#, std_logic_vector(to_signed(-512, 16)));
+		write_reg(16#80#, std_logic_vector(to_unsigned(25, 16)));
+		write_reg(16#81#, std_logic_vector(to_unsigned(20, 16)));
+		write_reg(to_integer(C_REG_CONFIG), x"0003");
+		WAIT FOR 20 us;
+		check_duty(0, 25, 0, "channel 0 velocity loop forward 25%");
+		check_duty(1, 0, 40, "channel 1 velocity loop reverse 40%");
+		write_reg(to_integer(C_REG_CONFIG), x"0001");
+
+		-- Disabling brakes all the bridges
+		write_reg(to_integer(C_REG_CONFIG), x"0000");
+		FOR ch IN 0 TO C_NB_CHANNELS-1 LOOP
+			check_duty(ch, 0, 0, "disabled again");
+		END LOOP;
+
+		tb_end("PWM_testbench", errors);
+		std.env.finish;
 		WAIT;
 	END PROCESS;
-	
-
-	WITH spi_ss SELECT 
-		spi_clk <= 	not spi_clk after 500 ns when '0',
-					'0' WHEN OTHERS;
-	
-	
-	PROCESS(spi_clk)
-	VARIABLE index : integer :=31;
-	BEGIN
-		IF(rising_edge(spi_clk)) THEN
-			CASE index IS
-				WHEN 31 => 
-					spi_mosi <= '1';
-				WHEN 26 => 
-					spi_mosi <= '1';
-					hold <= '1';	
-				WHEN 24 => spi_mosi <= '1';	   	 --address 0101
-				WHEN 10 => spi_mosi <= '1';
-				WHEN OTHERS => 
-					spi_mosi <= '0';
-					hold <= '0';
-			END CASE;
-				IF(index>0) THEN
-					index:=index-1;
-				END IF;
-		END IF;
-	END PROCESS;	
 
-END BEHAVIOR;
\ No newline at end of file
+END BEHAVIOR;
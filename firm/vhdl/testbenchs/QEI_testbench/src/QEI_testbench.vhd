@@ -1,42 +1,50 @@
 LIBRARY ieee;
 USE ieee.std_logic_1164.ALL;
-USE ieee.std_logic_unsigned.all;
+USE ieee.numeric_std.ALL;
+LIBRARY work;
+USE work.holoboard_pkg.ALL;
+USE work.spi_master_bfm_pkg.ALL;
+
+-- Self-checking test of the encoder path of HOLOBOARD: quadrature streams
+-- up to a 33 MHz edge rate in both directions, counters read back through
+-- the SPI register file and compared to the number of generated edges.
+-- Glitches shorter than the filter and illegal transitions (both channels
+-- changing at once) must not be counted, the latter are counted as errors.
+-- Sampling mode: counters frozen between samples, IRQ_O on each sample and
+-- on the first encoder error, samples held off while chip-select is active.
+-- Run with "make QEI_testbench" from the testbenchs directory.
 
 ENTITY QEI_testbench IS END;
 
 ARCHITECTURE BEHAVIOR OF QEI_testbench IS
-	COMPONENT HOLOBOARD IS 
+	COMPONENT HOLOBOARD IS
+		GENERIC (
+			G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+			);
 		PORT (
 			RESET_I		: IN  	STD_LOGIC;
-			SPI_CLK_I   : INOUT	STD_LOGIC;
+			SPI_CLK_I   : IN	STD_LOGIC;
 			SPI_SS_I    : IN 	STD_LOGIC;
-			SPI_MOSI_I  : INOUT	STD_LOGIC;
-			SPI_MISO_O	: INOUT	STD_LOGIC;
-			QE0_CHA_I	: IN 	STD_LOGIC;
-			QE0_CHB_I	: IN 	STD_LOGIC;
-			QE1_CHA_I	: IN 	STD_LOGIC;
-			QE1_CHB_I	: IN 	STD_LOGIC;
-			QE2_CHA_I	: IN 	STD_LOGIC;
-			QE2_CHB_I	: IN 	STD_LOGIC;
-			QE3_CHA_I	: IN 	STD_LOGIC;
-			QE3_CHB_I	: IN 	STD_LOGIC;
-			HOLD_QEx_I	: IN 	STD_LOGIC
-			--PWM0_IN1_o	: OUT	STD_LOGIC;
-			--PWM0_IN2_o	: OUT	STD_LOGIC;
-			--PWM1_IN1_o	: OUT	STD_LOGIC;
-			--PWM1_IN2_o	: OUT	STD_LOGIC;
-			--PWM2_IN1_o	: OUT	STD_LOGIC;	
-			--PWM2_IN2_o	: OUT	STD_LOGIC;
-			--PWM3_IN1_o	: OUT	STD_LOGIC;
-			--PWM3_IN2_o	: OUT	STD_LOGIC
+			SPI_MOSI_I  : IN	STD_LOGIC;
+			SPI_MISO_O	: OUT	STD_LOGIC;
+			QE_CHA_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			QE_CHB_I	: IN 	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			PWM_IN1_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			PWM_IN2_O	: OUT	STD_LOGIC_VECTOR(0 TO G_NB_CHANNELS-1);
+			IRQ_O		: OUT	STD_LOGIC
 			);
 	END COMPONENT;
-	
+
+	CONSTANT SPI_PERIOD : TIME := 83.333 ns;												-- 12 MHz
+	CONSTANT C_COUNTS_PER_CYCLE : INTEGER := 4;											-- all CHA and CHB edges
+	CONSTANT C_COUNTER_MOD : INTEGER := 4096;											-- 12-bit counters
+
 	SIGNAL reset, spi_ss : std_logic := '1';
-	SIGNAL qe0_a,qe0_b,qe1_a,qe1_b : std_logic := '0';
 	SIGNAL spi_clk, spi_mosi, spi_miso : std_logic := '0';
-	SIGNAl hold	: std_logic := '0';
-	
+	SIGNAL qe_a, qe_b : std_logic_vector(0 TO C_NB_CHANNELS-1) := (OTHERS => '0');
+	SIGNAL irq : std_logic;
+	SIGNAL irq_count : NATURAL := 0;													-- IRQ_O pulses
+
 BEGIN
 	-- Instantiate the Unit Under Test (UUT)
 	UUT : HOLOBOARD
@@ -45,63 +53,208 @@ BEGIN
 				SPI_SS_I => spi_ss,
 				SPI_MOSI_I => spi_mosi,
 				SPI_MISO_O => spi_miso,
-				QE0_CHA_I => qe0_a,
-				QE0_CHB_I => qe0_b,
-				QE1_CHA_I => qe0_b,
-				QE1_CHB_I => qe0_a,
-				QE2_CHA_I => qe1_a,
-				QE2_CHB_I => qe1_b,
-				QE3_CHA_I => qe1_b,
-				QE3_CHB_I => qe1_a,
-				HOLD_QEx_I => hold
-				);
-				
-	-- Generate signal to test counting and decounting with two rates
-	qe0_a <= not qe0_a after 100 ns;
-	qe0_b <= qe0_a after 50 ns;
-  	qe1_a <= not qe1_a after 1 us;
-	qe1_b <= qe1_a after 500 ns;
+				QE_CHA_I => qe_a,
+				QE_CHB_I => qe_b,
+				PWM_IN1_O => OPEN,
+				PWM_IN2_O => OPEN,
+				IRQ_O => irq);
+
+	PROCESS(irq)
+	BEGIN
+		IF (rising_edge(irq)) THEN
+			irq_count <= irq_count + 1;
+		END IF;
+	END PROCESS;
 
 	PROCESS
+		VARIABLE expected : INTEGER_VECTOR(0 TO C_NB_CHANNELS-1) := (OTHERS => 0);
+		VARIABLE sampled : INTEGER_VECTOR(0 TO C_NB_CHANNELS-1);
+		VARIABLE data : T_WORD_ARRAY(0 TO C_NB_CHANNELS-1);
+		VARIABLE word : T_WORD_ARRAY(0 TO 0);
+		VARIABLE status : STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE errors : NATURAL := 0;
+		VARIABLE irqs : NATURAL;
+		VARIABLE sample_time : TIME;
+
+		-- Quadrature cycles on one channel, positive = CHA leads CHB
+		PROCEDURE quadrature(ch : IN NATURAL; cycles : IN INTEGER; edge : IN TIME) IS
+			VARIABLE state : INTEGER;
+		BEGIN
+			FOR i IN 1 TO 4 * abs(cycles) LOOP
+				-- Gray sequence (A,B): 00 -> 10 -> 11 -> 01
+				IF (qe_a(ch) = '0' and qe_b(ch) = '0') THEN state := 0;
+				ELSIF (qe_a(ch) = '1' and qe_b(ch) = '0') THEN state := 1;
+				ELSIF (qe_a(ch) = '1' and qe_b(ch) = '1') THEN state := 2;
+				ELSE state := 3;
+				END IF;
+				IF (cycles > 0) THEN
+					state := (state + 1) MOD 4;
+				ELSE
+					state := (state + 3) MOD 4;
+				END IF;
+				IF (state = 1 or state = 2) THEN qe_a(ch) <= '1'; ELSE qe_a(ch) <= '0'; END IF;
+				IF (state = 2 or state = 3) THEN qe_b(ch) <= '1'; ELSE qe_b(ch) <= '0'; END IF;
+				WAIT FOR edge;
+			END LOOP;
+			expected(ch) := expected(ch) + cycles * C_COUNTS_PER_CYCLE;
+		END PROCEDURE;
+
+		PROCEDURE check_counters(what : IN STRING) IS
+		BEGIN
+			WAIT FOR 100 ns;
+			spi_read(to_integer(C_BANK_QEI) * 16, data, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				tb_check(to_integer(unsigned(data(i))) MOD C_COUNTER_MOD, expected(i) MOD C_COUNTER_MOD,
+					what & ", QEI" & integer'image(i), errors);
+			END LOOP;
+		END PROCEDURE;
+
+		PROCEDURE check_status(what : IN STRING; bit : IN NATURAL; expected_bit : IN STD_LOGIC) IS
+		BEGIN
+			spi_read(to_integer(C_REG_STATUS), word, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(word(0)(bit) = expected_bit, true, what, errors);
+		END PROCEDURE;
+
+		PROCEDURE check_errors(what : IN STRING; expected_errors : IN INTEGER_VECTOR) IS
+		BEGIN
+			spi_read(to_integer(C_BANK_QEI_ERR) * 16, data, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				tb_check(to_integer(unsigned(data(i))), expected_errors(i),
+					what & ", QEI" & integer'image(i) & " errors", errors);
+			END LOOP;
+		END PROCEDURE;
+
+		-- Pulse on one input, from and back to 0
+		PROCEDURE glitch(SIGNAL input : OUT STD_LOGIC; width : IN TIME) IS
+		BEGIN
+			input <= '1';
+			WAIT FOR width;
+			input <= '0';
+			WAIT FOR 1 us;
+		END PROCEDURE;
+
 	BEGIN
 		WAIT FOR 1 us;
-			reset <= '0';
+		reset <= '0';
+		WAIT FOR 100 ns;
+		check_counters("after reset");
+
+		-- Slow, both directions
+		quadrature(0, 10, 1 us);
+		quadrature(1, -10, 1 us);
+		quadrature(2, 5, 1 us);
+		quadrature(2, -8, 1 us);
+		check_counters("1 MHz edges");
+
+		-- Fast, down to 4 FPGA clocks between edges
+		quadrature(0, 200, 100 ns);
+		quadrature(1, -300, 50 ns);
+		quadrature(2, 500, 30 ns);
+		check_counters("fast edges");
+		check_errors("fast edges", (0, 0, 0));
+
+		-- Shorter than the default filter
+		glitch(qe_a(0), 10 ns);
+		glitch(qe_b(1), 10 ns);
+		check_counters("glitches");
+		check_errors("glitches", (0, 0, 0));
+
+		-- Both channels at once: 00 -> 11 -> 00
+		qe_a(1) <= '1';
+		qe_b(1) <= '1';
+		WAIT FOR 1 us;
+		qe_a(1) <= '0';
+		qe_b(1) <= '0';
+		WAIT FOR 1 us;
+		check_counters("illegal transitions");
+		check_errors("illegal transitions", (0, 2, 0));
+
+		-- Any write clears
+		spi_write(to_integer(C_BANK_QEI_ERR) * 16 + 1, (0 => x"0000"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		check_errors("errors cleared", (0, 0, 0));
+
+		-- Longer filter, 16 clocks
+		spi_read(to_integer(C_REG_QEI_FILTER), word, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		tb_check(to_integer(unsigned(word(0))), C_QEI_FILTER_RESET, "filter reset value", errors);
+		spi_write(to_integer(C_REG_QEI_FILTER), (0 => x"000F"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		spi_read(to_integer(C_REG_QEI_FILTER), word, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		tb_check(to_integer(unsigned(word(0))), 15, "filter written", errors);
+		glitch(qe_a(2), 100 ns);
+		quadrature(2, 3, 1 us);
+		quadrature(2, -1, 1 us);
+		check_counters("long filter");
+		spi_write(to_integer(C_REG_QEI_FILTER), (0 => std_logic_vector(to_unsigned(C_QEI_FILTER_RESET, 16))),
+			status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+
+		-- Counters wrap around
+		quadrature(0, -(C_COUNTER_MOD / C_COUNTS_PER_CYCLE + 100), 30 ns);
+		quadrature(1, C_COUNTER_MOD / C_COUNTS_PER_CYCLE + 100, 30 ns);
+		check_counters("wrap around");
+
+		-- Fault interrupt: once, on the first error
+		spi_write(to_integer(C_REG_IRQ_EN), (0 => x"0002"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		irqs := irq_count;
+		qe_a(2) <= '1';
+		qe_b(2) <= '1';
+		WAIT FOR 1 us;
+		qe_a(2) <= '0';
+		qe_b(2) <= '0';
+		WAIT FOR 1 us;
+		tb_check(irq_count - irqs, 1, "fault interrupts", errors);
+		check_status("STATUS.QEI_FAULT set", C_STATUS_QEI_FAULT, '1');
+		spi_write(to_integer(C_BANK_QEI_ERR) * 16 + 2, (0 => x"0000"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		check_status("STATUS.QEI_FAULT cleared", C_STATUS_QEI_FAULT, '0');
+		check_counters("fault interrupt");
+
+		-- Sampling every 50 us: counters frozen in between
+		spi_write(to_integer(C_REG_IRQ_EN), (0 => x"0001"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		spi_write(to_integer(C_REG_SAMPLE_PERIOD), (0 => x"0032"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		WAIT UNTIL irq = '1';
+		sample_time := now;
+		sampled := expected;
+		quadrature(0, 2, 1 us);
+		quadrature(1, -1, 1 us);
+		spi_read(to_integer(C_BANK_QEI) * 16, data, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+			tb_check(to_integer(unsigned(data(i))) MOD C_COUNTER_MOD, sampled(i) MOD C_COUNTER_MOD,
+				"between samples, QEI" & integer'image(i), errors);
+		END LOOP;
+		check_status("STATUS.SAMPLE cleared by the read", C_STATUS_SAMPLE, '0');
+		WAIT UNTIL irq = '1';
+		tb_check(abs(now - sample_time - 50 us) < 100 ns, true, "sample period", errors);
+		check_status("STATUS.SAMPLE set", C_STATUS_SAMPLE, '1');
+		spi_read(to_integer(C_BANK_QEI) * 16, data, status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+			tb_check(to_integer(unsigned(data(i))) MOD C_COUNTER_MOD, expected(i) MOD C_COUNTER_MOD,
+				"next sample, QEI" & integer'image(i), errors);
+		END LOOP;
+		-- A sample due inside a chip-select window waits for its end
+		WAIT UNTIL irq = '1';
+		spi_select(SPI_PERIOD, spi_ss);
+		irqs := irq_count;
+		WAIT FOR 60 us;
+		tb_check(irq_count - irqs, 0, "interrupts inside a window", errors);
+		spi_deselect(SPI_PERIOD, spi_ss);
+		WAIT FOR 1 us;
+		tb_check(irq_count - irqs, 1, "sample at the end of the window", errors);
+		spi_write(to_integer(C_REG_SAMPLE_PERIOD), (0 => x"0000"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+		irqs := irq_count;
+		WAIT FOR 50 us;
+		tb_check(irq_count - irqs, 0, "interrupts after sampling off", errors);
+		spi_write(to_integer(C_REG_IRQ_EN), (0 => x"0000"), status, SPI_PERIOD, spi_ss, spi_clk, spi_mosi, spi_miso);
+
+		-- Reset clears the counters
+		reset <= '1';
+		WAIT FOR 100 ns;
+		reset <= '0';
+		expected := (OTHERS => 0);
 		WAIT FOR 100 ns;
-			spi_ss <= '0';
+		check_counters("after second reset");
+		check_errors("after second reset", (0, 0, 0));
+
+		tb_end("QEI_testbench", errors);
+		std.env.finish;
 		WAIT;
 	END PROCESS;
-	
-
-	WITH spi_ss SELECT 
-		spi_clk <= 	not spi_clk after 500 ns when '0',
-					'0' WHEN OTHERS;
-	
-	
-	PROCESS(spi_clk)
-	VARIABLE index : integer :=47;
-	BEGIN
-		IF(rising_edge(spi_clk)) THEN
-			CASE index IS
-				WHEN 41 => 
-					spi_mosi <= '1';
-					hold <= '1';	
-				WHEN 42 => 
-					spi_mosi <= '0';	   	 --address 010
-					hold <= '0';
-				WHEN 19 => 
-					spi_mosi <= '0';	   	 
-					hold <= '1';
-				WHEN 18 => 
-					spi_mosi <= '0';	   	 --address 001
-					hold <= '0';	
-				WHEN OTHERS => 
-					spi_mosi <= '0';
-					hold <= '0';
-			END CASE;
-				IF(index>0) THEN
-					index:=index-1;
-				END IF;
-		END IF;
-	END PROCESS;	
 
-END BEHAVIOR;
\ No newline at end of file
+END BEHAVIOR;
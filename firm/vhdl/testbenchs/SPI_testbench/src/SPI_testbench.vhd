@@ -0,0 +1,242 @@
+LIBRARY ieee;
+USE ieee.std_logic_1164.ALL;
+USE ieee.numeric_std.ALL;
+LIBRARY work;
+USE work.holoboard_pkg.ALL;
+USE work.spi_master_bfm_pkg.ALL;
+
+-- Self-checking test of SIMPLE_SPI + MEMORY_MANAGER at the MCU link speeds,
+-- plain and CRC mode bursts.
+-- The FPGA clock (133 MHz) and SCLK are unrelated, so every word crosses
+-- clock domains with a different phase.
+-- Run with "make SPI_testbench" from the testbenchs directory.
+
+ENTITY SPI_testbench IS END;
+
+ARCHITECTURE BEHAVIOR OF SPI_testbench IS
+	COMPONENT SIMPLE_SPI IS
+		PORT (
+			RESET_I			:	IN	STD_LOGIC;
+			CLK_I     		:	IN	STD_LOGIC;
+			SCLK_I   		:	IN	STD_LOGIC;
+			SS_I    		:	IN	STD_LOGIC;
+			MOSI_I  		:	IN	STD_LOGIC;
+			MISO_O			:	OUT	STD_LOGIC;
+			TX_DATA_I	  	: 	IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			RX_DATA_O	 	: 	OUT STD_LOGIC_VECTOR(15 DOWNTO 0);
+			RX_VALID_O		:	OUT	STD_LOGIC;
+			CS_ACTIVE_O		:	OUT	STD_LOGIC
+		);
+	END COMPONENT;
+
+	COMPONENT MEMORY_MANAGER IS
+		PORT (
+			RESET_I			: IN  	STD_LOGIC;
+			CLK_I      		: IN  	STD_LOGIC;
+			RX_DATA_I		: IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			RX_VALID_I		: IN 	STD_LOGIC;
+			CS_ACTIVE_I		: IN 	STD_LOGIC;
+			TX_DATA_O		: OUT	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			QEI_I			: IN 	T_WORD_ARRAY(0 TO C_NB_CHANNELS-1);
+			QEI_ERR_I		: IN 	STD_LOGIC_VECTOR(0 TO C_NB_CHANNELS-1);
+			QEI_FILTER_O	: OUT	UNSIGNED(7 DOWNTO 0);
+			SCAN_O			: OUT	UNSIGNED(3 DOWNTO 0);
+			PWM_DUTY_O		: OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			PWM_PERIOD_O	: OUT 	UNSIGNED(14 DOWNTO 0);
+			PWM_DEADBAND_O	: OUT 	UNSIGNED(7 DOWNTO 0);
+			PWM_SLEW_O		: OUT 	UNSIGNED(14 DOWNTO 0);
+			PWM_EN_O		: OUT	STD_LOGIC;
+			VEL_REF_O		: OUT 	SIGNED(15 DOWNTO 0);
+			VEL_KP_O		: OUT 	SIGNED(15 DOWNTO 0);
+			VEL_KI_O		: OUT 	SIGNED(15 DOWNTO 0);
+			VEL_EN_O		: OUT	STD_LOGIC;
+			VEL_TICK_O		: OUT	STD_LOGIC;
+			IRQ_O			: OUT	STD_LOGIC
+		);
+	END COMPONENT;
+
+	CONSTANT CLK_PERIOD : TIME := 7.519 ns;													-- 133 MHz
+
+	SIGNAL reset : std_logic := '1';
+	SIGNAL clk : std_logic := '0';
+	SIGNAL sim_done : boolean := false;
+	SIGNAL spi_clk, spi_mosi, spi_miso : std_logic := '0';
+	SIGNAL spi_ss : std_logic := '1';
+	SIGNAL to_spi, from_spi : std_logic_vector(15 DOWNTO 0);
+	SIGNAL rx_valid, cs_active, pwm_en : std_logic;
+	SIGNAL qei, pwm_duty, vel_kp : T_WORD_ARRAY(0 TO C_NB_CHANNELS-1);						-- bank outputs, gathered from the scan
+	SIGNAL scan : UNSIGNED(3 DOWNTO 0);
+	SIGNAL scan_duty : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	SIGNAL scan_kp : SIGNED(15 DOWNTO 0);
+	SIGNAL qei_errors : std_logic_vector(0 TO C_NB_CHANNELS-1) := (OTHERS => '0');
+
+BEGIN
+	-- Units Under Test
+	SPI : SIMPLE_SPI
+	PORT MAP (RESET_I => reset, CLK_I => clk, SCLK_I => spi_clk, SS_I => spi_ss, MOSI_I => spi_mosi, MISO_O => spi_miso,
+			TX_DATA_I => to_spi, RX_DATA_O => from_spi, RX_VALID_O => rx_valid, CS_ACTIVE_O => cs_active);
+
+	REGS : MEMORY_MANAGER
+	PORT MAP (RESET_I => reset, CLK_I => clk, RX_DATA_I => from_spi, RX_VALID_I => rx_valid, CS_ACTIVE_I => cs_active, TX_DATA_O => to_spi,
+			QEI_I => qei, QEI_ERR_I => qei_errors, QEI_FILTER_O => OPEN, SCAN_O => scan, PWM_DUTY_O => scan_duty, PWM_PERIOD_O => OPEN, PWM_DEADBAND_O => OPEN, PWM_SLEW_O => OPEN,
+			PWM_EN_O => pwm_en, VEL_REF_O => OPEN, VEL_KP_O => scan_kp, VEL_KI_O => OPEN, VEL_EN_O => OPEN, VEL_TICK_O => OPEN, IRQ_O => OPEN);
+
+	clk <= not clk AFTER CLK_PERIOD/2 WHEN not sim_done ELSE '0';
+
+	PROCESS(clk)
+	BEGIN
+		IF (rising_edge(clk)) THEN
+			pwm_duty(to_integer(scan)) <= scan_duty;
+			vel_kp(to_integer(scan)) <= std_logic_vector(scan_kp);
+		END IF;
+	END PROCESS;
+
+	PROCESS
+		VARIABLE data : T_WORD_ARRAY(0 TO C_NB_CHANNELS);
+		VARIABLE value, status : STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE errors : NATURAL := 0;
+		VARIABLE ok : BOOLEAN;
+
+		PROCEDURE run(period : IN TIME; seed : IN NATURAL) IS
+		BEGIN
+			-- Enable the bridges
+			spi_write(to_integer(C_REG_CONFIG), (0 => x"0001"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			WAIT FOR 100 ns;
+			tb_check("000000000000000" & pwm_en, x"0001", "PWM_EN_O", errors);
+
+			-- Duty write burst, running past the last channel (ignored)
+			FOR i IN 0 TO C_NB_CHANNELS LOOP
+				data(i) := std_logic_vector(to_unsigned(seed * 977 + i * 4099, 16));
+			END LOOP;
+			spi_write(16#20#, data, status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			WAIT FOR 100 ns;
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				tb_check(pwm_duty(i), data(i), "PWM_DUTY_O(" & integer'image(i) & ")", errors);
+			END LOOP;
+
+			-- Read it back
+			spi_read(16#20#, data(0 TO C_NB_CHANNELS-1), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(status, x"0011", "STATUS in turnaround word", errors);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				tb_check(data(i), std_logic_vector(to_unsigned(seed * 977 + i * 4099, 16)), "duty read back(" & integer'image(i) & ")", errors);
+			END LOOP;
+
+			-- Period and slew are 15 bits wide, dead-band 8 bits wide
+			spi_write(16#30#, (0 => x"FFFF"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			spi_write(16#40#, (0 => x"FFFF"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			spi_write(16#60#, (0 => x"FFFF"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			spi_read(16#30#, data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"7FFF", "PWM period mask", errors);
+			spi_read(16#40#, data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"00FF", "PWM dead-band mask", errors);
+			spi_read(16#60#, data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"7FFF", "PWM slew mask", errors);
+
+			-- STATUS, CONFIG, CRC_ERR and QEI_FILTER in one burst, unmapped
+			-- addresses (past the last channel of a bank) read zero
+			spi_read(16#00#, data(0 TO 3), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"0011", "STATUS", errors);
+			tb_check(data(1), x"0001", "CONFIG", errors);
+			tb_check(data(2), x"0000", "CRC_ERR", errors);
+			tb_check(to_integer(unsigned(data(3))), C_QEI_FILTER_RESET, "QEI_FILTER", errors);
+			spi_read(16#20# + C_NB_CHANNELS, data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"0000", "unmapped register", errors);
+
+			-- Identification, read-only
+			spi_write(to_integer(C_REG_ID), (x"FFFF", x"FFFF"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			spi_read(to_integer(C_REG_ID), data(0 TO 1), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), C_ID_MAGIC & C_ID_VERSION, "ID", errors);
+			tb_check(data(1), caps_word(C_NB_CHANNELS), "CAPS", errors);
+			tb_check(to_integer(unsigned(data(1)(C_CAPS_CHANNELS_MSB DOWNTO 0))), C_NB_CHANNELS, "CAPS channels", errors);
+
+			-- Velocity loop period at its reset value, gains bank written and read back
+			spi_read(to_integer(C_REG_VEL_PERIOD), data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(to_integer(unsigned(data(0))), C_VEL_PERIOD_RESET, "VEL_PERIOD", errors);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				data(i) := std_logic_vector(to_unsigned(seed * 613 + i * 2053, 16));
+			END LOOP;
+			spi_write(16#80#, data(0 TO C_NB_CHANNELS-1), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			spi_read(16#80#, data(0 TO C_NB_CHANNELS-1), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				tb_check(data(i), std_logic_vector(to_unsigned(seed * 613 + i * 2053, 16)), "VEL_KP read back(" & integer'image(i) & ")", errors);
+				tb_check(vel_kp(i), data(i), "VEL_KP_O(" & integer'image(i) & ")", errors);
+			END LOOP;
+
+			-- Encoders are frozen when SS falls
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				qei(i) <= std_logic_vector(to_unsigned(seed * 31 + i, 16));
+			END LOOP;
+			WAIT FOR 100 ns;
+			spi_select(period, spi_ss);
+			spi_word(spi_command(16#10#, false), value, period, spi_clk, spi_mosi, spi_miso);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				qei(i) <= (OTHERS => '1');
+			END LOOP;
+			spi_word(x"0000", value, period, spi_clk, spi_mosi, spi_miso);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				spi_word(x"0000", value, period, spi_clk, spi_mosi, spi_miso);
+				tb_check(value, std_logic_vector(to_unsigned(seed * 31 + i, 16)), "QEI snapshot(" & integer'image(i) & ")", errors);
+			END LOOP;
+			spi_deselect(period, spi_ss);
+
+			-- CRC mode: checked write and read back
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				data(i) := std_logic_vector(to_unsigned(seed * 523 + i * 8191, 16));
+			END LOOP;
+			spi_write_crc(16#20#, data(0 TO C_NB_CHANNELS-1), false, ok, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(ok, true, "CRC write ack", errors);
+			spi_read_crc(16#20#, data(0 TO C_NB_CHANNELS-1), ok, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(ok, true, "CRC read crc word", errors);
+			FOR i IN 0 TO C_NB_CHANNELS-1 LOOP
+				tb_check(data(i), std_logic_vector(to_unsigned(seed * 523 + i * 8191, 16)), "CRC duty read back(" & integer'image(i) & ")", errors);
+				tb_check(pwm_duty(i), data(i), "CRC PWM_DUTY_O(" & integer'image(i) & ")", errors);
+			END LOOP;
+
+			-- CRC mode: a bad crc word or an over-long burst (past the G_NB_CHANNELS
+			-- words of the stage, the default here) is not applied and counted
+			spi_write_crc(16#20#, (x"1111", x"2222"), true, ok, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(ok, false, "bad CRC write ack", errors);
+			spi_write_crc(16#20#, (0 TO C_NB_CHANNELS => x"3333"), false, ok, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(ok, false, "over-long CRC write ack", errors);
+			spi_read_crc(16#20#, data(0 TO 0), ok, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), std_logic_vector(to_unsigned(seed * 523, 16)), "duty after rejected CRC writes", errors);
+			spi_read(to_integer(C_REG_CRC_ERR), data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"0002", "CRC_ERR", errors);
+			spi_write(to_integer(C_REG_CRC_ERR), (0 => x"0000"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			spi_read(to_integer(C_REG_CRC_ERR), data(0 TO 0), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			tb_check(data(0), x"0000", "CRC_ERR cleared", errors);
+
+			-- Disable the bridges
+			spi_write(to_integer(C_REG_CONFIG), (0 => x"0000"), status, period, spi_ss, spi_clk, spi_mosi, spi_miso);
+			WAIT FOR 100 ns;
+			tb_check("000000000000000" & pwm_en, x"0000", "PWM_EN_O", errors);
+		END PROCEDURE;
+
+	BEGIN
+		-- CRC-8 reference value, shared with hb_lcmxo2.c
+		tb_check(crc8(crc8(C_CRC_INIT, x"4320"), x"1234"), x"C2", "crc8 reference", errors);
+
+		WAIT FOR 1 us;
+		reset <= '0';
+		WAIT FOR 100 ns;
+
+		-- STATUS.READY is only set C_READY_CLOCKS after reset
+		spi_read(to_integer(C_REG_STATUS), data(0 TO 0), status, 37.3 ns, spi_ss, spi_clk, spi_mosi, spi_miso);
+		tb_check(data(0)(C_STATUS_READY DOWNTO C_STATUS_READY), "0", "STATUS.READY after reset", errors);
+		WAIT FOR C_READY_CLOCKS * CLK_PERIOD;
+		spi_read(to_integer(C_REG_STATUS), data(0 TO 0), status, 37.3 ns, spi_ss, spi_clk, spi_mosi, spi_miso);
+		tb_check(data(0)(C_STATUS_READY DOWNTO C_STATUS_READY), "1", "STATUS.READY", errors);
+
+		-- Slowest to fastest, including clocks that do not divide 133 MHz
+		run(1 us, 1);																	-- 1 MHz
+		run(83.333 ns, 2);																-- 12 MHz
+		run(41.667 ns, 3);																-- 24 MHz
+		run(40 ns, 4);																	-- 25 MHz
+		run(37.3 ns, 5);																-- 26.8 MHz
+
+		sim_done <= true;
+		tb_end("SPI_testbench", errors);
+		WAIT;
+	END PROCESS;
+
+END BEHAVIOR;
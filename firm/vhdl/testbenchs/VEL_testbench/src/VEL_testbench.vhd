@@ -0,0 +1,152 @@
+LIBRARY ieee;
+USE ieee.std_logic_1164.ALL;
+USE ieee.numeric_std.ALL;
+USE std.textio.ALL;
+LIBRARY work;
+USE work.holoboard_pkg.ALL;
+USE work.spi_master_bfm_pkg.ALL;
+
+-- Self-checking test of the fabric velocity PI (velocity_pi.vhd) against
+-- its C reference model: build/vel_pi_vectors.txt is written by
+-- src/vel_pi_model.c, one loop tick per line, inputs then expected duty.
+-- Every channel runs the same vectors, its encoder counter offset by a
+-- different constant: the duties only match if each channel keeps its own
+-- previous counter and integral.
+-- Run with "make VEL_testbench" from the testbenchs directory.
+
+ENTITY VEL_testbench IS
+	GENERIC (
+		G_VECTORS	: STRING := "build/vel_pi_vectors.txt"
+		);
+END;
+
+ARCHITECTURE BEHAVIOR OF VEL_testbench IS
+	COMPONENT VELOCITY_PI IS
+		GENERIC (
+			G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+			);
+		PORT (
+			RESET_I		: IN  	STD_LOGIC;
+			CLK_I      	: IN  	STD_LOGIC;
+			ENABLE_I	: IN 	STD_LOGIC;
+			TICK_I		: IN 	STD_LOGIC;
+			COUNTER_I	: IN 	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);
+			SCAN_I		: IN 	UNSIGNED(3 DOWNTO 0);
+			REF_I		: IN 	SIGNED(15 DOWNTO 0);
+			KP_I		: IN 	SIGNED(15 DOWNTO 0);
+			KI_I		: IN 	SIGNED(15 DOWNTO 0);
+			LIMIT_I		: IN 	UNSIGNED(14 DOWNTO 0);
+			DUTY_O		: OUT	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1)
+			);
+	END COMPONENT;
+
+	CONSTANT CLK_PERIOD : TIME := 1 us / 133.0;											-- OSCH model
+	CONSTANT C_TICK_CLOCKS : NATURAL := C_NB_CHANNELS * (38 + 4 * (C_NB_CHANNELS-1)) + 4;	-- last duty updated
+	CONSTANT C_COUNTER_OFFSET : NATURAL := 1000;										-- per channel
+
+	SIGNAL reset : std_logic := '1';
+	SIGNAL clk, enable, tick : std_logic := '0';
+	SIGNAL counters : T_WORD_ARRAY(0 TO C_NB_CHANNELS-1) := (OTHERS => (OTHERS => '0'));
+	SIGNAL scan : unsigned(3 DOWNTO 0) := (OTHERS => '0');
+	SIGNAL ref, kp, ki : signed(15 DOWNTO 0) := (OTHERS => '0');
+	SIGNAL limit : unsigned(14 DOWNTO 0) := (OTHERS => '0');
+	SIGNAL duties : T_WORD_ARRAY(0 TO C_NB_CHANNELS-1);
+
+BEGIN
+	-- Instantiate the Unit Under Test (UUT)
+	UUT : VELOCITY_PI
+	GENERIC MAP (G_NB_CHANNELS => C_NB_CHANNELS)
+	PORT MAP ( 	RESET_I => reset,
+				CLK_I => clk,
+				ENABLE_I => enable,
+				TICK_I => tick,
+				COUNTER_I => counters,
+				SCAN_I => scan,
+				REF_I => ref,
+				KP_I => kp,
+				KI_I => ki,
+				LIMIT_I => limit,
+				DUTY_O => duties);
+
+	clk <= not clk AFTER CLK_PERIOD / 2;
+
+	-- Channel scan of the register file, every channel has the same registers
+	PROCESS(clk)
+	BEGIN
+		IF (rising_edge(clk)) THEN
+			IF (scan = C_NB_CHANNELS-1) THEN
+				scan <= (OTHERS => '0');
+			ELSE
+				scan <= scan + 1;
+			END IF;
+		END IF;
+	END PROCESS;
+
+	PROCESS
+		FILE vectors : TEXT;
+		VARIABLE open_status : FILE_OPEN_STATUS;
+		VARIABLE row : LINE;
+		VARIABLE v_enable, v_counter, v_ref, v_kp, v_ki, v_limit, v_duty : INTEGER;
+		VARIABLE got : INTEGER;
+		VARIABLE errors : NATURAL := 0;
+		VARIABLE ticks : NATURAL := 0;
+	BEGIN
+		file_open(open_status, vectors, G_VECTORS, READ_MODE);
+		ASSERT open_status = OPEN_OK
+			REPORT "VEL_testbench: cannot open " & G_VECTORS SEVERITY FAILURE;
+
+		WAIT FOR 1 us;
+		WAIT UNTIL falling_edge(clk);
+		reset <= '0';
+
+		WHILE NOT endfile(vectors) LOOP
+			readline(vectors, row);
+			read(row, v_enable);
+			read(row, v_counter);
+			read(row, v_ref);
+			read(row, v_kp);
+			read(row, v_ki);
+			read(row, v_limit);
+			read(row, v_duty);
+
+			-- Inputs away from the clock edges, then one tick
+			WAIT UNTIL falling_edge(clk);
+			IF (v_enable = 0) THEN
+				enable <= '0';
+			ELSE
+				enable <= '1';
+			END IF;
+			FOR ch IN 0 TO C_NB_CHANNELS-1 LOOP
+				counters(ch) <= std_logic_vector(to_unsigned((v_counter + ch * C_COUNTER_OFFSET) MOD 4096, 16));
+			END LOOP;
+			ref <= to_signed(v_ref, 16);
+			kp <= to_signed(v_kp, 16);
+			ki <= to_signed(v_ki, 16);
+			limit <= to_unsigned(v_limit, 15);
+			WAIT UNTIL falling_edge(clk);
+			tick <= '1';
+			WAIT UNTIL falling_edge(clk);
+			tick <= '0';
+			FOR i IN 1 TO C_TICK_CLOCKS LOOP
+				WAIT UNTIL falling_edge(clk);
+			END LOOP;
+
+			-- Sign and magnitude, as PWM_DUTY
+			FOR ch IN 0 TO C_NB_CHANNELS-1 LOOP
+				got := to_integer(unsigned(duties(ch)(14 DOWNTO 0)));
+				IF (duties(ch)(15) = '1') THEN
+					got := -got;
+				END IF;
+				tb_check(got, v_duty, "channel " & integer'image(ch) & " duty at tick " & integer'image(ticks), errors);
+			END LOOP;
+			ticks := ticks + 1;
+		END LOOP;
+		file_close(vectors);
+
+		tb_check(ticks > 0, true, "vectors read", errors);
+		tb_end("VEL_testbench", errors);
+		std.env.finish;
+		WAIT;
+	END PROCESS;
+
+END BEHAVIOR;
@@ -0,0 +1,167 @@
+/* -----------------------------------------------------------------------------
+ * HoloBoard
+ * I-Grebot
+ * -----------------------------------------------------------------------------
+ * @file       vel_pi_model.c
+ * @author     I-Grebot
+ * @date       Oct 19, 2026
+ * -----------------------------------------------------------------------------
+ * @brief
+ *   Reference model of the fabric velocity PI (velocity_pi.vhd), same
+ *   fixed-point arithmetic, and generator of the VEL_testbench vectors.
+ *   One vector per loop tick, written on stdout:
+ *     <enable> <counter> <ref> <kp> <ki> <limit> <duty>
+ *   duty being the signed output expected after the tick.
+ *   Closed loop runs on a first order wheel model, then random inputs
+ *   over the full register ranges for the saturations and the wrap-around.
+ * -----------------------------------------------------------------------------
+ * Versionning informations
+ * Repository: https://github.com/I-Grebot/holoboard.git
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define VEL_PI_CLOSED_TICKS     400     /* per closed loop run */
+#define VEL_PI_RANDOM_TICKS     2000
+#define VEL_PI_WHEEL_SPEED_MAX  6.0     /* counts per tick at full duty */
+#define VEL_PI_WHEEL_ALPHA      0.05    /* speed filter of the wheel model, per tick */
+
+typedef struct {
+    uint16_t last;          /* 12 bits counter at the previous tick */
+    int32_t integral;       /* 1/256 duty steps */
+} vel_pi_t;
+
+static uint32_t vel_pi_seed = 0x12345678;
+
+static int64_t vel_pi_saturate(int64_t value, int64_t min, int64_t max)
+{
+    if(value > max)
+        return max;
+    if(value < min)
+        return min;
+    return value;
+}
+
+/**
+  * @brief  One tick of the controller, see velocity_pi.vhd
+  * @param  pi: controller state
+  * @param  enable: 0 clears the integral, the output is zero
+  * @param  counter: 12 bits encoder counter
+  * @param  ref: velocity reference, 1/256 counts per tick
+  * @param  kp, ki: gains, duty steps per count per tick (per tick for ki)
+  * @param  limit: output saturation, the PWM period
+  * @retval Signed duty
+  */
+static int32_t vel_pi_step(vel_pi_t* pi, int enable, uint16_t counter,
+                           int16_t ref, int16_t kp, int16_t ki, uint16_t limit)
+{
+    int32_t delta, error;
+    int64_t total;
+
+    if(!enable)
+    {
+        pi->last = counter;
+        pi->integral = 0;
+        return 0;
+    }
+
+    /* Counts since the previous tick, 12 bits two's complement */
+    delta = (counter - pi->last) & 0x0FFF;
+    if(delta & 0x0800)
+        delta -= 0x1000;
+    pi->last = counter;
+
+    error = (int32_t)vel_pi_saturate(ref - delta * 256, -32768, 32767);
+
+    total = (int64_t)pi->integral + (int64_t)ki * error;
+    pi->integral = (int32_t)vel_pi_saturate(total, -((int64_t)limit << 8), (int64_t)limit << 8);
+
+    /* Rounded down, as the arithmetic shift of the fabric */
+    total = (int64_t)kp * error + pi->integral;
+    total = (total >= 0) ? total / 256 : -((-total + 255) / 256);
+
+    return (int32_t)vel_pi_saturate(total, -(int64_t)limit, limit);
+}
+
+static uint32_t vel_pi_random(void)
+{
+    /* xorshift32, the vectors are the same on every run */
+    vel_pi_seed ^= vel_pi_seed << 13;
+    vel_pi_seed ^= vel_pi_seed >> 17;
+    vel_pi_seed ^= vel_pi_seed << 5;
+    return vel_pi_seed;
+}
+
+static void vel_pi_vector(vel_pi_t* pi, int enable, uint16_t counter,
+                          int16_t ref, int16_t kp, int16_t ki, uint16_t limit, int32_t* duty)
+{
+    *duty = vel_pi_step(pi, enable, counter, ref, kp, ki, limit);
+    printf("%d %u %d %d %d %u %d\n", enable, counter, ref, kp, ki, limit, *duty);
+}
+
+/**
+  * @brief  Closed loop on the wheel model, reference steps every quarter
+  * @param  pi: controller state, kept between the runs
+  * @param  kp, ki: gains of the run
+  * @param  limit: PWM period
+  * @param  position: wheel position, counts
+  * @retval None
+  */
+static void vel_pi_closed_loop(vel_pi_t* pi, int16_t kp, int16_t ki, uint16_t limit, double* position)
+{
+    static const int16_t refs[4] = { 512, 1200, -300, 0 };
+    double speed = 0;
+    int32_t duty = 0;
+    uint16_t tick;
+
+    for(tick = 0; tick < VEL_PI_CLOSED_TICKS; tick++)
+    {
+        speed += ((double)duty / limit * VEL_PI_WHEEL_SPEED_MAX - speed) * VEL_PI_WHEEL_ALPHA;
+        *position += speed;
+        vel_pi_vector(pi, 1, (uint16_t)((int32_t)*position & 0x0FFF),
+                      refs[tick * 4 / VEL_PI_CLOSED_TICKS], kp, ki, limit, &duty);
+    }
+}
+
+int main(void)
+{
+    vel_pi_t pi = { 0, 0 };
+    double position = 0;
+    uint16_t counter = 0, limit;
+    int16_t ref, kp, ki;
+    int32_t duty;
+    int tick, enable;
+
+    /* Enable from reset, the counter does not move */
+    vel_pi_vector(&pi, 0, 0, 0, 0, 0, 2047, &duty);
+
+    /* Wheel model: moderate gains, then high integral gain and windup */
+    vel_pi_closed_loop(&pi, 400, 20, 2047, &position);
+    vel_pi_closed_loop(&pi, 2000, 400, 2047, &position);
+    vel_pi_closed_loop(&pi, -300, -10, 6649, &position);
+
+    /* Random inputs, disabled one tick out of 32 */
+    counter = (uint16_t)((int32_t)position & 0x0FFF);
+    for(tick = 0; tick < VEL_PI_RANDOM_TICKS; tick++)
+    {
+        enable = (vel_pi_random() % 32) != 0;
+        counter = (counter + vel_pi_random()) & 0x0FFF;
+        ref = (int16_t)vel_pi_random();
+        kp = (int16_t)vel_pi_random();
+        ki = (int16_t)vel_pi_random();
+        limit = vel_pi_random() & 0x7FFF;
+        /* Small steps too, the full range mostly saturates */
+        if(tick & 1)
+        {
+            counter = (counter - (vel_pi_random() % 9) + 4) & 0x0FFF;
+            ref = (int16_t)(ref >> 8);
+            kp = (int16_t)(kp >> 7);
+            ki = (int16_t)(ki >> 11);
+        }
+        vel_pi_vector(&pi, enable, counter, ref, kp, ki, limit, &duty);
+    }
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+-- Placeholder for the Lattice vendor library: HOLOBOARD only needs
+-- "LIBRARY lattice" to exist when simulated outside Lattice Diamond.
+
+PACKAGE LATTICE_SIM IS
+END LATTICE_SIM;
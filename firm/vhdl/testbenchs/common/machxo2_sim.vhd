@@ -0,0 +1,47 @@
+LIBRARY ieee;
+USE ieee.std_logic_1164.ALL;
+
+-- Simulation model of the MachXO2 primitives used by HOLOBOARD, compiled
+-- into library machxo2 by the testbench Makefile (the vendor library is
+-- only available with Lattice Diamond).
+
+ENTITY OSCH IS
+	GENERIC(
+		NOM_FREQ: string := "2.08");												-- MHz
+	PORT(
+		STDBY    : IN  STD_LOGIC;
+		OSC      : OUT STD_LOGIC;
+		SEDSTDBY : OUT STD_LOGIC);
+END OSCH;
+
+ARCHITECTURE BEHAVIOR OF OSCH IS
+
+	-- "133.00" -> 133.0
+	FUNCTION to_mhz(s : STRING) RETURN REAL IS
+		VARIABLE value : REAL := 0.0;
+		VARIABLE scale : REAL := 1.0;
+		VARIABLE frac : BOOLEAN := false;
+	BEGIN
+		FOR i IN s'RANGE LOOP
+			IF (s(i) = '.') THEN
+				frac := true;
+			ELSIF (s(i) >= '0' and s(i) <= '9') THEN
+				IF (frac) THEN
+					scale := scale / 10.0;
+					value := value + scale * REAL(CHARACTER'POS(s(i)) - CHARACTER'POS('0'));
+				ELSE
+					value := value * 10.0 + REAL(CHARACTER'POS(s(i)) - CHARACTER'POS('0'));
+				END IF;
+			END IF;
+		END LOOP;
+		RETURN value;
+	END FUNCTION;
+
+	CONSTANT HALF_PERIOD : TIME := 1 us / (2.0 * to_mhz(NOM_FREQ));
+	SIGNAL clk : STD_LOGIC := '0';
+
+BEGIN
+	clk <= '0' WHEN STDBY = '1' ELSE not clk AFTER HALF_PERIOD;
+	OSC <= clk;
+	SEDSTDBY <= STDBY;
+END BEHAVIOR;
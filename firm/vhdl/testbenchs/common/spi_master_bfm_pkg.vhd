@@ -0,0 +1,306 @@
+LIBRARY ieee;
+USE ieee.std_logic_1164.ALL;
+USE ieee.numeric_std.ALL;
+LIBRARY work;
+USE work.holoboard_pkg.ALL;
+
+-- Bus functional model of the MCU SPI master (hb_lcmxo2.c): mode 0,
+-- 16-bit words, msb first, register bursts as described in holoboard_pkg.vhd.
+-- Also holds the checking helpers shared by the self-checking testbenches.
+
+PACKAGE SPI_MASTER_BFM_PKG IS
+
+	CONSTANT C_SPI_SS_HIGH : TIME := 40 ns;										-- SS high time between windows
+
+	-- One word, SS must already be low
+	PROCEDURE spi_word(
+		CONSTANT tx 	: IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE rx 	: OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		CONSTANT period	: IN 	TIME;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC);
+
+	-- Open / close a chip-select window
+	PROCEDURE spi_select(
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC);
+
+	PROCEDURE spi_deselect(
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC);
+
+	-- Write data'length registers from address, returns STATUS
+	PROCEDURE spi_write(
+		CONSTANT address: IN 	NATURAL;
+		CONSTANT data 	: IN 	T_WORD_ARRAY;
+		VARIABLE status : OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC);
+
+	-- Read data'length registers from address, returns STATUS
+	PROCEDURE spi_read(
+		CONSTANT address: IN 	NATURAL;
+		VARIABLE data 	: OUT 	T_WORD_ARRAY;
+		VARIABLE status : OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC);
+
+	-- CRC mode bursts, ok = ack (write) or crc (read) word matched.
+	-- bad_crc sends a wrong crc word to check the rejection.
+	PROCEDURE spi_write_crc(
+		CONSTANT address: IN 	NATURAL;
+		CONSTANT data 	: IN 	T_WORD_ARRAY;
+		CONSTANT bad_crc: IN 	BOOLEAN;
+		VARIABLE ok 	: OUT 	BOOLEAN;
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC);
+
+	PROCEDURE spi_read_crc(
+		CONSTANT address: IN 	NATURAL;
+		VARIABLE data 	: OUT 	T_WORD_ARRAY;
+		VARIABLE ok 	: OUT 	BOOLEAN;
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC);
+
+	-- Command word of a burst
+	FUNCTION spi_command(address : NATURAL; write : BOOLEAN) RETURN STD_LOGIC_VECTOR;
+	FUNCTION spi_command_crc(address : NATURAL; write : BOOLEAN; length : NATURAL) RETURN STD_LOGIC_VECTOR;
+
+	-- Report a mismatch as an error and count it
+	PROCEDURE tb_check(
+		CONSTANT got, expected	: IN 	STD_LOGIC_VECTOR;
+		CONSTANT what			: IN 	STRING;
+		VARIABLE errors			: INOUT	NATURAL);
+
+	PROCEDURE tb_check(
+		CONSTANT got, expected	: IN 	INTEGER;
+		CONSTANT what			: IN 	STRING;
+		VARIABLE errors			: INOUT	NATURAL);
+
+	PROCEDURE tb_check(
+		CONSTANT got, expected	: IN 	BOOLEAN;
+		CONSTANT what			: IN 	STRING;
+		VARIABLE errors			: INOUT	NATURAL);
+
+	-- Final verdict, a failure stops the simulation with a non-zero exit code
+	PROCEDURE tb_end(
+		CONSTANT name			: IN 	STRING;
+		CONSTANT errors			: IN 	NATURAL);
+
+END SPI_MASTER_BFM_PKG;
+
+PACKAGE BODY SPI_MASTER_BFM_PKG IS
+
+	FUNCTION spi_command(address : NATURAL; write : BOOLEAN) RETURN STD_LOGIC_VECTOR IS
+		VARIABLE cmd : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	BEGIN
+		cmd := std_logic_vector(to_unsigned(address, 16));
+		IF (write) THEN
+			cmd(C_CMD_WRITE_BIT) := '1';
+		END IF;
+		RETURN cmd;
+	END FUNCTION;
+
+	FUNCTION spi_command_crc(address : NATURAL; write : BOOLEAN; length : NATURAL) RETURN STD_LOGIC_VECTOR IS
+		VARIABLE cmd : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	BEGIN
+		cmd := spi_command(address, write);
+		cmd(C_CMD_CRC_BIT) := '1';
+		cmd(C_CMD_LENGTH_MSB DOWNTO C_CMD_LENGTH_LSB) := std_logic_vector(to_unsigned(length, C_CMD_LENGTH_MSB - C_CMD_LENGTH_LSB + 1));
+		RETURN cmd;
+	END FUNCTION;
+
+	PROCEDURE spi_word(
+		CONSTANT tx 	: IN 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE rx 	: OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		CONSTANT period	: IN 	TIME;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC) IS
+	BEGIN
+		FOR i IN 15 DOWNTO 0 LOOP
+			mosi <= tx(i);
+			WAIT FOR period/2;
+			sclk <= '1';
+			rx(i) := miso;
+			WAIT FOR period/2;
+			sclk <= '0';
+		END LOOP;
+	END PROCEDURE;
+
+	PROCEDURE spi_select(
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC) IS
+	BEGIN
+		ss <= '0';
+		WAIT FOR period;
+	END PROCEDURE;
+
+	PROCEDURE spi_deselect(
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC) IS
+	BEGIN
+		WAIT FOR period/2;
+		ss <= '1';
+		WAIT FOR C_SPI_SS_HIGH;
+	END PROCEDURE;
+
+	PROCEDURE spi_write(
+		CONSTANT address: IN 	NATURAL;
+		CONSTANT data 	: IN 	T_WORD_ARRAY;
+		VARIABLE status : OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC) IS
+		VARIABLE rx : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	BEGIN
+		spi_select(period, ss);
+		spi_word(spi_command(address, true), status, period, sclk, mosi, miso);
+		FOR i IN data'RANGE LOOP
+			spi_word(data(i), rx, period, sclk, mosi, miso);
+		END LOOP;
+		spi_deselect(period, ss);
+	END PROCEDURE;
+
+	PROCEDURE spi_read(
+		CONSTANT address: IN 	NATURAL;
+		VARIABLE data 	: OUT 	T_WORD_ARRAY;
+		VARIABLE status : OUT 	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC) IS
+		VARIABLE rx : STD_LOGIC_VECTOR(15 DOWNTO 0);
+	BEGIN
+		spi_select(period, ss);
+		spi_word(spi_command(address, false), rx, period, sclk, mosi, miso);
+		spi_word(x"0000", status, period, sclk, mosi, miso);					-- turnaround
+		FOR i IN data'RANGE LOOP
+			spi_word(x"0000", rx, period, sclk, mosi, miso);
+			data(i) := rx;
+		END LOOP;
+		spi_deselect(period, ss);
+	END PROCEDURE;
+
+	PROCEDURE spi_write_crc(
+		CONSTANT address: IN 	NATURAL;
+		CONSTANT data 	: IN 	T_WORD_ARRAY;
+		CONSTANT bad_crc: IN 	BOOLEAN;
+		VARIABLE ok 	: OUT 	BOOLEAN;
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC) IS
+		VARIABLE cmd, rx : STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE crc : STD_LOGIC_VECTOR(7 DOWNTO 0);
+	BEGIN
+		cmd := spi_command_crc(address, true, data'length);
+		crc := crc8(C_CRC_INIT, cmd);
+		spi_select(period, ss);
+		spi_word(cmd, rx, period, sclk, mosi, miso);
+		FOR i IN data'RANGE LOOP
+			spi_word(data(i), rx, period, sclk, mosi, miso);
+			crc := crc8(crc, data(i));
+		END LOOP;
+		IF (bad_crc) THEN
+			spi_word(x"00" & (crc xor x"01"), rx, period, sclk, mosi, miso);
+		ELSE
+			spi_word(x"00" & crc, rx, period, sclk, mosi, miso);
+		END IF;
+		spi_word(x"0000", rx, period, sclk, mosi, miso);						-- turnaround
+		spi_word(x"0000", rx, period, sclk, mosi, miso);						-- ack
+		spi_deselect(period, ss);
+		ok := (rx = C_CRC_ACK & crc);
+	END PROCEDURE;
+
+	PROCEDURE spi_read_crc(
+		CONSTANT address: IN 	NATURAL;
+		VARIABLE data 	: OUT 	T_WORD_ARRAY;
+		VARIABLE ok 	: OUT 	BOOLEAN;
+		CONSTANT period	: IN 	TIME;
+		SIGNAL ss		: OUT	STD_LOGIC;
+		SIGNAL sclk		: OUT	STD_LOGIC;
+		SIGNAL mosi		: OUT	STD_LOGIC;
+		SIGNAL miso		: IN	STD_LOGIC) IS
+		VARIABLE cmd, rx : STD_LOGIC_VECTOR(15 DOWNTO 0);
+		VARIABLE crc : STD_LOGIC_VECTOR(7 DOWNTO 0);
+	BEGIN
+		cmd := spi_command_crc(address, false, data'length);
+		crc := crc8(C_CRC_INIT, cmd);
+		spi_select(period, ss);
+		spi_word(cmd, rx, period, sclk, mosi, miso);
+		spi_word(x"0000", rx, period, sclk, mosi, miso);						-- turnaround, STATUS
+		crc := crc8(crc, rx);
+		FOR i IN data'RANGE LOOP
+			spi_word(x"0000", rx, period, sclk, mosi, miso);
+			data(i) := rx;
+			crc := crc8(crc, rx);
+		END LOOP;
+		spi_word(x"0000", rx, period, sclk, mosi, miso);						-- crc
+		spi_deselect(period, ss);
+		ok := (rx = x"00" & crc);
+	END PROCEDURE;
+
+	PROCEDURE tb_check(
+		CONSTANT got, expected	: IN 	STD_LOGIC_VECTOR;
+		CONSTANT what			: IN 	STRING;
+		VARIABLE errors			: INOUT	NATURAL) IS
+	BEGIN
+		IF (unsigned(got) /= unsigned(expected)) THEN
+			REPORT what & ": got " & integer'image(to_integer(unsigned(got))) &
+				", expected " & integer'image(to_integer(unsigned(expected))) SEVERITY ERROR;
+			errors := errors + 1;
+		END IF;
+	END PROCEDURE;
+
+	PROCEDURE tb_check(
+		CONSTANT got, expected	: IN 	INTEGER;
+		CONSTANT what			: IN 	STRING;
+		VARIABLE errors			: INOUT	NATURAL) IS
+	BEGIN
+		IF (got /= expected) THEN
+			REPORT what & ": got " & integer'image(got) & ", expected " & integer'image(expected) SEVERITY ERROR;
+			errors := errors + 1;
+		END IF;
+	END PROCEDURE;
+
+	PROCEDURE tb_check(
+		CONSTANT got, expected	: IN 	BOOLEAN;
+		CONSTANT what			: IN 	STRING;
+		VARIABLE errors			: INOUT	NATURAL) IS
+	BEGIN
+		IF (got /= expected) THEN
+			REPORT what & ": got " & boolean'image(got) & ", expected " & boolean'image(expected) SEVERITY ERROR;
+			errors := errors + 1;
+		END IF;
+	END PROCEDURE;
+
+	PROCEDURE tb_end(
+		CONSTANT name			: IN 	STRING;
+		CONSTANT errors			: IN 	NATURAL) IS
+	BEGIN
+		IF (errors = 0) THEN
+			REPORT name & ": PASS" SEVERITY NOTE;
+		ELSE
+			REPORT name & ": FAIL, " & integer'image(errors) & " error(s)" SEVERITY FAILURE;
+		END IF;
+	END PROCEDURE;
+
+END SPI_MASTER_BFM_PKG;
@@ -0,0 +1,230 @@
+LIBRARY  ieee;
+  USE ieee.std_logic_1164.all;
+  USE ieee.numeric_std.all;
+LIBRARY work;
+  USE work.holoboard_pkg.all;
+
+-- Wheel velocity PI controller, one datapath time-multiplexed over the
+-- G_NB_CHANNELS channels, run for each channel in turn on each TICK_I pulse:
+--   error    = REF - 256 * counts since the previous tick, saturated to 16 bits
+--   integral = integral + KI * error, saturated to +/- LIMIT * 256
+--   duty     = (KP * error + integral) / 256 rounded down, saturated to +/- LIMIT
+-- REF and error are in 1/256 counts per tick, KP in duty steps per count
+-- per tick, KI in duty steps per count per tick, per tick. LIMIT is the
+-- PWM period: the output saturates at full duty.
+-- The registers of a channel are taken from the register file channel scan
+-- (REF_I, KP_I, KI_I and LIMIT_I are the words of channel SCAN_I), the
+-- controller waits for its channel to come by before each use.
+-- The previous counter and the integral of each channel are kept in
+-- distributed RAM. Both products go through one shift-and-add multiplier,
+-- 17 clocks each (MachXO2 has no hardware multiplier): a channel takes at
+-- most 38 + 4 * (G_NB_CHANNELS-1) clocks, DUTY_O of the last channel is
+-- updated G_NB_CHANNELS times that after the tick. Ticks coming while the
+-- channels are still running are skipped.
+-- While ENABLE_I is low the integrals are cleared, one channel per clock,
+-- and DUTY_O is zero.
+-- The same arithmetic is modelled in C by VEL_testbench/src/vel_pi_model.c.
+
+ENTITY VELOCITY_PI IS
+	GENERIC (
+		G_NB_CHANNELS	: NATURAL := C_NB_CHANNELS
+		);
+	PORT (
+		RESET_I		: IN  	STD_LOGIC;
+		CLK_I      	: IN  	STD_LOGIC;
+		ENABLE_I	: IN 	STD_LOGIC;
+		TICK_I		: IN 	STD_LOGIC;												-- one clock pulse per loop period
+		COUNTER_I	: IN 	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1);						-- encoder counters, 12 bits, wrap around
+		SCAN_I		: IN 	UNSIGNED(3 DOWNTO 0);									-- channel of the register words below
+		REF_I		: IN 	SIGNED(15 DOWNTO 0);
+		KP_I		: IN 	SIGNED(15 DOWNTO 0);
+		KI_I		: IN 	SIGNED(15 DOWNTO 0);
+		LIMIT_I		: IN 	UNSIGNED(14 DOWNTO 0);
+		DUTY_O		: OUT	T_WORD_ARRAY(0 TO G_NB_CHANNELS-1)						-- msb = direction, then magnitude, as PWM_DUTY
+		);
+END VELOCITY_PI;
+
+ARCHITECTURE BEHAVIOR OF VELOCITY_PI IS
+
+	COMPONENT RAM IS
+	GENERIC (
+		G_WIDTH		: NATURAL := 16
+		);
+	PORT (
+		CLK_I      	: IN  	STD_LOGIC;
+		WE_I		: IN 	STD_LOGIC;
+		WADDR_I		: IN 	UNSIGNED(3 DOWNTO 0);
+		DATA_I		: IN 	STD_LOGIC_VECTOR(G_WIDTH-1 DOWNTO 0);
+		RADDR_I		: IN 	UNSIGNED(3 DOWNTO 0);
+		DATA_O		: OUT	STD_LOGIC_VECTOR(G_WIDTH-1 DOWNTO 0)
+		);
+	END COMPONENT;
+
+	TYPE T_STATE IS (IDLE, LOAD_P, MUL_P, LOAD_I, MUL_I, INTEGRATE, OUTPUT);
+
+	SIGNAL state			: T_STATE;
+	SIGNAL channel			: UNSIGNED(3 DOWNTO 0);									-- channel running, or cleared
+	SIGNAL error			: SIGNED(15 DOWNTO 0);									-- multiplicand
+	SIGNAL p_term			: SIGNED(32 DOWNTO 0);
+	SIGNAL product_high		: SIGNED(17 DOWNTO 0);									-- multiplier: error * |gain|, shifted right
+	SIGNAL product_low		: STD_LOGIC_VECTOR(16 DOWNTO 0);						-- |gain| bits left, then product lsbs
+	SIGNAL negate			: STD_LOGIC;											-- gain sign
+	SIGNAL steps			: UNSIGNED(4 DOWNTO 0);
+	SIGNAL last_we, integral_we : STD_LOGIC;
+	SIGNAL last_d, last_q	: STD_LOGIC_VECTOR(11 DOWNTO 0);						-- counter at the previous tick
+	SIGNAL integral_d, integral_q : STD_LOGIC_VECTOR(31 DOWNTO 0);
+
+	BEGIN
+
+	LAST_RAM : RAM
+	GENERIC MAP (G_WIDTH => 12)
+	PORT MAP (CLK_I => CLK_I, WE_I => last_we, WADDR_I => channel, DATA_I => last_d, RADDR_I => channel, DATA_O => last_q);
+
+	INTEGRAL_RAM : RAM
+	GENERIC MAP (G_WIDTH => 32)
+	PORT MAP (CLK_I => CLK_I, WE_I => integral_we, WADDR_I => channel, DATA_I => integral_d, RADDR_I => channel, DATA_O => integral_q);
+
+	-- State written when the channel is cleared, the counter when it is
+	-- loaded, the integral along with the output
+	last_we <= '1' WHEN ENABLE_I = '0' or (state = LOAD_P and SCAN_I = channel) ELSE '0';
+	last_d <= COUNTER_I(to_integer(channel))(11 DOWNTO 0);
+	integral_we <= '1' WHEN ENABLE_I = '0' or (state = OUTPUT and SCAN_I = channel) ELSE '0';
+	integral_d <= (OTHERS => '0') WHEN ENABLE_I = '0' ELSE
+				  std_logic_vector(resize(signed(std_logic_vector(product_high) & product_low), 32));
+
+	PROCESS(RESET_I, CLK_I)
+		VARIABLE counter	: UNSIGNED(11 DOWNTO 0);
+		VARIABLE delta		: SIGNED(11 DOWNTO 0);
+		VARIABLE wide_error	: SIGNED(20 DOWNTO 0);
+		VARIABLE sum		: SIGNED(17 DOWNTO 0);
+		VARIABLE product	: SIGNED(34 DOWNTO 0);
+		VARIABLE total		: SIGNED(33 DOWNTO 0);
+		VARIABLE limit		: SIGNED(33 DOWNTO 0);
+		VARIABLE duty		: SIGNED(25 DOWNTO 0);
+		BEGIN
+			IF (RESET_I = '1') THEN
+				state <= IDLE;
+				channel <= (OTHERS => '0');
+				error <= (OTHERS => '0');
+				p_term <= (OTHERS => '0');
+				product_high <= (OTHERS => '0');
+				product_low <= (OTHERS => '0');
+				negate <= '0';
+				steps <= (OTHERS => '0');
+				DUTY_O <= (OTHERS => (OTHERS => '0'));
+			ELSIF (rising_edge(CLK_I)) THEN
+				counter := unsigned(COUNTER_I(to_integer(channel))(11 DOWNTO 0));
+
+				IF (ENABLE_I = '0') THEN
+					-- Clear one channel per clock
+					state <= IDLE;
+					DUTY_O <= (OTHERS => (OTHERS => '0'));
+					IF (channel = G_NB_CHANNELS-1) THEN
+						channel <= (OTHERS => '0');
+					ELSE
+						channel <= channel + 1;
+					END IF;
+				ELSE
+					CASE state IS
+						WHEN IDLE =>
+							IF (TICK_I = '1') THEN
+								channel <= (OTHERS => '0');
+								state <= LOAD_P;
+							END IF;
+
+						WHEN LOAD_P =>
+							IF (SCAN_I = channel) THEN
+								delta := signed(counter - unsigned(last_q));
+								wide_error := resize(REF_I, 21) - shift_left(resize(delta, 21), 8);
+								IF (wide_error > 32767) THEN
+									wide_error := to_signed(32767, 21);
+								ELSIF (wide_error < -32768) THEN
+									wide_error := to_signed(-32768, 21);
+								END IF;
+								error <= resize(wide_error, 16);
+								-- KP * error first
+								product_high <= (OTHERS => '0');
+								product_low <= std_logic_vector(abs(resize(KP_I, 17)));
+								negate <= KP_I(15);
+								steps <= (OTHERS => '0');
+								state <= MUL_P;
+							END IF;
+
+						WHEN LOAD_I =>
+							IF (SCAN_I = channel) THEN
+								-- Then KI * error
+								product_high <= (OTHERS => '0');
+								product_low <= std_logic_vector(abs(resize(KI_I, 17)));
+								negate <= KI_I(15);
+								steps <= (OTHERS => '0');
+								state <= MUL_I;
+							END IF;
+
+						WHEN MUL_P | MUL_I =>
+							-- One multiplier bit per clock, lsb first, the
+							-- partial product shifted right into product_low
+							sum := product_high;
+							IF (product_low(0) = '1') THEN
+								sum := sum + resize(error, 18);
+							END IF;
+							product_high <= shift_right(sum, 1);
+							product_low <= sum(0) & product_low(16 DOWNTO 1);
+							steps <= steps + 1;
+							IF (steps = product_low'length - 1) THEN
+								product := signed(std_logic_vector(shift_right(sum, 1)) & sum(0) & product_low(16 DOWNTO 1));
+								IF (negate = '1') THEN
+									product := -product;
+								END IF;
+								IF (state = MUL_P) THEN
+									p_term <= resize(product, 33);
+									state <= LOAD_I;
+								ELSE
+									product_high <= product(34 DOWNTO 17);
+									product_low <= std_logic_vector(product(16 DOWNTO 0));
+									state <= INTEGRATE;
+								END IF;
+							END IF;
+
+						WHEN INTEGRATE =>
+							IF (SCAN_I = channel) THEN
+								-- Integral, anti-windup at the output limit
+								limit := signed(shift_left(resize(LIMIT_I, 34), 8));
+								total := resize(signed(integral_q), 34) + resize(signed(std_logic_vector(product_high) & product_low), 34);
+								IF (total > limit) THEN
+									total := limit;
+								ELSIF (total < -limit) THEN
+									total := -limit;
+								END IF;
+								-- Written to the RAM by OUTPUT
+								product := resize(total, 35);
+								product_high <= product(34 DOWNTO 17);
+								product_low <= std_logic_vector(product(16 DOWNTO 0));
+								state <= OUTPUT;
+							END IF;
+
+						WHEN OUTPUT =>
+							IF (SCAN_I = channel) THEN
+								total := resize(p_term, 34) + resize(signed(std_logic_vector(product_high) & product_low), 34);
+								duty := resize(shift_right(total, 8), 26);
+								IF (duty > signed(resize(LIMIT_I, 26))) THEN
+									duty := signed(resize(LIMIT_I, 26));
+								ELSIF (duty < -signed(resize(LIMIT_I, 26))) THEN
+									duty := -signed(resize(LIMIT_I, 26));
+								END IF;
+								IF (duty < 0) THEN
+									DUTY_O(to_integer(channel)) <= '1' & std_logic_vector(resize(unsigned(-duty), 15));
+								ELSE
+									DUTY_O(to_integer(channel)) <= '0' & std_logic_vector(resize(unsigned(duty), 15));
+								END IF;
+								IF (channel = G_NB_CHANNELS-1) THEN
+									state <= IDLE;
+								ELSE
+									channel <= channel + 1;
+									state <= LOAD_P;
+								END IF;
+							END IF;
+					END CASE;
+				END IF;
+			END IF;
+	END PROCESS;
+END BEHAVIOR;